@@ -154,6 +154,13 @@ enum stream_query_e
     STREAM_GET_CONTENT_TYPE,    /**< arg1= char **         res=can fail */
     STREAM_GET_SIGNAL,      /**< arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
     STREAM_GET_TAGS,        /**< arg1=const block_t ** res=can fail */
+    /* Zero-copy read: the block references the data of the stream at the
+     * given offset (e.g. a file mapping), the stream position is unchanged.
+     * Only filters that do not alter the data or its offsets forward it. */
+    STREAM_GET_MAPPED_BLOCK, /**< arg1= uint64_t offset, arg2= size_t size, arg3= block_t ** res=can fail */
+    /* Reads within the ranges announced with STREAM_SET_READAHEAD (hits)
+     * or not (misses), and the bytes fetched in advance so far */
+    STREAM_GET_READAHEAD_STATS, /**< arg1= uint64_t *hits, arg2= uint64_t *misses, arg3= uint64_t *bytes res=can fail */
 
     STREAM_SET_PAUSE_STATE = 0x200, /**< arg1= bool        res=can fail */
     STREAM_SET_TITLE,       /**< arg1= int          res=can fail */
@@ -161,6 +168,9 @@ enum stream_query_e
 
     /* XXX only data read through vlc_stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,     /**< arg1=bool, arg2=const char *psz_ext (if arg1 is true)  res=can fail */
+    /* Hint that a range will be read soon, e.g. the upcoming samples of a
+     * badly interleaved file, so that the source can fetch it in advance. */
+    STREAM_SET_READAHEAD,   /**< arg1= uint64_t offset, arg2= uint64_t size res=can fail */
 
     STREAM_SET_PRIVATE_ID_STATE = 0x1000, /* arg1= int i_private_data, bool b_selected    res=can fail */
     STREAM_SET_PRIVATE_ID_CA,             /* arg1= int i_program_number, uint16_t i_vpid, uint16_t i_apid1, uint16_t i_apid2, uint16_t i_apid3, uint8_t i_length, uint8_t *p_data */
@@ -52,9 +52,13 @@
 #   include <unistd.h>
 #endif
 #include <dirent.h>
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include "fs.h"
+#include "readahead.h"
 #include <vlc_input.h>
 #include <vlc_access.h>
 #ifdef _WIN32
@@ -63,12 +67,69 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 #include <vlc_interrupt.h>
+#include <vlc_atomic.h>
+
+#ifdef HAVE_MMAP
+/* A window of the file mapped in memory. It is shared by the access and by
+ * the blocks referencing it, and unmapped when the last of them releases it. */
+typedef struct
+{
+    void *addr;
+    uint64_t offset; /* file offset of addr */
+    size_t length;
+    atomic_uint refs;
+} file_map_t;
+
+typedef struct
+{
+    block_t self;
+    file_map_t *map;
+} file_block_t;
+
+/* Blocks pin their whole window until they are released, so keep it small */
+#define FILE_MAP_WINDOW  (4 << 20)
+/* Readable bytes required after the data of a block, as with block_Alloc() */
+#define FILE_MAP_PADDING 32
+#endif
+
+#ifdef HAVE_POSIX_FADVISE
+/* Read-ahead planner: the coalesced ranges (see readahead.h) are passed to
+ * the kernel by a background thread, so that far apart samples do not defeat
+ * the sequential heuristics of the kernel read-ahead. */
+typedef struct
+{
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    bool b_stop;
+    int fd;
+
+    file_range_t pending[FILE_RA_SLOTS]; /* oldest first */
+    unsigned i_pending;
+    file_range_t advised[FILE_RA_SLOTS]; /* ring buffer */
+    unsigned i_advised;
+
+    /* statistics */
+    uint64_t i_hits; /* reads within advised ranges */
+    uint64_t i_misses;
+    uint64_t i_bytes; /* advised bytes */
+} file_readahead_t;
+#endif
 
 struct access_sys_t
 {
     int fd;
 
     bool b_pace_control;
+#ifdef HAVE_MMAP
+    bool b_map;
+    file_map_t *map; /* current window, or NULL */
+    uint64_t map_size; /* file size when the window was last mapped */
+#endif
+#ifdef HAVE_POSIX_FADVISE
+    uint64_t i_pos;
+    file_readahead_t *readahead; /* created on the first hint */
+#endif
 };
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -139,6 +200,228 @@ static bool IsRemote (const char *path)
 # define posix_fadvise(fd, off, len, adv)
 #endif
 
+#ifdef HAVE_POSIX_FADVISE
+static void *ReadAheadThread (void *data)
+{
+    file_readahead_t *ra = data;
+
+    vlc_mutex_lock (&ra->lock);
+    for (;;)
+    {
+        while (!ra->b_stop && ra->i_pending == 0)
+            vlc_cond_wait (&ra->wait, &ra->lock);
+        if (ra->b_stop)
+            break;
+
+        file_range_t range = ra->pending[0];
+        memmove (&ra->pending[0], &ra->pending[1],
+                 --ra->i_pending * sizeof (range));
+        vlc_mutex_unlock (&ra->lock);
+
+        /* This may block until the request is queued to the device */
+        posix_fadvise (ra->fd, range.start, range.end - range.start,
+                       POSIX_FADV_WILLNEED);
+
+        vlc_mutex_lock (&ra->lock);
+        ra->advised[ra->i_advised++ % FILE_RA_SLOTS] = range;
+        ra->i_bytes += range.end - range.start;
+    }
+    vlc_mutex_unlock (&ra->lock);
+    return NULL;
+}
+
+static int ReadAheadAdd (stream_t *p_access, uint64_t offset, uint64_t size)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    file_readahead_t *ra = p_sys->readahead;
+
+    if (size == 0 || offset + size < offset)
+        return VLC_EGENERIC;
+
+    if (ra == NULL)
+    {
+        ra = malloc (sizeof (*ra));
+        if (unlikely(ra == NULL))
+            return VLC_ENOMEM;
+
+        vlc_mutex_init (&ra->lock);
+        vlc_cond_init (&ra->wait);
+        ra->b_stop = false;
+        ra->fd = p_sys->fd;
+        ra->i_pending = ra->i_advised = 0;
+        ra->i_hits = ra->i_misses = ra->i_bytes = 0;
+
+        if (vlc_clone (&ra->thread, ReadAheadThread, ra,
+                       VLC_THREAD_PRIORITY_LOW))
+        {
+            vlc_cond_destroy (&ra->wait);
+            vlc_mutex_destroy (&ra->lock);
+            free (ra);
+            return VLC_EGENERIC;
+        }
+        p_sys->readahead = ra;
+    }
+
+    file_range_t range = { offset, offset + size };
+
+    vlc_mutex_lock (&ra->lock);
+    /* Unless already requested */
+    if (!file_ranges_Cover (ra->advised, __MIN(ra->i_advised, FILE_RA_SLOTS),
+                            range.start, range.end)
+     && file_ranges_Add (ra->pending, &ra->i_pending, range))
+        vlc_cond_signal (&ra->wait);
+    vlc_mutex_unlock (&ra->lock);
+    return VLC_SUCCESS;
+}
+
+/**
+ * Accounts a read in the hit/miss statistics of the planner.
+ */
+static void ReadAheadAccount (access_sys_t *p_sys, uint64_t offset,
+                              uint64_t size)
+{
+    file_readahead_t *ra = p_sys->readahead;
+
+    if (ra == NULL || size == 0)
+        return;
+
+    vlc_mutex_lock (&ra->lock);
+    if (file_ranges_Cover (ra->advised, __MIN(ra->i_advised, FILE_RA_SLOTS),
+                           offset, offset + size))
+        ra->i_hits++;
+    else
+        ra->i_misses++;
+    vlc_mutex_unlock (&ra->lock);
+}
+
+static void ReadAheadStop (stream_t *p_access, file_readahead_t *ra)
+{
+    vlc_mutex_lock (&ra->lock);
+    ra->b_stop = true;
+    vlc_cond_signal (&ra->wait);
+    vlc_mutex_unlock (&ra->lock);
+    vlc_join (ra->thread, NULL);
+
+    msg_Dbg (p_access, "read-ahead: %"PRIu64" KiB advised, %"PRIu64" hits, "
+             "%"PRIu64" misses", ra->i_bytes >> 10, ra->i_hits, ra->i_misses);
+
+    vlc_cond_destroy (&ra->wait);
+    vlc_mutex_destroy (&ra->lock);
+    free (ra);
+}
+#endif
+
+#ifdef HAVE_MMAP
+static void FileMapRelease (file_map_t *map)
+{
+    if (atomic_fetch_sub (&map->refs, 1) == 1)
+    {
+        munmap (map->addr, map->length);
+        free (map);
+    }
+}
+
+static void FileBlockRelease (block_t *block)
+{
+    file_block_t *fb = (file_block_t *)block;
+
+    FileMapRelease (fb->map);
+    free (fb);
+}
+
+/**
+ * Returns a mapping window covering size bytes at offset, plus the padding.
+ * The window is replaced when a read falls outside of it, so that the mapped
+ * (and potentially copied on write) size is bounded whatever the file size.
+ */
+static file_map_t *FileMapWindow (stream_t *p_access, uint64_t offset,
+                                  size_t size)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    file_map_t *map = p_sys->map;
+
+    /* Checked before every block, even within the current window: a
+     * shrinking file is being rewritten, and reading a mapped page beyond
+     * its new end would raise SIGBUS. */
+    struct stat st;
+    if (fstat (p_sys->fd, &st))
+        return NULL;
+    if ((uint64_t)st.st_size < p_sys->map_size)
+    {
+        msg_Warn (p_access, "file truncated, not mapping it anymore");
+        p_sys->b_map = false;
+        if (map != NULL)
+            FileMapRelease (map);
+        p_sys->map = NULL;
+        return NULL;
+    }
+    p_sys->map_size = st.st_size;
+
+    if (map != NULL && offset >= map->offset
+     && offset - map->offset + size + FILE_MAP_PADDING <= map->length)
+        return map;
+
+    uint64_t start = offset & ~(uint64_t)(sysconf (_SC_PAGESIZE) - 1);
+    uint64_t end = start + __MAX(FILE_MAP_WINDOW,
+                                 offset - start + size + FILE_MAP_PADDING);
+    if (end > (uint64_t)st.st_size)
+        end = st.st_size;
+    /* The tail of the file is read normally: there is no padding there */
+    if (offset + size + FILE_MAP_PADDING > end || end - start > SIZE_MAX)
+        return NULL;
+
+    map = malloc (sizeof (*map));
+    if (unlikely(map == NULL))
+        return NULL;
+
+    /* Private writable mapping: decoders may modify blocks in place. */
+    map->addr = mmap (NULL, end - start, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      p_sys->fd, start);
+    if (map->addr == MAP_FAILED)
+    {
+        msg_Dbg (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        p_sys->b_map = false;
+        free (map);
+        return NULL;
+    }
+    map->offset = start;
+    map->length = end - start;
+    atomic_init (&map->refs, 1); /* reference of the access */
+
+    if (p_sys->map != NULL)
+        FileMapRelease (p_sys->map);
+    p_sys->map = map;
+    return map;
+}
+
+static block_t *FileMapBlock (stream_t *p_access, uint64_t offset,
+                              size_t size)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (!p_sys->b_map || size == 0)
+        return NULL;
+
+    file_map_t *map = FileMapWindow (p_access, offset, size);
+    if (map == NULL)
+        return NULL;
+
+    file_block_t *fb = malloc (sizeof (*fb));
+    if (unlikely(fb == NULL))
+        return NULL;
+
+    block_Init (&fb->self, (uint8_t *)map->addr + (offset - map->offset),
+                size);
+    fb->self.pf_release = FileBlockRelease;
+    fb->map = map;
+    atomic_fetch_add (&map->refs, 1);
+#ifdef HAVE_POSIX_FADVISE
+    ReadAheadAccount (p_sys, offset, size);
+#endif
+    return &fb->self;
+}
+#endif
+
 static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
 static int NoSeek (stream_t *, uint64_t);
@@ -225,6 +508,18 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_MMAP
+    /* Remote files may be truncated behind our back, causing SIGBUS. */
+    p_sys->b_map = S_ISREG (st.st_mode)
+                && !IsRemote(fd, p_access->psz_filepath)
+                && var_InheritBool (p_access, "file-mmap");
+    p_sys->map = NULL;
+    p_sys->map_size = st.st_size;
+#endif
+#ifdef HAVE_POSIX_FADVISE
+    p_sys->i_pos = 0;
+    p_sys->readahead = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -273,6 +568,14 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_POSIX_FADVISE
+    if (p_sys->readahead != NULL)
+        ReadAheadStop (p_access, p_sys->readahead);
+#endif
+#ifdef HAVE_MMAP
+    if (p_sys->map != NULL)
+        FileMapRelease (p_sys->map);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -296,6 +599,10 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
         val = 0;
     }
 
+#ifdef HAVE_POSIX_FADVISE
+    ReadAheadAccount (p_sys, p_sys->i_pos, val);
+    p_sys->i_pos += val;
+#endif
     return val;
 }
 
@@ -308,6 +615,9 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
 
     if (lseek(sys->fd, i_pos, SEEK_SET) == (off_t)-1)
         return VLC_EGENERIC;
+#ifdef HAVE_POSIX_FADVISE
+    sys->i_pos = i_pos;
+#endif
     return VLC_SUCCESS;
 }
 
@@ -360,10 +670,54 @@ static int FileControl( stream_t *p_access, int i_query, va_list args )
             *pi_64 *= 1000;
             break;
 
+#ifdef HAVE_MMAP
+        case STREAM_GET_MAPPED_BLOCK:
+        {
+            uint64_t offset = va_arg( args, uint64_t );
+            size_t size = va_arg( args, size_t );
+            block_t *block = FileMapBlock( p_access, offset, size );
+
+            if( block == NULL )
+                return VLC_EGENERIC;
+            *va_arg( args, block_t ** ) = block;
+            break;
+        }
+
+#endif
         case STREAM_SET_PAUSE_STATE:
             /* Nothing to do */
             break;
 
+#ifdef HAVE_POSIX_FADVISE
+        case STREAM_SET_READAHEAD:
+        {
+            if (p_access->pf_seek == NoSeek)
+                return VLC_EGENERIC;
+
+            uint64_t offset = va_arg( args, uint64_t );
+            uint64_t size = va_arg( args, uint64_t );
+            return ReadAheadAdd( p_access, offset, size );
+        }
+
+        case STREAM_GET_READAHEAD_STATS:
+        {
+            file_readahead_t *ra = p_sys->readahead;
+            if (ra == NULL)
+                return VLC_EGENERIC;
+
+            uint64_t *hits = va_arg( args, uint64_t * );
+            uint64_t *misses = va_arg( args, uint64_t * );
+            uint64_t *bytes = va_arg( args, uint64_t * );
+
+            vlc_mutex_lock (&ra->lock);
+            *hits = ra->i_hits;
+            *misses = ra->i_misses;
+            *bytes = ra->i_bytes;
+            vlc_mutex_unlock (&ra->lock);
+            break;
+        }
+#endif
+
         default:
             return VLC_EGENERIC;
 
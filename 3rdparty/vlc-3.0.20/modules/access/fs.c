@@ -39,6 +39,11 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+    add_bool( "file-mmap", true, N_("Memory-map local files"),
+              N_("Large reads from local files reference a memory mapping "
+                 "of the file instead of being copied. The file size is "
+                 "checked before each read, and a file seen shrinking is "
+                 "read normally from then on."), true )
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -92,14 +92,28 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+#define VLC_HTTP_MGR_H1_MAX 4
+
 struct vlc_http_mgr
 {
     vlc_object_t *obj;
     vlc_tls_creds_t *creds;
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    struct vlc_http_conn *conn; /**< HTTP/2 connection */
+    struct vlc_http_conn *h1[VLC_HTTP_MGR_H1_MAX]; /**< Most recent first */
+    unsigned h1_count;
+    unsigned conn_count; /**< Number of connections established */
+    unsigned connecting; /**< Number of connections being established */
+    bool use_h2c;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
 };
 
+static bool vlc_http_mgr_empty(const struct vlc_http_mgr *mgr)
+{
+    return mgr->conn == NULL && mgr->h1_count == 0;
+}
+
 static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
                                                const char *host, unsigned port)
 {
@@ -107,6 +121,16 @@ static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
     return mgr->conn;
 }
 
+static void vlc_http_mgr_add(struct vlc_http_mgr *mgr,
+                             struct vlc_http_conn *conn)
+{
+    if (mgr->conn != NULL) /* superseded, closes once its streams are done */
+        vlc_http_conn_release(mgr->conn);
+
+    mgr->conn = conn;
+    mgr->conn_count++;
+}
+
 static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
                                  struct vlc_http_conn *conn)
 {
@@ -116,6 +140,163 @@ static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
     vlc_http_conn_release(conn);
 }
 
+/* HTTP/1.1 connections carry one request at a time. The manager keeps a few
+ * of them so that concurrent requests each get one, and the least recently
+ * used one is dropped when a new one is needed. A connection that failed is
+ * never used again, and thus ends up dropped too. */
+static void vlc_http_mgr_add_h1(struct vlc_http_mgr *mgr,
+                                struct vlc_http_conn *conn)
+{
+    if (mgr->h1_count == VLC_HTTP_MGR_H1_MAX) /* closes once it is done */
+        vlc_http_conn_release(mgr->h1[--mgr->h1_count]);
+
+    memmove(mgr->h1 + 1, mgr->h1, mgr->h1_count * sizeof (mgr->h1[0]));
+    mgr->h1[0] = conn;
+    mgr->h1_count++;
+    mgr->conn_count++;
+}
+
+static void vlc_http_mgr_remove_h1(struct vlc_http_mgr *mgr, unsigned i)
+{
+    struct vlc_http_conn *conn = mgr->h1[i];
+
+    assert(i < mgr->h1_count);
+    mgr->h1_count--;
+    memmove(mgr->h1 + i, mgr->h1 + i + 1,
+            (mgr->h1_count - i) * sizeof (mgr->h1[0]));
+    vlc_http_conn_release(conn);
+}
+
+/* Gets rid of a failed connection. It was possibly dropped and destroyed
+ * since count was read: only compare the pointers if no connection was added
+ * meanwhile. */
+static void vlc_http_mgr_drop_h1(struct vlc_http_mgr *mgr,
+                                 struct vlc_http_conn *conn, unsigned count)
+{
+    if (mgr->conn_count != count)
+        return;
+
+    for (unsigned i = 0; i < mgr->h1_count; i++)
+        if (mgr->h1[i] == conn)
+        {
+            vlc_http_mgr_remove_h1(mgr, i);
+            break;
+        }
+}
+
+/* Called with the manager lock held. The lock is dropped while waiting for
+ * the response so that other requests can go on meanwhile. */
+static
+struct vlc_http_msg *vlc_http_mgr_wait(struct vlc_http_mgr *mgr,
+                                       struct vlc_http_stream *stream)
+{
+    vlc_mutex_unlock(&mgr->lock);
+    struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+    vlc_mutex_lock(&mgr->lock);
+    return m;
+}
+
+/* Puts back a connection taken out of the pool by vlc_http_mgr_reuse_h1().
+ * Connections may have been added meanwhile: if the pool is full, the least
+ * recently used one is dropped, which is this one if it is not put first. */
+static void vlc_http_mgr_put_h1(struct vlc_http_mgr *mgr,
+                                struct vlc_http_conn *conn, bool first)
+{
+    if (mgr->h1_count == VLC_HTTP_MGR_H1_MAX)
+    {
+        if (!first)
+        {
+            vlc_http_conn_release(conn);
+            return;
+        }
+        vlc_http_conn_release(mgr->h1[--mgr->h1_count]);
+    }
+
+    if (first)
+    {
+        memmove(mgr->h1 + 1, mgr->h1, mgr->h1_count * sizeof (mgr->h1[0]));
+        mgr->h1[0] = conn;
+    }
+    else
+        mgr->h1[mgr->h1_count] = conn;
+    mgr->h1_count++;
+}
+
+static
+struct vlc_http_msg *vlc_http_mgr_reuse_h1(struct vlc_http_mgr *mgr,
+                                           const struct vlc_http_msg *req)
+{
+    struct vlc_http_conn *tried[VLC_HTTP_MGR_H1_MAX];
+    unsigned tries = 0;
+
+    for (unsigned i = 0; i < mgr->h1_count && tries < VLC_HTTP_MGR_H1_MAX;)
+    {
+        struct vlc_http_conn *conn = mgr->h1[i];
+        bool skip = false;
+
+        for (unsigned j = 0; j < tries; j++)
+            skip |= tried[j] == conn;
+        if (skip)
+        {
+            i++;
+            continue;
+        }
+        tried[tries++] = conn;
+
+        /* Sending the request blocks: the connection is taken out of the
+         * pool meanwhile, so that it is not dropped under our feet, and the
+         * pool is scanned again afterwards as it may have changed. */
+        mgr->h1_count--;
+        memmove(mgr->h1 + i, mgr->h1 + i + 1,
+                (mgr->h1_count - i) * sizeof (mgr->h1[0]));
+        vlc_mutex_unlock(&mgr->lock);
+        struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
+        vlc_mutex_lock(&mgr->lock);
+
+        vlc_http_mgr_put_h1(mgr, conn, stream != NULL);
+        if (stream == NULL)
+        {   /* busy or failed */
+            i = 0;
+            continue;
+        }
+
+        unsigned count = mgr->conn_count;
+        struct vlc_http_msg *m = vlc_http_mgr_wait(mgr, stream);
+        if (m == NULL)
+            vlc_http_mgr_drop_h1(mgr, conn, count);
+        return m;
+    }
+    return NULL;
+}
+
+/* Connections are established without the manager lock. Until a connection
+ * turned out to be HTTP/1.1, the pending one may be HTTP/2 and shared, so
+ * other requests wait for it rather than connect too. */
+static bool vlc_http_mgr_wait_connect(struct vlc_http_mgr *mgr)
+{
+    if (mgr->connecting == 0 || mgr->h1_count > 0)
+        return false;
+
+    while (mgr->connecting > 0)
+        vlc_cond_wait(&mgr->wait, &mgr->lock);
+    return true;
+}
+
+static void vlc_http_mgr_unlock_connect(struct vlc_http_mgr *mgr)
+{
+    mgr->connecting++;
+    vlc_mutex_unlock(&mgr->lock);
+}
+
+static void vlc_http_mgr_lock_connect(struct vlc_http_mgr *mgr)
+{
+    vlc_mutex_lock(&mgr->lock);
+    assert(mgr->connecting > 0);
+    if (--mgr->connecting == 0)
+        vlc_cond_broadcast(&mgr->wait);
+}
+
+/* Called with the manager lock held. */
 static
 struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
                                         const char *host, unsigned port,
@@ -123,12 +304,13 @@ struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
 {
     struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
     if (conn == NULL)
-        return NULL;
+        return vlc_http_mgr_reuse_h1(mgr, req);
 
+    unsigned count = mgr->conn_count;
     struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
     if (stream != NULL)
     {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+        struct vlc_http_msg *m = vlc_http_mgr_wait(mgr, stream);
         if (m != NULL)
             return m;
 
@@ -136,6 +318,11 @@ struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
          * was processed by the other end. Thus POST is not used/supported so
          * far, and CONNECT is treated as if it were idempotent (which works
          * fine here). */
+
+        /* The stream was closed, and the connection possibly with it:
+         * only compare the pointer if no connection was added since. */
+        if (mgr->conn_count != count || mgr->conn != conn)
+            return NULL;
     }
     /* Get rid of closing or reset connection */
     vlc_http_mgr_release(mgr, conn);
@@ -149,7 +336,7 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
+    if (mgr->creds == NULL && !vlc_http_mgr_empty(mgr))
         return NULL; /* switch from HTTP to HTTPS not implemented */
 
     if (mgr->creds == NULL)
@@ -160,19 +347,28 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     }
 
     /* TODO? non-idempotent request support */
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp;
+
+    while ((resp = vlc_http_mgr_reuse(mgr, host, port, req)) == NULL
+        && vlc_http_mgr_wait_connect(mgr));
     if (resp != NULL)
         return resp; /* existing connection reused */
 
+    /* Other requests can use the existing connections during the handshake.
+     * The credentials are only deleted along with the manager. */
+    vlc_tls_creds_t *creds = mgr->creds;
     char *proxy = vlc_http_proxy_find(host, port, true);
+
+    vlc_http_mgr_unlock_connect(mgr);
     if (proxy != NULL)
     {
-        tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
+        tls = vlc_https_connect_proxy(creds, creds,
                                       host, port, &http2, proxy);
         free(proxy);
     }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+        tls = vlc_https_connect(creds, host, port, &http2);
+    vlc_http_mgr_lock_connect(mgr);
 
     if (tls == NULL)
         return NULL;
@@ -187,7 +383,14 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
      * NOTE: We do not enforce TLS version 1.2 for HTTP 2.0 explicitly.
      */
     if (http2)
+    {
+        if (mgr->conn != NULL)
+        {   /* Another request connected meanwhile: share its connection */
+            vlc_tls_Close(tls);
+            return vlc_http_mgr_reuse(mgr, host, port, req);
+        }
         conn = vlc_h2_conn_create(mgr->obj, tls);
+    }
     else
         conn = vlc_h1_conn_create(mgr->obj, tls, false);
 
@@ -197,19 +400,65 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (http2)
+        vlc_http_mgr_add(mgr, conn);
+    else
+        vlc_http_mgr_add_h1(mgr, conn);
+    vlc_http_dbg(mgr->obj, "%s connection #%u to %s",
+                 http2 ? "HTTP/2" : "HTTP/1.1", mgr->conn_count, host);
 
     return vlc_http_mgr_reuse(mgr, host, port, req);
 }
 
+/* Cleartext HTTP/2 with prior knowledge (RFC 7540 §3.4) */
+static struct vlc_http_msg *vlc_h2c_request(struct vlc_http_mgr *mgr,
+                                            const char *host, unsigned port,
+                                            const struct vlc_http_msg *req)
+{
+    vlc_http_mgr_unlock_connect(mgr);
+    vlc_tls_t *tls = vlc_tls_SocketOpenTCP(mgr->obj, host, port ? port : 80);
+    vlc_http_mgr_lock_connect(mgr);
+    if (tls == NULL)
+        return NULL;
+
+    if (mgr->conn != NULL)
+    {   /* Another request connected meanwhile: share its connection */
+        vlc_tls_Close(tls);
+        return vlc_http_mgr_reuse(mgr, host, port, req);
+    }
+
+    struct vlc_http_conn *conn = vlc_h2_conn_create(mgr->obj, tls);
+    if (unlikely(conn == NULL))
+    {
+        vlc_tls_Close(tls);
+        return NULL;
+    }
+
+    vlc_http_mgr_add(mgr, conn);
+    vlc_http_dbg(mgr->obj, "HTTP/2 cleartext connection #%u to %s",
+                 mgr->conn_count, host);
+
+    unsigned count = mgr->conn_count;
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    if (resp == NULL && mgr->conn == NULL && mgr->conn_count == count)
+    {   /* Server does not seem to speak HTTP/2: stick to HTTP/1.1 */
+        vlc_http_dbg(mgr->obj, "falling back to HTTP/1.1");
+        mgr->use_h2c = false;
+    }
+    return resp;
+}
+
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
+    if (mgr->creds != NULL && !vlc_http_mgr_empty(mgr))
         return NULL; /* switch from HTTPS to HTTP not implemented */
 
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp;
+
+    while ((resp = vlc_http_mgr_reuse(mgr, host, port, req)) == NULL
+        && vlc_http_mgr_wait_connect(mgr));
     if (resp != NULL)
         return resp;
 
@@ -224,30 +473,41 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         vlc_UrlParse(&url, proxy);
         free(proxy);
 
+        vlc_mutex_unlock(&mgr->lock);
         if (url.psz_host != NULL)
             stream = vlc_h1_request(mgr->obj, url.psz_host,
                                     url.i_port ? url.i_port : 80, true, req,
                                     true, &conn);
         else
             stream = NULL;
+        vlc_mutex_lock(&mgr->lock);
 
         vlc_UrlClean(&url);
     }
     else
+    {
+        if (mgr->use_h2c)
+        {
+            resp = vlc_h2c_request(mgr, host, port, req);
+            if (resp != NULL || mgr->use_h2c)
+                return resp;
+        }
+
+        vlc_mutex_unlock(&mgr->lock);
         stream = vlc_h1_request(mgr->obj, host, port ? port : 80, false, req,
                                 true, &conn);
+        vlc_mutex_lock(&mgr->lock);
+    }
 
     if (stream == NULL)
         return NULL;
 
-    resp = vlc_http_msg_get_initial(stream);
-    if (resp == NULL)
-    {
-        vlc_http_conn_release(conn);
-        return NULL;
-    }
+    vlc_http_mgr_add_h1(mgr, conn);
 
-    mgr->conn = conn;
+    unsigned count = mgr->conn_count;
+    resp = vlc_http_mgr_wait(mgr, stream);
+    if (resp == NULL)
+        vlc_http_mgr_drop_h1(mgr, conn, count);
     return resp;
 }
 
@@ -255,7 +515,19 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
                                           const char *host, unsigned port,
                                           const struct vlc_http_msg *m)
 {
-    return (https ? vlc_https_request : vlc_http_request)(mgr, host, port, m);
+    struct vlc_http_msg *resp;
+
+    vlc_mutex_lock(&mgr->lock);
+    resp = (https ? vlc_https_request : vlc_http_request)(mgr, host, port, m);
+    vlc_mutex_unlock(&mgr->lock);
+    return resp;
+}
+
+void vlc_http_mgr_use_h2c(struct vlc_http_mgr *mgr, bool enable)
+{
+    vlc_mutex_lock(&mgr->lock);
+    mgr->use_h2c = enable;
+    vlc_mutex_unlock(&mgr->lock);
 }
 
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
@@ -274,6 +546,12 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->creds = NULL;
     mgr->jar = jar;
     mgr->conn = NULL;
+    mgr->h1_count = 0;
+    mgr->conn_count = 0;
+    mgr->connecting = 0;
+    mgr->use_h2c = false;
+    vlc_mutex_init(&mgr->lock);
+    vlc_cond_init(&mgr->wait);
     return mgr;
 }
 
@@ -281,7 +559,11 @@ void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
     if (mgr->conn != NULL)
         vlc_http_mgr_release(mgr, mgr->conn);
+    while (mgr->h1_count > 0)
+        vlc_http_mgr_remove_h1(mgr, 0);
     if (mgr->creds != NULL)
         vlc_tls_Delete(mgr->creds);
+    vlc_cond_destroy(&mgr->wait);
+    vlc_mutex_destroy(&mgr->lock);
     free(mgr);
 }
@@ -45,6 +45,9 @@ struct vlc_http_cookie_jar_t;
  * @param port TCP server port number, or 0 for the default port number
  * @param req HTTP request header to send
  *
+ * Requests can be sent concurrently from different threads. With HTTP/2,
+ * they are multiplexed over a single connection.
+ *
  * @return The initial HTTP response header, or NULL in case of failure.
  */
 struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
@@ -53,6 +56,19 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
 
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 
+/**
+ * Enables cleartext HTTP/2
+ *
+ * Makes unencrypted HTTP requests use HTTP/2 with prior knowledge ("h2c")
+ * rather than HTTP/1.1, so that they can share one connection. If the server
+ * fails to answer in HTTP/2, the manager falls back to HTTP/1.1.
+ * Requests through a proxy always use HTTP/1.1.
+ *
+ * @param mgr HTTP connection manager
+ * @param enable whether to use HTTP/2 for unencrypted HTTP
+ */
+void vlc_http_mgr_use_h2c(struct vlc_http_mgr *mgr, bool enable);
+
 /**
  * Creates an HTTP connection manager
  *
@@ -0,0 +1,322 @@
+/*****************************************************************************
+ * connmgr_test.c: HTTP connection manager multiplexing test
+ *****************************************************************************
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+#include "h2frame.h"
+#include "connmgr.h"
+#include "message.h"
+
+#define STREAMS 3
+#define BODY_SIZE 12000
+
+enum {
+    DATA, HEADERS, PRIORITY, RST_STREAM, SETTINGS, PUSH_PROMISE, PING, GOAWAY,
+    WINDOW_UPDATE, CONTINUATION,
+};
+
+static int lfd;
+static unsigned weights[STREAMS];
+static bool answered[STREAMS];
+
+static void server_send(int fd, struct vlc_h2_frame *f)
+{
+    assert(f != NULL);
+
+    size_t len = vlc_h2_frame_size(f);
+    ssize_t val = write(fd, f->data, len);
+    assert((size_t)val == len);
+    free(f);
+}
+
+static bool server_recv(int fd, void *buf, size_t len)
+{
+    return recv(fd, buf, len, MSG_WAITALL) == (ssize_t)len;
+}
+
+static void server_reply(int fd, uint_fast32_t id)
+{
+    static const char *const resp[][2] = {
+        { ":status", "200" },
+        { "content-length", "12000" },
+    };
+    static char body[BODY_SIZE];
+
+    server_send(fd, vlc_h2_frame_headers(id, VLC_H2_DEFAULT_MAX_FRAME, false,
+                                         2, resp));
+    server_send(fd, vlc_h2_frame_data(id, body, sizeof (body), true));
+}
+
+/* Minimal cleartext HTTP/2 server: answers the requests once they are all
+ * pending, heaviest stream first, on the single connection it accepts */
+static void *server_thread(void *data)
+{
+    unsigned count = 0;
+    char preface[24];
+    int fd = accept(lfd, NULL, NULL);
+
+    (void) data;
+    assert(fd >= 0);
+    assert(server_recv(fd, preface, sizeof (preface)));
+    assert(!memcmp(preface, "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", 24));
+    server_send(fd, vlc_h2_frame_settings());
+
+    /* Each request is followed by its priority */
+    while (count < STREAMS || weights[STREAMS - 1] == 0)
+    {
+        uint8_t hdr[9];
+
+        assert(server_recv(fd, hdr, 9));
+
+        size_t len = (hdr[0] << 16) | (hdr[1] << 8) | hdr[2];
+        uint32_t id = GetDWBE(hdr + 5) & 0x7fffffff;
+        uint8_t payload[len ? len : 1];
+
+        if (len > 0)
+            assert(server_recv(fd, payload, len));
+
+        switch (hdr[3])
+        {
+            case SETTINGS:
+                if (!(hdr[4] & 1))
+                    server_send(fd, vlc_h2_frame_settings_ack());
+                break;
+            case HEADERS:
+                assert(id == 2 * count + 1);
+                count++;
+                break;
+            case PRIORITY:
+                assert(len == 5);
+                assert(id >= 1 && (id - 1) / 2 < STREAMS);
+                weights[(id - 1) / 2] = payload[4] + 1;
+                break;
+        }
+    }
+
+    for (unsigned i = 0; i < STREAMS; i++)
+    {
+        unsigned best = STREAMS;
+
+        for (unsigned j = 0; j < STREAMS; j++)
+            if (!answered[j]
+             && (best == STREAMS || weights[j] > weights[best]))
+                best = j;
+        server_reply(fd, 2 * best + 1);
+        answered[best] = true;
+    }
+
+    /* Wait for the client to close the connection */
+    char buf[256];
+    while (read(fd, buf, sizeof (buf)) > 0);
+    close(fd);
+    return NULL;
+}
+
+/* Minimal HTTP/1.1 server: answers requests on the connection it accepts
+ * until the client closes it */
+static atomic_uint h1_accepted = ATOMIC_VAR_INIT(0);
+
+static void *h1_server_thread(void *data)
+{
+    static const char hdr[] = "HTTP/1.1 200 OK\r\n"
+                              "Content-Length: 12000\r\n\r\n";
+    static char resp[sizeof (hdr) - 1 + BODY_SIZE];
+    int fd = accept(lfd, NULL, NULL);
+
+    (void) data;
+    if (fd < 0)
+        return NULL; /* not needed */
+    atomic_fetch_add(&h1_accepted, 1);
+
+    for (;;)
+    {
+        char buf[1024];
+        size_t len = 0;
+
+        do
+        {
+            if (len == sizeof (buf) || read(fd, buf + len, 1) != 1)
+                goto out;
+            len++;
+        }
+        while (len < 4 || memcmp(buf + len - 4, "\r\n\r\n", 4));
+
+        assert(!memcmp(buf, "GET /segment HTTP/1.1\r\n", 23));
+        memcpy(resp, hdr, sizeof (hdr) - 1);
+        assert(write(fd, resp, sizeof (resp)) == sizeof (resp));
+    }
+out:
+    close(fd);
+    return NULL;
+}
+
+static struct vlc_http_mgr *mgr;
+static unsigned port;
+
+struct client
+{
+    vlc_thread_t thread;
+    unsigned weight;
+};
+
+static void *client_thread(void *data)
+{
+    struct client *c = data;
+    char authority[32];
+
+    snprintf(authority, sizeof (authority), "127.0.0.1:%u", port);
+
+    struct vlc_http_msg *req = vlc_http_req_create("GET", "http", authority,
+                                                   "/segment");
+    assert(req != NULL);
+    vlc_http_msg_set_priority(req, c->weight);
+    assert(vlc_http_msg_get_priority(req) == c->weight);
+
+    struct vlc_http_msg *resp = vlc_http_mgr_request(mgr, false, "127.0.0.1",
+                                                     port, req);
+    vlc_http_msg_destroy(req);
+    assert(resp != NULL);
+    assert(vlc_http_msg_get_status(resp) == 200);
+
+    size_t total = 0;
+    block_t *block;
+
+    while ((block = vlc_http_msg_read(resp)) != NULL)
+    {
+        assert(block != vlc_http_error);
+        total += block->i_buffer;
+        block_Release(block);
+    }
+    assert(total == BODY_SIZE);
+    vlc_http_msg_destroy(resp);
+    return NULL;
+}
+
+static void run_clients(struct client *clients)
+{
+    for (unsigned i = 0; i < STREAMS; i++)
+        if (vlc_clone(&clients[i].thread, client_thread, &clients[i],
+                      VLC_THREAD_PRIORITY_LOW))
+            assert(!"Thread error");
+    for (unsigned i = 0; i < STREAMS; i++)
+        vlc_join(clients[i].thread, NULL);
+}
+
+/* HTTP/1.1 connections are kept alive for the next requests */
+static void test_h1(void)
+{
+    vlc_thread_t servers[STREAMS];
+    struct client clients[STREAMS] = {
+        { .weight = 32 }, { .weight = 128 }, { .weight = 256 },
+    };
+
+    mgr = vlc_http_mgr_create(NULL, NULL);
+    assert(mgr != NULL);
+
+    for (unsigned i = 0; i < STREAMS; i++)
+        if (vlc_clone(&servers[i], h1_server_thread, NULL,
+                      VLC_THREAD_PRIORITY_LOW))
+            assert(!"Thread error");
+
+    run_clients(clients);
+    unsigned accepted = atomic_load(&h1_accepted);
+    assert(accepted >= 1 && accepted <= STREAMS);
+
+    /* The next requests reuse the idle connections */
+    run_clients(clients);
+    assert(atomic_load(&h1_accepted) == accepted);
+
+    struct pollfd ufd = { .fd = lfd, .events = POLLIN };
+    assert(poll(&ufd, 1, 0) == 0);
+
+    vlc_http_mgr_destroy(mgr);
+    shutdown(lfd, SHUT_RDWR); /* wakes up the servers left waiting */
+    for (unsigned i = 0; i < STREAMS; i++)
+        vlc_join(servers[i], NULL);
+}
+
+int main(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof (addr);
+    vlc_thread_t server;
+
+    unsetenv("http_proxy");
+
+    lfd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(lfd >= 0);
+    assert(bind(lfd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(listen(lfd, 8) == 0);
+    assert(getsockname(lfd, (struct sockaddr *)&addr, &addrlen) == 0);
+    port = ntohs(addr.sin_port);
+
+    mgr = vlc_http_mgr_create(NULL, NULL);
+    assert(mgr != NULL);
+    vlc_http_mgr_use_h2c(mgr, true);
+
+    if (vlc_clone(&server, server_thread, NULL, VLC_THREAD_PRIORITY_LOW))
+        assert(!"Thread error");
+
+    /* Audio, video and subtitles segment requests at once */
+    struct client clients[STREAMS] = {
+        { .weight = 32 }, { .weight = 128 }, { .weight = 256 },
+    };
+
+    run_clients(clients);
+
+    /* All the requests went through a single connection... */
+    struct pollfd ufd = { .fd = lfd, .events = POLLIN };
+    assert(poll(&ufd, 1, 0) == 0);
+
+    vlc_http_mgr_destroy(mgr);
+    vlc_join(server, NULL);
+
+    /* ...with each request priority sent along */
+    unsigned sum = 0;
+    for (unsigned i = 0; i < STREAMS; i++)
+    {
+        assert(answered[i]);
+        sum += weights[i];
+    }
+    assert(sum == 32 + 128 + 256);
+
+    test_h1();
+    close(lfd);
+    return 0;
+}
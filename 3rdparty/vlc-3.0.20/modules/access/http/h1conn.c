@@ -117,6 +117,7 @@ struct vlc_h1_conn
     bool released;
     bool proxy;
     void *opaque;
+    vlc_mutex_t lock; /**< Protects active and released */
 };
 
 #define CO(conn) ((conn)->opaque)
@@ -147,24 +148,39 @@ static struct vlc_http_stream *vlc_h1_stream_open(struct vlc_http_conn *c,
     size_t len;
     ssize_t val;
 
+    /* The connection manager may try a connection while the previous
+     * stream is being closed by another thread. */
+    vlc_mutex_lock(&conn->lock);
     if (conn->active || conn->conn.tls == NULL)
+    {
+        vlc_mutex_unlock(&conn->lock);
         return NULL;
+    }
+    conn->active = true;
+    vlc_mutex_unlock(&conn->lock);
 
     char *payload = vlc_http_msg_format(req, &len, conn->proxy);
     if (unlikely(payload == NULL))
-        return NULL;
+        goto error;
 
     vlc_http_dbg(CO(conn), "outgoing request:\n%.*s", (int)len, payload);
     val = vlc_tls_Write(conn->conn.tls, payload, len);
     free(payload);
 
     if (val < (ssize_t)len)
-        return vlc_h1_stream_fatal(conn);
+    {
+        vlc_h1_stream_fatal(conn);
+        goto error;
+    }
 
-    conn->active = true;
     conn->content_length = 0;
     conn->connection_close = false;
     return &conn->stream;
+error:
+    vlc_mutex_lock(&conn->lock);
+    conn->active = false;
+    vlc_mutex_unlock(&conn->lock);
+    return NULL;
 }
 
 static struct vlc_http_msg *vlc_h1_stream_wait(struct vlc_http_stream *stream)
@@ -286,9 +302,12 @@ static void vlc_h1_stream_close(struct vlc_http_stream *stream, bool abort)
         /* Shut the underlying connection down and prevent reuse. */
         vlc_h1_stream_fatal(conn);
 
+    vlc_mutex_lock(&conn->lock);
     conn->active = false;
+    bool destroy = conn->released;
+    vlc_mutex_unlock(&conn->lock);
 
-    if (conn->released)
+    if (destroy)
         vlc_h1_conn_destroy(conn);
 }
 
@@ -309,6 +328,7 @@ static void vlc_h1_conn_destroy(struct vlc_h1_conn *conn)
         vlc_tls_Shutdown(conn->conn.tls, true);
         vlc_tls_Close(conn->conn.tls);
     }
+    vlc_mutex_destroy(&conn->lock);
     free(conn);
 }
 
@@ -316,10 +336,13 @@ static void vlc_h1_conn_release(struct vlc_http_conn *c)
 {
     struct vlc_h1_conn *conn = container_of(c, struct vlc_h1_conn, conn);
 
+    vlc_mutex_lock(&conn->lock);
     assert(!conn->released);
     conn->released = true;
+    bool destroy = !conn->active;
+    vlc_mutex_unlock(&conn->lock);
 
-    if (!conn->active)
+    if (destroy)
         vlc_h1_conn_destroy(conn);
 }
 
@@ -342,6 +365,7 @@ struct vlc_http_conn *vlc_h1_conn_create(void *ctx, vlc_tls_t *tls, bool proxy)
     conn->released = false;
     conn->proxy = proxy;
     conn->opaque = ctx;
+    vlc_mutex_init(&conn->lock);
 
     return &conn->conn;
 }
@@ -436,6 +436,14 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
 
     vlc_h2_conn_queue(conn, f);
 
+    unsigned weight = vlc_http_msg_get_priority(msg);
+    if (weight != 0)
+    {   /* PRIORITY is allowed in any stream state, send it right after */
+        f = vlc_h2_frame_priority(s->id, weight);
+        if (likely(f != NULL))
+            vlc_h2_conn_queue(conn, f);
+    }
+
     s->older = conn->streams;
     if (s->older != NULL)
         s->older->newer = s;
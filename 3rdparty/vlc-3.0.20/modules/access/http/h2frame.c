@@ -237,6 +237,24 @@ vlc_h2_frame_data(uint_fast32_t stream_id, const void *buf, size_t len,
     return f;
 }
 
+struct vlc_h2_frame *
+vlc_h2_frame_priority(uint_fast32_t stream_id, unsigned weight)
+{
+    struct vlc_h2_frame *f = vlc_h2_frame_alloc(VLC_H2_FRAME_PRIORITY, 0,
+                                                stream_id, 5);
+
+    assert(weight >= 1 && weight <= 256);
+
+    if (likely(f != NULL))
+    {   /* Non-exclusive dependency on the root stream */
+        uint8_t *p = vlc_h2_frame_payload(f);
+
+        SetDWBE(p, 0);
+        p[4] = weight - 1;
+    }
+    return f;
+}
+
 struct vlc_h2_frame *
 vlc_h2_frame_rst_stream(uint_fast32_t stream_id, uint_fast32_t error_code)
 {
@@ -42,6 +42,8 @@ struct vlc_h2_frame *
 vlc_h2_frame_data(uint_fast32_t stream_id, const void *buf, size_t len,
                   bool eos);
 struct vlc_h2_frame *
+vlc_h2_frame_priority(uint_fast32_t stream_id, unsigned weight);
+struct vlc_h2_frame *
 vlc_h2_frame_rst_stream(uint_fast32_t stream_id, uint_fast32_t error_code);
 struct vlc_h2_frame *vlc_h2_frame_settings(void);
 struct vlc_h2_frame *vlc_h2_frame_settings_ack(void);
@@ -390,6 +390,32 @@ static void test_preface_fail(void)
     vlc_h2_parse_destroy(p);
 }
 
+static void test_priority(void)
+{
+    static const unsigned weights[] = { 1, 16, 256 };
+
+    for (size_t i = 0; i < sizeof (weights) / sizeof (weights[0]); i++)
+    {
+        struct vlc_h2_frame *f = vlc_h2_frame_priority(STREAM_ID, weights[i]);
+        assert(f != NULL);
+        assert(vlc_h2_frame_size(f) == 9 + 5);
+
+        static const uint8_t header[] = { 0, 0, 5, 0x2, 0 };
+        assert(!memcmp(f->data, header, sizeof (header)));
+        assert(GetDWBE(f->data + 5) == STREAM_ID);
+        /* non-exclusive dependency on the root stream */
+        assert(GetDWBE(f->data + 9) == 0);
+        assert(f->data[13] == weights[i] - 1);
+
+        /* and accepted by the parser */
+        unsigned ret = test_seq(CTX, response(false), f, data(true), NULL);
+        assert(ret == 3);
+        assert(stream_header_tables == 1);
+        assert(stream_blocks == 1);
+        assert(stream_ends == 1);
+    }
+}
+
 static void test_header_block_fail(void)
 {
     struct vlc_h2_frame *hf = response(true);
@@ -447,6 +473,7 @@ int main(void)
 
     test_preface_fail();
     test_header_block_fail();
+    test_priority();
 
     test_bad_seq(CTX, globalize(response(true)), NULL);
     test_bad_seq(CTX, resize(reflag(response(true), 0x08), 0), NULL);
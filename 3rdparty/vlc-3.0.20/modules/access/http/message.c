@@ -47,6 +47,7 @@ struct vlc_http_msg
     char *path;
     char *(*headers)[2];
     unsigned count;
+    unsigned weight;
     struct vlc_http_stream *payload;
 };
 
@@ -189,6 +190,17 @@ const char *vlc_http_msg_get_path(const struct vlc_http_msg *m)
     return m->path;
 }
 
+void vlc_http_msg_set_priority(struct vlc_http_msg *m, unsigned weight)
+{
+    assert(weight <= 256);
+    m->weight = weight;
+}
+
+unsigned vlc_http_msg_get_priority(const struct vlc_http_msg *m)
+{
+    return m->weight;
+}
+
 void vlc_http_msg_destroy(struct vlc_http_msg *m)
 {
     if (m->payload != NULL)
@@ -224,6 +236,7 @@ vlc_http_req_create(const char *method, const char *scheme,
     m->path = (path != NULL) ? strdup(path) : NULL;
     m->count = 0;
     m->headers = NULL;
+    m->weight = 0;
     m->payload = NULL;
 
     if (unlikely(m->method == NULL
@@ -251,6 +264,7 @@ struct vlc_http_msg *vlc_http_resp_create(unsigned status)
     m->path = NULL;
     m->count = 0;
     m->headers = NULL;
+    m->weight = 0;
     m->payload = NULL;
     return m;
 }
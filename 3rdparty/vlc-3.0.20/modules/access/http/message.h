@@ -216,6 +216,24 @@ const char *vlc_http_msg_get_authority(const struct vlc_http_msg *);
  */
 const char *vlc_http_msg_get_path(const struct vlc_http_msg *);
 
+/**
+ * Sets request priority.
+ *
+ * Sets the relative weight of a request against other requests multiplexed
+ * on the same connection. This is only a hint to the server; it is ignored
+ * with HTTP/1.x.
+ *
+ * @param weight HTTP/2 stream weight (1-256), or 0 to leave unspecified
+ */
+void vlc_http_msg_set_priority(struct vlc_http_msg *, unsigned weight);
+
+/**
+ * Gets request priority.
+ *
+ * @return stream weight (1-256), or 0 if unspecified
+ */
+unsigned vlc_http_msg_get_priority(const struct vlc_http_msg *);
+
 /**
  * Looks up a token in a header field.
  *
@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * readahead.h: read-ahead ranges planning for the file access
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_ACCESS_READAHEAD_H
+#define VLC_ACCESS_READAHEAD_H
+
+/* Ranges announced by the demuxer (STREAM_SET_READAHEAD) are coalesced
+ * into a few large requests before they are passed to the kernel. */
+typedef struct
+{
+    uint64_t start;
+    uint64_t end;
+} file_range_t;
+
+#define FILE_RA_SLOTS 32          /* pending and recently advised ranges */
+#define FILE_RA_MERGE (256 << 10) /* gap filled to merge two ranges */
+#define FILE_RA_MAX   (8 << 20)   /* largest merged range */
+
+static inline bool file_ranges_Cover( const file_range_t *ranges,
+                                      unsigned count,
+                                      uint64_t start, uint64_t end )
+{
+    for( unsigned i = 0; i < count; i++ )
+        if( ranges[i].start <= start && end <= ranges[i].end )
+            return true;
+    return false;
+}
+
+/**
+ * Adds a range to the pending ones, oldest first: it is merged into a
+ * pending range nearby, if the result is not too large, or appended, the
+ * oldest range being dropped if all the slots are in use.
+ *
+ * \return true if the range was appended, false if it was merged
+ */
+static inline bool file_ranges_Add( file_range_t *pending, unsigned *count,
+                                    file_range_t range )
+{
+    for( unsigned i = 0; i < *count; i++ )
+    {
+        file_range_t *cur = &pending[i];
+        uint64_t start = __MIN(cur->start, range.start);
+        uint64_t end = __MAX(cur->end, range.end);
+
+        if( range.start <= cur->end + FILE_RA_MERGE
+         && cur->start <= range.end + FILE_RA_MERGE
+         && end - start <= FILE_RA_MAX )
+        {
+            cur->start = start;
+            cur->end = end;
+            return false;
+        }
+    }
+
+    if( *count == FILE_RA_SLOTS )
+    {   /* Too far behind: the oldest hint is the least useful one */
+        memmove( &pending[0], &pending[1], --(*count) * sizeof (range) );
+    }
+    pending[(*count)++] = range;
+    return true;
+}
+
+#endif
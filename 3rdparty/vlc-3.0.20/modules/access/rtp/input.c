@@ -103,6 +103,98 @@ static int rtp_timeout (vlc_tick_t deadline)
 /**
  * RTP/RTCP session thread for datagram sockets
  */
+#ifdef HAVE_RECVMMSG
+/* Datagrams received per system call */
+# define RTP_BATCH 32
+
+struct rtp_batch
+{
+    block_t *blocks[RTP_BATCH]; /**< Preallocated receive buffers */
+    size_t mru;
+};
+
+static void rtp_batch_cleanup (void *data)
+{
+    struct rtp_batch *batch = data;
+
+    for (unsigned i = 0; i < RTP_BATCH; i++)
+        if (batch->blocks[i] != NULL)
+            block_Release (batch->blocks[i]);
+}
+
+/**
+ * Receives all pending datagrams (up to RTP_BATCH) in a single call.
+ * The blocks are preallocated, and only the consumed ones are replaced.
+ * @return false if no blocks could be allocated
+ */
+static bool rtp_recv_batch (demux_t *demux, int fd, struct rtp_batch *batch,
+                            int trunc_flag)
+{
+    block_t **blocks = batch->blocks;
+    struct mmsghdr msgs[RTP_BATCH];
+    struct iovec iovs[RTP_BATCH];
+    unsigned count = 0;
+
+    while (count < RTP_BATCH)
+    {
+        if (blocks[count] == NULL)
+        {
+            blocks[count] = block_Alloc (batch->mru);
+            if (unlikely(blocks[count] == NULL))
+                break;
+        }
+
+        iovs[count].iov_base = blocks[count]->p_buffer;
+        iovs[count].iov_len = blocks[count]->i_buffer;
+        memset (&msgs[count], 0, sizeof (msgs[count]));
+        msgs[count].msg_hdr.msg_iov = &iovs[count];
+        msgs[count].msg_hdr.msg_iovlen = 1;
+        count++;
+    }
+
+    if (count == 0)
+        return false;
+
+    int n = recvmmsg (fd, msgs, count, MSG_DONTWAIT | trunc_flag, NULL);
+    if (n == -1)
+    {
+        if (errno != EAGAIN)
+            msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+        return true;
+    }
+
+    bool shrink = false;
+
+    for (int i = 0; i < n; i++)
+    {
+        block_t *block = blocks[i];
+        size_t len = msgs[i].msg_len;
+
+        blocks[i] = NULL;
+        if (msgs[i].msg_hdr.msg_flags & trunc_flag)
+        {
+            msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                    len, block->i_buffer);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            batch->mru = len;
+            shrink = true;
+        }
+        else
+            block->i_buffer = len;
+
+        rtp_process (demux, block);
+    }
+
+    if (shrink) /* the spare blocks are now too small */
+        for (unsigned i = n; i < count; i++)
+        {
+            block_Release (blocks[i]);
+            blocks[i] = NULL;
+        }
+    return true;
+}
+#endif
+
 void *rtp_dgram_thread (void *opaque)
 {
     demux_t *demux = opaque;
@@ -115,6 +207,9 @@ void *rtp_dgram_thread (void *opaque)
     const int trunc_flag = 0;
 #endif
 
+#ifdef HAVE_RECVMMSG
+    struct rtp_batch batch = { .mru = DEFAULT_MRU };
+#else
     struct iovec iov =
     {
         .iov_len = DEFAULT_MRU,
@@ -124,11 +219,15 @@ void *rtp_dgram_thread (void *opaque)
         .msg_iov = &iov,
         .msg_iovlen = 1,
     };
+#endif
 
     struct pollfd ufd[1];
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
 
+#ifdef HAVE_RECVMMSG
+    vlc_cleanup_push (rtp_batch_cleanup, &batch);
+#endif
     for (;;)
     {
         int n = poll (ufd, 1, rtp_timeout (deadline));
@@ -145,6 +244,16 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
+#ifdef HAVE_RECVMMSG
+            if (!rtp_recv_batch (demux, rtp_fd, &batch, trunc_flag))
+            {
+                if (batch.mru == DEFAULT_MRU)
+                    break; /* we are totallly screwed */
+                batch.mru = DEFAULT_MRU;
+                vlc_restorecancel (canc);
+                continue; /* retry with shrunk MRU */
+            }
+#else
             block_t *block = block_Alloc (iov.iov_len);
             if (unlikely(block == NULL))
             {
@@ -178,6 +287,7 @@ void *rtp_dgram_thread (void *opaque)
                           vlc_strerror_c(errno));
                 block_Release (block);
             }
+#endif
         }
 
     dequeue:
@@ -185,6 +295,10 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TICK_INVALID;
         vlc_restorecancel (canc);
     }
+#ifdef HAVE_RECVMMSG
+    vlc_cleanup_pop ();
+    rtp_batch_cleanup (&batch);
+#endif
     return NULL;
 }
 
@@ -37,12 +37,14 @@
 #endif
 
 #include <errno.h>
+#include <stdlib.h>
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
 #include <vlc_network.h>
 #include <vlc_block.h>
 #include <vlc_interrupt.h>
+#include <vlc_atomic.h>
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
@@ -59,6 +61,10 @@ static void Close( vlc_object_t * );
 #define BUFFER_TEXT N_("Receive buffer")
 #define BUFFER_LONGTEXT N_("UDP receive buffer size (bytes)" )
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define RCVBUF_TEXT N_("Socket receive buffer (bytes)")
+#define RCVBUF_LONGTEXT N_("Size of the kernel buffer holding the datagrams " \
+    "not read yet. Raise it for high bitrate streams if datagrams are " \
+    "dropped. 0 keeps the system default.")
 
 vlc_module_begin ()
     set_shortname( N_("UDP" ) )
@@ -69,6 +75,7 @@ vlc_module_begin ()
     add_obsolete_integer( "server-port" ) /* since 2.0.0 */
     add_obsolete_integer( "udp-buffer" ) /* since 3.0.0 */
     add_integer( "udp-timeout", -1, TIMEOUT_TEXT, NULL, true )
+    add_integer( "udp-rcvbuf", 0, RCVBUF_TEXT, RCVBUF_LONGTEXT, true )
 
     set_capability( "access", 0 )
     add_shortcut( "udp", "udpstream", "udp4", "udp6" )
@@ -76,19 +83,94 @@ vlc_module_begin ()
     set_callbacks( Open, Close )
 vlc_module_end ()
 
+#ifdef HAVE_RECVMMSG
+/* Datagrams are received in batches into a ring of preallocated slots, and
+ * handed out as blocks pointing to their slot. The stream layer copies and
+ * releases them right away, so the ring only fills up when blocks are kept
+ * further downstream; heap blocks are then used until slots are released. */
+# define UDP_RING_SLOTS 512
+# define UDP_BATCH      64
+# define UDP_RING_ALIGN 2048 /* slot size increment */
+
+struct udp_ring;
+
+struct udp_slot
+{
+    block_t          block;
+    struct udp_ring *ring;
+    atomic_bool      busy; /**< Handed out, not released yet */
+};
+
+struct udp_ring
+{
+    atomic_uint     refs; /**< Access plus handed out blocks */
+    size_t          mtu;
+    unsigned        next; /**< Next slot to receive into */
+    uint8_t        *data;
+    struct udp_slot slots[UDP_RING_SLOTS];
+};
+#endif
+
 struct access_sys_t
 {
     int fd;
     int timeout;
     size_t mtu;
+#ifdef HAVE_RECVMMSG
+    struct udp_ring *ring;
+    struct udp_slot *batch[UDP_BATCH];
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iov[UDP_BATCH];
+# ifdef SO_RXQ_OVFL
+    char cmsg[UDP_BATCH][CMSG_SPACE(sizeof (uint32_t))];
+# endif
+    unsigned batch_count; /**< Datagrams received in the batch */
+    unsigned batch_next; /**< Next datagram of the batch to hand out */
+#endif
+#ifdef SO_RXQ_OVFL
+    uint32_t drops; /**< Kernel socket drop count */
+    vlc_tick_t drops_warned;
+#endif
+    bool drops_known; /**< The kernel reports the drops */
+    struct
+    {
+        uint64_t datagrams;
+        uint64_t calls;
+        uint64_t dropped;
+        uint64_t truncated;
+        uint64_t overruns;
+    } stats;
 };
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static block_t *BlockUDP( stream_t *, bool * );
+#ifdef HAVE_RECVMMSG
+static block_t *BlockRing( stream_t *, bool * );
+static struct udp_ring *RingNew( size_t );
+static void RingRelease( struct udp_ring * );
+#endif
 static int Control( stream_t *, int, va_list );
 
+static void SetReceiveBuffer( stream_t *p_access, int fd, int size )
+{
+    if( setsockopt( fd, SOL_SOCKET, SO_RCVBUF, (void *)&size, sizeof( size ) ) )
+        msg_Warn( p_access, "cannot set receive buffer: %s",
+                  vlc_strerror_c( net_errno ) );
+#ifdef SO_RCVBUFFORCE
+    /* Privileged processes can go beyond the system maximum */
+    setsockopt( fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof( size ) );
+#endif
+
+    int val;
+    socklen_t len = sizeof( val );
+
+    if( getsockopt( fd, SOL_SOCKET, SO_RCVBUF, (void *)&val, &len ) == 0 )
+        msg_Dbg( p_access, "receive buffer is %d bytes (%d requested)",
+                 val, size );
+}
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -174,6 +256,26 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+    int rcvbuf = var_InheritInteger( p_access, "udp-rcvbuf" );
+    if( rcvbuf > 0 )
+        SetReceiveBuffer( p_access, sys->fd, rcvbuf );
+
+    memset( &sys->stats, 0, sizeof( sys->stats ) );
+    sys->drops_known = false;
+#ifdef SO_RXQ_OVFL
+    /* Report the kernel drop count along with the datagrams */
+    sys->drops_known = setsockopt( sys->fd, SOL_SOCKET, SO_RXQ_OVFL,
+                                   &(int){ 1 }, sizeof( int ) ) == 0;
+    sys->drops = 0;
+    sys->drops_warned = VLC_TICK_INVALID;
+#endif
+#ifdef HAVE_RECVMMSG
+    sys->ring = RingNew( sys->mtu );
+    if( sys->ring != NULL )
+        p_access->pf_block = BlockRing;
+    sys->batch_count = sys->batch_next = 0;
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -185,6 +287,18 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+    char dropped[24] = "unknown";
+
+    if( sys->drops_known )
+        snprintf( dropped, sizeof( dropped ), "%"PRIu64, sys->stats.dropped );
+    msg_Dbg( p_access, "received %"PRIu64" datagrams in %"PRIu64" calls, "
+             "%s dropped, %"PRIu64" truncated, %"PRIu64" ring overruns",
+             sys->stats.datagrams, sys->stats.calls, dropped,
+             sys->stats.truncated, sys->stats.overruns );
+#ifdef HAVE_RECVMMSG
+    if( sys->ring != NULL )
+        RingRelease( sys->ring ); /* blocks may still be in use downstream */
+#endif
     net_Close( sys->fd );
 }
 
@@ -218,6 +332,43 @@ static int Control( stream_t *p_access, int i_query, va_list args )
     return VLC_SUCCESS;
 }
 
+#ifdef SO_RXQ_OVFL
+/* The kernel drop count is cumulative: the latest datagram has the latest
+ * value */
+static void CheckDrops(stream_t *access, struct msghdr *msg)
+{
+    access_sys_t *sys = access->p_sys;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL)
+            continue;
+
+        uint32_t drops;
+
+        memcpy(&drops, CMSG_DATA(cmsg), sizeof (drops));
+        if (drops == sys->drops)
+            break;
+
+        sys->stats.dropped += (uint32_t)(drops - sys->drops);
+        sys->drops = drops;
+
+        vlc_tick_t now = mdate();
+        if (sys->drops_warned == VLC_TICK_INVALID
+         || now - sys->drops_warned >= CLOCK_FREQ)
+        {
+            msg_Warn(access, "%"PRIu64" datagrams dropped by the kernel, "
+                     "the receive buffer may be too small",
+                     sys->stats.dropped);
+            sys->drops_warned = now;
+        }
+        break;
+    }
+}
+#endif
+
 /*****************************************************************************
  * BlockUDP:
  *****************************************************************************/
@@ -248,6 +399,12 @@ static block_t *BlockUDP(stream_t *access, bool *restrict eof)
         .msg_iovlen = 1,
         .msg_flags = trunc_flag,
     };
+#ifdef SO_RXQ_OVFL
+    char cmsg[CMSG_SPACE(sizeof (uint32_t))];
+
+    msg.msg_control = cmsg;
+    msg.msg_controllen = sizeof (cmsg);
+#endif
 
     struct pollfd ufd[1];
 
@@ -273,15 +430,205 @@ skip:
         return NULL;
     }
 
+    sys->stats.calls++;
+    sys->stats.datagrams++;
+#ifdef SO_RXQ_OVFL
+    CheckDrops(access, &msg);
+#endif
+
     if (msg.msg_flags & trunc_flag)
     {
         msg_Err(access, "%zd bytes packet truncated (MTU was %zu)",
                 len, sys->mtu);
         pkt->i_flags |= BLOCK_FLAG_CORRUPTED;
         sys->mtu = len;
+        sys->stats.truncated++;
     }
     else
         pkt->i_buffer = len;
 
     return pkt;
 }
+
+#ifdef HAVE_RECVMMSG
+static struct udp_ring *RingNew(size_t mtu)
+{
+    struct udp_ring *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    ring->data = malloc(UDP_RING_SLOTS * mtu);
+    if (unlikely(ring->data == NULL))
+    {
+        free(ring);
+        return NULL;
+    }
+
+    atomic_init(&ring->refs, 1);
+    ring->mtu = mtu;
+    ring->next = 0;
+
+    for (unsigned i = 0; i < UDP_RING_SLOTS; i++)
+    {
+        ring->slots[i].ring = ring;
+        atomic_init(&ring->slots[i].busy, false);
+    }
+    return ring;
+}
+
+static void RingRelease(struct udp_ring *ring)
+{
+    if (atomic_fetch_sub_explicit(&ring->refs, 1, memory_order_acq_rel) == 1)
+    {
+        free(ring->data);
+        free(ring);
+    }
+}
+
+/* Larger datagrams were truncated: grows the slots, in place unless blocks
+ * are still held downstream. The size is rounded up so that slowly growing
+ * datagrams do not grow the ring every time. */
+static void RingGrow(access_sys_t *sys)
+{
+    struct udp_ring *ring = sys->ring;
+    size_t mtu = (sys->mtu + UDP_RING_ALIGN - 1)
+               & ~(size_t)(UDP_RING_ALIGN - 1);
+
+    if (atomic_load_explicit(&ring->refs, memory_order_acquire) == 1)
+    {
+        uint8_t *data = realloc(ring->data, UDP_RING_SLOTS * mtu);
+        if (likely(data != NULL))
+        {
+            ring->data = data;
+            ring->mtu = mtu;
+        }
+        return;
+    }
+
+    ring = RingNew(mtu);
+    if (likely(ring != NULL))
+    {
+        RingRelease(sys->ring);
+        sys->ring = ring;
+    }
+}
+
+static void RingSlotRelease(block_t *block)
+{
+    struct udp_slot *slot = container_of(block, struct udp_slot, block);
+    struct udp_ring *ring = slot->ring;
+
+    atomic_store_explicit(&slot->busy, false, memory_order_release);
+    RingRelease(ring);
+}
+
+/* Sets the batch up with the free slots following the last used one */
+static unsigned RingPrepare(access_sys_t *sys)
+{
+    struct udp_ring *ring = sys->ring;
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < UDP_RING_SLOTS && n < UDP_BATCH; i++)
+    {
+        unsigned idx = ring->next;
+        struct udp_slot *slot = &ring->slots[idx];
+
+        ring->next = (idx + 1) % UDP_RING_SLOTS;
+        if (atomic_load_explicit(&slot->busy, memory_order_acquire))
+            continue;
+
+        sys->batch[n] = slot;
+        sys->iov[n].iov_base = ring->data + idx * ring->mtu;
+        sys->iov[n].iov_len = ring->mtu;
+        memset(&sys->msgs[n].msg_hdr, 0, sizeof (sys->msgs[n].msg_hdr));
+        sys->msgs[n].msg_hdr.msg_iov = &sys->iov[n];
+        sys->msgs[n].msg_hdr.msg_iovlen = 1;
+# ifdef SO_RXQ_OVFL
+        sys->msgs[n].msg_hdr.msg_control = sys->cmsg[n];
+        sys->msgs[n].msg_hdr.msg_controllen = sizeof (sys->cmsg[n]);
+# endif
+        n++;
+    }
+    return n;
+}
+
+static block_t *BlockRing(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->batch_next >= sys->batch_count)
+    {
+        if (unlikely(sys->ring->mtu < sys->mtu))
+            RingGrow(sys);
+
+        unsigned n = RingPrepare(sys);
+        if (n == 0)
+        {   /* All slots are still held downstream */
+            sys->stats.overruns++;
+            return BlockUDP(access, eof);
+        }
+
+        struct pollfd ufd[1];
+
+        ufd[0].fd = sys->fd;
+        ufd[0].events = POLLIN;
+
+        switch (vlc_poll_i11e(ufd, 1, sys->timeout))
+        {
+            case 0:
+                msg_Err(access, "receive time-out");
+                *eof = true;
+                /* fall through */
+            case -1:
+                return NULL;
+        }
+
+# ifdef __linux__
+        const int trunc_flag = MSG_TRUNC;
+# else
+        const int trunc_flag = 0;
+# endif
+        int val = recvmmsg(sys->fd, sys->msgs, n, MSG_DONTWAIT | trunc_flag,
+                           NULL);
+        if (val <= 0)
+        {
+            if (val < 0 && errno != EAGAIN && errno != EWOULDBLOCK
+             && errno != EINTR)
+                msg_Err(access, "receive error: %s", vlc_strerror_c(errno));
+            return NULL;
+        }
+
+        sys->batch_count = val;
+        sys->batch_next = 0;
+        sys->stats.calls++;
+        sys->stats.datagrams += val;
+# ifdef SO_RXQ_OVFL
+        CheckDrops(access, &sys->msgs[val - 1].msg_hdr);
+# endif
+    }
+
+    unsigned i = sys->batch_next++;
+    struct udp_slot *slot = sys->batch[i];
+    const struct mmsghdr *msg = &sys->msgs[i];
+    block_t *pkt = &slot->block;
+
+    block_Init(pkt, sys->iov[i].iov_base, sys->iov[i].iov_len);
+    pkt->pf_release = RingSlotRelease;
+    atomic_store_explicit(&slot->busy, true, memory_order_relaxed);
+    atomic_fetch_add_explicit(&sys->ring->refs, 1, memory_order_relaxed);
+
+    if (msg->msg_hdr.msg_flags & MSG_TRUNC)
+    {
+        msg_Err(access, "%u bytes packet truncated (MTU was %zu)",
+                msg->msg_len, sys->ring->mtu);
+        pkt->i_flags |= BLOCK_FLAG_CORRUPTED;
+        if (msg->msg_len > sys->mtu)
+            sys->mtu = msg->msg_len;
+        sys->stats.truncated++;
+    }
+    else
+        pkt->i_buffer = msg->msg_len;
+
+    return pkt;
+}
+#endif
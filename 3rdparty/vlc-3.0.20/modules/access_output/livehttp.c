@@ -105,6 +105,11 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define WRITERQUEUE_TEXT N_("Segments queued for writing")
+#define WRITERQUEUE_LONGTEXT N_("Number of complete segments that can wait "\
+                                "to be encrypted and written to disk before "\
+                                "the stream is held back")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -115,6 +120,8 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "seglen", 10, SEGLEN_TEXT, SEGLEN_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "numsegs", 0, NUMSEGS_TEXT, NUMSEGS_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "initial-segment-number", 1, INTITIAL_SEG_TEXT, INITIAL_SEG_LONGTEXT, false )
+    add_integer_with_range( SOUT_CFG_PREFIX "writer-queue", 3, 1, 100,
+                            WRITERQUEUE_TEXT, WRITERQUEUE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "splitanywhere", false,
               SPLITANYWHERE_TEXT, SPLITANYWHERE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "delsegs", true,
@@ -156,6 +163,7 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "writer-queue",
     NULL
 };
 
@@ -173,8 +181,19 @@ typedef struct output_segment
     uint8_t aes_ivs[16];
 } output_segment_t;
 
+/* Work handed over to the writer thread, in stream order */
+typedef struct output_job
+{
+    struct output_job *p_next;
+    bool b_close;        /* close the segment, otherwise open a new one */
+    bool b_isend;
+    float f_seglen;
+    block_t *p_data;     /* data of the segment being closed */
+} output_job_t;
+
 struct sout_access_out_sys_t
 {
+    /* Owned by the writer thread: segment files, encryption and index */
     char *psz_cursegPath;
     char *psz_indexPath;
     char *psz_indexUrl;
@@ -205,12 +224,28 @@ struct sout_access_out_sys_t
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+
+    /* Owned by the stream thread: segment boundaries */
+    bool b_segment_open;
+    float f_streamlen;
+
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;            /* jobs were queued */
+    vlc_cond_t space;           /* a segment was written */
+    output_job_t *jobs;
+    output_job_t **jobs_end;
+    unsigned i_queued;          /* segments waiting to be written */
+    unsigned i_queue_max;
+    bool b_error;
+    bool b_closing;
 };
 
 static int LoadCryptFile( sout_access_out_t *p_access);
 static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
-static ssize_t writeSegment( sout_access_out_t *p_access );
+static ssize_t writeSegment( sout_access_out_t *p_access, block_t *output );
+static void *WriterThread( void * );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
 /*****************************************************************************
  * Open: open the file
@@ -250,6 +285,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
     p_sys->b_segment_has_data = false;
+    p_sys->i_queue_max = var_GetInteger( p_access, SOUT_CFG_PREFIX "writer-queue" );
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -301,6 +337,35 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
 
+    p_sys->b_segment_open = false;
+    p_sys->f_streamlen = 0.f;
+    vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( &p_sys->wait );
+    vlc_cond_init( &p_sys->space );
+    p_sys->jobs = NULL;
+    p_sys->jobs_end = &p_sys->jobs;
+    p_sys->i_queued = 0;
+    p_sys->b_error = false;
+    p_sys->b_closing = false;
+
+    if( vlc_clone( &p_sys->thread, WriterThread, p_access,
+                   VLC_THREAD_PRIORITY_OUTPUT ) )
+    {
+        vlc_cond_destroy( &p_sys->space );
+        vlc_cond_destroy( &p_sys->wait );
+        vlc_mutex_destroy( &p_sys->lock );
+        if( p_sys->key_uri )
+        {
+            gcry_cipher_close( p_sys->aes_ctx );
+            free( p_sys->key_uri );
+        }
+        free( p_sys->psz_keyfile );
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
@@ -667,6 +732,11 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
             }
 
         }
+#ifdef HAVE_FSYNC
+        /* make sure the new index is complete before it replaces the old */
+        if( fflush( fp ) == 0 )
+            fsync( fileno( fp ) );
+#endif
         fclose( fp );
 
         val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
@@ -710,6 +780,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
+    /* called from the writer thread */
     if ( p_sys->i_handle >= 0 )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
@@ -754,6 +825,133 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
     }
 }
 
+/*****************************************************************************
+ * WriterThread: open, encrypt, write and close segments, update the index
+ *****************************************************************************/
+static bool runJob( sout_access_out_t *p_access, output_job_t *job )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( !job->b_close )
+        return openNextFile( p_access, p_sys ) >= 0;
+
+    if( p_sys->i_handle < 0 )
+    {
+        /* opening that segment failed, it was reported already */
+        if( job->p_data )
+            block_ChainRelease( job->p_data );
+        return true;
+    }
+
+    ssize_t val = writeSegment( p_access, job->p_data );
+    msg_Dbg( p_access, "Writing.. %zd", val );
+
+    p_sys->f_seglen = job->f_seglen;
+    closeCurrentSegment( p_access, p_sys, job->b_isend );
+    return val >= 0;
+}
+
+static void *WriterThread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        while( p_sys->jobs == NULL && !p_sys->b_closing )
+            vlc_cond_wait( &p_sys->wait, &p_sys->lock );
+
+        output_job_t *job = p_sys->jobs;
+        if( job == NULL )
+            break;
+        p_sys->jobs = job->p_next;
+        if( p_sys->jobs == NULL )
+            p_sys->jobs_end = &p_sys->jobs;
+        vlc_mutex_unlock( &p_sys->lock );
+
+        bool b_ok = runJob( p_access, job );
+
+        vlc_mutex_lock( &p_sys->lock );
+        if( !b_ok )
+            p_sys->b_error = true;
+        if( job->b_close )
+        {
+            p_sys->i_queued--;
+            vlc_cond_signal( &p_sys->space );
+        }
+        free( job );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
+/*****************************************************************************
+ * queueJob: hand work over to the writer thread
+ *****************************************************************************/
+static int queueJob( sout_access_out_t *p_access, bool b_close, bool b_isend,
+                     block_t *p_data )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    output_job_t *job = malloc( sizeof( *job ) );
+
+    if( unlikely( job == NULL ) )
+    {
+        if( p_data )
+            block_ChainRelease( p_data );
+        return -1;
+    }
+    job->p_next = NULL;
+    job->b_close = b_close;
+    job->b_isend = b_isend;
+    job->f_seglen = p_sys->f_streamlen;
+    job->p_data = p_data;
+
+    int canc = vlc_savecancel();
+    vlc_mutex_lock( &p_sys->lock );
+    /* Only hold the stream back when the disk cannot keep up at all */
+    while( b_close && p_sys->i_queued >= p_sys->i_queue_max )
+        vlc_cond_wait( &p_sys->space, &p_sys->lock );
+    if( b_close )
+        p_sys->i_queued++;
+    *p_sys->jobs_end = job;
+    p_sys->jobs_end = &job->p_next;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+    vlc_restorecancel( canc );
+    return 0;
+}
+
+/*****************************************************************************
+ * queueSegmentClose: queue the full segments and the close of the segment
+ *****************************************************************************/
+static ssize_t queueSegmentClose( sout_access_out_t *p_access, bool b_isend )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    block_t *output = p_sys->full_segments;
+    ssize_t i_size = 0;
+
+    if( output )
+    {
+        block_t *last = output;
+
+        for( block_t *p = output; p != NULL; p = p->p_next )
+        {
+            i_size += p->i_buffer;
+            last = p;
+        }
+        p_sys->f_streamlen =
+            (float)(output->i_length + last->i_dts - p_sys->i_opendts) / CLOCK_FREQ;
+    }
+    p_sys->full_segments = NULL;
+    p_sys->full_segments_end = &p_sys->full_segments;
+    p_sys->b_segment_open = false;
+
+    if( queueJob( p_access, true, b_isend, output ) < 0 )
+        return -1;
+    return i_size;
+}
+
 /*****************************************************************************
  * Close: close the target
  *****************************************************************************/
@@ -786,17 +984,18 @@ static void Close( vlc_object_t * p_this )
         p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
     }
 
-    ssize_t writevalue = writeSegment( p_access );
-    msg_Dbg( p_access, "Writing.. %zd", writevalue );
-    if( unlikely( writevalue < 0 ) )
-    {
-        if( p_sys->full_segments )
-            block_ChainRelease( p_sys->full_segments );
-        if( p_sys->ongoing_segment )
-            block_ChainRelease( p_sys->ongoing_segment );
-    }
+    /* the writer flushes the last segment and ends the index */
+    queueSegmentClose( p_access, true );
 
-    closeCurrentSegment( p_access, p_sys, true );
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_closing = true;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    vlc_join( p_sys->thread, NULL );
+    vlc_cond_destroy( &p_sys->space );
+    vlc_cond_destroy( &p_sys->wait );
+    vlc_mutex_destroy( &p_sys->lock );
 
     if( p_sys->key_uri )
     {
@@ -817,6 +1016,7 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    free( p_sys->psz_keyfile );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -899,7 +1099,6 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     p_sys->psz_cursegPath = strdup(segment->psz_filename);
     p_sys->i_handle = fd;
     p_sys->i_segment = i_newseg;
-    p_sys->b_segment_has_data = false;
     return fd;
 }
 /*****************************************************************************
@@ -910,20 +1109,19 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     ssize_t writevalue = 0;
 
-    if( p_sys->i_handle > 0 && p_sys->b_segment_has_data &&
+    if( p_sys->b_segment_open && p_sys->b_segment_has_data &&
        (( p_buffer->i_length + p_buffer->i_dts - p_sys->i_opendts ) >= p_sys->i_seglenm ) )
     {
-        writevalue = writeSegment( p_access );
+        writevalue = queueSegmentClose( p_access, false );
         if( unlikely( writevalue < 0 ) )
         {
             block_ChainRelease ( p_buffer );
             return -1;
         }
-        closeCurrentSegment( p_access, p_sys, false );
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !p_sys->b_segment_open ) )
     {
         p_sys->i_opendts = p_buffer->i_dts;
 
@@ -935,26 +1133,20 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
 
         msg_Dbg( p_access, "Setting new opendts %"PRId64, p_sys->i_opendts );
 
-        if ( openNextFile( p_access, p_sys ) < 0 )
+        if ( queueJob( p_access, false, false, NULL ) < 0 )
            return -1;
+        p_sys->b_segment_open = true;
+        /* Owned by Write(), not by the writer thread opening the file */
+        p_sys->b_segment_has_data = false;
     }
     return writevalue;
 }
 
-static ssize_t writeSegment( sout_access_out_t *p_access )
+static ssize_t writeSegment( sout_access_out_t *p_access, block_t *output )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     msg_Dbg( p_access, "Writing all full segments" );
 
-    block_t *output = p_sys->full_segments;
-    vlc_tick_t output_last_length = 0;
-    if( output )
-        output_last_length = output->i_length;
-    if( *p_sys->full_segments_end )
-        output_last_length = (*p_sys->full_segments_end)->i_length;
-    p_sys->full_segments = NULL;
-    p_sys->full_segments_end = &p_sys->full_segments;
-
     ssize_t i_write=0;
     bool encrypted = false;
     while( output )
@@ -963,9 +1155,14 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
         {
             if( p_sys->stuffing_size )
             {
+                block_t *p_next = output->p_next;
                 output = block_Realloc( output, p_sys->stuffing_size, output->i_buffer );
                 if( unlikely(!output ) )
+                {
+                    block_ChainRelease( p_next );
                     return VLC_ENOMEM;
+                }
+                output->p_next = p_next;
                 memcpy( output->p_buffer, p_sys->stuffing_bytes, p_sys->stuffing_size );
                 p_sys->stuffing_size = 0;
             }
@@ -984,6 +1181,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
             if( err )
             {
                 msg_Err( p_access, "Encryption failure: %s ", gpg_strerror(err) );
+                block_ChainRelease( output );
                 return -1;
             }
             encrypted=true;
@@ -995,13 +1193,10 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
         {
            if ( errno == EINTR )
               continue;
+           block_ChainRelease( output );
            return -1;
         }
 
-        p_sys->f_seglen =
-            (float)(output_last_length +
-                    output->i_dts - p_sys->i_opendts) / CLOCK_FREQ;
-
         if ( (size_t)val >= output->i_buffer )
         {
            block_t *p_next = output->p_next;
@@ -1026,6 +1221,18 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     size_t i_write = 0;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    bool b_error = p_sys->b_error;
+    p_sys->b_error = false;
+    vlc_mutex_unlock( &p_sys->lock );
+    if( unlikely( b_error ) )
+    {
+        msg_Err( p_access, "Error in segment writer" );
+        block_ChainRelease( p_buffer );
+        return -1;
+    }
+
     while( p_buffer )
     {
         /* Check if current block is already past segment-length
@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "logic/BufferingLogic.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
@@ -83,6 +84,7 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     cached.playlistEnd = 0;
     cached.playlistLength = 0;
     cached.lastupdate = 0;
+    cached.lastlatencyreport = 0;
 }
 
 PlaylistManager::~PlaylistManager   ()
@@ -119,6 +121,9 @@ bool PlaylistManager::setupPeriod()
     if(!bufferingLogic && !(bufferingLogic = createBufferingLogic()))
         return false;
 
+    if(playlist->isLive())
+        resources->getConnManager()->setLowLatency(bufferingLogic->isLowLatency(playlist));
+
     const std::vector<BaseAdaptationSet*> &sets = currentPeriod->getAdaptationSets();
     for(BaseAdaptationSet *set : sets)
     {
@@ -705,9 +710,10 @@ void PlaylistManager::setBufferingRunState(bool b)
 void PlaylistManager::Run()
 {
     vlc_mutex_lock(&lock);
-    const vlc_tick_t i_min_buffering = bufferingLogic->getMinBuffering(playlist);
-    const vlc_tick_t i_max_buffering = bufferingLogic->getMaxBuffering(playlist);
-    const vlc_tick_t i_target_buffering = bufferingLogic->getStableBuffering(playlist);
+    vlc_tick_t i_min_buffering = bufferingLogic->getMinBuffering(playlist);
+    vlc_tick_t i_max_buffering = bufferingLogic->getMaxBuffering(playlist);
+    vlc_tick_t i_target_buffering = bufferingLogic->getStableBuffering(playlist);
+    const bool b_lowlatency = playlist->isLive() && bufferingLogic->isLowLatency(playlist);
     while(1)
     {
         while(!b_buffering && !b_canceled)
@@ -715,6 +721,15 @@ void PlaylistManager::Run()
         if (b_canceled)
             break;
 
+        if(b_lowlatency)
+        {
+            /* Follow the live edge as close as the delivery jitter allows */
+            bufferingLogic->setDeliveryJitter(resources->getConnManager()->getDeliveryJitter());
+            i_min_buffering = bufferingLogic->getMinBuffering(playlist);
+            i_max_buffering = bufferingLogic->getMaxBuffering(playlist);
+            i_target_buffering = bufferingLogic->getStableBuffering(playlist);
+        }
+
         if(needsUpdate())
         {
             if(updatePlaylist())
@@ -805,6 +820,26 @@ void PlaylistManager::updateControlsPosition()
                       cached.playlistStart, cached.playlistEnd, cached.playlistEnd,
                       startTimes.segment.media, startTimes.segment.demux));
 
+    /* Display times are only set when wall clock anchored, by the HLS
+     * program date time or the DASH availability start time */
+    if(cached.b_live && currentTimes.segment.display != VLC_TICK_INVALID &&
+       now - cached.lastlatencyreport >= 5)
+    {
+        /* Wall clock time of the picture being displayed: demuxed time,
+         * minus what the output still buffers */
+        struct timespec ts;
+        vlc_tick_t i_system, i_delay;
+        if(timespec_get(&ts, TIME_UTC) == TIME_UTC &&
+           es_out_ControlGetPcrSystem(p_demux->out, &i_system, &i_delay) == VLC_SUCCESS)
+        {
+            const vlc_tick_t i_now = VLC_TICK_0 + CLOCK_FREQ * ts.tv_sec + ts.tv_nsec / 1000;
+            cached.lastlatencyreport = now;
+            msg_Dbg(p_demux, "live latency %" PRId64 "ms (delivery jitter %" PRId64 "ms)",
+                    (i_now - currentTimes.segment.display + i_delay) / 1000,
+                    resources->getConnManager()->getDeliveryJitter() / 1000);
+        }
+    }
+
     if(cached.b_live)
     {
         /* Special case for live until we can provide relative start to fully match
@@ -888,6 +923,15 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             logic = noplogic;
             break;
         }
+        case AbstractAdaptationLogic::LogicType::Hybrid:
+        {
+            HybridAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(obj);
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
+        }
         case AbstractAdaptationLogic::LogicType::Predictive:
         {
             AbstractAdaptationLogic *predictivelogic =
@@ -926,6 +970,9 @@ AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
     DefaultBufferingLogic *bl = new DefaultBufferingLogic();
     if(bl)
     {
+        int lowlatency = var_InheritInteger(p_demux, "adaptive-lowlatency");
+        if(lowlatency != -1)
+            bl->setLowDelay(lowlatency == 1);
         unsigned v = var_InheritInteger(p_demux, "adaptive-livedelay");
         if(v)
             bl->setUserLiveDelay(CLOCK_FREQ / 1000 * v);
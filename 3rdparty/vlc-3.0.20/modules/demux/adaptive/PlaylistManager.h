@@ -138,6 +138,7 @@ namespace adaptive
                 vlc_tick_t  playlistEnd;
                 vlc_tick_t  playlistLength;
                 time_t      lastupdate;
+                time_t      lastlatencyreport;
             } cached;
 
             SynchronizationReferences synchronizationReferences;
@@ -24,11 +24,13 @@
 
 #include "SegmentTracker.hpp"
 #include "SharedResources.hpp"
+#include "http/HTTPConnectionManager.h"
 #include "playlist/BasePlaylist.hpp"
 #include "playlist/BaseRepresentation.h"
 #include "playlist/BaseAdaptationSet.h"
 #include "playlist/Segment.h"
 #include "playlist/SegmentChunk.hpp"
+#include "playlist/SegmentTemplate.h"
 #include "logic/AbstractAdaptationLogic.h"
 #include "logic/BufferingLogic.hpp"
 
@@ -330,7 +332,18 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
     vlc_tick_t displayTime = datasegment->getDisplayTime();
     /* timings belong to timeline and are not set on the segment or need profile timescale */
     if(pos.rep->getPlaybackTimeDurationBySegmentNumber(pos.number, &startTime, &duration))
+    {
+        /* Live number based templates start at the availability start time,
+         * which gives their wall clock time */
+        const BasePlaylist *playlist = pos.rep->getPlaylist();
+        const SegmentTemplate *templ = pos.rep->inheritSegmentTemplate();
+        if(displayTime == VLC_TICK_INVALID && playlist->isLive() &&
+           playlist->availabilityStartTime.Get() > 0 &&
+           templ && !templ->inheritSegmentTimeline())
+            displayTime = VLC_TICK_0 + playlist->availabilityStartTime.Get() +
+                          pos.rep->getPeriodStart() + startTime;
         startTime += VLC_TICK_0;
+    }
 
     return ChunkEntry(segmentChunk, pos, startTime, duration, displayTime);
 }
@@ -576,12 +589,17 @@ void SegmentTracker::updateSynchronizationReference(uint64_t discontinuitysequen
 void SegmentTracker::notifyBufferingState(bool enabled) const
 {
     notify(BufferingStateUpdatedEvent(adaptationSet->getID(), enabled));
+    if(!enabled)
+        resources->getConnManager()->updateBufferingLevel(adaptationSet->getID(),
+                                                          VLC_TICK_INVALID);
 }
 
 void SegmentTracker::notifyBufferingLevel(vlc_tick_t min, vlc_tick_t max,
                                           vlc_tick_t current, vlc_tick_t target) const
 {
     notify(BufferingLevelChangedEvent(adaptationSet->getID(), min, max, current, target));
+    /* Lets the downloader serve the starving tracks first */
+    resources->getConnManager()->updateBufferingLevel(adaptationSet->getID(), current);
 }
 
 void SegmentTracker::registerListener(SegmentTrackerListenerInterface *listener)
@@ -25,6 +25,7 @@
 #include "http/AuthStorage.hpp"
 #include "http/HTTPConnectionManager.h"
 #include "http/HTTPConnection.hpp"
+#include "http/SegmentCache.hpp"
 #include "encryption/Keyring.hpp"
 
 using namespace adaptive;
@@ -64,10 +65,16 @@ SharedResources * SharedResources::createDefault(vlc_object_t *obj,
 {
     AuthStorage *auth = new AuthStorage(obj);
     Keyring *keyring = new Keyring(obj);
-    HTTPConnectionManager *m = new HTTPConnectionManager(obj);
+    HTTPConnectionManager *m =
+            new HTTPConnectionManager(obj, var_InheritInteger(obj, "adaptive-connections"));
     if(!var_InheritBool(obj, "adaptive-use-access")) /* only use http from access */
-        m->addFactory(new LibVLCHTTPConnectionFactory(auth));
+        m->addFactory(new LibVLCHTTPConnectionFactory(auth,
+                                     var_InheritBool(obj, "adaptive-http2")));
     m->addFactory(new StreamUrlConnectionFactory());
+    int64_t i_cachesize = var_InheritInteger(obj, "adaptive-cache-size");
+    std::string cachedir = SegmentCache::defaultDirectory();
+    if(i_cachesize > 0 && !cachedir.empty())
+        m->setSegmentCache(new SegmentCache(obj, cachedir, i_cachesize << 20));
     ConnectionParams params(playlisturl);
     if(params.isLocal())
         m->setLocalConnectionsAllowed();
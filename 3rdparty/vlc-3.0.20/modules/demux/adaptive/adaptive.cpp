@@ -82,6 +82,19 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_CONNECTIONS_TEXT N_("Connections per server")
+#define ADAPT_CONNECTIONS_LONGTEXT N_("Maximum number of segments downloaded "\
+    "simultaneously")
+
+#define ADAPT_HTTP2_TEXT N_("Multiplex HTTP requests")
+#define ADAPT_HTTP2_LONGTEXT N_("Shares a single HTTP/2 connection per server "\
+    "between all the tracks, with audio requests prioritized. Plain HTTP "\
+    "servers must support HTTP/2 without TLS (h2c).")
+
+#define ADAPT_CACHE_TEXT N_("Segments cache size (MiB)")
+#define ADAPT_CACHE_LONGTEXT N_("Keeps the downloaded segments on disk, up to "\
+    "this size, to play them again without downloading. 0 disables the cache.")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
@@ -89,6 +102,7 @@ static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::LogicType::Default,
                                 AbstractAdaptationLogic::LogicType::Predictive,
                                 AbstractAdaptationLogic::LogicType::NearOptimal,
+                                AbstractAdaptationLogic::LogicType::Hybrid,
                                 AbstractAdaptationLogic::LogicType::RateBased,
                                 AbstractAdaptationLogic::LogicType::FixedRate,
                                 AbstractAdaptationLogic::LogicType::AlwaysLowest,
@@ -98,6 +112,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -106,6 +121,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Buffer and Throughput Hybrid"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -137,6 +153,11 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_integer_with_range( "adaptive-connections", 2, 1, 8,
+                     ADAPT_CONNECTIONS_TEXT, ADAPT_CONNECTIONS_LONGTEXT, true );
+        add_bool   ( "adaptive-http2", false, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true );
+        add_integer( "adaptive-cache-size", 0,
+                     ADAPT_CACHE_TEXT, ADAPT_CACHE_LONGTEXT, true );
         add_integer( "adaptive-livedelay",
                      AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING / 1000,
                      ADAPT_BUFFER_TEXT, ADAPT_BUFFER_LONGTEXT, true );
@@ -210,7 +231,7 @@ static int Open(vlc_object_t *p_obj)
     else
     {
         /* Handle XML Based ones */
-        DOMParser xmlParser; /* Share that xml reader */
+        DOMParser xmlParser; /* Share that parser */
         if(dashmime)
         {
             p_manager = HandleDash(p_demux, xmlParser, playlisturl, logic);
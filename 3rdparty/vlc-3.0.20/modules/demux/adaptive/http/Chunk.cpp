@@ -42,6 +42,7 @@ AbstractChunkSource::AbstractChunkSource(ChunkType t, const BytesRange &range)
     type = t;
     contentLength = 0;
     requeststatus = RequestStatus::Success;
+    priority = 0;
     bytesRange = range;
     if(bytesRange.isValid() && bytesRange.getEndByte())
         contentLength = bytesRange.getEndByte() - bytesRange.getStartByte();
@@ -77,6 +78,16 @@ ChunkType AbstractChunkSource::getChunkType() const
     return type;
 }
 
+unsigned AbstractChunkSource::getPriority() const
+{
+    return priority;
+}
+
+void AbstractChunkSource::setPriority(unsigned p)
+{
+    priority = p;
+}
+
 AbstractChunk::AbstractChunk(AbstractChunkSource *source_)
 {
     bytesRead = 0;
@@ -224,7 +235,10 @@ block_t * HTTPChunkSource::read(size_t readsize)
         return nullptr;
     }
 
+    const vlc_tick_t readStart = mdate();
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    if(ret > 0 && type == ChunkType::Segment)
+        connManager->updateDownloadProgress(ret, readStart, mdate());
     if(ret < 0)
     {
         block_Release(p_block);
@@ -278,6 +292,11 @@ void HTTPChunkSource::setIdentifier(const std::string &s, const BytesRange &r)
     storeid =  makeStorageID(s, r);
 }
 
+const std::string & HTTPChunkSource::getHostname() const
+{
+    return params.getHostname();
+}
+
 bool HTTPChunkSource::prepare()
 {
     if(prepared)
@@ -287,6 +306,7 @@ bool HTTPChunkSource::prepare()
         return false;
 
     ConnectionParams connparams = params; /* can be changed on 301 */
+    connparams.setPriority(priority);
 
     requestStartTime = mdate();
 
@@ -300,12 +320,21 @@ bool HTTPChunkSource::prepare()
                 break;
         }
 
-        requeststatus = connection->request(connparams.getPath(), bytesRange);
+        requeststatus = connection->request(connparams.getPath(), bytesRange,
+                                            conditions.isValid() ? &conditions : nullptr);
+        if(requeststatus == RequestStatus::NotModified)
+        {
+            /* nothing to read, the local copy is used instead */
+            prepared = true;
+            responseTime = mdate();
+            return true;
+        }
         if(requeststatus != RequestStatus::Success)
         {
             if(requeststatus == RequestStatus::Redirection)
             {
                 connparams = connection->getRedirection();
+                connparams.setPriority(priority);
                 connection->setUsed(false);
                 connection = nullptr;
                 if(!connparams.getUrl().empty())
@@ -345,6 +374,15 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     held = false;
     p_read = nullptr;
     inblockreadoffset = 0;
+    p_cached = nullptr;
+    fromcache = false;
+    revalidated = false;
+    cacheaccounted = false;
+    progressive = manager->isLowLatency() && type == ChunkType::Segment;
+    lastArrival = VLC_TICK_INVALID;
+    maxArrivalGap = 0;
+    receivedBytes = 0;
+    receivingTime = 0;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -364,6 +402,8 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         p_read = nullptr;
         pp_tail = &p_head;
     }
+    if(p_cached)
+        block_ChainRelease(p_cached);
     buffered = 0;
     vlc_mutex_unlock(&lock);
 
@@ -376,6 +416,44 @@ bool HTTPChunkBufferedSource::isDone() const
     return done;
 }
 
+bool HTTPChunkBufferedSource::isComplete() const
+{
+    vlc_mutex_locker locker( &lock );
+    if(!done || fromcache || requeststatus != RequestStatus::Success || !buffered)
+        return false;
+    /* chunked or compressed transfers have no usable length */
+    if(contentLength > 0 && contentLength != SIZE_MAX)
+        return buffered == contentLength;
+    return connection && connection->isBodyComplete();
+}
+
+void HTTPChunkBufferedSource::setCachedData(block_t *p_data, const std::string &type,
+                                            const CacheValidators &validators)
+{
+    vlc_mutex_locker locker( &lock );
+    p_cached = p_data;
+    cachedType = type;
+    conditions = validators;
+}
+
+void HTTPChunkBufferedSource::useCachedData()
+{
+    p_head = p_cached;
+    p_cached = nullptr;
+    buffered = 0;
+    for(block_t *p = p_head; p; p = p->p_next)
+    {
+        buffered += p->i_buffer;
+        pp_tail = &p->p_next;
+    }
+    contentLength = buffered;
+    p_read = p_head;
+    inblockreadoffset = 0;
+    fromcache = true;
+    done = true;
+    vlc_cond_signal(&avail);
+}
+
 void HTTPChunkBufferedSource::hold()
 {
     vlc_mutex_locker locker( &lock );
@@ -392,6 +470,13 @@ void HTTPChunkBufferedSource::release()
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     vlc_mutex_lock(&lock);
+    if(p_cached && conditions.isFresh(time(nullptr)))
+    {   /* no need to ask the server */
+        useCachedData();
+        vlc_mutex_unlock(&lock);
+        return;
+    }
+
     if(!prepare())
     {
         done = true;
@@ -401,6 +486,15 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         return;
     }
 
+    if(requeststatus == RequestStatus::NotModified)
+    {
+        requeststatus = RequestStatus::Success;
+        revalidated = true;
+        useCachedData();
+        vlc_mutex_unlock(&lock);
+        return;
+    }
+
     if(readsize < HTTPChunkSource::CHUNK_SIZE)
         readsize = HTTPChunkSource::CHUNK_SIZE;
 
@@ -423,7 +517,14 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         vlc_tick_t latency;
     } rate = {0,0,0};
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    const vlc_tick_t readStart = mdate();
+    ssize_t ret = progressive ? connection->readPartial(p_block->p_buffer, readsize)
+                              : connection->read(p_block->p_buffer, readsize);
+    const vlc_tick_t readEnd = mdate();
+    /* Reading chunks as they come, a partial read blocked for long was
+     * waiting for the live encoder, and tells nothing about the link */
+    const bool receiving = ret > 0 && (!progressive || (size_t) ret == readsize ||
+                                       readEnd - readStart < ENCODER_WAIT);
     if(ret <= 0)
     {
         block_Release(p_block);
@@ -446,7 +547,22 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             p_read = p_block;
             inblockreadoffset = 0;
         }
-        if((size_t) ret < readsize)
+        if(progressive)
+        {
+            /* how long the demuxer had to wait for this data */
+            const vlc_tick_t now = mdate();
+            if(lastArrival != VLC_TICK_INVALID && now - lastArrival > maxArrivalGap)
+                maxArrivalGap = now - lastArrival;
+            lastArrival = now;
+            if(receiving)
+            {
+                receivedBytes += ret;
+                receivingTime += readEnd - readStart;
+            }
+        }
+        /* short reads are the end, unless reading chunks as they come */
+        if(progressive ? (contentLength && buffered >= contentLength)
+                       : (size_t) ret < readsize)
         {
             done = true;
             downloadEndTime = mdate();
@@ -456,10 +572,22 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         }
     }
 
+    if(receiving && type == ChunkType::Segment)
+        connManager->updateDownloadProgress(ret, readStart, readEnd);
+
+    /* the whole transfer was paced by the encoder: only count the bursts */
+    if(rate.size && progressive && receivingTime)
+    {
+        rate.size = receivedBytes;
+        rate.time = receivingTime;
+    }
+
     if(rate.size && rate.time && type == ChunkType::Segment)
     {
         connManager->updateDownloadRate(sourceid, rate.size,
                                         rate.time, rate.latency);
+        if(progressive)
+            connManager->updateDeliveryJitter(sourceid, maxArrivalGap);
     }
 
     vlc_cond_signal(&avail);
@@ -471,6 +599,16 @@ bool HTTPChunkBufferedSource::hasMoreData() const
     return !eof;
 }
 
+std::string HTTPChunkBufferedSource::getContentType() const
+{
+    {
+        vlc_mutex_locker locker( &lock );
+        if(fromcache)
+            return cachedType;
+    }
+    return HTTPChunkSource::getContentType();
+}
+
 void HTTPChunkBufferedSource::recycle()
 {
     p_read = p_head;
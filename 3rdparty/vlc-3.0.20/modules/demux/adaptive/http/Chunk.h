@@ -74,6 +74,8 @@ namespace adaptive
                 const BytesRange &  getBytesRange   () const;
                 ChunkType           getChunkType    () const;
                 const StorageID &   getStorageID    () const;
+                unsigned            getPriority     () const;
+                void                setPriority     (unsigned);
                 virtual std::string getContentType  () const override;
                 virtual RequestStatus getRequestStatus() const override;
                 virtual void        recycle() = 0;
@@ -86,6 +88,7 @@ namespace adaptive
                 RequestStatus       requeststatus;
                 size_t              contentLength;
                 BytesRange          bytesRange;
+                unsigned            priority;
         };
 
         class AbstractChunk : public ChunkInterface
@@ -137,6 +140,7 @@ namespace adaptive
 
                 virtual bool        prepare();
                 void                setIdentifier(const std::string &, const BytesRange &);
+                const std::string & getHostname() const;
                 AbstractConnection    *connection;
                 AbstractConnectionManager *connManager;
                 mutable vlc_mutex_t lock;
@@ -144,6 +148,7 @@ namespace adaptive
                 bool                prepared;
                 bool                eof;
                 ID                  sourceid;
+                CacheValidators     conditions; /* of the request */
                 vlc_tick_t          requestStartTime;
                 vlc_tick_t          responseTime;
                 vlc_tick_t          downloadEndTime;
@@ -163,6 +168,7 @@ namespace adaptive
                 virtual block_t *  readBlock       ()  override;
                 virtual block_t *  read            (size_t)  override;
                 virtual bool       hasMoreData     () const  override;
+                virtual std::string getContentType () const  override;
                 virtual void        recycle() override;
 
             protected:
@@ -171,8 +177,11 @@ namespace adaptive
                                         bool = false);
                 void               bufferize(size_t);
                 bool               isDone() const;
+                bool               isComplete() const;
                 void               hold();
                 void               release();
+                void               setCachedData(block_t *, const std::string &,
+                                                 const CacheValidators &);
 
             private:
                 block_t            *p_head; /* read cache buffer */
@@ -184,6 +193,18 @@ namespace adaptive
                 bool                eof;
                 vlc_cond_t          avail;
                 bool                held;
+                void                useCachedData();
+                block_t            *p_cached; /* local copy, if not modified */
+                std::string         cachedType;
+                bool                fromcache;
+                bool                revalidated;
+                bool                cacheaccounted;
+                bool                progressive; /* partial reads, low latency */
+                vlc_tick_t          lastArrival;
+                vlc_tick_t          maxArrivalGap;
+                size_t              receivedBytes; /* outside of encoder waits */
+                vlc_tick_t          receivingTime;
+                static const vlc_tick_t ENCODER_WAIT = CLOCK_FREQ / 20;
         };
 
         class HTTPChunk : public AbstractChunk
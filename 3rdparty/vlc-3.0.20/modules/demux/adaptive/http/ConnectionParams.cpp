@@ -32,10 +32,12 @@ using namespace adaptive::http;
 
 ConnectionParams::ConnectionParams()
 {
+    priority = 0;
 }
 
 ConnectionParams::ConnectionParams(const std::string &uri)
 {
+    priority = 0;
     this->uri = uri;
     parse();
 }
@@ -83,6 +85,17 @@ uint16_t ConnectionParams::getPort() const
     return port;
 }
 
+/* HTTP/2 stream weight of the request, 0 if unspecified */
+unsigned ConnectionParams::getPriority() const
+{
+    return priority;
+}
+
+void ConnectionParams::setPriority(unsigned p)
+{
+    priority = p;
+}
+
 bool ConnectionParams::isLocal() const
 {
     return scheme != "http" && scheme != "https";
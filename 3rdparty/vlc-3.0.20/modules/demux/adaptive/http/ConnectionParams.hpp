@@ -35,9 +35,23 @@ namespace adaptive
             Redirection,
             Unauthorized,
             NotFound,
+            NotModified,
             GenericError,
         };
 
+        /* Response identification for conditional requests, and freshness */
+        class CacheValidators
+        {
+            public:
+                CacheValidators() { expires = 0; storable = true; }
+                bool isValid() const { return !etag.empty() || !lastModified.empty(); }
+                bool isFresh(time_t now) const { return expires > now; }
+                std::string etag;
+                std::string lastModified;
+                time_t expires; /* used without revalidation until then */
+                bool storable; /* not no-store */
+        };
+
         class BackendPrefInterface
         {
             /* Design Hack for now to force fallback on regular access
@@ -62,6 +76,8 @@ namespace adaptive
                 bool isLocal() const;
                 void setPath(const std::string &);
                 uint16_t getPort() const;
+                unsigned getPriority() const;
+                void setPriority(unsigned);
 
             private:
                 void parse();
@@ -70,6 +86,7 @@ namespace adaptive
                 std::string hostname;
                 std::string path;
                 uint16_t port;
+                unsigned priority;
         };
     }
 }
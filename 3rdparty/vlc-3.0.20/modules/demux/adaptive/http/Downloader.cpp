@@ -28,56 +28,70 @@
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Downloader(unsigned workers_, unsigned perhost_)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
     vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
-    current = nullptr;
-    cancel_current = false;
+    started = 0;
+    perhost = perhost_;
+    workers.resize(workers_ ? workers_ : 1);
+    for(Worker &w : workers)
+    {
+        w.owner = this;
+        w.current = nullptr;
+        w.cancel = false;
+    }
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    for(; started < workers.size(); started++)
     {
-        return false;
+        Worker *w = &workers[started];
+        if(vlc_clone(&w->thread, downloaderThread,
+                     static_cast<void *>(w), VLC_THREAD_PRIORITY_INPUT))
+            break;
     }
-    thread_handle_valid = true;
-    return true;
+    return started > 0;
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, nullptr);
+    for(unsigned i = 0; i < started; i++)
+        vlc_join(workers[i].thread, nullptr);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
+    vlc_cond_destroy(&updatedcond);
 }
+
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
     source->hold();
     chunks.push_back(source);
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock(&lock);
 }
 
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
-    while (current == source)
+    for(;;)
     {
-        cancel_current = true;
+        Worker *owner = nullptr;
+        for(Worker &w : workers)
+            if(w.current == source)
+                owner = &w;
+        if(!owner)
+            break;
+        owner->cancel = true;
         vlc_cond_wait(&updatedcond, &lock);
     }
 
@@ -89,36 +103,83 @@ void Downloader::cancel(HTTPChunkBufferedSource *source)
     vlc_mutex_unlock(&lock);
 }
 
+void Downloader::updateBufferingLevel(const ID &id, vlc_tick_t level)
+{
+    vlc_mutex_lock(&lock);
+    if(level == VLC_TICK_INVALID)
+        levels.erase(id);
+    else
+        levels[id] = level;
+    vlc_mutex_unlock(&lock);
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
-    Downloader *instance = static_cast<Downloader *>(opaque);
-    instance->Run();
+    Worker *worker = static_cast<Worker *>(opaque);
+    worker->owner->Run(worker);
     return nullptr;
 }
 
-void Downloader::Run()
+HTTPChunkBufferedSource * Downloader::getNextChunk() const
+{
+    HTTPChunkBufferedSource *next = nullptr;
+    vlc_tick_t nextlevel = 0;
+
+    for(HTTPChunkBufferedSource *chunk : chunks)
+    {
+        unsigned samehost = 0;
+        bool busy = false;
+        for(const Worker &w : workers)
+        {
+            if(!w.current)
+                continue;
+            if(w.current == chunk || w.current->sourceid == chunk->sourceid)
+                busy = true;
+            else if(w.current->getHostname() == chunk->getHostname())
+                samehost++;
+        }
+        if(busy || (perhost && samehost >= perhost))
+            continue;
+
+        /* Sources without level are starting and come first */
+        auto it = levels.find(chunk->sourceid);
+        vlc_tick_t level = (it != levels.end()) ? it->second : 0;
+        if(!next || level < nextlevel)
+        {
+            next = chunk;
+            nextlevel = level;
+        }
+    }
+    return next;
+}
+
+void Downloader::Run(Worker *worker)
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        while(!killed && !(worker->current = getNextChunk()))
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        current = chunks.front();
-        vlc_mutex_unlock(&lock);
-        current->bufferize(HTTPChunkSource::CHUNK_SIZE);
-        vlc_mutex_lock(&lock);
-        if(current->isDone() || cancel_current)
+        HTTPChunkBufferedSource *current = worker->current;
+        do
         {
-            chunks.pop_front();
-            current->release();
-        }
-        cancel_current = false;
-        current = nullptr;
-        vlc_cond_signal(&updatedcond);
+            vlc_mutex_unlock(&lock);
+            current->bufferize(HTTPChunkSource::CHUNK_SIZE);
+            vlc_mutex_lock(&lock);
+        } while(!current->isDone() && !worker->cancel && !killed);
+
+        chunks.remove(current);
+        current->release();
+        worker->cancel = false;
+        worker->current = nullptr;
+        vlc_cond_broadcast(&updatedcond);
+        /* Chunks of the same source or host can now start */
+        vlc_cond_broadcast(&waitcond);
     }
+    worker->current = nullptr;
     vlc_mutex_unlock(&lock);
 }
@@ -24,6 +24,8 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace adaptive
 {
@@ -31,27 +33,43 @@ namespace adaptive
     namespace http
     {
 
+        /* Pool of download threads. Each thread transfers one chunk at a
+         * time, at most one per source (track) so that segments of a track
+         * are received in order, and at most perhost per server. Among the
+         * chunks that can start, the one of the source with the lowest
+         * buffering level is picked first. */
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned workers = 1, unsigned perhost = 0);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
+                /* VLC_TICK_INVALID forgets the source */
+                void updateBufferingLevel(const ID &, vlc_tick_t);
 
             private:
+                class Worker
+                {
+                    public:
+                        Downloader              *owner;
+                        vlc_thread_t             thread;
+                        HTTPChunkBufferedSource *current;
+                        bool                     cancel;
+                };
                 static void * downloaderThread(void *);
-                void Run();
-                vlc_thread_t thread_handle;
+                void Run(Worker *);
+                HTTPChunkBufferedSource * getNextChunk() const;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
                 vlc_cond_t   updatedcond;
-                bool         thread_handle_valid;
+                unsigned     started;
+                unsigned     perhost;
                 bool         killed;
-                bool         cancel_current;
+                std::vector<Worker> workers;
                 std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                std::map<ID, vlc_tick_t> levels;
         };
 
     }
@@ -30,6 +30,8 @@
 #include <vlc_stream.h>
 #include <vlc_keystore.h>
 
+#include <sstream>
+
 extern "C"
 {
     #include "../access/http/resource.h"
@@ -63,6 +65,11 @@ bool AbstractConnection::prepare(const ConnectionParams &params_)
     return true;
 }
 
+ssize_t AbstractConnection::readPartial(void *p_buffer, size_t len)
+{
+    return read(p_buffer, len);
+}
+
 size_t AbstractConnection::getContentLength() const
 {
     return contentLength;
@@ -73,11 +80,21 @@ size_t AbstractConnection::getBytesRead() const
     return bytesRead;
 }
 
+bool AbstractConnection::isBodyComplete() const
+{
+    return contentLength > 0 && bytesRead >= contentLength;
+}
+
 const std::string & AbstractConnection::getContentType() const
 {
     return contentType;
 }
 
+const CacheValidators & AbstractConnection::getValidators() const
+{
+    return validators;
+}
+
 const ConnectionParams & AbstractConnection::getRedirection() const
 {
     return locationparams;
@@ -91,12 +108,24 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         LibVLCHTTPSource(vlc_object_t *p_object, struct vlc_http_cookie_jar_t *jar)
         {
             http_mgr = vlc_http_mgr_create(p_object, jar);
+            owns_mgr = true;
+            http_res = nullptr;
+            totalRead = 0;
+            ended = false;
+            priority = 0;
+        }
+        LibVLCHTTPSource(struct vlc_http_mgr *shared)
+        {
+            http_mgr = shared;
+            owns_mgr = false;
             http_res = nullptr;
             totalRead = 0;
+            ended = false;
+            priority = 0;
         }
         virtual ~LibVLCHTTPSource()
         {
-            if(http_mgr)
+            if(http_mgr && owns_mgr)
                 vlc_http_mgr_destroy(http_mgr);
         }
         virtual block_t *readNextBlock() override
@@ -108,6 +137,8 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
                 return nullptr;
             if(b)
                 totalRead += b->i_buffer;
+            else
+                ended = true;
             return b;
         }
         void reset()
@@ -118,6 +149,7 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
                 http_res = nullptr;
                 totalRead = 0;
             }
+            ended = false;
         }
 
     private:
@@ -132,6 +164,14 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         {
             vlc_http_msg_add_header(req, "Accept-Encoding", "deflate, gzip");
             vlc_http_msg_add_header(req, "Cache-Control", "no-cache");
+            vlc_http_msg_set_priority(req, priority);
+            if(!conditions.etag.empty() &&
+               vlc_http_msg_add_header(req, "If-None-Match", "%s", conditions.etag.c_str()))
+                return -1;
+            if(!conditions.lastModified.empty() &&
+               vlc_http_msg_add_header(req, "If-Modified-Since", "%s",
+                                       conditions.lastModified.c_str()))
+                return -1;
             if(range.isValid())
             {
                 if(range.getEndByte() > 0)
@@ -185,17 +225,24 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
 
         static const struct vlc_http_resource_cbs callbacks;
         size_t totalRead;
+        bool ended; /* not interrupted by an error */
         struct vlc_http_mgr *http_mgr;
+        bool owns_mgr;
+        unsigned priority;
         BytesRange range;
+        CacheValidators conditions;
 
     public:
         struct vlc_http_resource *http_res;
         int create(const char *uri,const std::string &ua,
-                   const std::string &ref, const BytesRange &range)
+                   const std::string &ref, const BytesRange &range,
+                   const CacheValidators *conditions, unsigned priority)
         {
             struct restuple *tpl = new struct restuple;
             tpl->source = this;
             this->range = range;
+            this->priority = priority;
+            this->conditions = conditions ? *conditions : CacheValidators();
             if (vlc_http_res_init(&tpl->resource, &this->callbacks, http_mgr, uri,
                                   ua.empty() ? nullptr : ua.c_str(),
                                   ref.empty() ? nullptr : ref.c_str()))
@@ -235,10 +282,14 @@ const struct vlc_http_resource_cbs LibVLCHTTPSource::callbacks =
     LibVLCHTTPSource::validateresponse_handler,
 };
 
-LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, AuthStorage *auth)
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
+                                           struct vlc_http_mgr *shared)
     : AbstractConnection( p_object_ )
 {
-    source = new adaptive::http::LibVLCHTTPSource(p_object_, auth->getJar());
+    if(shared)
+        source = new adaptive::http::LibVLCHTTPSource(shared);
+    else
+        source = new adaptive::http::LibVLCHTTPSource(p_object_, auth->getJar());
     sourceStream = new ChunksSourceStream(p_object, source);
     stream = nullptr;
     char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
@@ -273,6 +324,7 @@ void LibVLCHTTPConnection::reset()
     }
     bytesRange = BytesRange();
     contentType = std::string();
+    validators = CacheValidators();
     bytesRead = 0;
     contentLength = 0;
 }
@@ -286,8 +338,41 @@ bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
             params.getPort() == params_.getPort());
 }
 
+/* How long the response can be used without revalidation, from its
+ * Cache-Control max-age, or its Expires date (RFC 7234 4.2.1) */
+static time_t GetFreshnessLifetime(const struct vlc_http_msg *resp)
+{
+    time_t lifetime = 0;
+    const char *s = vlc_http_msg_get_token(resp, "Cache-Control", "max-age");
+    if(s)
+    {
+        s += strlen("max-age");
+        s += strspn(s, " \t");
+        if(*s == '=')
+            lifetime = strtoul(s + 1, nullptr, 10);
+    }
+    else
+    {
+        time_t expires = vlc_http_msg_get_time(resp, "Expires");
+        time_t date = vlc_http_msg_get_atime(resp);
+        if(date == -1)
+            date = time(nullptr);
+        if(expires != -1 && expires > date)
+            lifetime = expires - date;
+    }
+
+    s = vlc_http_msg_get_header(resp, "Age");
+    if(s)
+    {
+        time_t age = strtoul(s, nullptr, 10);
+        lifetime = lifetime > age ? lifetime - age : 0;
+    }
+    return lifetime;
+}
+
 RequestStatus LibVLCHTTPConnection::request(const std::string &path,
-                                            const BytesRange &range)
+                                            const BytesRange &range,
+                                            const CacheValidators *conditions)
 {
     if(source->http_mgr == nullptr)
         return RequestStatus::GenericError;
@@ -303,7 +388,8 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     else
         msg_Dbg(p_object, "Retrieving %s", params.getUrl().c_str());
 
-    if(source->create(params.getUrl().c_str(), useragent,referer, range))
+    if(source->create(params.getUrl().c_str(), useragent,referer, range, conditions,
+                      params.getPriority()))
         return RequestStatus::GenericError;
 
     struct vlc_credential crd;
@@ -367,6 +453,9 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     if (status >= 400)
         return RequestStatus::GenericError;
 
+    if (status == 304)
+        return RequestStatus::NotModified;
+
     char *psz_redir = vlc_http_res_get_redirect(source->http_res);
     if(psz_redir)
     {
@@ -392,6 +481,23 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
     if(s)
         contentType = std::string(s);
 
+    s = vlc_http_msg_get_header(source->http_res->response, "ETag");
+    if(s)
+        validators.etag = std::string(s);
+    s = vlc_http_msg_get_header(source->http_res->response, "Last-Modified");
+    if(s)
+        validators.lastModified = std::string(s);
+
+    const struct vlc_http_msg *resp = source->http_res->response;
+    if(vlc_http_msg_get_token(resp, "Cache-Control", "no-store"))
+        validators.storable = false;
+    else if(!vlc_http_msg_get_token(resp, "Cache-Control", "no-cache"))
+    {
+        time_t lifetime = GetFreshnessLifetime(resp);
+        if(lifetime > 0)
+            validators.expires = time(nullptr) + lifetime;
+    }
+
     s = vlc_http_msg_get_header(source->http_res->response, "Content-Encoding");
     if(s && stream && (strstr(s, "deflate") || strstr(s, "gzip")))
     {
@@ -413,6 +519,19 @@ ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
     return read;
 }
 
+bool LibVLCHTTPConnection::isBodyComplete() const
+{
+    return source->ended;
+}
+
+ssize_t LibVLCHTTPConnection::readPartial(void *p_buffer, size_t len)
+{
+    /* chunked transfers: hand over each chunk as it arrives */
+    ssize_t read = vlc_stream_ReadPartial(stream, p_buffer, len);
+    bytesRead = source->totalRead;
+    return read;
+}
+
 void LibVLCHTTPConnection::setUsed( bool b )
 {
     available = !b;
@@ -454,8 +573,10 @@ bool StreamUrlConnection::canReuse(const ConnectionParams &params_) const
 }
 
 RequestStatus StreamUrlConnection::request(const std::string &path,
-                                           const BytesRange &range)
+                                           const BytesRange &range,
+                                           const CacheValidators *)
 {
+    /* access modules can't send conditional requests */
     reset();
 
     /* Set new path for this query */
@@ -535,10 +656,41 @@ void StreamUrlConnection::setUsed( bool b )
        reset();
 }
 
-LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth )
+LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth,
+                                                          bool multiplex_ )
     : AbstractConnectionFactory()
 {
     authStorage = auth;
+    multiplex = multiplex_;
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    for(auto it = managers.begin(); it != managers.end(); ++it)
+        vlc_http_mgr_destroy((*it).second);
+}
+
+/* All the connections to a server share its manager, and thus a single
+ * HTTP/2 connection over which the tracks requests are multiplexed */
+struct vlc_http_mgr * LibVLCHTTPConnectionFactory::getSharedManager(vlc_object_t *p_object,
+                                                                    const ConnectionParams &params)
+{
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << params.getScheme() << "://" << params.getHostname() << ":" << params.getPort();
+    const std::string key = os.str();
+
+    auto it = managers.find(key);
+    if(it != managers.end())
+        return (*it).second;
+
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(p_object, authStorage->getJar());
+    if(mgr == nullptr)
+        return nullptr;
+    if(params.getScheme() == "http")
+        vlc_http_mgr_use_h2c(mgr, true);
+    managers.insert(std::pair<std::string, struct vlc_http_mgr *>(key, mgr));
+    return mgr;
 }
 
 AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
@@ -547,7 +699,14 @@ AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t
     if((params.getScheme() != "http" && params.getScheme() != "https") ||
        params.getHostname().empty())
         return nullptr;
-    return new LibVLCHTTPConnection(p_object, authStorage);
+    struct vlc_http_mgr *shared = nullptr;
+    if(multiplex)
+    {
+        shared = getSharedManager(p_object, params);
+        if(shared == nullptr)
+            return nullptr;
+    }
+    return new LibVLCHTTPConnection(p_object, authStorage, shared);
 }
 
 StreamUrlConnectionFactory::StreamUrlConnectionFactory()
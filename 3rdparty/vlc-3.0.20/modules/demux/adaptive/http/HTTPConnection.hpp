@@ -29,6 +29,9 @@
 #include "BytesRange.hpp"
 #include <vlc_common.h>
 #include <string>
+#include <map>
+
+struct vlc_http_mgr;
 
 namespace adaptive
 {
@@ -50,12 +53,18 @@ namespace adaptive
                 virtual bool    canReuse     (const ConnectionParams &) const = 0;
 
                 virtual RequestStatus request(const std::string& path,
-                                              const BytesRange & = BytesRange()) = 0;
+                                              const BytesRange & = BytesRange(),
+                                              const CacheValidators * = nullptr) = 0;
                 virtual ssize_t read        (void *p_buffer, size_t len) = 0;
+                /* returns as soon as some data is available */
+                virtual ssize_t readPartial (void *p_buffer, size_t len);
 
                 virtual size_t  getContentLength() const;
                 virtual size_t  getBytesRead() const;
+                /* the whole body was read, its length known or not */
+                virtual bool    isBodyComplete() const;
                 virtual const std::string & getContentType() const;
+                virtual const CacheValidators & getValidators() const;
                 virtual const ConnectionParams &getRedirection() const;
                 virtual void    setUsed( bool ) = 0;
 
@@ -66,6 +75,7 @@ namespace adaptive
                 bool               available;
                 size_t             contentLength;
                 std::string        contentType;
+                CacheValidators    validators;
                 BytesRange         bytesRange;
                 size_t             bytesRead;
         };
@@ -75,12 +85,16 @@ namespace adaptive
        class LibVLCHTTPConnection : public AbstractConnection
        {
             public:
-               LibVLCHTTPConnection(vlc_object_t *, AuthStorage *);
+               LibVLCHTTPConnection(vlc_object_t *, AuthStorage *,
+                                    struct vlc_http_mgr * = nullptr);
                virtual ~LibVLCHTTPConnection();
                virtual bool    canReuse     (const ConnectionParams &) const override;
                virtual RequestStatus request(const std::string& path,
-                                             const BytesRange & = BytesRange()) override;
+                                             const BytesRange & = BytesRange(),
+                                             const CacheValidators * = nullptr) override;
                virtual ssize_t read         (void *p_buffer, size_t len) override;
+               virtual ssize_t readPartial  (void *p_buffer, size_t len) override;
+               virtual bool    isBodyComplete() const override;
                virtual void    setUsed      ( bool ) override;
 
             private:
@@ -101,7 +115,8 @@ namespace adaptive
                 virtual bool    canReuse     (const ConnectionParams &) const override;
 
                 virtual RequestStatus request(const std::string& path,
-                                              const BytesRange & = BytesRange()) override;
+                                              const BytesRange & = BytesRange(),
+                                              const CacheValidators * = nullptr) override;
                 virtual ssize_t read        (void *p_buffer, size_t len) override;
 
                 virtual void    setUsed( bool ) override;
@@ -122,11 +137,14 @@ namespace adaptive
        class LibVLCHTTPConnectionFactory : public AbstractConnectionFactory
        {
            public:
-               LibVLCHTTPConnectionFactory( AuthStorage * );
-               virtual ~LibVLCHTTPConnectionFactory() = default;
+               LibVLCHTTPConnectionFactory( AuthStorage *, bool = false );
+               virtual ~LibVLCHTTPConnectionFactory();
                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &) override;
            private:
+               struct vlc_http_mgr * getSharedManager(vlc_object_t *, const ConnectionParams &);
                AuthStorage *authStorage;
+               bool multiplex;
+               std::map<std::string, struct vlc_http_mgr *> managers;
        };
 
        class StreamUrlConnectionFactory : public AbstractConnectionFactory
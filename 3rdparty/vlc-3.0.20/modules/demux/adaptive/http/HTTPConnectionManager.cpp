@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
@@ -40,11 +41,14 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = nullptr;
+    lowLatency = false;
+    deliveryJitter = 0;
+    vlc_mutex_init(&jitterlock);
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
 {
-
+    vlc_mutex_destroy(&jitterlock);
 }
 
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size,
@@ -60,27 +64,76 @@ void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid,
     }
 }
 
+void AbstractConnectionManager::updateDownloadProgress(size_t size,
+                                                       vlc_tick_t start, vlc_tick_t end)
+{
+    if(rateObserver)
+        rateObserver->updateDownloadProgress(size, start, end);
+}
+
+void AbstractConnectionManager::updateBufferingLevel(const adaptive::ID &, vlc_tick_t)
+{
+
+}
+
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
 {
     rateObserver = obs;
 }
 
+void AbstractConnectionManager::setLowLatency(bool b)
+{
+    vlc_mutex_locker locker(&jitterlock);
+    lowLatency = b;
+}
+
+bool AbstractConnectionManager::isLowLatency() const
+{
+    vlc_mutex_locker locker(&jitterlock);
+    return lowLatency;
+}
+
+/* The jitter is the longest wait for data during a progressive transfer,
+ * following peaks immediately and decaying slowly when delivery is steady */
+void AbstractConnectionManager::updateDeliveryJitter(const adaptive::ID &sourceid,
+                                                     vlc_tick_t gap)
+{
+    vlc_mutex_locker locker(&jitterlock);
+    if(gap > deliveryJitter)
+        deliveryJitter = gap;
+    else
+        deliveryJitter = (deliveryJitter * 7 + gap) / 8;
+    BwDebug(msg_Dbg(p_object, "delivery gap %" PRId64 "ms, jitter %" PRId64 "ms [%s]",
+                    gap / 1000, deliveryJitter / 1000, sourceid.str().c_str()));
+    VLC_UNUSED(sourceid);
+}
+
+vlc_tick_t AbstractConnectionManager::getDeliveryJitter() const
+{
+    vlc_mutex_locker locker(&jitterlock);
+    return deliveryJitter;
+}
+
 void AbstractConnectionManager::deleteSource(AbstractChunkSource *source)
 {
     delete source;
 }
 
-HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
+HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_,
+                                                 unsigned perhost)
     : AbstractConnectionManager( p_object_ ),
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new Downloader();
+    if(perhost == 0)
+        perhost = 1;
+    downloader = new Downloader(perhost, perhost);
     downloaderhp = new Downloader();
     downloader->start();
     downloaderhp->start();
     cache_total = 0;
     cache_max = 1 << 19;
+    segmentCache = nullptr;
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
@@ -88,6 +141,7 @@ HTTPConnectionManager::~HTTPConnectionManager   ()
     delete downloader;
     delete downloaderhp;
     this->closeAllConnections();
+    delete segmentCache;
     while(!factories.empty())
     {
         delete factories.front();
@@ -178,11 +232,28 @@ AbstractChunkSource *HTTPConnectionManager::makeSource(const std::string &url,
                     cache_total -= s->contentLength;
                     CacheDebug(msg_Dbg(p_object, "Cache GET '%s' usage %u bytes",
                                        storageid.c_str(), cache_total));
+                    if(segmentCache)
+                        segmentCache->hit(s->contentLength, false);
                     return s;
                 }
             }
             // fallthrough
         case ChunkType::Segment:
+            if(segmentCache)
+            {
+                HTTPChunkBufferedSource *s =
+                        new HTTPChunkBufferedSource(url, this, id, type, range);
+                SegmentCache::Entry entry;
+                if(segmentCache->get(storageid, &entry))
+                {
+                    CacheDebug(msg_Dbg(p_object, "Cache GET '%s' from disk",
+                                       storageid.c_str()));
+                    s->setCachedData(entry.p_data, entry.contentType, entry.validators);
+                    entry.p_data = nullptr;
+                }
+                return s;
+            }
+            // fallthrough
         case ChunkType::Key:
         case ChunkType::Playlist:
         default:
@@ -208,6 +279,24 @@ void HTTPConnectionManager::recycleSource(AbstractChunkSource *source)
     }
 
     HTTPChunkBufferedSource *buf = dynamic_cast<HTTPChunkBufferedSource *>(source);
+    if(buf && segmentCache && source->getChunkType() != ChunkType::Key &&
+       source->getChunkType() != ChunkType::Playlist && !buf->cacheaccounted)
+    {
+        if(buf->fromcache)
+        {
+            segmentCache->hit(buf->contentLength, buf->revalidated);
+            buf->cacheaccounted = true;
+        }
+        else if(buf->isComplete())
+        {
+            segmentCache->miss(buf->buffered);
+            segmentCache->put(buf->getStorageID(), buf->p_head,
+                              buf->connection->getContentType(),
+                              buf->connection->getValidators());
+            buf->cacheaccounted = true;
+        }
+    }
+
     if(buf && b_cacheable && !buf->getStorageID().empty() &&
        buf->contentLength < cache_max)
     {
@@ -258,6 +347,11 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         getDownloadQueue(src)->cancel(src);
 }
 
+void HTTPConnectionManager::updateBufferingLevel(const adaptive::ID &id, vlc_tick_t level)
+{
+    downloader->updateBufferingLevel(id, level);
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
@@ -267,3 +361,9 @@ void HTTPConnectionManager::addFactory(AbstractConnectionFactory *factory)
 {
     factories.push_back(factory);
 }
+
+void HTTPConnectionManager::setSegmentCache(SegmentCache *cache)
+{
+    delete segmentCache;
+    segmentCache = cache;
+}
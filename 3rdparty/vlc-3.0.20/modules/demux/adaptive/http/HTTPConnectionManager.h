@@ -44,6 +44,7 @@ namespace adaptive
         class Downloader;
         class AbstractChunkSource;
         class HTTPChunkBufferedSource;
+        class SegmentCache;
         enum class ChunkType;
 
         class AbstractConnectionManager : public IDownloadRateObserver
@@ -63,20 +64,33 @@ namespace adaptive
 
                 virtual void updateDownloadRate(const ID &, size_t,
                                                 mtime_t, mtime_t) override;
+                virtual void updateDownloadProgress(size_t, vlc_tick_t,
+                                                    vlc_tick_t) override;
+                virtual void updateBufferingLevel(const ID &, vlc_tick_t);
                 void setDownloadRateObserver(IDownloadRateObserver *);
 
+                /* Low latency: segments are handed over while they download */
+                void setLowLatency(bool);
+                bool isLowLatency() const;
+                void updateDeliveryJitter(const ID &, vlc_tick_t);
+                vlc_tick_t getDeliveryJitter() const;
+
             protected:
                 void deleteSource(AbstractChunkSource *);
                 vlc_object_t                                       *p_object;
 
             private:
                 IDownloadRateObserver                              *rateObserver;
+                mutable vlc_mutex_t                                 jitterlock;
+                bool                                                lowLatency;
+                vlc_tick_t                                          deliveryJitter;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
         {
             public:
-                HTTPConnectionManager           (vlc_object_t *p_object);
+                HTTPConnectionManager           (vlc_object_t *p_object,
+                                                 unsigned perhost = 1);
                 virtual ~HTTPConnectionManager  ();
 
                 virtual void    closeAllConnections ()  override;
@@ -88,8 +102,10 @@ namespace adaptive
 
                 virtual void start(AbstractChunkSource *)  override;
                 virtual void cancel(AbstractChunkSource *)  override;
+                virtual void updateBufferingLevel(const ID &, vlc_tick_t) override;
                 void         setLocalConnectionsAllowed();
                 void         addFactory(AbstractConnectionFactory *);
+                void         setSegmentCache(SegmentCache *);
 
             private:
                 void    releaseAllConnections ();
@@ -104,6 +120,7 @@ namespace adaptive
                 std::list<HTTPChunkBufferedSource *> cache;
                 unsigned cache_total;
                 unsigned cache_max;
+                SegmentCache *segmentCache;
         };
     }
 }
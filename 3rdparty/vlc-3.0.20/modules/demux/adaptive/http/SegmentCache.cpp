@@ -0,0 +1,518 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_configuration.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace adaptive::http;
+
+#define CACHE_MAGIC "VLCADC02"
+/* Chunks waiting to be written, beyond which new ones are not stored */
+#define CACHE_PENDING_MAX (32 << 20)
+
+vlc_mutex_t SegmentCache::Store::storesLock = VLC_STATIC_MUTEX;
+std::map<std::string, SegmentCache::Store *> SegmentCache::Store::stores;
+
+SegmentCache::Entry::Entry()
+{
+    p_data = nullptr;
+}
+
+SegmentCache::Entry::~Entry()
+{
+    if(p_data)
+        block_Release(p_data);
+}
+
+SegmentCache::Store::Store(const std::string &dir_, size_t maxsize_)
+{
+    dir = dir_;
+    maxsize = maxsize_;
+    scanning = false;
+    listed = false;
+    total = 0;
+    refs = 1;
+    vlc_mutex_init(&lock);
+
+    /* Create the cache directory and its parent */
+    std::string::size_type sep = dir.rfind(DIR_SEP_CHAR);
+    if(sep != std::string::npos && sep > 0)
+        vlc_mkdir(dir.substr(0, sep).c_str(), 0700);
+    vlc_mkdir(dir.c_str(), 0700);
+}
+
+SegmentCache::Store::~Store()
+{
+    vlc_mutex_destroy(&lock);
+}
+
+SegmentCache::Store * SegmentCache::Store::acquire(const std::string &dir,
+                                                   size_t maxsize)
+{
+    Store *store;
+
+    vlc_mutex_lock(&storesLock);
+    auto it = stores.find(dir);
+    if(it != stores.end())
+    {   /* the latest limit applies */
+        store = it->second;
+        store->refs++;
+        vlc_mutex_lock(&store->lock);
+        store->maxsize = maxsize;
+        store->evict(0);
+        vlc_mutex_unlock(&store->lock);
+    }
+    else
+    {
+        store = new Store(dir, maxsize);
+        stores[dir] = store;
+    }
+    vlc_mutex_unlock(&storesLock);
+    return store;
+}
+
+void SegmentCache::Store::release()
+{
+    vlc_mutex_lock(&storesLock);
+    const bool b_last = --refs == 0;
+    if(b_last)
+        stores.erase(dir);
+    vlc_mutex_unlock(&storesLock);
+    if(b_last)
+        delete this;
+}
+
+void SegmentCache::Store::scan()
+{
+    vlc_mutex_lock(&lock);
+    const bool b_scan = !scanning;
+    scanning = true;
+    vlc_mutex_unlock(&lock);
+    if(!b_scan)
+        return;
+
+    /* Restore the previous sessions files, by last write */
+    std::vector<std::pair<time_t, File>> found;
+    DIR *p_dir = vlc_opendir(dir.c_str());
+    if(p_dir)
+    {
+        const char *psz_name;
+        while((psz_name = vlc_readdir(p_dir)))
+        {
+            File file;
+            file.name = psz_name;
+            struct stat st;
+            if(file.name.size() != 16 ||
+               vlc_stat((dir + DIR_SEP + file.name).c_str(), &st) ||
+               !S_ISREG(st.st_mode))
+                continue;
+            file.size = st.st_size;
+            found.push_back(std::make_pair(st.st_mtime, file));
+        }
+        closedir(p_dir);
+    }
+
+    std::sort(found.begin(), found.end(),
+              [](const std::pair<time_t, File> &a, const std::pair<time_t, File> &b)
+                { return a.first > b.first; });
+
+    vlc_mutex_lock(&lock);
+    for(const auto &f : found)
+    {
+        if(index.find(f.second.name) != index.end())
+            continue; /* already used or written */
+        files.push_back(f.second);
+        index[f.second.name] = --files.end();
+        total += f.second.size;
+    }
+    listed = true;
+    evict(0);
+    vlc_mutex_unlock(&lock);
+}
+
+void SegmentCache::Store::touch(const std::string &name, size_t size)
+{
+    auto it = index.find(name);
+    if(it != index.end())
+    {
+        total -= it->second->size;
+        files.erase(it->second);
+    }
+    File file;
+    file.name = name;
+    file.size = size;
+    files.push_front(file);
+    index[name] = files.begin();
+    total += size;
+}
+
+void SegmentCache::Store::forget(const std::string &name)
+{
+    auto it = index.find(name);
+    if(it != index.end())
+    {
+        total -= it->second->size;
+        files.erase(it->second);
+        index.erase(it);
+    }
+}
+
+void SegmentCache::Store::evict(size_t needed)
+{
+    while(!files.empty() && total + needed > maxsize)
+    {
+        const File &file = files.back();
+        vlc_unlink((dir + DIR_SEP + file.name).c_str());
+        total -= file.size;
+        index.erase(file.name);
+        files.pop_back();
+    }
+}
+
+SegmentCache::SegmentCache(vlc_object_t *obj, const std::string &dir, size_t maxsize)
+{
+    p_obj = obj;
+    stats.hits = stats.revalidated = stats.misses = 0;
+    stats.hitbytes = stats.missbytes = 0;
+    pendingsize = 0;
+    b_stop = false;
+    vlc_mutex_init(&lock);
+    vlc_cond_init(&cond);
+    store = Store::acquire(dir, maxsize);
+
+    b_thread = !vlc_clone(&thread, writerThread,
+                          static_cast<void *>(this), VLC_THREAD_PRIORITY_LOW);
+    if(!b_thread)
+        store->scan();
+}
+
+SegmentCache::~SegmentCache()
+{
+    if(b_thread)
+    {   /* pending chunks are written first */
+        vlc_mutex_lock(&lock);
+        b_stop = true;
+        vlc_cond_broadcast(&cond);
+        vlc_mutex_unlock(&lock);
+        vlc_join(thread, nullptr);
+    }
+    store->release();
+
+    const unsigned requests = stats.hits + stats.misses;
+    if(requests)
+        msg_Dbg(p_obj, "segment cache: %u/%u hits (%u%%, %u revalidated), "
+                       "%" PRIu64 "KiB served locally, %" PRIu64 "KiB downloaded",
+                       stats.hits, requests, stats.hits * 100 / requests,
+                       stats.revalidated, stats.hitbytes / 1024, stats.missbytes / 1024);
+    vlc_cond_destroy(&cond);
+    vlc_mutex_destroy(&lock);
+}
+
+void * SegmentCache::writerThread(void *opaque)
+{
+    SegmentCache *cache = static_cast<SegmentCache *>(opaque);
+
+    /* listing a large directory must not delay the playback */
+    cache->store->scan();
+
+    vlc_mutex_lock(&cache->lock);
+    for(;;)
+    {
+        while(cache->pending.empty() && !cache->b_stop)
+            vlc_cond_wait(&cache->cond, &cache->lock);
+        if(cache->pending.empty())
+            break;
+
+        /* stays queued, and served from memory, until it is on disk */
+        const PendingWrite &w = cache->pending.front();
+        vlc_mutex_unlock(&cache->lock);
+        cache->write(w);
+        vlc_mutex_lock(&cache->lock);
+
+        cache->pendingsize -= w.p_data->i_buffer;
+        block_Release(w.p_data);
+        cache->pending.pop_front();
+        vlc_cond_broadcast(&cache->cond);
+    }
+    vlc_mutex_unlock(&cache->lock);
+    return nullptr;
+}
+
+void SegmentCache::flush()
+{
+    vlc_mutex_lock(&lock);
+    while(!pending.empty())
+        vlc_cond_wait(&cond, &lock);
+    vlc_mutex_unlock(&lock);
+}
+
+std::string SegmentCache::defaultDirectory()
+{
+    std::string dir;
+    char *psz_dir = config_GetUserDir(VLC_CACHE_DIR);
+    if(psz_dir)
+    {
+        dir = std::string(psz_dir) + DIR_SEP "adaptive";
+        free(psz_dir);
+    }
+    return dir;
+}
+
+std::string SegmentCache::getFilename(const std::string &key) const
+{
+    /* FNV-1a of the storage ID */
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for(unsigned char c : key)
+        hash = (hash ^ c) * UINT64_C(0x100000001b3);
+
+    char name[17];
+    snprintf(name, sizeof(name), "%016" PRIx64, hash);
+    return std::string(name);
+}
+
+static bool ReadString(FILE *stream, std::string *str)
+{
+    uint8_t len[4];
+    if(fread(len, 4, 1, stream) != 1)
+        return false;
+    str->resize(GetDWBE(len));
+    return str->empty() || fread(&(*str)[0], str->size(), 1, stream) == 1;
+}
+
+static bool WriteString(FILE *stream, const std::string &str)
+{
+    uint8_t len[4];
+    SetDWBE(len, str.size());
+    return fwrite(len, 4, 1, stream) == 1 &&
+           (str.empty() || fwrite(str.data(), str.size(), 1, stream) == 1);
+}
+
+/* A copy that can't be revalidated must not be served once stale */
+static bool IsUsable(const CacheValidators &validators)
+{
+    return validators.storable &&
+           (validators.isValid() || validators.isFresh(time(nullptr)));
+}
+
+bool SegmentCache::get(const std::string &key, Entry *entry)
+{
+    const std::string name = getFilename(key);
+    const std::string path = store->dir + DIR_SEP + name;
+
+    vlc_mutex_lock(&lock);
+    for(auto w = pending.rbegin(); w != pending.rend(); ++w)
+    {
+        if((*w).key != key)
+            continue;
+        entry->p_data = block_Duplicate((*w).p_data);
+        entry->contentType = (*w).contentType;
+        entry->validators = (*w).validators;
+        vlc_mutex_unlock(&lock);
+        return entry->p_data != nullptr;
+    }
+    vlc_mutex_unlock(&lock);
+
+    vlc_mutex_lock(&store->lock);
+    auto it = store->index.find(name);
+    if(it != store->index.end())
+        store->touch(name, it->second->size);
+    else if(!store->listed)
+    {   /* still listing the directory: look the file up */
+        struct stat st;
+        if(vlc_stat(path.c_str(), &st) || !S_ISREG(st.st_mode))
+        {
+            vlc_mutex_unlock(&store->lock);
+            return false;
+        }
+        store->touch(name, st.st_size);
+    }
+    else
+    {
+        vlc_mutex_unlock(&store->lock);
+        return false;
+    }
+    const size_t maxsize = store->maxsize;
+    vlc_mutex_unlock(&store->lock);
+
+    FILE *stream = vlc_fopen(path.c_str(), "rb");
+    if(!stream)
+    {   /* evicted by another process */
+        vlc_mutex_lock(&store->lock);
+        store->forget(name);
+        vlc_mutex_unlock(&store->lock);
+        return false;
+    }
+
+    bool b_ok = false;
+    char magic[8];
+    std::string storedkey;
+    uint8_t expires[8];
+    uint8_t size[8];
+    if(fread(magic, 8, 1, stream) == 1 && !memcmp(magic, CACHE_MAGIC, 8) &&
+       ReadString(stream, &storedkey) && storedkey == key && /* no collision */
+       ReadString(stream, &entry->contentType) &&
+       ReadString(stream, &entry->validators.etag) &&
+       ReadString(stream, &entry->validators.lastModified) &&
+       fread(expires, 8, 1, stream) == 1 &&
+       fread(size, 8, 1, stream) == 1 && GetQWBE(size) <= maxsize)
+    {
+        entry->validators.expires = GetQWBE(expires);
+        if(IsUsable(entry->validators))
+            entry->p_data = block_Alloc(GetQWBE(size));
+        if(entry->p_data)
+        {
+            b_ok = fread(entry->p_data->p_buffer, entry->p_data->i_buffer,
+                         1, stream) == 1;
+            if(!b_ok)
+            {
+                block_Release(entry->p_data);
+                entry->p_data = nullptr;
+            }
+        }
+    }
+    fclose(stream);
+    return b_ok;
+}
+
+void SegmentCache::put(const std::string &key, const block_t *p_chain,
+                       const std::string &contentType,
+                       const CacheValidators &validators)
+{
+    if(!IsUsable(validators))
+        return;
+
+    size_t size = 0;
+    for(const block_t *p = p_chain; p; p = p->p_next)
+        size += p->i_buffer;
+    if(size == 0 || size > store->maxsize)
+        return;
+
+    vlc_mutex_lock(&lock);
+    const bool b_queue = b_thread && pendingsize + size <= CACHE_PENDING_MAX;
+    if(b_queue)
+        pendingsize += size;
+    vlc_mutex_unlock(&lock);
+    if(!b_queue)
+        return; /* the disk can't keep up */
+
+    PendingWrite w;
+    w.key = key;
+    w.contentType = contentType;
+    w.validators = validators;
+    w.p_data = block_Alloc(size);
+    if(w.p_data)
+    {
+        uint8_t *p_dst = w.p_data->p_buffer;
+        for(const block_t *p = p_chain; p; p = p->p_next)
+        {
+            memcpy(p_dst, p->p_buffer, p->i_buffer);
+            p_dst += p->i_buffer;
+        }
+    }
+
+    vlc_mutex_lock(&lock);
+    if(w.p_data)
+    {
+        pending.push_back(w);
+        vlc_cond_broadcast(&cond);
+    }
+    else
+        pendingsize -= size;
+    vlc_mutex_unlock(&lock);
+}
+
+void SegmentCache::write(const PendingWrite &w)
+{
+    const std::string &key = w.key;
+    const size_t size = w.p_data->i_buffer;
+    const std::string name = getFilename(key);
+    const std::string path = store->dir + DIR_SEP + name;
+    /* unique among the threads and processes sharing the directory */
+    std::string tmppath = path + ".XXXXXX";
+
+    int fd = vlc_mkstemp(&tmppath[0]);
+    if(fd == -1)
+        return;
+    FILE *stream = fdopen(fd, "wb");
+    if(!stream)
+    {
+        vlc_close(fd);
+        vlc_unlink(tmppath.c_str());
+        return;
+    }
+
+    uint8_t expires[8];
+    uint8_t size64[8];
+    SetQWBE(expires, w.validators.expires);
+    SetQWBE(size64, size);
+    bool b_ok = fwrite(CACHE_MAGIC, 8, 1, stream) == 1 &&
+                WriteString(stream, key) &&
+                WriteString(stream, w.contentType) &&
+                WriteString(stream, w.validators.etag) &&
+                WriteString(stream, w.validators.lastModified) &&
+                fwrite(expires, 8, 1, stream) == 1 &&
+                fwrite(size64, 8, 1, stream) == 1 &&
+                fwrite(w.p_data->p_buffer, size, 1, stream) == 1;
+
+    const long filesize = ftell(stream); /* accounted with the header */
+    if(fclose(stream) || !b_ok || filesize < 0)
+    {
+        vlc_unlink(tmppath.c_str());
+        return;
+    }
+
+    vlc_mutex_lock(&store->lock);
+    store->forget(name); /* replaced */
+    store->evict(filesize);
+    if(vlc_rename(tmppath.c_str(), path.c_str()))
+        vlc_unlink(tmppath.c_str());
+    else
+        store->touch(name, filesize);
+    vlc_mutex_unlock(&store->lock);
+}
+
+void SegmentCache::hit(size_t size, bool revalidated)
+{
+    vlc_mutex_lock(&lock);
+    stats.hits++;
+    stats.hitbytes += size;
+    if(revalidated)
+        stats.revalidated++;
+    vlc_mutex_unlock(&lock);
+}
+
+void SegmentCache::miss(size_t size)
+{
+    vlc_mutex_lock(&lock);
+    stats.misses++;
+    stats.missbytes += size;
+    vlc_mutex_unlock(&lock);
+}
@@ -0,0 +1,130 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include "ConnectionParams.hpp"
+
+#include <vlc_common.h>
+#include <list>
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* Disk store of downloaded chunks, by storage ID (url and range).
+         * Files are evicted least recently used first above the size limit,
+         * and outlive the demuxer so that looped or replayed programs are
+         * served locally. Fresh copies are used as is, others are
+         * revalidated, so chunks without validators are only stored while
+         * they are fresh. Chunks are written by a background thread, which
+         * also lists the files of the previous sessions. */
+        class SegmentCache
+        {
+            public:
+                class Entry
+                {
+                    public:
+                        Entry();
+                        ~Entry();
+                        block_t        *p_data;
+                        std::string     contentType;
+                        CacheValidators validators;
+                };
+
+                SegmentCache(vlc_object_t *, const std::string &dir, size_t maxsize);
+                ~SegmentCache();
+                bool get(const std::string &, Entry *);
+                void put(const std::string &, const block_t *, const std::string &,
+                         const CacheValidators &);
+                void flush();
+                void hit(size_t, bool revalidated);
+                void miss(size_t);
+                static std::string defaultDirectory();
+
+            private:
+                class File
+                {
+                    public:
+                        std::string name;
+                        size_t      size;
+                };
+                class PendingWrite
+                {
+                    public:
+                        std::string     key;
+                        block_t        *p_data;
+                        std::string     contentType;
+                        CacheValidators validators;
+                };
+                /* Files of a directory, accounted once for all the caches
+                 * of the process using it */
+                class Store
+                {
+                    public:
+                        static Store * acquire(const std::string &, size_t);
+                        void release();
+                        void scan();
+                        void touch(const std::string &, size_t);
+                        void forget(const std::string &);
+                        void evict(size_t);
+                        std::string dir;
+                        size_t maxsize;
+                        vlc_mutex_t lock;
+                        bool scanning; /* by the first writer thread */
+                        bool listed; /* files not listed yet are looked up */
+                        size_t total;
+                        std::list<File> files; /* most recently used first */
+                        std::map<std::string, std::list<File>::iterator> index;
+
+                    private:
+                        Store(const std::string &, size_t);
+                        ~Store();
+                        unsigned refs;
+                        static vlc_mutex_t storesLock;
+                        static std::map<std::string, Store *> stores;
+                };
+                static void * writerThread(void *);
+                void write(const PendingWrite &);
+                std::string getFilename(const std::string &) const;
+                vlc_object_t *p_obj;
+                vlc_mutex_t lock;
+                vlc_cond_t cond;
+                vlc_thread_t thread;
+                bool b_thread;
+                bool b_stop;
+                std::list<PendingWrite> pending; /* oldest first */
+                size_t pendingsize;
+                Store *store;
+                struct
+                {
+                    unsigned hits;
+                    unsigned revalidated;
+                    unsigned misses;
+                    uint64_t hitbytes;
+                    uint64_t missbytes;
+                } stats;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -50,6 +50,8 @@ namespace adaptive
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *) = 0;
                 virtual void                updateDownloadRate     (const ID &, size_t,
                                                                     mtime_t, mtime_t) override;
+                virtual void                updateDownloadProgress (size_t, vlc_tick_t,
+                                                                    vlc_tick_t) override {}
                 virtual void                trackerEvent           (const TrackerEvent &) override {}
                 void                        setMaxDeviceResolution (int, int);
 
@@ -62,6 +64,7 @@ namespace adaptive
                     FixedRate,
                     Predictive,
                     NearOptimal,
+                    Hybrid,
                 };
 
             protected:
@@ -38,6 +38,7 @@ using namespace adaptive::playlist;
 using namespace adaptive::logic;
 
 const vlc_tick_t AbstractBufferingLogic::BUFFERING_LOWEST_LIMIT = CLOCK_FREQ * 2;
+const vlc_tick_t AbstractBufferingLogic::LOW_LATENCY_MIN_BUFFERING = CLOCK_FREQ / 2;
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_MIN_BUFFERING = CLOCK_FREQ * 6;
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_MAX_BUFFERING = CLOCK_FREQ * 30;
 const vlc_tick_t AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING = CLOCK_FREQ * 15;
@@ -47,6 +48,7 @@ AbstractBufferingLogic::AbstractBufferingLogic()
     userMinBuffering = 0;
     userMaxBuffering = 0;
     userLiveDelay = 0;
+    deliveryJitter = 0;
 }
 
 void AbstractBufferingLogic::setLowDelay(bool b)
@@ -54,6 +56,11 @@ void AbstractBufferingLogic::setLowDelay(bool b)
     userLowLatency = b;
 }
 
+void AbstractBufferingLogic::setDeliveryJitter(vlc_tick_t v)
+{
+    deliveryJitter = v;
+}
+
 void AbstractBufferingLogic::setUserMinBuffering(vlc_tick_t v)
 {
     userMinBuffering = v;
@@ -103,7 +110,13 @@ uint64_t DefaultBufferingLogic::getStartSegmentNumber(BaseRepresentation *rep) c
 vlc_tick_t DefaultBufferingLogic::getMinBuffering(const BasePlaylist *p) const
 {
     if(isLowLatency(p))
-        return BUFFERING_LOWEST_LIMIT;
+    {
+        /* Only needs to bridge the longest wait for data, once known */
+        if(deliveryJitter == 0)
+            return BUFFERING_LOWEST_LIMIT;
+        return std::min(BUFFERING_LOWEST_LIMIT,
+                        std::max(LOW_LATENCY_MIN_BUFFERING, deliveryJitter * 2));
+    }
 
     vlc_tick_t buffering = userMinBuffering ? userMinBuffering
                                          : DEFAULT_MIN_BUFFERING;
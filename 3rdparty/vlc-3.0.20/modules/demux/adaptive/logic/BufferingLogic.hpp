@@ -47,11 +47,14 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const = 0;
+                virtual bool isLowLatency(const BasePlaylist *) const = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
                 void setLowDelay(bool);
+                void setDeliveryJitter(vlc_tick_t);
                 static const vlc_tick_t BUFFERING_LOWEST_LIMIT;
+                static const vlc_tick_t LOW_LATENCY_MIN_BUFFERING;
                 static const vlc_tick_t DEFAULT_MIN_BUFFERING;
                 static const vlc_tick_t DEFAULT_MAX_BUFFERING;
                 static const vlc_tick_t DEFAULT_LIVE_BUFFERING;
@@ -61,6 +64,7 @@ namespace adaptive
                 vlc_tick_t userMaxBuffering;
                 vlc_tick_t userLiveDelay;
                 Undef<bool> userLowLatency;
+                vlc_tick_t deliveryJitter; /* measured, 0 if unknown */
         };
 
         class DefaultBufferingLogic : public AbstractBufferingLogic
@@ -73,13 +77,13 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const override;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const override;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const override;
+                virtual bool isLowLatency(const BasePlaylist *) const override;
                 static const unsigned SAFETY_BUFFERING_EDGE_OFFSET;
                 static const unsigned SAFETY_EXPURGING_OFFSET;
 
             protected:
                 vlc_tick_t getBufferingOffset(const BasePlaylist *) const;
                 uint64_t getLiveStartSegmentNumber(BaseRepresentation *) const;
-                bool isLowLatency(const BasePlaylist *) const;
         };
     }
 }
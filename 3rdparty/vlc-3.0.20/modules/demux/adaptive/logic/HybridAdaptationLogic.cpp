@@ -0,0 +1,267 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../SegmentTracker.hpp"
+#include "../tools/Debug.hpp"
+
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput rule below the low threshold, buffer rule (BOLA-O) above the
+ * high one, as in DYNAMIC: Sprint, Spiteri, Sitaraman, Stohr
+ * "From Theory to Practice: Improving Bitrate Adaptation in the DASH
+ * Reference Player" https://arxiv.org/abs/1811.06325
+ */
+
+#define minimumBufferS   (CLOCK_FREQ * 6)  /* Qmin, and back to throughput rule */
+#define bufferTargetS    (CLOCK_FREQ * 30) /* Qmax */
+#define bufferRuleS      (CLOCK_FREQ * 10) /* switch to buffer rule above */
+#define fastHalfLifeS    3.0
+#define slowHalfLifeS    8.0
+#define safetyFactor     0.9
+#define upSwitchHold     2 /* segments */
+#define throughputWindow (CLOCK_FREQ / 4)
+
+HybridContext::HybridContext()
+    : buffering_level( 0 )
+    , buffering_target( bufferTargetS )
+    , bandwidth( 0 )
+    , buffer_mode( false )
+    , downloads( 0 )
+{ }
+
+HybridAdaptationLogic::HybridAdaptationLogic( vlc_object_t *obj )
+    : AbstractAdaptationLogic(obj)
+    , meter( throughputWindow )
+    , fast_bps( 0 )
+    , slow_bps( 0 )
+    , has_estimate( false )
+{
+    vlc_mutex_init(&lock);
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+    vlc_mutex_destroy(&lock);
+}
+
+BaseRepresentation *
+HybridAdaptationLogic::getBufferBased(BaseAdaptationSet *adaptSet, RepresentationSelector &selector,
+                                      const HybridContext &ctx) const
+{
+    BaseRepresentation *lowest = selector.lowest(adaptSet);
+    BaseRepresentation *highest = selector.highest(adaptSet);
+    const float smin = lowest->getBandwidth();
+    /* utilities can't be compared without declared bandwidths */
+    if(smin <= 0)
+        return nullptr;
+    const vlc_tick_t target = std::max(ctx.buffering_target, bufferRuleS);
+
+    /* utility is 1 + log(S/Smin), parameters as in dash.js */
+    const float umax = 1.0 + std::log(highest->getBandwidth() / smin);
+    const float gammaP = (umax - 1.0) / ((float)target / minimumBufferS - 1.0);
+    const float Vp = ((float)minimumBufferS / CLOCK_FREQ) / gammaP;
+    const float Q = (float)ctx.buffering_level / CLOCK_FREQ;
+
+    BaseRepresentation *ret = nullptr;
+    BaseRepresentation *prev = nullptr;
+    float argmax = 0;
+    for(BaseRepresentation *rep = lowest; rep && rep != prev;
+        rep = selector.higher(adaptSet, rep))
+    {
+        const float utility = 1.0 + std::log(rep->getBandwidth() / smin);
+        const float arg = (Vp * (utility + gammaP) - Q) / rep->getBandwidth();
+        if(ret == nullptr || argmax <= arg)
+        {
+            ret = rep;
+            argmax = arg;
+        }
+        prev = rep;
+    }
+    return ret;
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet,
+                                                                 BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    BaseRepresentation *lowest = selector.lowest(adaptSet);
+    BaseRepresentation *highest = selector.highest(adaptSet);
+    if(lowest == nullptr || highest == nullptr)
+        return nullptr;
+
+    if(lowest == highest)
+        return lowest;
+
+    vlc_mutex_lock(&lock);
+    std::map<ID, HybridContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end())
+    {
+        vlc_mutex_unlock(&lock);
+        return lowest;
+    }
+    HybridContext &ctx = (*it).second;
+
+    /* Hysteresis between the two rules */
+    if(ctx.buffer_mode && ctx.buffering_level < minimumBufferS)
+        ctx.buffer_mode = false;
+    else if(!ctx.buffer_mode && ctx.buffering_level >= bufferRuleS)
+        ctx.buffer_mode = true;
+
+    BaseRepresentation *m;
+    BaseRepresentation *throughputRep = nullptr;
+    if(has_estimate)
+    {
+        /* the link is shared with the other streams */
+        uint64_t others = 0;
+        for(const auto &s : streams)
+            if(&s.second != &ctx)
+                others += s.second.bandwidth;
+        double bps = std::min(fast_bps, slow_bps) * safetyFactor;
+        bps = (bps > others) ? bps - others : 0;
+        throughputRep = selector.select(adaptSet, bps);
+    }
+
+    if(prevRep == nullptr || throughputRep == nullptr) /* Starting */
+    {
+        m = throughputRep ? throughputRep : lowest;
+    }
+    else if(ctx.buffer_mode)
+    {
+        m = getBufferBased(adaptSet, selector, ctx);
+        if(m == nullptr)
+            m = throughputRep;
+        /* Don't go above both the sustainable and the current rate */
+        else if(m->getBandwidth() > prevRep->getBandwidth() &&
+           m->getBandwidth() > throughputRep->getBandwidth())
+            m = (prevRep->getBandwidth() > throughputRep->getBandwidth()) ? prevRep
+                                                                        : throughputRep;
+    }
+    else
+    {
+        m = throughputRep;
+    }
+
+    if(prevRep && m->getBandwidth() > prevRep->getBandwidth() &&
+       ctx.downloads < upSwitchHold)
+        m = prevRep;
+
+    if(m != prevRep)
+        ctx.downloads = 0;
+    ctx.bandwidth = m->getBandwidth();
+
+    BwDebug(msg_Info(p_obj, "%s rule, buffering level %.2fs rep %" PRIu64 " kBps",
+                     ctx.buffer_mode ? "buffer" : "throughput",
+                     (float) ctx.buffering_level / CLOCK_FREQ, m->getBandwidth() / 8000));
+
+    vlc_mutex_unlock(&lock);
+
+    return m;
+}
+
+void HybridAdaptationLogic::updateDownloadRate(const ID &id, size_t, mtime_t, mtime_t)
+{
+    vlc_mutex_lock(&lock);
+    std::map<ID, HybridContext>::iterator it = streams.find(id);
+    if(it != streams.end())
+        (*it).second.downloads++;
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::updateDownloadProgress(size_t size,
+                                                   vlc_tick_t start, vlc_tick_t end)
+{
+    vlc_mutex_lock(&lock);
+    size_t bps;
+    vlc_tick_t busy;
+    if(meter.push(size, start, end, &bps, &busy))
+    {
+        if(!has_estimate)
+        {
+            fast_bps = slow_bps = bps;
+            has_estimate = true;
+        }
+        else
+        {
+            /* weighted by the time the link was busy */
+            const double seconds = (double) busy / CLOCK_FREQ;
+            const double fast = std::pow(0.5, seconds / fastHalfLifeS);
+            const double slow = std::pow(0.5, seconds / slowHalfLifeS);
+            fast_bps = fast * fast_bps + (1.0 - fast) * bps;
+            slow_bps = slow * slow_bps + (1.0 - slow) * bps;
+        }
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::trackerEvent(const TrackerEvent &ev)
+{
+    switch(ev.getType())
+    {
+    case TrackerEvent::Type::BufferingStateUpdate:
+        {
+            const BufferingStateUpdatedEvent &event =
+                    static_cast<const BufferingStateUpdatedEvent &>(ev);
+            const ID &id = *event.id;
+            vlc_mutex_lock(&lock);
+            if(event.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                    streams.insert(std::pair<ID, HybridContext>(id, HybridContext()));
+            }
+            else
+            {
+                streams.erase(id);
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case TrackerEvent::Type::BufferingLevelChange:
+        {
+            const BufferingLevelChangedEvent &event =
+                    static_cast<const BufferingLevelChangedEvent &>(ev);
+            const ID &id = *event.id;
+            vlc_mutex_lock(&lock);
+            std::map<ID, HybridContext>::iterator it = streams.find(id);
+            if(it != streams.end())
+            {
+                (*it).second.buffering_level = event.current;
+                (*it).second.buffering_target = event.target;
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * HybridAdaptationLogic.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HYBRIDADAPTATIONLOGIC_HPP
+#define HYBRIDADAPTATIONLOGIC_HPP
+
+#include "AbstractAdaptationLogic.h"
+#include "Representationselectors.hpp"
+#include "../tools/ThroughputMeter.hpp"
+#include <map>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        class HybridContext
+        {
+            friend class HybridAdaptationLogic;
+
+            public:
+                HybridContext();
+
+            private:
+                vlc_tick_t buffering_level;
+                vlc_tick_t buffering_target;
+                uint64_t   bandwidth; /* of the representation in use */
+                bool       buffer_mode; /* BOLA, when the buffer is safe */
+                unsigned   downloads; /* since last switch */
+        };
+
+        /*
+         * Picks by throughput while the buffer is low, and by buffer
+         * occupancy (BOLA) once it is safe, with a cap to the sustainable
+         * rate to avoid oscillations. Switching up needs a few segments
+         * downloaded since the last switch. The throughput is measured on
+         * the link, across the parallel downloads of all the streams, and
+         * each stream gets what the others do not use.
+         */
+        class HybridAdaptationLogic : public AbstractAdaptationLogic
+        {
+            public:
+                HybridAdaptationLogic(vlc_object_t *);
+                virtual ~HybridAdaptationLogic();
+
+                virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *,
+                                                                  BaseRepresentation *) override;
+                virtual void                updateDownloadRate     (const ID &, size_t,
+                                                                    mtime_t, mtime_t) override;
+                virtual void                updateDownloadProgress (size_t, vlc_tick_t,
+                                                                    vlc_tick_t) override;
+                virtual void                trackerEvent           (const TrackerEvent &) override;
+
+            private:
+                BaseRepresentation *        getBufferBased(BaseAdaptationSet *,
+                                                           RepresentationSelector &,
+                                                           const HybridContext &) const;
+                std::map<adaptive::ID, HybridContext> streams;
+                ThroughputMeter             meter;
+                double                      fast_bps; /* throughput averages */
+                double                      slow_bps;
+                bool                        has_estimate;
+                vlc_mutex_t                 lock;
+        };
+    }
+}
+
+#endif // HYBRIDADAPTATIONLOGIC_HPP
@@ -36,6 +36,10 @@ namespace adaptive
         public:
             virtual void updateDownloadRate(const ID &, size_t,
                                             mtime_t, mtime_t) = 0;
+            /* bytes received by a single read of any transfer, with the
+             * time the read started and ended */
+            virtual void updateDownloadProgress(size_t, vlc_tick_t,
+                                                vlc_tick_t) = 0;
             virtual ~IDownloadRateObserver(){}
     };
 }
@@ -39,11 +39,10 @@ using namespace adaptive;
 RateBasedAdaptationLogic::RateBasedAdaptationLogic  (vlc_object_t *obj) :
                           AbstractAdaptationLogic   (obj),
                           bpsAvg(0),
-                          currentBps(0)
+                          currentBps(0),
+                          meter(CLOCK_FREQ / 4)
 {
     usedBps = 0;
-    dllength = 0;
-    dlsize = 0;
     vlc_mutex_init(&lock);
 }
 
@@ -77,21 +76,19 @@ BaseRepresentation *RateBasedAdaptationLogic::getNextRepresentation(BaseAdaptati
     return rep;
 }
 
-void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size,
-                                                  vlc_tick_t time, mtime_t)
+void RateBasedAdaptationLogic::updateDownloadProgress(size_t size,
+                                                      vlc_tick_t start, vlc_tick_t end)
 {
-    if(unlikely(time == 0))
-        return;
-    /* Accumulate up to observation window */
-    dllength += time;
-    dlsize += size;
-
-    if(dllength < CLOCK_FREQ / 4)
+    vlc_mutex_lock(&lock);
+    /* Accumulate up to observation window, segments can be downloaded
+     * in parallel */
+    size_t bps;
+    if(!meter.push(size, start, end, &bps))
+    {
+        vlc_mutex_unlock(&lock);
         return;
+    }
 
-    const size_t bps = CLOCK_FREQ * dlsize * 8 / dllength;
-
-    vlc_mutex_lock(&lock);
     bpsAvg = average.push(bps);
 
 //    BwDebug(msg_Dbg(p_obj, "alpha1 %lf alpha0 %lf dmax %ld ds %ld", alpha,
@@ -100,7 +97,6 @@ void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size,
                             bps / 8000, bpsAvg / 8000));
 
     currentBps = bpsAvg * 3/4;
-    dlsize = dllength = 0;
 
     BwDebug(msg_Info(p_obj, "Current bandwidth %zu KiB/s using %u%%",
                     (bpsAvg / 8000), (bpsAvg) ? (unsigned)(usedBps * 100.0 / bpsAvg) : 0));
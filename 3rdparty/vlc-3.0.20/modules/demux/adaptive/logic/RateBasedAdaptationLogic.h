@@ -27,6 +27,7 @@
 
 #include "AbstractAdaptationLogic.h"
 #include "../tools/MovingAverage.hpp"
+#include "../tools/ThroughputMeter.hpp"
 
 namespace adaptive
 {
@@ -41,8 +42,8 @@ namespace adaptive
 
                 BaseRepresentation *getNextRepresentation(BaseAdaptationSet *,
                                                           BaseRepresentation *) override;
-                virtual void updateDownloadRate(const ID &, size_t,
-                                                mtime_t, mtime_t) override;
+                virtual void updateDownloadProgress(size_t, vlc_tick_t,
+                                                    vlc_tick_t) override;
                 virtual void trackerEvent(const TrackerEvent &) override;
 
             private:
@@ -51,9 +52,7 @@ namespace adaptive
                 size_t                  usedBps;
 
                 MovingAverage<size_t>   average;
-
-                size_t                  dlsize;
-                vlc_tick_t              dllength;
+                ThroughputMeter         meter;
 
                 mutable vlc_mutex_t     lock;
         };
@@ -31,6 +31,7 @@
 #include "BaseRepresentation.h"
 #include "BasePlaylist.hpp"
 #include "SegmentChunk.hpp"
+#include "CodecDescription.hpp"
 #include "../SharedResources.hpp"
 #include "../http/BytesRange.hpp"
 #include "../http/HTTPConnectionManager.h"
@@ -77,6 +78,33 @@ bool ISegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRepre
     return true;
 }
 
+/* Relative weight of the track transfers when they share a connection:
+ * audio first, as it is small and the first to underrun */
+static unsigned getTransferPriority(const BaseRepresentation *rep)
+{
+    CodecDescriptionList descs;
+    rep->getCodecsDesc(&descs);
+    unsigned priority = 0;
+    for(const CodecDescription *desc : descs)
+    {
+        switch(desc->getFmt()->i_cat)
+        {
+            case VIDEO_ES:
+                return 128; /* muxed, goes at the video pace */
+            case AUDIO_ES:
+                priority = 256;
+                break;
+            case SPU_ES:
+                if(priority == 0)
+                    priority = 32;
+                break;
+            default:
+                break;
+        }
+    }
+    return priority;
+}
+
 SegmentChunk* ISegment::toChunk(SharedResources *res, size_t index, BaseRepresentation *rep)
 {
     const std::string url = getUrlSegment().toString(index, rep);
@@ -96,6 +124,7 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, size_t index, BaseRepresen
                                                           range);
     if(source)
     {
+        source->setPriority(getTransferPriority(rep));
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
         {
@@ -233,6 +233,9 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
         return;
     }
 
+    /* start of the update window */
+    const stime_t windowstart = other.elements.empty() ? 0 : other.elements.front()->t;
+
     Element *last = elements.back();
     while(other.elements.size())
     {
@@ -259,6 +262,19 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
             last = el;
         }
     }
+
+    /* drop what left the window, or it would grow for the whole session */
+    for(const Element *el : elements)
+    {
+        if(windowstart < el->t + el->d * (stime_t)(el->r + 1))
+        {
+            if(windowstart > el->t)
+                pruneBySequenceNumber(el->number + (windowstart - el->t) / el->d);
+            else
+                pruneBySequenceNumber(el->number);
+            break;
+        }
+    }
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
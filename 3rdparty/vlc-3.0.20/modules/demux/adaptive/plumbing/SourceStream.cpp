@@ -142,10 +142,16 @@ ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
 
     while(i_toread && !b_eof)
     {
-        if(!p_block && !(p_block = source->readNextBlock()))
+        if(!p_block)
         {
-            b_eof = true;
-            break;
+            /* partial reads return what arrived, vlc_stream_Read() loops */
+            if(i_copied)
+                break;
+            if(!(p_block = source->readNextBlock()))
+            {
+                b_eof = true;
+                break;
+            }
         }
 
         if(p_block->i_buffer > i_toread)
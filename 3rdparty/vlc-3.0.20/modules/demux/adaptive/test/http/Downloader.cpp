@@ -0,0 +1,260 @@
+/*****************************************************************************
+ * Downloader.cpp: concurrent segment downloads and scheduling order tests
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/HTTPConnectionManager.h"
+#include "../../http/HTTPConnection.hpp"
+#include "../../http/ConnectionParams.hpp"
+#include "../../http/Chunk.h"
+#include "../../ID.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+
+#include <map>
+#include <vector>
+#include <string>
+#include <cstring>
+
+using namespace adaptive;
+using namespace adaptive::http;
+
+/* Fake servers which hold the transfers until their gate opens, recording
+ * concurrent transfers */
+class GatedServers
+{
+    public:
+        GatedServers(unsigned openat = 0)
+        {
+            vlc_mutex_init(&lock);
+            vlc_cond_init(&cond);
+            total = maxtotal = 0;
+            opened = false;
+            openAt = openat;
+        }
+        ~GatedServers()
+        {
+            vlc_cond_destroy(&cond);
+            vlc_mutex_destroy(&lock);
+        }
+        /* opens the gate, or once openAt transfers are running */
+        void open()
+        {
+            vlc_mutex_locker locker(&lock);
+            opened = true;
+            vlc_cond_broadcast(&cond);
+        }
+        void transfer(const std::string &host)
+        {
+            vlc_mutex_locker locker(&lock);
+            if(++active[host] > maxactive[host])
+                maxactive[host] = active[host];
+            if(++total > maxtotal)
+                maxtotal = total;
+            if(openAt && total >= openAt)
+                opened = true;
+            vlc_cond_broadcast(&cond);
+            while(!opened)
+                vlc_cond_wait(&cond, &lock);
+            active[host]--;
+            total--;
+        }
+        void request(const std::string &path)
+        {
+            vlc_mutex_locker locker(&lock);
+            requests.push_back(path);
+            vlc_cond_broadcast(&cond);
+        }
+        void waitRequest()
+        {
+            vlc_mutex_locker locker(&lock);
+            while(requests.empty())
+                vlc_cond_wait(&cond, &lock);
+        }
+
+        vlc_mutex_t lock;
+        vlc_cond_t cond;
+        bool opened;
+        unsigned openAt;
+        std::map<std::string, unsigned> active;
+        std::map<std::string, unsigned> maxactive;
+        unsigned total;
+        unsigned maxtotal;
+        std::vector<std::string> requests;
+};
+
+class GatedConnection : public AbstractConnection
+{
+    public:
+        GatedConnection(GatedServers *s) : AbstractConnection(nullptr)
+        {
+            servers = s;
+        }
+        virtual bool canReuse(const ConnectionParams &params_) const override
+        {
+            return available && params.getHostname() == params_.getHostname();
+        }
+        virtual RequestStatus request(const std::string &path,
+                                      const BytesRange &,
+                                      const CacheValidators *) override
+        {
+            servers->request(path);
+            /* path encodes the number of slices to send */
+            contentLength = HTTPChunkSource::CHUNK_SIZE * (path[1] - '0') + 1;
+            bytesRead = 0;
+            return RequestStatus::Success;
+        }
+        virtual ssize_t read(void *p_buffer, size_t len) override
+        {
+            if(bytesRead >= contentLength)
+                return 0;
+            servers->transfer(params.getHostname());
+            len = std::min(len, contentLength - bytesRead);
+            memset(p_buffer, 0, len);
+            bytesRead += len;
+            return len;
+        }
+        virtual void setUsed(bool b) override
+        {
+            available = !b;
+        }
+
+    private:
+        GatedServers *servers;
+};
+
+class GatedConnectionFactory : public AbstractConnectionFactory
+{
+    public:
+        GatedConnectionFactory(GatedServers *s)
+        {
+            servers = s;
+        }
+        virtual AbstractConnection * createConnection(vlc_object_t *,
+                                                      const ConnectionParams &) override
+        {
+            return new GatedConnection(servers);
+        }
+
+    private:
+        GatedServers *servers;
+};
+
+static size_t Download(AbstractChunkSource *source)
+{
+    size_t total = 0;
+    block_t *p_block;
+    while((p_block = source->readBlock()))
+    {
+        total += p_block->i_buffer;
+        block_Release(p_block);
+    }
+    return total;
+}
+
+static void ParallelTransfers_test()
+{
+    /* held until two transfers run at once */
+    GatedServers servers(2);
+    HTTPConnectionManager *manager = new HTTPConnectionManager(nullptr, 2);
+    manager->addFactory(new GatedConnectionFactory(&servers));
+
+    const char *urls[] = { "http://a.test/4a", "http://a.test/4b",
+                           "http://a.test/4c", "http://b.test/4d" };
+    std::vector<AbstractChunkSource *> sources;
+    for(const char *url : urls)
+    {
+        AbstractChunkSource *source = manager->makeSource(url, ID(url),
+                                                          ChunkType::Segment,
+                                                          BytesRange());
+        manager->start(source);
+        sources.push_back(source);
+    }
+
+    for(AbstractChunkSource *source : sources)
+    {
+        Expect(Download(source) == HTTPChunkSource::CHUNK_SIZE * 4 + 1);
+        manager->recycleSource(source);
+    }
+    delete manager;
+
+    /* concurrent transfers, up to the per server limit, which is also the
+     * number of workers */
+    Expect(servers.requests.size() == 4);
+    Expect(servers.maxactive["a.test"] == 2);
+    Expect(servers.maxactive["b.test"] == 1);
+    Expect(servers.maxtotal == 2);
+}
+
+static void Priority_test()
+{
+    GatedServers servers;
+    HTTPConnectionManager *manager = new HTTPConnectionManager(nullptr, 1);
+    manager->addFactory(new GatedConnectionFactory(&servers));
+
+    /* occupy the single connection */
+    AbstractChunkSource *busy = manager->makeSource("http://a.test/8x", ID("x"),
+                                                    ChunkType::Segment, BytesRange());
+    manager->start(busy);
+    servers.waitRequest();
+
+    manager->updateBufferingLevel(ID("full"), 10 * CLOCK_FREQ);
+    manager->updateBufferingLevel(ID("starving"), CLOCK_FREQ);
+    AbstractChunkSource *full = manager->makeSource("http://a.test/1f", ID("full"),
+                                                    ChunkType::Segment, BytesRange());
+    manager->start(full);
+    AbstractChunkSource *starving = manager->makeSource("http://a.test/1s", ID("starving"),
+                                                        ChunkType::Segment, BytesRange());
+    manager->start(starving);
+    servers.open();
+
+    Expect(Download(busy) == HTTPChunkSource::CHUNK_SIZE * 8 + 1);
+    Expect(Download(full) == HTTPChunkSource::CHUNK_SIZE + 1);
+    Expect(Download(starving) == HTTPChunkSource::CHUNK_SIZE + 1);
+    manager->recycleSource(busy);
+    manager->recycleSource(full);
+    manager->recycleSource(starving);
+    delete manager;
+
+    /* lowest buffering level is served first */
+    Expect(servers.requests.size() == 3);
+    Expect(servers.requests[0] == "/8x");
+    Expect(servers.requests[1] == "/1s");
+    Expect(servers.requests[2] == "/1f");
+    Expect(servers.maxactive["a.test"] == 1);
+}
+
+int Downloader_test()
+{
+    try
+    {
+        ParallelTransfers_test();
+        Priority_test();
+    }
+    catch (...)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/HTTPConnectionManager.h"
+#include "../../http/HTTPConnection.hpp"
+#include "../../http/ConnectionParams.hpp"
+#include "../../http/Chunk.h"
+#include "../../logic/BufferingLogic.hpp"
+#include "../../logic/IDownloadRateObserver.h"
+#include "../../plumbing/SourceStream.hpp"
+#include "../../AbstractSource.hpp"
+#include "../../playlist/BasePlaylist.hpp"
+#include "../../ID.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+#include <vlc_stream.h>
+
+#include <cstring>
+
+using namespace adaptive;
+using namespace adaptive::http;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+
+/* Fake live encoder publishing a segment as small CMAF like chunks,
+ * one every 80ms, with a single hiccup in the middle. Each chunk then
+ * takes a few ms to cross the link, in parts */
+#define CHUNK_COUNT     10
+#define CHUNK_PARTS     4
+#define CHUNK_BYTES     2000
+#define CHUNK_INTERVAL  (CLOCK_FREQ * 8 / 100)
+#define CHUNK_HICCUP    (CLOCK_FREQ * 15 / 100)
+#define PART_INTERVAL   (CLOCK_FREQ * 4 / 1000)
+
+class ChunkedConnection : public AbstractConnection
+{
+    public:
+        ChunkedConnection() : AbstractConnection(nullptr)
+        {
+            vlc_mutex_init(&lock);
+            vlc_cond_init(&cond);
+            start = VLC_TICK_INVALID;
+            sent = 0;
+        }
+        virtual ~ChunkedConnection()
+        {
+            vlc_cond_destroy(&cond);
+            vlc_mutex_destroy(&lock);
+        }
+        virtual bool canReuse(const ConnectionParams &) const override
+        {
+            return available;
+        }
+        virtual RequestStatus request(const std::string &,
+                                      const BytesRange &,
+                                      const CacheValidators *) override
+        {
+            /* chunked transfer encoding: no Content-Length */
+            start = mdate();
+            sent = 0;
+            contentLength = 0;
+            bytesRead = 0;
+            return RequestStatus::Success;
+        }
+        virtual ssize_t readPartial(void *p_buffer, size_t len) override
+        {
+            if(sent == CHUNK_COUNT * CHUNK_PARTS)
+                return 0;
+            waitPart(sent);
+            len = std::min(len, (size_t) CHUNK_BYTES / CHUNK_PARTS);
+            memset(p_buffer, 0, len);
+            bytesRead += len;
+            sent++;
+            return len;
+        }
+        virtual ssize_t read(void *p_buffer, size_t len) override
+        {
+            size_t total = 0;
+            while(total < len)
+            {
+                ssize_t ret = readPartial((uint8_t *)p_buffer + total, len - total);
+                if(ret <= 0)
+                    break;
+                total += ret;
+            }
+            return total;
+        }
+        virtual void setUsed(bool b) override
+        {
+            available = !b;
+        }
+
+        static vlc_tick_t chunkTime(unsigned i)
+        {
+            return (i + 1) * CHUNK_INTERVAL + (i >= CHUNK_COUNT / 2 ? CHUNK_HICCUP : 0);
+        }
+
+    private:
+        void waitPart(unsigned i)
+        {
+            vlc_mutex_locker locker(&lock);
+            const vlc_tick_t deadline = start + chunkTime(i / CHUNK_PARTS) +
+                                        (i % CHUNK_PARTS) * PART_INTERVAL;
+            while(vlc_cond_timedwait(&cond, &lock, deadline) == 0);
+        }
+        vlc_mutex_t lock;
+        vlc_cond_t cond;
+        vlc_tick_t start;
+        unsigned sent;
+};
+
+class ChunkedConnectionFactory : public AbstractConnectionFactory
+{
+    public:
+        virtual AbstractConnection * createConnection(vlc_object_t *,
+                                                      const ConnectionParams &) override
+        {
+            return new ChunkedConnection();
+        }
+};
+
+class RateRecorder : public IDownloadRateObserver
+{
+    public:
+        RateRecorder()
+        {
+            size = 0;
+            time = 0;
+            progress = 0;
+        }
+        virtual void updateDownloadRate(const ID &, size_t s,
+                                        vlc_tick_t t, vlc_tick_t) override
+        {
+            size = s;
+            time = t;
+        }
+        virtual void updateDownloadProgress(size_t s, vlc_tick_t,
+                                            vlc_tick_t) override
+        {
+            progress += s;
+        }
+        size_t size;
+        vlc_tick_t time;
+        size_t progress;
+};
+
+/* Returns the delay until the first data, and the total size */
+static vlc_tick_t FirstData(HTTPConnectionManager *manager, size_t *total)
+{
+    AbstractChunkSource *source = manager->makeSource("http://live.test/seg", ID("live"),
+                                                      ChunkType::Segment, BytesRange());
+    const vlc_tick_t start = mdate();
+    manager->start(source);
+
+    vlc_tick_t first = VLC_TICK_INVALID;
+    block_t *p_block;
+    *total = 0;
+    while((p_block = source->readBlock()))
+    {
+        if(p_block->i_buffer && first == VLC_TICK_INVALID)
+            first = mdate() - start;
+        *total += p_block->i_buffer;
+        block_Release(p_block);
+    }
+    manager->recycleSource(source);
+    return first;
+}
+
+static void ChunkedDelivery_test()
+{
+    const vlc_tick_t end = ChunkedConnection::chunkTime(CHUNK_COUNT - 1);
+    const uint64_t encodedbps = CHUNK_BYTES * 8 * CLOCK_FREQ / CHUNK_INTERVAL;
+    RateRecorder rate;
+    size_t total;
+
+    /* default mode waits for the full read */
+    HTTPConnectionManager *manager = new HTTPConnectionManager(nullptr, 1);
+    manager->addFactory(new ChunkedConnectionFactory());
+    manager->setDownloadRateObserver(&rate);
+    Expect(FirstData(manager, &total) >= end);
+    Expect(total == CHUNK_COUNT * CHUNK_BYTES);
+    Expect(manager->getDeliveryJitter() == 0);
+    delete manager;
+    Expect(rate.size == total);
+    Expect(rate.progress == total);
+
+    /* low latency hands each chunk over as it arrives */
+    rate = RateRecorder();
+    manager = new HTTPConnectionManager(nullptr, 1);
+    manager->addFactory(new ChunkedConnectionFactory());
+    manager->setDownloadRateObserver(&rate);
+    manager->setLowLatency(true);
+    Expect(FirstData(manager, &total) < end / 2);
+    Expect(total == CHUNK_COUNT * CHUNK_BYTES);
+    /* the hiccup is the longest wait */
+    Expect(manager->getDeliveryJitter() >= CHUNK_HICCUP);
+    Expect(manager->getDeliveryJitter() < end);
+    delete manager;
+    /* only the parts following each chunk first one were timed: the rate
+     * is the link one, not the encoder one */
+    Expect(rate.size == CHUNK_COUNT * (CHUNK_PARTS - 1) * CHUNK_BYTES / CHUNK_PARTS);
+    Expect(rate.progress == rate.size);
+    Expect(rate.time > 0);
+    Expect(rate.size * 8 * CLOCK_FREQ / rate.time > 2 * encodedbps);
+}
+
+/* Source handing over a chunk at a time, as vlc_http_res_read() does */
+class ChunksSource : public AbstractSource
+{
+    public:
+        ChunksSource(unsigned n)
+        {
+            count = n;
+            pulled = 0;
+        }
+        virtual block_t *readNextBlock() override
+        {
+            if(pulled == count)
+                return nullptr;
+            block_t *p_block = block_Alloc(CHUNK_BYTES);
+            if(p_block)
+            {
+                memset(p_block->p_buffer, pulled, CHUNK_BYTES);
+                pulled++;
+            }
+            return p_block;
+        }
+        unsigned count;
+        unsigned pulled;
+};
+
+/* LibVLCHTTPConnection::readPartial() reads the chunks source stream */
+static void PartialRead_test()
+{
+    vlc_object_t *obj = static_cast<vlc_object_t*>(nullptr);
+    ChunksSource source(2);
+    ChunksSourceStream sourcestream(obj, &source);
+    stream_t *stream = sourcestream.makeStream();
+    Expect(stream);
+
+    uint8_t buf[CHUNK_BYTES * 4];
+    try
+    {
+        /* never waits for the next chunk once it has data */
+        Expect(vlc_stream_ReadPartial(stream, buf, sizeof(buf)) == CHUNK_BYTES);
+        Expect(source.pulled == 1);
+        Expect(vlc_stream_ReadPartial(stream, buf, CHUNK_BYTES / 2) == CHUNK_BYTES / 2);
+        Expect(vlc_stream_ReadPartial(stream, buf, sizeof(buf)) == CHUNK_BYTES / 2);
+        Expect(source.pulled == 2);
+        /* full reads still go through the chunks */
+        source.count = 4;
+        Expect(vlc_stream_Read(stream, buf, sizeof(buf)) == CHUNK_BYTES * 2);
+        Expect(buf[0] == 2 && buf[CHUNK_BYTES] == 3);
+        Expect(vlc_stream_ReadPartial(stream, buf, sizeof(buf)) == 0);
+    }
+    catch(...)
+    {
+        vlc_stream_Delete(stream);
+        throw;
+    }
+    vlc_stream_Delete(stream);
+}
+
+static void JitterBuffering_test()
+{
+    vlc_object_t *obj = static_cast<vlc_object_t*>(nullptr);
+    BasePlaylist *pl = new BasePlaylist(obj);
+    DefaultBufferingLogic bufferingLogic;
+    bufferingLogic.setLowDelay(true);
+
+    /* unknown jitter */
+    Expect(bufferingLogic.getMinBuffering(pl) == AbstractBufferingLogic::BUFFERING_LOWEST_LIMIT);
+
+    bufferingLogic.setDeliveryJitter(CLOCK_FREQ / 100);
+    Expect(bufferingLogic.getMinBuffering(pl) == AbstractBufferingLogic::LOW_LATENCY_MIN_BUFFERING);
+
+    bufferingLogic.setDeliveryJitter(CLOCK_FREQ * 4 / 10);
+    Expect(bufferingLogic.getMinBuffering(pl) == CLOCK_FREQ * 8 / 10);
+    Expect(bufferingLogic.getMaxBuffering(pl) == CLOCK_FREQ * 8 / 10);
+    Expect(bufferingLogic.getStableBuffering(pl) == CLOCK_FREQ * 8 / 10);
+
+    bufferingLogic.setDeliveryJitter(CLOCK_FREQ * 5);
+    Expect(bufferingLogic.getMinBuffering(pl) == AbstractBufferingLogic::BUFFERING_LOWEST_LIMIT);
+
+    /* normal mode ignores the jitter */
+    bufferingLogic.setLowDelay(false);
+    Expect(bufferingLogic.getMinBuffering(pl) == AbstractBufferingLogic::DEFAULT_MIN_BUFFERING);
+
+    delete pl;
+}
+
+int LowLatency_test()
+{
+    try
+    {
+        ChunkedDelivery_test();
+        PartialRead_test();
+        JitterBuffering_test();
+    }
+    catch (...)
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*****************************************************************************
+ * SegmentCache.cpp: disk segment cache and revalidation tests
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/HTTPConnectionManager.h"
+#include "../../http/HTTPConnection.hpp"
+#include "../../http/ConnectionParams.hpp"
+#include "../../http/SegmentCache.hpp"
+#include "../../http/Chunk.h"
+#include "../../ID.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#include <map>
+#include <string>
+#include <cstring>
+#include <unistd.h>
+
+using namespace adaptive;
+using namespace adaptive::http;
+
+/* concurrent test runs must not share their files */
+static std::string cacheDir;
+
+/* Stand-in server: the content of a path is the path, repeated to size,
+ * and its version is its ETag */
+class Origin
+{
+    public:
+        Origin()
+        {
+            transfers = notmodified = 0;
+            lifetime = 0;
+            nostore = chunked = false;
+        }
+        std::map<std::string, std::string> versions; /* none if empty */
+        unsigned transfers;
+        unsigned notmodified;
+        time_t lifetime; /* max-age */
+        bool nostore;
+        bool chunked; /* unknown length */
+};
+
+class OriginConnection : public AbstractConnection
+{
+    public:
+        OriginConnection(Origin *o) : AbstractConnection(nullptr)
+        {
+            origin = o;
+        }
+        virtual bool canReuse(const ConnectionParams &params_) const override
+        {
+            return available && params.getHostname() == params_.getHostname();
+        }
+        virtual RequestStatus request(const std::string &path,
+                                      const BytesRange &,
+                                      const CacheValidators *conditions) override
+        {
+            validators = CacheValidators();
+            validators.etag = origin->versions[path];
+            if(origin->lifetime)
+                validators.expires = time(nullptr) + origin->lifetime;
+            validators.storable = !origin->nostore;
+            if(conditions && conditions->etag == validators.etag)
+            {
+                origin->notmodified++;
+                return RequestStatus::NotModified;
+            }
+            origin->transfers++;
+            content.clear();
+            while(content.size() < 100000)
+                content += path + validators.etag;
+            contentLength = origin->chunked ? SIZE_MAX : content.size();
+            contentType = "video/mp4";
+            bytesRead = 0;
+            return RequestStatus::Success;
+        }
+        virtual ssize_t read(void *p_buffer, size_t len) override
+        {
+            len = std::min(len, content.size() - bytesRead);
+            memcpy(p_buffer, &content[bytesRead], len);
+            bytesRead += len;
+            return len;
+        }
+        virtual bool isBodyComplete() const override
+        {
+            return bytesRead == content.size();
+        }
+        virtual void setUsed(bool b) override
+        {
+            available = !b;
+        }
+
+    private:
+        Origin *origin;
+        std::string content;
+};
+
+class OriginConnectionFactory : public AbstractConnectionFactory
+{
+    public:
+        OriginConnectionFactory(Origin *o)
+        {
+            origin = o;
+        }
+        virtual AbstractConnection * createConnection(vlc_object_t *,
+                                                      const ConnectionParams &) override
+        {
+            return new OriginConnection(origin);
+        }
+
+    private:
+        Origin *origin;
+};
+
+static std::string Load(HTTPConnectionManager *manager, const std::string &url)
+{
+    AbstractChunkSource *source = manager->makeSource(url, ID("track"),
+                                                      ChunkType::Segment,
+                                                      BytesRange());
+    manager->start(source);
+    std::string data;
+    block_t *p_block;
+    while((p_block = source->readBlock()))
+    {
+        data.append((const char *) p_block->p_buffer, p_block->i_buffer);
+        block_Release(p_block);
+    }
+    Expect(source->getContentType() == "video/mp4");
+    manager->recycleSource(source);
+    return data;
+}
+
+static void Loop_test()
+{
+    Origin origin;
+    origin.versions["/1.m4s"] = "v1";
+    origin.versions["/2.m4s"] = "v1";
+
+    HTTPConnectionManager *manager = new HTTPConnectionManager(nullptr);
+    manager->addFactory(new OriginConnectionFactory(&origin));
+    manager->setSegmentCache(new SegmentCache(nullptr, cacheDir, 1 << 20));
+
+    const std::string first = Load(manager, "http://origin.test/1.m4s");
+    const std::string second = Load(manager, "http://origin.test/2.m4s");
+    Expect(origin.transfers == 2);
+
+    /* looping: revalidated and served locally */
+    Expect(Load(manager, "http://origin.test/1.m4s") == first);
+    Expect(Load(manager, "http://origin.test/2.m4s") == second);
+    Expect(origin.transfers == 2);
+    Expect(origin.notmodified == 2);
+
+    /* updated on the server */
+    origin.versions["/2.m4s"] = "v2";
+    Expect(Load(manager, "http://origin.test/2.m4s") != second);
+    Expect(origin.transfers == 3);
+    delete manager;
+
+    /* kept for the next session */
+    manager = new HTTPConnectionManager(nullptr);
+    manager->addFactory(new OriginConnectionFactory(&origin));
+    manager->setSegmentCache(new SegmentCache(nullptr, cacheDir, 1 << 20));
+    Expect(Load(manager, "http://origin.test/1.m4s") == first);
+    Expect(origin.transfers == 3);
+    Expect(origin.notmodified == 3);
+    delete manager;
+}
+
+static void Freshness_test()
+{
+    Origin origin;
+    origin.versions["/1.m4s"] = "v1";
+    origin.versions["/2.m4s"] = "";
+    origin.lifetime = 3600;
+
+    HTTPConnectionManager *manager = new HTTPConnectionManager(nullptr);
+    manager->addFactory(new OriginConnectionFactory(&origin));
+    manager->setSegmentCache(new SegmentCache(nullptr, cacheDir, 1 << 20));
+
+    /* fresh: served without asking, with validators or not */
+    const std::string first = Load(manager, "http://fresh.test/1.m4s");
+    const std::string second = Load(manager, "http://fresh.test/2.m4s");
+    Expect(Load(manager, "http://fresh.test/1.m4s") == first);
+    Expect(Load(manager, "http://fresh.test/2.m4s") == second);
+    Expect(origin.transfers == 2);
+    Expect(origin.notmodified == 0);
+
+    /* stale without validators: not stored */
+    origin.lifetime = 0;
+    origin.versions["/3.m4s"] = "";
+    Load(manager, "http://fresh.test/3.m4s");
+    Load(manager, "http://fresh.test/3.m4s");
+    Expect(origin.transfers == 4);
+
+    /* no-store */
+    origin.nostore = true;
+    origin.versions["/4.m4s"] = "v1";
+    Load(manager, "http://fresh.test/4.m4s");
+    Load(manager, "http://fresh.test/4.m4s");
+    Expect(origin.transfers == 6);
+    Expect(origin.notmodified == 0);
+    delete manager;
+}
+
+static void Chunked_test()
+{
+    Origin origin;
+    origin.versions["/1.m4s"] = "v1";
+    origin.chunked = true;
+
+    HTTPConnectionManager *manager = new HTTPConnectionManager(nullptr);
+    manager->addFactory(new OriginConnectionFactory(&origin));
+    manager->setSegmentCache(new SegmentCache(nullptr, cacheDir, 1 << 20));
+
+    /* stored once the whole body was read, whatever its length */
+    const std::string first = Load(manager, "http://chunked.test/1.m4s");
+    Expect(Load(manager, "http://chunked.test/1.m4s") == first);
+    Expect(origin.transfers == 1);
+    Expect(origin.notmodified == 1);
+    delete manager;
+}
+
+static void Eviction_test()
+{
+    SegmentCache *cache = new SegmentCache(nullptr, cacheDir, 250000);
+    CacheValidators validators;
+    validators.etag = "v1";
+    block_t *p_block = block_Alloc(100000);
+    memset(p_block->p_buffer, 0, p_block->i_buffer);
+
+    cache->put("a", p_block, "", validators);
+    cache->put("b", p_block, "", validators);
+    SegmentCache::Entry entry;
+    Expect(cache->get("a", &entry)); /* queued or written */
+    Expect(entry.p_data->i_buffer == 100000);
+    cache->flush();
+    SegmentCache::Entry touched;
+    Expect(cache->get("a", &touched));
+    /* least recently used is b */
+    cache->put("c", p_block, "", validators);
+    cache->flush();
+    SegmentCache::Entry entries[3];
+    Expect(cache->get("a", &entries[0]));
+    Expect(!cache->get("b", &entries[1]));
+    Expect(cache->get("c", &entries[2]));
+    Expect(entries[2].validators.etag == "v1");
+
+    /* could never be revalidated */
+    cache->put("d", p_block, "", CacheValidators());
+    cache->flush();
+    SegmentCache::Entry unvalidated;
+    Expect(!cache->get("d", &unvalidated));
+
+    /* the size limit holds for all the caches of the directory */
+    SegmentCache *other = new SegmentCache(nullptr, cacheDir, 250000);
+    other->put("e", p_block, "", validators);
+    other->flush();
+    SegmentCache::Entry shared[3];
+    Expect(!cache->get("a", &shared[0]));
+    Expect(other->get("c", &shared[1]));
+    Expect(cache->get("e", &shared[2]));
+    delete other;
+    block_Release(p_block);
+    delete cache;
+}
+
+int SegmentCache_test()
+{
+    int ret = 0;
+
+    cacheDir = "adaptive_test_cache." + std::to_string(getpid());
+    /* empty cache */
+    delete new SegmentCache(nullptr, cacheDir, 0);
+    try
+    {
+        Loop_test();
+        Freshness_test();
+        Chunked_test();
+        Eviction_test();
+    }
+    catch (...)
+    {
+        ret = 1;
+    }
+    delete new SegmentCache(nullptr, cacheDir, 0);
+    rmdir(cacheDir.c_str());
+
+    return ret;
+}
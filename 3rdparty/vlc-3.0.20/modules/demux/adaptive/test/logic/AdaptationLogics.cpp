@@ -0,0 +1,255 @@
+/*****************************************************************************
+ * AdaptationLogics.cpp: adaptation logics over simulated networks tests
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "TraceSimulator.hpp"
+#include "../../SegmentTracker.hpp"
+
+#include "../../playlist/BasePeriod.h"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../logic/AbstractAdaptationLogic.h"
+#include "../../playlist/BaseRepresentation.h"
+#include "../../../hls/playlist/Parser.hpp"
+#include "../../../hls/playlist/M3U8.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_stream.h>
+
+#include <map>
+#include <memory>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+using namespace hls::playlist;
+
+static const char manifest[] =
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=500000\n"
+    "http://example.com/500k.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=1000000\n"
+    "http://example.com/1m.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=2500000\n"
+    "http://example.com/2500k.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=5000000\n"
+    "http://example.com/5m.m3u8\n";
+
+/* audio only variant without any declared bandwidth */
+static const char manifest_nobw[] =
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=0\n"
+    "http://example.com/audio.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=1000000\n"
+    "http://example.com/1m.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=2500000\n"
+    "http://example.com/2500k.m3u8\n";
+
+static std::map<std::string, SimulationResult> Simulate(BaseAdaptationSet *set,
+                                                        const BandwidthTrace &trace)
+{
+    std::map<std::string, SimulationResult> results;
+    TraceSimulator sim(trace, CLOCK_FREQ * 4);
+    for(const std::string &logicname : TraceSimulator::logics())
+    {
+        std::unique_ptr<AbstractAdaptationLogic> logic(TraceSimulator::createLogic(logicname));
+        results[logicname] = sim.run(logic.get(), set, 150);
+    }
+    return results;
+}
+
+static M3U8 * Parse(const char *data, size_t size)
+{
+    vlc_object_t *obj = static_cast<vlc_object_t*>(nullptr);
+    M3U8Parser parser(nullptr);
+    stream_t *stream = vlc_stream_MemoryNew(obj, (uint8_t *) data, size, true);
+    if(!stream)
+        return nullptr;
+    M3U8 *m3u = parser.parse(obj, stream, std::string("stdin://"));
+    vlc_stream_Delete(stream);
+    return m3u;
+}
+
+static int NoBandwidth_test()
+{
+    M3U8 *m3u = Parse(manifest_nobw, sizeof(manifest_nobw));
+    if(!m3u)
+        return 1;
+
+    try
+    {
+        BaseAdaptationSet *set = m3u->getFirstPeriod()->getAdaptationSets().front();
+        Expect(set->getRepresentations().size() == 3);
+
+        BaseRepresentation *prev = nullptr;
+        for(BaseRepresentation *rep : set->getRepresentations())
+            if(rep->getBandwidth() == 1000000)
+                prev = rep;
+        Expect(prev);
+
+        /* 3 Mbit/s measured, buffer full: the buffer rule can't rank the
+         * variants, and the throughput rule must choose instead */
+        const ID &id = set->getID();
+        std::unique_ptr<AbstractAdaptationLogic> logic(TraceSimulator::createLogic("hybrid"));
+        logic->trackerEvent(BufferingStateUpdatedEvent(id, true));
+        logic->updateDownloadProgress(375000, 0, CLOCK_FREQ);
+        logic->updateDownloadRate(id, 375000, CLOCK_FREQ, 0);
+        logic->trackerEvent(BufferingLevelChangedEvent(id, 0, CLOCK_FREQ * 30,
+                                                       CLOCK_FREQ * 30, CLOCK_FREQ * 30));
+        BaseRepresentation *rep = logic->getNextRepresentation(set, prev);
+        Expect(rep);
+        Expect(rep->getBandwidth() >= 1000000);
+        logic->trackerEvent(BufferingStateUpdatedEvent(id, false));
+
+        delete m3u;
+    }
+    catch(...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int ParallelDownloads_test()
+{
+    M3U8 *m3u = Parse(manifest, sizeof(manifest));
+    if(!m3u)
+        return 1;
+
+    try
+    {
+        BaseAdaptationSet *set = m3u->getFirstPeriod()->getAdaptationSets().front();
+        std::unique_ptr<AbstractAdaptationLogic> logic(TraceSimulator::createLogic("rate"));
+
+        /* 3 Mbit/s link shared by 3 simultaneous segment downloads, read
+         * by 100ms slices: each one only gets a third of the link, but the
+         * link is fully used */
+        for(vlc_tick_t t = 0; t < CLOCK_FREQ * 3; t += CLOCK_FREQ / 10)
+            for(unsigned i = 0; i < 3; i++)
+                logic->updateDownloadProgress(12500, t, t + CLOCK_FREQ / 10);
+        BaseRepresentation *rep = logic->getNextRepresentation(set, nullptr);
+        Expect(rep);
+        Expect(rep->getBandwidth() == 1000000);
+
+        /* then one at a time, over the same link */
+        for(vlc_tick_t t = CLOCK_FREQ * 3; t < CLOCK_FREQ * 6; t += CLOCK_FREQ / 10)
+            logic->updateDownloadProgress(37500, t, t + CLOCK_FREQ / 10);
+        rep = logic->getNextRepresentation(set, nullptr);
+        Expect(rep);
+        Expect(rep->getBandwidth() == 1000000);
+
+        /* the hybrid logic estimates the link the same way, over long
+         * enough for its slow average to settle */
+        const ID &id = set->getID();
+        logic.reset(TraceSimulator::createLogic("hybrid"));
+        logic->trackerEvent(BufferingStateUpdatedEvent(id, true));
+        for(vlc_tick_t t = 0; t < CLOCK_FREQ * 20; t += CLOCK_FREQ / 10)
+            for(unsigned i = 0; i < 3; i++)
+            {
+                logic->updateDownloadProgress(12500, t, t + CLOCK_FREQ / 10);
+                logic->updateDownloadRate(id, 12500, CLOCK_FREQ / 10, 0);
+            }
+        rep = logic->getNextRepresentation(set, nullptr);
+        Expect(rep);
+        Expect(rep->getBandwidth() == 2500000);
+        logic->trackerEvent(BufferingStateUpdatedEvent(id, false));
+
+        delete m3u;
+    }
+    catch(...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    return 0;
+}
+
+int AdaptationLogics_test()
+{
+    M3U8 *m3u = Parse(manifest, sizeof(manifest));
+    if(!m3u)
+        return 1;
+
+    try
+    {
+        Expect(m3u);
+        BaseAdaptationSet *set = m3u->getFirstPeriod()->getAdaptationSets().front();
+        Expect(set->getRepresentations().size() == 4);
+
+        /* fixed bandwidth */
+        BandwidthTrace steady;
+        steady.add(CLOCK_FREQ, 3000000);
+        TraceSimulator sim(steady, CLOCK_FREQ * 4);
+        Expect(steady.transfer(CLOCK_FREQ / 2, 375000) == CLOCK_FREQ);
+        Expect(steady.transfer(CLOCK_FREQ / 2, 0) == 0);
+
+        auto results = Simulate(set, steady);
+        Expect(results["lowest"].averageBitrate == 500000);
+        Expect(results["lowest"].switches == 0);
+        Expect(results["lowest"].rebuffering == 0);
+        Expect(results["highest"].averageBitrate == 5000000);
+        Expect(results["highest"].rebuffering > 0);
+        Expect(results["hybrid"].rebuffering == 0);
+        Expect(results["hybrid"].averageBitrate >= 2000000);
+        Expect(results["hybrid"].switches <= 4);
+
+        /* bandwidth alternating between good and poor every 10s */
+        BandwidthTrace oscillating;
+        oscillating.add(CLOCK_FREQ * 10, 6000000);
+        oscillating.add(CLOCK_FREQ * 10, 1200000);
+        Expect(oscillating.transfer(CLOCK_FREQ * 9, 1500000) == CLOCK_FREQ * 6);
+
+        results = Simulate(set, oscillating);
+        Expect(results["hybrid"].rebuffering <= results["highest"].rebuffering);
+        Expect(results["hybrid"].switches <= results["rate"].switches);
+        Expect(results["hybrid"].averageBitrate > results["lowest"].averageBitrate);
+
+        /* good link with periodic outages */
+        BandwidthTrace outages;
+        outages.add(CLOCK_FREQ * 40, 4000000);
+        outages.add(CLOCK_FREQ * 5, 0);
+        Expect(!outages.empty());
+        Expect(outages.transfer(CLOCK_FREQ * 41, 0) == 0);
+        Expect(outages.transfer(CLOCK_FREQ * 41, 500000) == CLOCK_FREQ * 5);
+
+        BandwidthTrace disconnected;
+        disconnected.add(CLOCK_FREQ, 0);
+        Expect(disconnected.empty());
+        Expect(disconnected.transfer(0, 500000) == 0);
+
+        results = Simulate(set, outages);
+        Expect(results["hybrid"].rebuffering <= results["highest"].rebuffering);
+        Expect(results["hybrid"].averageBitrate > results["lowest"].averageBitrate);
+
+        delete m3u;
+    }
+    catch(...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    return NoBandwidth_test() || ParallelDownloads_test();
+}
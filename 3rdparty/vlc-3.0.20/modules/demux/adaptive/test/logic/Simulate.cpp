@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * Simulate.cpp: replays bandwidth traces against the adaptation logics
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "TraceSimulator.hpp"
+
+#include "../../playlist/BasePeriod.h"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../logic/AbstractAdaptationLogic.h"
+#include "../../../hls/playlist/Parser.hpp"
+#include "../../../hls/playlist/M3U8.hpp"
+
+#include <vlc_stream.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+using namespace hls::playlist;
+
+extern const char vlc_module_name[] = "adaptive_sim";
+
+/*
+ * adaptive_sim <master.m3u8> <trace> [segment duration s] [segments]
+ *
+ * The trace has one "<duration ms> <kbps>" sample per line and is repeated
+ * until all segments are played. DASH manifests need the xml module, which
+ * is not available offline: convert them to a HLS master playlist first.
+ */
+int main(int argc, char **argv)
+{
+    if(argc < 3)
+    {
+        fprintf(stderr, "usage: %s <master.m3u8> <trace> [segment s] [segments]\n",
+                argv[0]);
+        return 2;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    if(content.empty())
+    {
+        fprintf(stderr, "cannot read playlist %s\n", argv[1]);
+        return 1;
+    }
+
+    BandwidthTrace trace;
+    if(!trace.load(argv[2]))
+    {
+        fprintf(stderr, "cannot read trace %s\n", argv[2]);
+        return 1;
+    }
+
+    const double duration = argc > 3 ? atof(argv[3]) : 4.0;
+    const unsigned segments = argc > 4 ? atoi(argv[4]) : 300;
+    if(duration <= 0.0)
+        return 2;
+
+    vlc_object_t *obj = static_cast<vlc_object_t*>(nullptr);
+    M3U8Parser parser(nullptr);
+    stream_t *stream = vlc_stream_MemoryNew(obj, (uint8_t *) &content[0],
+                                            content.size(), true);
+    if(!stream)
+        return 1;
+    std::unique_ptr<M3U8> m3u(parser.parse(obj, stream, std::string(argv[1])));
+    vlc_stream_Delete(stream);
+    if(!m3u || !m3u->getFirstPeriod() ||
+       m3u->getFirstPeriod()->getAdaptationSets().empty())
+    {
+        fprintf(stderr, "no variant in %s\n", argv[1]);
+        return 1;
+    }
+    BaseAdaptationSet *set = m3u->getFirstPeriod()->getAdaptationSets().front();
+
+    TraceSimulator sim(trace, duration * CLOCK_FREQ);
+    printf("%-12s %10s %9s %12s %7s %11s\n", "logic", "kbps", "switches",
+           "rebuffer ms", "stalls", "startup ms");
+    for(const std::string &name : TraceSimulator::logics())
+    {
+        std::unique_ptr<AbstractAdaptationLogic> logic(TraceSimulator::createLogic(name));
+        const SimulationResult r = sim.run(logic.get(), set, segments);
+        printf("%-12s %10" PRIu64 " %9u %12" PRId64 " %7u %11" PRId64 "\n",
+               name.c_str(), r.averageBitrate / 1000, r.switches,
+               r.rebuffering * 1000 / CLOCK_FREQ, r.stalls,
+               r.startup * 1000 / CLOCK_FREQ);
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * TraceSimulator.cpp: plays segments over bandwidth traces
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "TraceSimulator.hpp"
+
+#include "../../SegmentTracker.hpp"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../playlist/BaseRepresentation.h"
+#include "../../logic/AlwaysBestAdaptationLogic.h"
+#include "../../logic/AlwaysLowestAdaptationLogic.hpp"
+#include "../../logic/HybridAdaptationLogic.hpp"
+#include "../../logic/NearOptimalAdaptationLogic.hpp"
+#include "../../logic/PredictiveAdaptationLogic.hpp"
+#include "../../logic/RateBasedAdaptationLogic.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+
+void BandwidthTrace::add(vlc_tick_t duration, uint64_t bps)
+{
+    if(duration <= 0)
+        return;
+    samples.push_back(std::make_pair(duration, bps));
+    total += duration;
+}
+
+bool BandwidthTrace::load(const std::string &path)
+{
+    std::ifstream file(path);
+    if(!file)
+        return false;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.empty() || line[0] == '#')
+            continue;
+        std::istringstream is(line);
+        double ms, kbps;
+        if(is >> ms >> kbps && ms > 0 && kbps >= 0)
+            add(ms * CLOCK_FREQ / 1000, kbps * 1000);
+    }
+    return !empty();
+}
+
+bool BandwidthTrace::empty() const
+{
+    uint64_t bits = 0;
+    for(const auto &s : samples)
+        bits += s.second;
+    return bits == 0;
+}
+
+vlc_tick_t BandwidthTrace::transfer(vlc_tick_t start, uint64_t bytes) const
+{
+    /* nothing to wait for, or no bandwidth ever */
+    if(bytes == 0 || empty())
+        return 0;
+
+    /* find the sample playing at start */
+    vlc_tick_t offset = start % total;
+    size_t i = 0;
+    while(offset >= samples[i].first)
+        offset -= samples[i++].first;
+
+    double bits = bytes * 8.0;
+    vlc_tick_t elapsed = 0;
+    for(;;)
+    {
+        const vlc_tick_t remain = samples[i].first - offset;
+        const double capacity = (double) samples[i].second * remain / CLOCK_FREQ;
+        if(samples[i].second > 0 && capacity >= bits)
+            return elapsed + bits * CLOCK_FREQ / samples[i].second;
+        bits -= capacity;
+        elapsed += remain;
+        offset = 0;
+        i = (i + 1) % samples.size();
+    }
+}
+
+TraceSimulator::TraceSimulator(const BandwidthTrace &t, vlc_tick_t duration,
+                               vlc_tick_t maxbuffering)
+    : trace(t)
+{
+    segmentDuration = duration;
+    maxBuffering = maxbuffering;
+}
+
+SimulationResult TraceSimulator::run(AbstractAdaptationLogic *logic,
+                                     BaseAdaptationSet *adaptSet,
+                                     unsigned segments) const
+{
+    SimulationResult result;
+    const ID &id = adaptSet->getID();
+    BaseRepresentation *prev = nullptr;
+    vlc_tick_t now = 0;
+    vlc_tick_t buffering = 0;
+    bool playing = false;
+    uint64_t bitrates = 0;
+
+    logic->trackerEvent(BufferingStateUpdatedEvent(id, true));
+    for(unsigned i = 0; i < segments; i++)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(adaptSet, prev);
+        if(rep != prev)
+        {
+            logic->trackerEvent(RepresentationSwitchEvent(prev, rep));
+            if(prev)
+                result.switches++;
+        }
+        prev = rep;
+
+        const size_t size = rep->getBandwidth() * segmentDuration / CLOCK_FREQ / 8;
+        const vlc_tick_t duration = trace.transfer(now, size);
+        now += duration;
+
+        /* playback drains the buffer while downloading */
+        if(!playing)
+        {
+            if(i == 0)
+                result.startup = duration;
+            else
+                result.rebuffering += duration;
+        }
+        else if(duration > buffering)
+        {
+            result.rebuffering += duration - buffering;
+            result.stalls++;
+            buffering = 0;
+        }
+        else buffering -= duration;
+        buffering += segmentDuration;
+        playing = true;
+        bitrates += rep->getBandwidth();
+
+        logic->updateDownloadProgress(size, now - duration, now);
+        logic->updateDownloadRate(id, size, duration, 0);
+        logic->trackerEvent(BufferingLevelChangedEvent(id, 0, maxBuffering,
+                                                       buffering, maxBuffering));
+
+        /* waits for room in the buffer */
+        if(buffering > maxBuffering)
+        {
+            now += buffering - maxBuffering;
+            buffering = maxBuffering;
+        }
+    }
+    logic->trackerEvent(BufferingStateUpdatedEvent(id, false));
+
+    if(segments)
+        result.averageBitrate = bitrates / segments;
+    return result;
+}
+
+std::vector<std::string> TraceSimulator::logics()
+{
+    return { "rate", "predictive", "nearoptimal", "hybrid", "lowest", "highest" };
+}
+
+AbstractAdaptationLogic * TraceSimulator::createLogic(const std::string &name)
+{
+    if(name == "rate")
+        return new RateBasedAdaptationLogic(nullptr);
+    if(name == "predictive")
+        return new PredictiveAdaptationLogic(nullptr);
+    if(name == "nearoptimal")
+        return new NearOptimalAdaptationLogic(nullptr);
+    if(name == "hybrid")
+        return new HybridAdaptationLogic(nullptr);
+    if(name == "lowest")
+        return new AlwaysLowestAdaptationLogic(nullptr);
+    if(name == "highest")
+        return new AlwaysBestAdaptationLogic(nullptr);
+    return nullptr;
+}
@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * TraceSimulator.hpp: plays segments over bandwidth traces
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef ADAPTIVE_TRACESIMULATOR_HPP
+#define ADAPTIVE_TRACESIMULATOR_HPP
+
+#include <vlc_common.h>
+
+#include <string>
+#include <vector>
+
+namespace adaptive
+{
+    namespace playlist
+    {
+        class BaseAdaptationSet;
+    }
+
+    namespace logic
+    {
+        class AbstractAdaptationLogic;
+    }
+
+    /* Network bandwidth over time, repeated when exhausted */
+    class BandwidthTrace
+    {
+        public:
+            void add(vlc_tick_t duration, uint64_t bps);
+            bool load(const std::string &); /* lines of "<ms> <kbps>" */
+            bool empty() const;
+            /* time to receive bytes from start, 0 if it never can */
+            vlc_tick_t transfer(vlc_tick_t start, uint64_t bytes) const;
+
+        private:
+            std::vector<std::pair<vlc_tick_t, uint64_t>> samples;
+            vlc_tick_t total = 0;
+    };
+
+    class SimulationResult
+    {
+        public:
+            uint64_t    averageBitrate = 0;
+            unsigned    switches = 0;
+            vlc_tick_t  startup = 0;
+            vlc_tick_t  rebuffering = 0;
+            unsigned    stalls = 0;
+    };
+
+    /* Plays segments of a single adaptation set over a trace, feeding the
+     * logic the download rates and buffering levels the player would. */
+    class TraceSimulator
+    {
+        public:
+            TraceSimulator(const BandwidthTrace &, vlc_tick_t segmentDuration,
+                           vlc_tick_t maxBuffering = CLOCK_FREQ * 30);
+            SimulationResult run(logic::AbstractAdaptationLogic *,
+                                 playlist::BaseAdaptationSet *, unsigned segments) const;
+
+            /* All the logics that can be simulated, by option value */
+            static std::vector<std::string> logics();
+            static logic::AbstractAdaptationLogic * createLogic(const std::string &);
+
+        private:
+            const BandwidthTrace &trace;
+            vlc_tick_t segmentDuration;
+            vlc_tick_t maxBuffering;
+    };
+}
+
+#endif
@@ -40,6 +40,8 @@
 
 #include <limits>
 #include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace adaptive;
 using namespace adaptive::playlist;
@@ -548,3 +550,110 @@ int M3U8Playlist_test()
 
     return 0;
 }
+
+/* Window [first, first + count) of a live stream of 2s segments,
+ * with discontinuities before the segments numbers of discont */
+static std::string LivePlaylist(uint64_t first, uint64_t count,
+                                const std::vector<uint64_t> &discont)
+{
+    const uint64_t sequence = 3 + std::count_if(discont.cbegin(), discont.cend(),
+                                                [first](uint64_t n) { return n < first; });
+    std::string s = "#EXTM3U\n"
+                    "#EXT-X-TARGETDURATION:2\n"
+                    "#EXT-X-MEDIA-SEQUENCE:" + std::to_string(first) + "\n"
+                    "#EXT-X-DISCONTINUITY-SEQUENCE:" + std::to_string(sequence) + "\n";
+    for(uint64_t i = first; i < first + count; i++)
+    {
+        if(std::find(discont.cbegin(), discont.cend(), i) != discont.cend())
+            s += "#EXT-X-DISCONTINUITY\n";
+        s += "#EXTINF:2.000,\nhttp://example.com/segments/" + std::to_string(i) + ".ts\n";
+    }
+    return s;
+}
+
+static void Update(M3U8Parser &parser, vlc_object_t *obj,
+                   HLSRepresentation *rep, const std::string &s)
+{
+    parser.appendSegmentsFromPlaylist(obj, rep, (const uint8_t *) s.data(), s.size());
+}
+
+/* Segments numbered [first, last], each starting where the previous one ends */
+static void ExpectContiguous(const SegmentList *list, uint64_t first, uint64_t last)
+{
+    const std::vector<Segment *> &segments = list->getSegments();
+    Expect(segments.size() == last - first + 1);
+    for(size_t i = 0; i < segments.size(); i++)
+    {
+        Expect(segments[i]->getSequenceNumber() == first + i);
+        Expect(segments[i]->duration.Get() == segments[0]->duration.Get());
+        if(i > 0)
+            Expect(segments[i]->startTime.Get() == segments[i - 1]->startTime.Get() +
+                                                   segments[i - 1]->duration.Get());
+    }
+}
+
+int M3U8LiveUpdate_test()
+{
+    vlc_object_t *obj = static_cast<vlc_object_t*>(nullptr);
+    M3U8Parser parser(nullptr);
+    const uint64_t count = 6 * 3600 / 2; /* 6 hours DVR */
+    const std::vector<uint64_t> discont = { 1005, 1000 + count + 2 };
+
+    std::string manifest = LivePlaylist(1000, count, discont);
+    M3U8 *m3u = ParseM3U8(obj, manifest.c_str(), manifest.size());
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive());
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>(
+                    m3u->getFirstPeriod()->getAdaptationSets().front()->getRepresentations().front());
+        const SegmentList *list = rep->inheritSegmentList();
+        Expect(list);
+        ExpectContiguous(list, 1000, 1000 + count - 1);
+
+        const Timescale timescale = list->inheritTimescale();
+        const stime_t end = list->getSegments().back()->startTime.Get() +
+                            list->getSegments().back()->duration.Get();
+
+        /* slides by 3 segments, with a discontinuity before the last one */
+        manifest = LivePlaylist(1003, count, discont);
+        Update(parser, obj, rep, manifest);
+        Expect(rep->inheritSegmentList() == list);
+        ExpectContiguous(list, 1003, 1000 + count + 2);
+        Expect(list->getMediaSegment(1000 + count)->startTime.Get() == end);
+        Expect(timescale.ToTime(list->getTotalLength()) == CLOCK_FREQ * 2 * count);
+        Expect(list->getMediaSegment(1004)->getDiscontinuitySequenceNumber() == 3);
+        Expect(list->getMediaSegment(1005)->getDiscontinuitySequenceNumber() == 4);
+        Expect(list->getMediaSegment(1000 + count)->getDiscontinuitySequenceNumber() == 4);
+        Expect(list->getMediaSegment(1000 + count + 1)->getDiscontinuitySequenceNumber() == 4);
+        Expect(list->getMediaSegment(1000 + count + 2)->getDiscontinuitySequenceNumber() == 5);
+        Expect(list->getMediaSegment(1000 + count + 2)->discontinuity);
+        Expect(!list->getMediaSegment(1000 + count + 1)->discontinuity);
+
+        /* nothing new, but the window start moved */
+        manifest = LivePlaylist(1010, count - 7, discont);
+        const stime_t start = list->getMediaSegment(1010)->startTime.Get();
+        Update(parser, obj, rep, manifest);
+        Expect(rep->inheritSegmentList() == list);
+        ExpectContiguous(list, 1010, 1000 + count + 2);
+        Expect(list->getMediaSegment(1010)->startTime.Get() == start);
+        Expect(list->getMediaSegment(1000 + count + 2)->discontinuity);
+
+        /* we fell out of the window: replaced by a full parse */
+        manifest = LivePlaylist(1000 + count + 10, 5, discont);
+        Update(parser, obj, rep, manifest);
+        list = rep->inheritSegmentList();
+        Expect(list);
+        ExpectContiguous(list, 1000 + count + 10, 1000 + count + 14);
+        Expect(list->getMediaSegment(1000 + count + 10)->getDiscontinuitySequenceNumber() == 5);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
+    return 0;
+}
@@ -163,6 +163,9 @@ int Timeline_test()
         timeline2->addElement(4+1, 2, 99-1, START+1000 + 2000 * 2 + 2 * 1);
         timeline->updateWith(*timeline2);
         Expect(timeline->maxElementNumber() == 4+99);
+        /* and should drop what is before the update window */
+        Expect(timeline->minElementNumber() == 4+1);
+        Expect(timeline->getTotalLength() == 2 * 99);
 
         delete timeline2;
         timeline2 = new SegmentTimeline(nullptr);
@@ -49,6 +49,12 @@ int main()
     TEST(CommandsQueue) ||
     TEST(M3U8MasterPlaylist) ||
     TEST(M3U8Playlist) ||
-    TEST(SegmentTracker)
+    TEST(M3U8LiveUpdate) ||
+    TEST(SegmentTracker) ||
+    TEST(Downloader) ||
+    TEST(SegmentCache) ||
+    TEST(AdaptationLogics) ||
+    TEST(LowLatency) ||
+    TEST(XMLParser)
     ;
 }
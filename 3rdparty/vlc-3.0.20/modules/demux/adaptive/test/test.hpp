@@ -45,9 +45,15 @@ int Timeline_test();
 int Conversions_test();
 int M3U8MasterPlaylist_test();
 int M3U8Playlist_test();
+int M3U8LiveUpdate_test();
 int CommandsQueue_test();
 int BufferingLogic_test();
 int FakeEsOut_test();
 int SegmentTracker_test();
+int Downloader_test();
+int SegmentCache_test();
+int AdaptationLogics_test();
+int LowLatency_test();
+int XMLParser_test();
 
 #endif
@@ -65,5 +65,12 @@ int Conversions_test()
     isotime = IsoTime("PT.010S");
     Expect(isotime == VLC_TICK_FROM_MS(10));
 
+    Expect(Integer<uint64_t>("18446744073709551615") == std::numeric_limits<uint64_t>::max());
+    Expect(Integer<int64_t>(" -42") == -42);
+    Expect(Integer<int64_t>("12abc") == 12);
+    Expect(Integer<int64_t>("abc") == 0);
+    Expect(Integer<int64_t>("99999999999999999999") == 0);
+    Expect(Integer<int64_t>(std::string("-42")) == -42);
+
     return 0;
 }
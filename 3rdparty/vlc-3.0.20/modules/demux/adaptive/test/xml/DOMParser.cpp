@@ -0,0 +1,286 @@
+/*****************************************************************************
+ * DOMParser.cpp: in place XML parser tests
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../xml/DOMParser.h"
+#include "../../xml/DOMHelper.h"
+#include "../../xml/Node.h"
+#include "../../tools/Conversions.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_stream.h>
+
+#include <cstring>
+#include <string>
+
+using namespace adaptive::xml;
+
+static const char manifest[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+    "<!DOCTYPE MPD [ <!ENTITY foo \"bar\"> ]>\n"
+    "<!-- <MPD> in comments is ignored -->\n"
+    "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" xmlns:cenc='urn:mpeg:cenc:2013'\n"
+    "     type=\"static\">\n"
+    "  <ProgramInformation>\n"
+    "    <Title>Tom &amp; Jerry &#x20AC;&#65; &unknown;</Title>\n"
+    "    <Source><![CDATA[<raw> & unescaped]]></Source>\n"
+    "  </ProgramInformation>\n"
+    "  <BaseURL>\n  http://example.com/\n</BaseURL>\n"
+    "  <Period id=\"p&quot;0&quot;\">\n"
+    "    <AdaptationSet cenc:default_KID = \"1\tline\nbreak\"/>\n"
+    "    <AdaptationSet/>\n"
+    "  </Period >\n"
+    "</MPD>\n"
+    "<trailing/>";
+
+static void Tree_test()
+{
+    DOMParser parser;
+    Expect(parser.parse(manifest, sizeof(manifest) - 1, true));
+
+    Node *root = parser.getRootNode();
+    Expect(root);
+    Expect(!strcmp(root->getName(), "MPD"));
+    Expect(root->getAttributeValue("xmlns") == "urn:mpeg:dash:schema:mpd:2011");
+    Expect(root->getAttributeValue("xmlns:cenc") == "urn:mpeg:cenc:2013");
+    Expect(root->getAttributeValue("type") == "static");
+    Expect(root->getAttributeValue("missing").empty());
+    Expect(!root->hasAttribute("missing"));
+    Expect(root->getAttributeView("missing") == nullptr);
+    Expect(root->getText().empty());
+
+    Node *info = DOMHelper::getFirstChildElementByName(root, "ProgramInformation");
+    Expect(info);
+    Expect(info->getFirstChild() && info->getFirstChild()->getNextSibling());
+    Expect(DOMHelper::getFirstChildElementByName(info, "Title")->getText() ==
+           "Tom & Jerry \xE2\x82\xAC" "A &unknown;");
+    Expect(DOMHelper::getFirstChildElementByName(info, "Source")->getText() ==
+           "<raw> & unescaped");
+
+    Expect(DOMHelper::getFirstChildElementByName(root, "BaseURL")->getText() ==
+           "\n  http://example.com/\n");
+
+    Node *period = DOMHelper::getFirstChildElementByName(root, "Period");
+    Expect(period);
+    Expect(period->getAttributeValue("id") == "p\"0\"");
+    std::vector<Node *> sets = DOMHelper::getChildElementByTagName(period, "AdaptationSet");
+    Expect(sets.size() == 2);
+    Expect(sets[0]->getAttributeValue("cenc:default_KID") == "1 line break");
+    Expect(sets[0]->getFirstChild() == nullptr);
+    Expect(DOMHelper::getNextSiblingElementByName(sets[0], "AdaptationSet") == sets[1]);
+    Expect(DOMHelper::getNextSiblingElementByName(sets[1], "AdaptationSet") == nullptr);
+    Expect(DOMHelper::getElementByTagName(root, "AdaptationSet", false).size() == 2);
+
+    /* the parser can be reused */
+    Expect(parser.parse("<a><b/></a>", 11, true));
+    Expect(!strcmp(parser.getRootNode()->getName(), "a"));
+    Expect(!strcmp(parser.getRootNode()->getFirstChild()->getName(), "b"));
+}
+
+static void Truncated_test()
+{
+    /* probing only sees the start of the document */
+    const size_t truncated = strstr(manifest, "<Period") - manifest + 10;
+    DOMParser parser;
+    Expect(!parser.parse(manifest, truncated, true));
+    Expect(parser.parse(manifest, truncated, false));
+    Node *root = parser.getRootNode();
+    Expect(!strcmp(root->getName(), "MPD"));
+    Expect(DOMHelper::getFirstChildElementByName(root, "BaseURL"));
+    Expect(!DOMHelper::getFirstChildElementByName(root, "Period"));
+
+    const char mismatched[] = "<MPD><Period></MPD></Period>";
+    Expect(!parser.parse(mismatched, sizeof(mismatched) - 1, true));
+    const char unquoted[] = "<MPD type=static></MPD>";
+    Expect(!parser.parse(unquoted, sizeof(unquoted) - 1, true));
+    Expect(!parser.parse("", 0, false));
+    Expect(!parser.parse("no markup", 9, false));
+}
+
+static void Stream_test()
+{
+    vlc_object_t *obj = static_cast<vlc_object_t*>(nullptr);
+    stream_t *stream = vlc_stream_MemoryNew(obj, (uint8_t *) manifest,
+                                            sizeof(manifest) - 1, true);
+    Expect(stream);
+    DOMParser parser(stream);
+    const bool b = parser.parse(true);
+    /* the known size is read into a single copy, never grown
+     * just to find the end of the stream */
+    const unsigned streamallocations = parser.getAllocations();
+    vlc_stream_Delete(stream);
+    Expect(b);
+    Expect(!strcmp(parser.getRootNode()->getName(), "MPD"));
+    Expect(streamallocations == 2); /* document and first arena block */
+}
+
+static void Charset_test()
+{
+    /* UTF-16LE with BOM, as some Smooth servers send */
+    const char utf8[] = "<SmoothStreamingMedia Name=\"\xC3\xA9t\xC3\xA9\"/>";
+    std::string utf16("\xFF\xFE", 2);
+    for(const char *p = "<SmoothStreamingMedia Name=\""; *p; p++)
+        utf16 += std::string(1, *p) + '\0';
+    utf16 += std::string("\xE9\0t\0\xE9\0\"\0/\0>\0", 12);
+
+    DOMParser parser;
+    Expect(parser.parse(utf16.data(), utf16.size(), true));
+    Expect(!strcmp(parser.getRootNode()->getName(), "SmoothStreamingMedia"));
+    Expect(parser.getRootNode()->getAttributeValue("Name") == "\xC3\xA9t\xC3\xA9");
+
+    /* UTF-8 BOM */
+    std::string bom = std::string("\xEF\xBB\xBF") + utf8;
+    Expect(parser.parse(bom.data(), bom.size(), true));
+    Expect(parser.getRootNode()->getAttributeValue("Name") == "\xC3\xA9t\xC3\xA9");
+
+    /* declared legacy encoding */
+    const char latin1[] = "<?xml version='1.0' encoding='ISO-8859-1'?><a b=\"\xE9\"/>";
+    Expect(parser.parse(latin1, sizeof(latin1) - 1, true));
+    Expect(parser.getRootNode()->getAttributeValue("b") == "\xC3\xA9");
+}
+
+static void CharReference_test()
+{
+    static const struct
+    {
+        const char *text;
+        const char *unescaped;
+    } refs[] = {
+        { "&#65;&#x42;&#X43;", "ABC" },
+        { "&#xE9;&#8364;&#x1F600;", "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80" },
+        { "&#x10FFFF;", "\xF4\x8F\xBF\xBF" },
+        /* not references: kept as they are */
+        { "&#;&#x;&#-1;&#+65;&# 65;&#x 41;&#0x41;&#6A;", "&#;&#x;&#-1;&#+65;&# 65;&#x 41;&#0x41;&#6A;" },
+        { "&#x110000;&#1114112;&#99999999999;", "&#x110000;&#1114112;&#99999999999;" },
+        { "&#xD800;&#xDFFF;&#55296;", "&#xD800;&#xDFFF;&#55296;" },
+        { "&#0;", "&#0;" },
+    };
+
+    DOMParser parser;
+    for(size_t i = 0; i < ARRAY_SIZE(refs); i++)
+    {
+        const std::string doc = std::string("<a b=\"") + refs[i].text + "\">" +
+                                refs[i].text + "</a>";
+        Expect(parser.parse(doc.data(), doc.size(), true));
+        Expect(parser.getRootNode()->getAttributeValue("b") == refs[i].unescaped);
+        Expect(parser.getRootNode()->getText() == refs[i].unescaped);
+    }
+}
+
+/* Multi period live MPD with long SegmentTimelines */
+static std::string LargeMPD(unsigned periods, unsigned sets, unsigned elements)
+{
+    std::string s = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                    "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"dynamic\""
+                    " profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+                    " availabilityStartTime=\"1970-01-01T00:00:00Z\">\n";
+    uint64_t t = 0;
+    for(unsigned p = 0; p < periods; p++)
+    {
+        s += " <Period id=\"" + std::to_string(p) + "\">\n";
+        for(unsigned a = 0; a < sets; a++)
+        {
+            s += "  <AdaptationSet mimeType=\"video/mp4\" segmentAlignment=\"true\">\n"
+                 "   <SegmentTemplate timescale=\"90000\" media=\"$RepresentationID$/$Time$.m4s\">\n"
+                 "    <SegmentTimeline>\n";
+            uint64_t time = t;
+            for(unsigned e = 0; e < elements; e++)
+            {
+                /* varying durations defeat the repeat count */
+                const unsigned d = 180000 + (e % 3) * 90;
+                s += "     <S t=\"" + std::to_string(time) + "\" d=\"" + std::to_string(d) + "\"/>\n";
+                time += d;
+            }
+            s += "    </SegmentTimeline>\n"
+                 "   </SegmentTemplate>\n"
+                 "   <Representation id=\"v" + std::to_string(a) + "\" bandwidth=\"5000000\""
+                 " width=\"1920\" height=\"1080\" codecs=\"avc1.640028\"/>\n"
+                 "  </AdaptationSet>\n";
+        }
+        s += " </Period>\n";
+        t += (uint64_t) elements * 180000;
+    }
+    s += "</MPD>\n";
+    return s;
+}
+
+static void LargeMPD_test()
+{
+    const unsigned periods = 10, sets = 4, elements = 5000;
+    const std::string mpd = LargeMPD(periods, sets, elements);
+
+    DOMParser parser;
+    bool b = parser.parse(mpd.data(), mpd.size(), true);
+    const unsigned parseallocations = parser.getAllocations();
+    const size_t arenasize = parser.getArenaSize();
+    Expect(b);
+
+    /* reading the timelines back does not allocate either */
+    size_t count = 0;
+    uint64_t total = 0;
+    for(Node *period = DOMHelper::getFirstChildElementByName(parser.getRootNode(), "Period");
+        period; period = DOMHelper::getNextSiblingElementByName(period, "Period"))
+    {
+        for(Node *set = DOMHelper::getFirstChildElementByName(period, "AdaptationSet");
+            set; set = DOMHelper::getNextSiblingElementByName(set, "AdaptationSet"))
+        {
+            Node *timeline = DOMHelper::getFirstChildElementByName(
+                        DOMHelper::getFirstChildElementByName(set, "SegmentTemplate"),
+                        "SegmentTimeline");
+            for(Node *s = DOMHelper::getFirstChildElementByName(timeline, "S");
+                s; s = DOMHelper::getNextSiblingElementByName(s, "S"))
+            {
+                total += Integer<uint64_t>(s->getAttributeView("d"));
+                count++;
+            }
+        }
+    }
+    Expect(parser.getAllocations() == parseallocations);
+    Expect(parser.getArenaSize() == arenasize);
+    Expect(count == periods * sets * elements);
+    Expect(total == (uint64_t) periods * sets * (elements * 180000 +
+                                                (elements / 3) * (90 + 180) + 90 * ((elements % 3) > 1)));
+
+    /* the document copy and a few doubling arena blocks,
+     * never one per element or attribute */
+    Expect(parseallocations < 32);
+}
+
+int XMLParser_test()
+{
+    try
+    {
+        Tree_test();
+        Truncated_test();
+        Stream_test();
+        Charset_test();
+        CharReference_test();
+        LargeMPD_test();
+    }
+    catch (...)
+    {
+        return 1;
+    }
+
+    return 0;
+}
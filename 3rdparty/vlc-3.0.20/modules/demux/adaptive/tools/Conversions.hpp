@@ -23,6 +23,9 @@
 #include <vlc_common.h>
 #include <string>
 #include <sstream>
+#include <limits>
+#include <cerrno>
+#include <cstdlib>
 
 class IsoTime
 {
@@ -61,6 +64,19 @@ template<typename T> class Integer
             }
         }
 
+        /* allocation free, for values read in place from the XML */
+        Integer(const char *str)
+        {
+            char *end;
+            errno = 0;
+            if(std::numeric_limits<T>::is_signed)
+                value = strtoll(str, &end, 10);
+            else
+                value = strtoull(str, &end, 10);
+            if(end == str || errno == ERANGE)
+                value = 0;
+        }
+
         operator T() const
         {
             return value;
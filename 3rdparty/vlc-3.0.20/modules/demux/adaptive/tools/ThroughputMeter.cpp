@@ -0,0 +1,84 @@
+/*
+ * ThroughputMeter.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "ThroughputMeter.hpp"
+
+#include <algorithm>
+
+using namespace adaptive;
+
+ThroughputMeter::ThroughputMeter(vlc_tick_t window_)
+{
+    window = window_;
+    windowStart = VLC_TICK_INVALID;
+    bytes = 0;
+}
+
+vlc_tick_t ThroughputMeter::busyTime() const
+{
+    std::vector<std::pair<vlc_tick_t, vlc_tick_t>> sorted(transfers);
+    std::sort(sorted.begin(), sorted.end());
+
+    /* length of the union of the transfer intervals */
+    vlc_tick_t busy = 0;
+    vlc_tick_t until = VLC_TICK_INVALID;
+    for(const auto &t : sorted)
+    {
+        vlc_tick_t start = t.first;
+        if(until != VLC_TICK_INVALID && start < until)
+            start = until;
+        if(t.second > start)
+        {
+            busy += t.second - start;
+            until = t.second;
+        }
+    }
+    return busy;
+}
+
+bool ThroughputMeter::push(size_t size, vlc_tick_t start, vlc_tick_t end,
+                           size_t *bps, vlc_tick_t *busy)
+{
+    /* Time already accounted in the previous window is not counted twice,
+     * so that the bytes and the busy time both add up over windows */
+    if(windowStart != VLC_TICK_INVALID && start < windowStart)
+        start = windowStart;
+    if(end > start)
+        transfers.push_back(std::make_pair(start, end));
+    bytes += size;
+
+    const vlc_tick_t time = busyTime();
+    if(time < window)
+        return false;
+
+    *bps = CLOCK_FREQ * bytes * 8 / time;
+    if(busy)
+        *busy = time;
+
+    for(const auto &t : transfers)
+        if(windowStart == VLC_TICK_INVALID || t.second > windowStart)
+            windowStart = t.second;
+    transfers.clear();
+    bytes = 0;
+    return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * ThroughputMeter.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef THROUGHPUTMETER_HPP
+#define THROUGHPUTMETER_HPP
+
+#include <vlc_common.h>
+
+#include <vector>
+#include <utility>
+
+namespace adaptive
+{
+    /* Link throughput from transfers that may overlap: the bytes received
+     * over the wall clock time at least one transfer was receiving. Dividing
+     * each transfer by its own duration would only give each of N parallel
+     * transfers its share of the link. */
+    class ThroughputMeter
+    {
+        public:
+            ThroughputMeter(vlc_tick_t window);
+            /* Adds size bytes received from start to end. Returns true,
+             * with the throughput in bps and optionally the time the link
+             * was busy, once it was busy for the whole observation window. */
+            bool push(size_t size, vlc_tick_t start, vlc_tick_t end,
+                      size_t *bps, vlc_tick_t *busy = nullptr);
+
+        private:
+            vlc_tick_t busyTime() const;
+            std::vector<std::pair<vlc_tick_t, vlc_tick_t>> transfers;
+            size_t bytes;
+            vlc_tick_t windowStart;
+            vlc_tick_t window;
+    };
+}
+
+#endif // THROUGHPUTMETER_HPP
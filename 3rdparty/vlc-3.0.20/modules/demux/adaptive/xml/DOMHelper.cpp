@@ -27,56 +27,68 @@
 
 #include "DOMHelper.h"
 
+#include <cstring>
+
 using namespace adaptive::xml;
 
-std::vector<Node *> DOMHelper::getElementByTagName      (Node *root, const std::string& name, bool selfContain)
+std::vector<Node *> DOMHelper::getElementByTagName      (Node *root, const char *name, bool selfContain)
 {
     std::vector<Node *> elements;
 
-    for(size_t i = 0; i < root->getSubNodes().size(); i++)
+    for(Node *child = root->getFirstChild(); child; child = child->getNextSibling())
     {
-        getElementsByTagName(root->getSubNodes().at(i), name, &elements, selfContain);
+        getElementsByTagName(child, name, &elements, selfContain);
     }
 
     return elements;
 }
 
-std::vector<Node *> DOMHelper::getChildElementByTagName (Node *root, const std::string& name)
+std::vector<Node *> DOMHelper::getChildElementByTagName (Node *root, const char *name)
 {
     std::vector<Node *> elements;
 
-    for(size_t i = 0; i < root->getSubNodes().size(); i++)
+    for(Node *child = root->getFirstChild(); child; child = child->getNextSibling())
     {
-        if( root->getSubNodes().at(i)->getName() == name )
-            elements.push_back(root->getSubNodes().at(i));
+        if( !strcmp(child->getName(), name) )
+            elements.push_back(child);
     }
 
     return elements;
 }
 
-void                DOMHelper::getElementsByTagName     (Node *root, const std::string& name, std::vector<Node*> *elements, bool selfContain)
+void                DOMHelper::getElementsByTagName     (Node *root, const char *name, std::vector<Node*> *elements, bool selfContain)
 {
-    if(!selfContain && !root->getName().compare(name))
+    if(!selfContain && !strcmp(root->getName(), name))
     {
         elements->push_back(root);
         return;
     }
 
-    if(!root->getName().compare(name))
+    if(!strcmp(root->getName(), name))
         elements->push_back(root);
 
-    for(size_t i = 0; i < root->getSubNodes().size(); i++)
+    for(Node *child = root->getFirstChild(); child; child = child->getNextSibling())
     {
-        getElementsByTagName(root->getSubNodes().at(i), name, elements, selfContain);
+        getElementsByTagName(child, name, elements, selfContain);
     }
 }
 
-Node*           DOMHelper::getFirstChildElementByName( Node *root, const std::string &name )
+Node*           DOMHelper::getFirstChildElementByName( Node *root, const char *name )
+{
+    for(Node *child = root->getFirstChild(); child; child = child->getNextSibling())
+    {
+        if( !strcmp(child->getName(), name) )
+            return child;
+    }
+    return nullptr;
+}
+
+Node*           DOMHelper::getNextSiblingElementByName( Node *node, const char *name )
 {
-    for(size_t i = 0; i < root->getSubNodes().size(); i++)
+    while((node = node->getNextSibling()))
     {
-        if( root->getSubNodes().at( i )->getName() == name )
-            return root->getSubNodes().at( i );
+        if( !strcmp(node->getName(), name) )
+            return node;
     }
     return nullptr;
 }
@@ -37,12 +37,13 @@ namespace adaptive
         class DOMHelper
         {
             public:
-                static std::vector<Node *> getElementByTagName      (Node *root, const std::string& name, bool selfContain);
-                static std::vector<Node *> getChildElementByTagName (Node *root, const std::string& name);
-                static Node*               getFirstChildElementByName( Node *root, const std::string& name );
+                static std::vector<Node *> getElementByTagName      (Node *root, const char *name, bool selfContain);
+                static std::vector<Node *> getChildElementByTagName (Node *root, const char *name);
+                static Node*               getFirstChildElementByName( Node *root, const char *name );
+                static Node*               getNextSiblingElementByName( Node *node, const char *name );
 
             private:
-                static void getElementsByTagName(Node *root, const std::string& name, std::vector<Node *> *elements, bool selfContain);
+                static void getElementsByTagName(Node *root, const char *name, std::vector<Node *> *elements, bool selfContain);
         };
     }
 }
@@ -27,169 +27,570 @@
 
 #include "DOMParser.h"
 
+#include <vlc_charset.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
 #include <vector>
-#include <stack>
-#include <vlc_xml.h>
 
 using namespace adaptive::xml;
 
+const size_t DOMParser::ARENA_MIN_BLOCK;
+
 DOMParser::DOMParser() :
     root( nullptr ),
     stream( nullptr ),
-    vlc_reader( nullptr )
+    document( nullptr ),
+    arena( nullptr ),
+    arenasize( 0 ),
+    allocations( 0 )
 {
 }
 
 DOMParser::DOMParser    (stream_t *stream) :
     root( nullptr ),
     stream( stream ),
-    vlc_reader( nullptr )
+    document( nullptr ),
+    arena( nullptr ),
+    arenasize( 0 ),
+    allocations( 0 )
 {
 }
 
 DOMParser::~DOMParser   ()
 {
-    delete this->root;
-    if(this->vlc_reader)
-        xml_ReaderDelete(this->vlc_reader);
+    clear();
+}
+
+void DOMParser::clear()
+{
+    /* nodes are plain arena data, no destructors to run */
+    root = nullptr;
+    while(arena)
+    {
+        ArenaBlock *next = arena->next;
+        delete[] reinterpret_cast<uint8_t *>(arena);
+        arena = next;
+    }
+    arenasize = 0;
+    allocations = 0;
+    delete[] document;
+    document = nullptr;
+}
+
+void * DOMParser::allocate(size_t size)
+{
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    if(!arena || arena->used + size > arena->size)
+    {
+        /* double the arena on each block, so large documents
+         * only need a few allocations */
+        const size_t blocksize = std::max(size, std::max(arenasize, ARENA_MIN_BLOCK));
+        uint8_t *p = new (std::nothrow) uint8_t[sizeof(ArenaBlock) + blocksize];
+        if(!p)
+            return nullptr;
+        allocations++;
+        ArenaBlock *block = reinterpret_cast<ArenaBlock *>(p);
+        block->next = arena;
+        block->size = blocksize;
+        block->used = 0;
+        arena = block;
+        arenasize += blocksize;
+    }
+    void *p = reinterpret_cast<uint8_t *>(arena + 1) + arena->used;
+    arena->used += size;
+    return p;
+}
+
+char * DOMParser::allocateDocument(size_t size)
+{
+    char *p = new (std::nothrow) char[size];
+    if(p)
+        allocations++;
+    return p;
+}
+
+size_t DOMParser::getArenaSize() const
+{
+    return arenasize;
+}
+
+unsigned DOMParser::getAllocations() const
+{
+    return allocations;
 }
 
 Node*   DOMParser::getRootNode              ()
 {
     return this->root;
 }
+
 bool    DOMParser::parse                    (bool b)
 {
     if(!stream)
         return false;
 
-    if(!vlc_reader && !(vlc_reader = xml_ReaderCreate(stream, stream)))
+    clear();
+
+    uint64_t streamsize;
+    size_t size = 0;
+    size_t allocated = 0;
+    if(vlc_stream_GetSize(stream, &streamsize) == VLC_SUCCESS &&
+       streamsize > 0 && streamsize < (UINT64_C(1) << 30))
+        allocated = streamsize + 1;
+    if(allocated && !(document = allocateDocument(allocated)))
         return false;
 
-    const int i_flags = vlc_reader->obj.flags;
-    if(!b)
-        vlc_reader->obj.flags |= OBJECT_FLAGS_QUIET;
-    root = processNode(b);
-    vlc_reader->obj.flags = i_flags;
-    if ( root == nullptr )
+    for(;;)
+    {
+        if(size + 1 >= allocated)
+        {
+            /* all of the known size may have been read: only grow
+             * if there is more */
+            char extra;
+            if(document && vlc_stream_Read(stream, &extra, 1) <= 0)
+                break;
+            allocated = std::max(allocated * 2, (size_t) 64 * 1024);
+            char *grown = allocateDocument(allocated);
+            if(!grown)
+            {
+                clear();
+                return false;
+            }
+            if(document)
+            {
+                memcpy(grown, document, size);
+                grown[size++] = extra;
+            }
+            delete[] document;
+            document = grown;
+        }
+        ssize_t ret = vlc_stream_Read(stream, &document[size], allocated - size - 1);
+        if(ret <= 0)
+            break;
+        size += ret;
+    }
+
+    if(!document)
         return false;
+    document[size] = 0;
 
-    return true;
+    return load(size) && (root = processNode(b)) != nullptr;
+}
+
+bool    DOMParser::parse                    (const void *data, size_t size, bool b)
+{
+    clear();
+
+    if(!(document = allocateDocument(size + 1)))
+        return false;
+    memcpy(document, data, size);
+    document[size] = 0;
+
+    return load(size) && (root = processNode(b)) != nullptr;
 }
 
 bool DOMParser::reset(stream_t *s)
 {
     stream = s;
-    if(!vlc_reader)
-        return true;
-    delete root;
-    root = nullptr;
-    vlc_reader = xml_ReaderReset(vlc_reader, s);
-    return !!vlc_reader;
+    clear();
+    return true;
 }
 
-Node* DOMParser::processNode(bool b_strict)
+bool DOMParser::convert(const char *charset, size_t offset, size_t size)
+{
+    char *converted = FromCharset(charset, document + offset, size - offset);
+    if(!converted)
+        return false;
+    size = strlen(converted);
+    delete[] document;
+    document = allocateDocument(size + 1);
+    if(document)
+        memcpy(document, converted, size + 1);
+    free(converted);
+    return document != nullptr;
+}
+
+/* Brings the document to UTF-8, the only encoding handled in place */
+bool DOMParser::load(size_t size)
 {
-    const char *data;
-    int type;
-    std::stack<Node *> lifo;
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(document);
+
+    /* UTF-16 with or without BOM, truncated to whole code units
+     * as we might only have been given a peek */
+    if(size >= 2 && p[0] == 0xFF && p[1] == 0xFE)
+        return convert("UTF-16LE", 2, size & ~1);
+    else if(size >= 2 && p[0] == 0xFE && p[1] == 0xFF)
+        return convert("UTF-16BE", 2, size & ~1);
+    else if(size >= 2 && p[0] == '<' && p[1] == 0)
+        return convert("UTF-16LE", 0, size & ~1);
+    else if(size >= 2 && p[0] == 0 && p[1] == '<')
+        return convert("UTF-16BE", 0, size & ~1);
+
+    if(size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+    {
+        memmove(document, document + 3, size - 3 + 1);
+        return true;
+    }
 
-    while( (type = xml_ReaderNextNode(vlc_reader, &data)) > 0 )
+    /* legacy 8 bits encodings from the declaration */
+    if(!strncmp(document, "<?xml", 5))
     {
-        switch(type)
+        const char *end = strstr(document, "?>");
+        const char *enc = strstr(document, "encoding");
+        if(end && enc && enc < end && (enc = strpbrk(enc, "\"'")))
         {
-            case XML_READER_STARTELEM:
+            const char *encend = strchr(enc + 1, *enc);
+            if(encend && encend < end)
             {
-                bool empty = xml_ReaderIsEmptyElement(vlc_reader);
-                Node *node = new (std::nothrow) Node();
-                if(node)
-                {
-                    if(!lifo.empty())
-                        lifo.top()->addSubNode(node);
-                    lifo.push(node);
+                std::string name(enc + 1, encend - enc - 1);
+                if(strcasecmp(name.c_str(), "UTF-8") && strcasecmp(name.c_str(), "UTF8"))
+                    return convert(name.c_str(), 0, size);
+            }
+        }
+    }
 
-                    node->setName(std::string(data));
-                    addAttributesToNode(node);
-                }
+    return true;
+}
 
-                if(empty && lifo.size() > 1)
-                    lifo.pop();
-                break;
-            }
+static inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
 
-            case XML_READER_TEXT:
-            {
-                if(!lifo.empty())
-                    lifo.top()->setText(std::string(data));
-                break;
-            }
+static inline bool IsNameEnd(char c)
+{
+    return IsSpace(c) || c == '/' || c == '>' || c == '=' || c == 0;
+}
 
-            case XML_READER_ENDELEM:
-            {
-                if(lifo.empty())
-                    return nullptr;
+/* Returns the code point of the digits of a character reference [s, end),
+ * or 0 if it is not a valid XML character */
+static uint32_t CharReference(const char *s, const char *end)
+{
+    const bool hex = (*s == 'x' || *s == 'X');
+    if(hex)
+        s++;
+    if(s == end)
+        return 0;
+
+    uint32_t cp = 0;
+    for(; s < end; s++)
+    {
+        unsigned digit;
+        if(*s >= '0' && *s <= '9')
+            digit = *s - '0';
+        else if(hex && *s >= 'a' && *s <= 'f')
+            digit = *s - 'a' + 10;
+        else if(hex && *s >= 'A' && *s <= 'F')
+            digit = *s - 'A' + 10;
+        else
+            return 0;
+        cp = cp * (hex ? 16 : 10) + digit;
+        if(cp > 0x10FFFF)
+            return 0;
+    }
 
-                Node *node = lifo.top();
-                lifo.pop();
-                if(lifo.empty())
-                    return node;
-            }
+    /* surrogates only exist in UTF-16 */
+    if(cp >= 0xD800 && cp <= 0xDFFF)
+        return 0;
+    return cp;
+}
 
-            default:
-                break;
+/* Unescapes [s, end) in place and terminates it. Entities never expand,
+ * so the result always fits. */
+static char * Unescape(char *s, char *end, bool attribute)
+{
+    char *w = s;
+    char *r = s;
+    while(r < end)
+    {
+        if(*r == '&')
+        {
+            char *semicolon = static_cast<char *>(memchr(r, ';', std::min<size_t>(end - r, 12)));
+            if(semicolon)
+            {
+                const size_t len = semicolon - r - 1;
+                const char *name = r + 1;
+                uint32_t cp = 0;
+                if(len == 2 && !strncmp(name, "lt", 2))
+                    cp = '<';
+                else if(len == 2 && !strncmp(name, "gt", 2))
+                    cp = '>';
+                else if(len == 3 && !strncmp(name, "amp", 3))
+                    cp = '&';
+                else if(len == 4 && !strncmp(name, "quot", 4))
+                    cp = '"';
+                else if(len == 4 && !strncmp(name, "apos", 4))
+                    cp = '\'';
+                else if(len > 1 && name[0] == '#')
+                    cp = CharReference(name + 1, semicolon);
+
+                if(cp)
+                {
+                    if(cp < 0x80)
+                    {
+                        *w++ = cp;
+                    }
+                    else if(cp < 0x800)
+                    {
+                        *w++ = 0xC0 | (cp >> 6);
+                        *w++ = 0x80 | (cp & 0x3F);
+                    }
+                    else if(cp < 0x10000)
+                    {
+                        *w++ = 0xE0 | (cp >> 12);
+                        *w++ = 0x80 | ((cp >> 6) & 0x3F);
+                        *w++ = 0x80 | (cp & 0x3F);
+                    }
+                    else
+                    {
+                        *w++ = 0xF0 | (cp >> 18);
+                        *w++ = 0x80 | ((cp >> 12) & 0x3F);
+                        *w++ = 0x80 | ((cp >> 6) & 0x3F);
+                        *w++ = 0x80 | (cp & 0x3F);
+                    }
+                    r = semicolon + 1;
+                    continue;
+                }
+            }
+            *w++ = *r++;
+        }
+        else if(*r == '\r')
+        {
+            /* line ends are normalized, then attribute whitespace */
+            *w++ = attribute ? ' ' : '\n';
+            if(++r < end && *r == '\n')
+                r++;
+        }
+        else if(attribute && (*r == '\n' || *r == '\t'))
+        {
+            *w++ = ' ';
+            r++;
+        }
+        else
+        {
+            *w++ = *r++;
         }
     }
+    *w = 0;
+    return s;
+}
 
-    while( lifo.size() > 1 )
-        lifo.pop();
+/* Returns past the end of the start tag, or nullptr if it is invalid or
+ * truncated */
+char * DOMParser::parseAttributes(Node *node, char *p, bool *empty)
+{
+    for(;;)
+    {
+        while(IsSpace(*p))
+            p++;
 
-    Node *node = (!lifo.empty()) ? lifo.top() : nullptr;
+        if(*p == '>')
+        {
+            *empty = false;
+            return p + 1;
+        }
+        else if(*p == '/')
+        {
+            *empty = true;
+            return (p[1] == '>') ? p + 2 : nullptr;
+        }
 
-    if(b_strict && node)
-    {
-        delete node;
-        return nullptr;
+        char *name = p;
+        while(!IsNameEnd(*p))
+            p++;
+        if(p == name)
+            return nullptr;
+        char *nameend = p;
+
+        while(IsSpace(*p))
+            p++;
+        if(*p++ != '=')
+            return nullptr;
+        while(IsSpace(*p))
+            p++;
+        const char quote = *p;
+        if(quote != '"' && quote != '\'')
+            return nullptr;
+        char *value = ++p;
+        char *valueend = strchr(value, quote);
+        if(!valueend)
+            return nullptr;
+
+        Node::Attribute *attr = static_cast<Node::Attribute *>(allocate(sizeof(*attr)));
+        if(!attr)
+            return nullptr;
+        *nameend = 0;
+        attr->name = name;
+        attr->value = Unescape(value, valueend, true);
+        node->addAttribute(attr);
+
+        p = valueend + 1;
     }
-
-    return node;
 }
 
-void    DOMParser::addAttributesToNode      (Node *node)
+Node* DOMParser::processNode(bool b_strict)
 {
-    const char *attrValue;
-    const char *attrName;
+    std::vector<Node *> lifo;
+    lifo.reserve(16);
+    Node *rootnode = nullptr;
+    bool complete = false;
 
-    while((attrName = xml_ReaderNextAttr(this->vlc_reader, &attrValue)) != nullptr)
+    char *p = document;
+    while(*p && !complete)
     {
-        std::string key     = attrName;
-        std::string value   = attrValue;
-        node->addAttribute(key, value);
+        char *lt = strchr(p, '<');
+        char *textend = lt ? lt : p + strlen(p);
+
+        /* text content, whitespace only is not reported */
+        if(!lifo.empty())
+        {
+            char *text = p;
+            while(text < textend && IsSpace(*text))
+                text++;
+            if(text < textend)
+                lifo.back()->setText(Unescape(p, textend, false));
+        }
+
+        if(!lt)
+            break;
+
+        char *q = lt + 1;
+        if(*q == '?')
+        {
+            char *end = strstr(q, "?>");
+            if(!end)
+                break;
+            p = end + 2;
+        }
+        else if(!strncmp(q, "!--", 3))
+        {
+            char *end = strstr(q + 3, "-->");
+            if(!end)
+                break;
+            p = end + 3;
+        }
+        else if(!strncmp(q, "![CDATA[", 8))
+        {
+            char *end = strstr(q + 8, "]]>");
+            if(!end)
+                break;
+            *end = 0;
+            if(!lifo.empty())
+                lifo.back()->setText(q + 8);
+            p = end + 3;
+        }
+        else if(*q == '!')
+        {
+            /* doctype, possibly with an internal subset */
+            int depth = 0;
+            for(p = q + 1; *p; p++)
+            {
+                if(*p == '[')
+                    depth++;
+                else if(*p == ']')
+                    depth--;
+                else if(*p == '>' && depth <= 0)
+                    break;
+            }
+            if(!*p)
+                break;
+            p++;
+        }
+        else if(*q == '/')
+        {
+            char *name = q + 1;
+            char *nameend = name;
+            while(!IsNameEnd(*nameend))
+                nameend++;
+            char *gt = strchr(nameend, '>');
+            if(!gt || lifo.empty())
+                break;
+            const char *open = lifo.back()->getName();
+            const size_t len = nameend - name;
+            if(strncmp(open, name, len) || open[len])
+                break; /* mismatched */
+            lifo.pop_back();
+            complete = lifo.empty();
+            p = gt + 1;
+        }
+        else
+        {
+            char *name = q;
+            char *nameend = name;
+            while(!IsNameEnd(*nameend))
+                nameend++;
+            if(nameend == name)
+                break;
+
+            void *storage = allocate(sizeof(Node));
+            if(!storage)
+                break;
+            Node *node = new (storage) Node(name);
+
+            bool empty = false;
+            const char c = *nameend;
+            *nameend = 0;
+            if(IsSpace(c))
+                p = parseAttributes(node, nameend + 1, &empty);
+            else if(c == '>')
+                p = nameend + 1;
+            else if(c == '/' && nameend[1] == '>')
+            {
+                p = nameend + 2;
+                empty = true;
+            }
+            else
+                p = nullptr;
+
+            if(!p) /* invalid or truncated start tag */
+                break;
+
+            if(!lifo.empty())
+                lifo.back()->addSubNode(node);
+            else if(!rootnode)
+                rootnode = node;
+            else
+                break; /* only one root */
+
+            if(!empty)
+                lifo.push_back(node);
+            else
+                complete = lifo.empty();
+        }
     }
+
+    if(b_strict && !complete)
+        return nullptr;
+
+    return rootnode;
 }
+
 void    DOMParser::print                    (Node *node, int offset)
 {
     for(int i = 0; i < offset; i++)
         msg_Dbg(this->stream, " ");
 
-    msg_Dbg(this->stream, "%s", node->getName().c_str());
+    msg_Dbg(this->stream, "%s", node->getName());
 
     std::vector<std::string> keys = node->getAttributeKeys();
 
     for(size_t i = 0; i < keys.size(); i++)
-        msg_Dbg(this->stream, " %s=%s", keys.at(i).c_str(), node->getAttributeValue(keys.at(i)).c_str());
+        msg_Dbg(this->stream, " %s=%s", keys.at(i).c_str(),
+                node->getAttributeView(keys.at(i).c_str()));
 
     msg_Dbg(this->stream, "\n");
 
     offset++;
 
-    for(size_t i = 0; i < node->getSubNodes().size(); i++)
+    for(Node *child = node->getFirstChild(); child; child = child->getNextSibling())
     {
-        this->print(node->getSubNodes().at(i), offset);
+        this->print(child, offset);
     }
 }
 void    DOMParser::print                    ()
 {
-    this->print(this->root, 0);
+    if(this->stream && this->root)
+        this->print(this->root, 0);
 }
-
-
@@ -34,6 +34,9 @@ namespace adaptive
 {
     namespace xml
     {
+        /* Non validating in place parser: the document is copied once,
+         * names, values and text are terminated and unescaped in that
+         * copy, and nodes are carved from a growing arena. */
         class DOMParser
         {
             public:
@@ -42,18 +45,37 @@ namespace adaptive
                 virtual ~DOMParser  ();
 
                 bool                parse       (bool);
+                bool                parse       (const void *, size_t, bool);
                 bool                reset       (stream_t *);
                 Node*               getRootNode ();
                 void                print       ();
 
+                size_t              getArenaSize() const;
+                unsigned            getAllocations() const;
+
             private:
                 Node                *root;
                 stream_t            *stream;
 
-                xml_reader_t        *vlc_reader;
+                char                *document;
+                struct ArenaBlock
+                {
+                    ArenaBlock  *next;
+                    size_t      size;
+                    size_t      used;
+                } *arena;
+                size_t              arenasize;
+                unsigned            allocations; /* heap blocks since the last parse */
+
+                static const size_t ARENA_MIN_BLOCK = 64 * 1024;
 
+                void    clear                   ();
+                void*   allocate                (size_t);
+                char*   allocateDocument        (size_t);
+                bool    load                    (size_t);
+                bool    convert                 (const char *, size_t, size_t);
                 Node*   processNode             (bool);
-                void    addAttributesToNode     (Node *node);
+                char*   parseAttributes         (Node *, char *, bool *);
                 void    print                   (Node *node, int offset);
         };
     }
@@ -27,108 +27,92 @@
 
 #include "Node.h"
 
-#include <cassert>
-#include <vlc_common.h>
-#include <vlc_xml.h>
+#include <cstring>
 
 using namespace adaptive::xml;
 
-const std::string   Node::EmptyString = "";
-
-Node::Node() :
-    type( -1 )
+Node::Node(const char *name_) :
+    name( name_ ),
+    text( nullptr ),
+    attributes( nullptr ),
+    firstChild( nullptr ),
+    lastChild( nullptr ),
+    nextSibling( nullptr )
 {
 }
-Node::~Node ()
+
+Node*                               Node::getFirstChild         () const
 {
-    for(size_t i = 0; i < this->subNodes.size(); i++)
-        delete(this->subNodes.at(i));
+    return this->firstChild;
 }
-
-const std::vector<Node*>&           Node::getSubNodes           () const
+Node*                               Node::getNextSibling        () const
 {
-    return this->subNodes;
+    return this->nextSibling;
 }
 void                                Node::addSubNode            (Node *node)
 {
-    this->subNodes.push_back(node);
+    if(this->lastChild)
+        this->lastChild->nextSibling = node;
+    else
+        this->firstChild = node;
+    this->lastChild = node;
 }
-const std::string&                  Node::getName               () const
+const char*                         Node::getName               () const
 {
     return this->name;
 }
-void                                Node::setName               (const std::string& name)
+
+bool                                Node::hasAttribute        (const char *name) const
 {
-    this->name = name;
+    return getAttributeView(name) != nullptr;
 }
-
-bool                                Node::hasAttribute        (const std::string& name) const
+const char*                         Node::getAttributeView      (const char *key) const
 {
-    if(this->attributes.find(name) != this->attributes.end())
-        return true;
-
-    return false;
+    for(const Attribute *attr = this->attributes; attr; attr = attr->next)
+    {
+        if(!strcmp(attr->name, key))
+            return attr->value;
+    }
+    return nullptr;
 }
-const std::string&                  Node::getAttributeValue     (const std::string& key) const
+std::string                         Node::getAttributeValue     (const char *key) const
 {
-    std::map<std::string, std::string>::const_iterator  it = this->attributes.find( key );
-
-    if ( it != this->attributes.end() )
-        return it->second;
-    return EmptyString;
+    const char *value = getAttributeView(key);
+    return value ? std::string(value) : std::string();
 }
 
-void                                Node::addAttribute          ( const std::string& key, const std::string& value)
+void                                Node::addAttribute          (Attribute *attr)
 {
-    this->attributes[key] = value;
+    attr->next = this->attributes;
+    this->attributes = attr;
 }
 std::vector<std::string>            Node::getAttributeKeys      () const
 {
     std::vector<std::string> keys;
-    std::map<std::string, std::string>::const_iterator it;
-
-    for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
-    {
-        keys.push_back(it->first);
-    }
+    for(const Attribute *attr = this->attributes; attr; attr = attr->next)
+        keys.push_back(attr->name);
     return keys;
 }
 
-const std::string&                         Node::getText               () const
+std::string                         Node::getText               () const
 {
-    return text;
+    return text ? std::string(text) : std::string();
 }
 
-void Node::setText(const std::string &text)
+void Node::setText(const char *text)
 {
     this->text = text;
 }
 
-const std::map<std::string,std::string>&   Node::getAttributes         () const
-{
-    return this->attributes;
-}
-
-int Node::getType() const
-{
-    return this->type;
-}
-
-void Node::setType(int type)
-{
-    this->type = type;
-}
-
 std::vector<std::string> Node::toString(int indent) const
 {
     std::vector<std::string> ret;
     std::string text(indent, ' ');
     text.append(getName());
     ret.push_back(text);
-    std::vector<Node *>::const_iterator l;
-    for(l = subNodes.begin(); l < subNodes.end(); ++l)
+    for(const Node *l = firstChild; l; l = l->nextSibling)
     {
-        std::vector<std::string> sub = (*l)->toString(indent + 1);
+        std::vector<std::string> sub = l->toString(indent + 1);
         ret.insert(ret.end(), sub.begin(), sub.end());
     }
     return ret;
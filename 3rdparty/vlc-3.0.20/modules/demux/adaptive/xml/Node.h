@@ -27,41 +27,46 @@
 
 #include <vector>
 #include <string>
-#include <map>
 
 namespace adaptive
 {
     namespace xml
     {
+        /* Nodes live in the DOMParser arena: names, attributes and text
+         * point into the parsed document and are only valid as long as
+         * the parser is. */
         class Node
         {
             public:
-                Node            ();
-                virtual ~Node   ();
+                struct Attribute
+                {
+                    const char  *name;
+                    const char  *value;
+                    Attribute   *next;
+                };
 
-                const std::vector<Node *>&          getSubNodes         () const;
+                Node            (const char *name);
+
+                Node*                               getFirstChild       () const;
+                Node*                               getNextSibling      () const;
                 void                                addSubNode          (Node *node);
-                const std::string&                  getName             () const;
-                void                                setName             (const std::string& name);
-                bool                                hasAttribute        (const std::string& name) const;
-                void                                addAttribute        (const std::string& key, const std::string& value);
-                const std::string&                  getAttributeValue   (const std::string& key) const;
+                const char*                         getName             () const;
+                bool                                hasAttribute        (const char *name) const;
+                void                                addAttribute        (Attribute *attr);
+                std::string                         getAttributeValue   (const char *key) const;
+                const char*                         getAttributeView    (const char *key) const;
                 std::vector<std::string>            getAttributeKeys    () const;
-                const std::string&                  getText             () const;
-                void                                setText( const std::string &text );
-                const std::map<std::string, std::string>& getAttributes () const;
-                int                                 getType() const;
-                void                                setType( int type );
+                std::string                         getText             () const;
+                void                                setText             (const char *text);
                 std::vector<std::string>            toString(int) const;
 
             private:
-                static const std::string            EmptyString;
-                std::vector<Node *>                 subNodes;
-                std::map<std::string, std::string>  attributes;
-                std::string                         name;
-                std::string                         text;
-                int                                 type;
-
+                const char                          *name;
+                const char                          *text;
+                Attribute                           *attributes;
+                Node                                *firstChild;
+                Node                                *lastChild;
+                Node                                *nextSibling;
         };
     }
 }
@@ -44,6 +44,7 @@
 #include "../adaptive/tools/Retrieve.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <ctime>
 
 using namespace dash;
@@ -180,7 +181,7 @@ bool DASHManager::isDASH(xml::Node *root)
         "urn:mpeg:DASH:schema:MPD:2011",
     };
 
-    if(root->getName() != "MPD")
+    if(strcmp(root->getName(), "MPD"))
         return false;
 
     std::string ns = root->getAttributeValue("xmlns");
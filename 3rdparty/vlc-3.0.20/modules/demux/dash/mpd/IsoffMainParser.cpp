@@ -45,6 +45,7 @@
 #include "../../adaptive/tools/Conversions.hpp"
 #include <vlc_stream.h>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 
 using namespace dash::mpd;
@@ -108,49 +109,38 @@ MPD * IsoffMainParser::parse()
 
 void    IsoffMainParser::parseMPDAttributes   (MPD *mpd, xml::Node *node)
 {
-    const std::map<std::string, std::string> & attr = node->getAttributes();
+    const char *value;
 
-    std::map<std::string, std::string>::const_iterator it;
+    if((value = node->getAttributeView("mediaPresentationDuration")))
+        mpd->duration.Set(IsoTime(value));
 
-    it = attr.find("mediaPresentationDuration");
-    if(it != attr.end())
-        mpd->duration.Set(IsoTime(it->second));
+    if((value = node->getAttributeView("minBufferTime")))
+        mpd->setMinBuffering(IsoTime(value));
 
-    it = attr.find("minBufferTime");
-    if(it != attr.end())
-        mpd->setMinBuffering(IsoTime(it->second));
-
-    it = attr.find("minimumUpdatePeriod");
-    if(it != attr.end())
+    if((value = node->getAttributeView("minimumUpdatePeriod")))
     {
-        vlc_tick_t minupdate = IsoTime(it->second);
+        vlc_tick_t minupdate = IsoTime(value);
         if(minupdate > 0)
             mpd->minUpdatePeriod.Set(minupdate);
     }
 
-    it = attr.find("maxSegmentDuration");
-    if(it != attr.end())
-        mpd->maxSegmentDuration.Set(IsoTime(it->second));
+    if((value = node->getAttributeView("maxSegmentDuration")))
+        mpd->maxSegmentDuration.Set(IsoTime(value));
 
-    it = attr.find("type");
-    if(it != attr.end())
-        mpd->setType(it->second);
+    if((value = node->getAttributeView("type")))
+        mpd->setType(value);
 
-    it = attr.find("availabilityStartTime");
-    if(it != attr.end())
-        mpd->availabilityStartTime.Set(UTCTime(it->second).mtime());
+    if((value = node->getAttributeView("availabilityStartTime")))
+        mpd->availabilityStartTime.Set(UTCTime(value).mtime());
 
-    it = attr.find("availabilityEndTime");
-    if(it != attr.end())
-        mpd->availabilityEndTime.Set(UTCTime(it->second).mtime());
+    if((value = node->getAttributeView("availabilityEndTime")))
+        mpd->availabilityEndTime.Set(UTCTime(value).mtime());
 
-    it = attr.find("timeShiftBufferDepth");
-        if(it != attr.end())
-            mpd->timeShiftBufferDepth.Set(IsoTime(it->second));
+    if((value = node->getAttributeView("timeShiftBufferDepth")))
+        mpd->timeShiftBufferDepth.Set(IsoTime(value));
 
-    it = attr.find("suggestedPresentationDelay");
-    if(it != attr.end())
-        mpd->suggestedPresentationDelay.Set(IsoTime(it->second));
+    if((value = node->getAttributeView("suggestedPresentationDelay")))
+        mpd->suggestedPresentationDelay.Set(IsoTime(value));
 }
 
 void IsoffMainParser::parsePeriods(MPD *mpd, Node *root)
@@ -429,7 +419,6 @@ size_t IsoffMainParser::parseSegmentList(MPD *mpd, Node * segListNode, SegmentIn
     size_t total = 0;
     if(segListNode)
     {
-        std::vector<Node *> segments = DOMHelper::getElementByTagName(segListNode, "SegmentURL", false);
         SegmentList *list;
         if((list = new (std::nothrow) SegmentList(info)))
         {
@@ -443,24 +432,21 @@ size_t IsoffMainParser::parseSegmentList(MPD *mpd, Node * segListNode, SegmentIn
 
             const stime_t duration = list->inheritDuration();
             stime_t nzStartTime = sequenceNumber * duration;
-            std::vector<Node *>::const_iterator it;
-            for(it = segments.begin(); it != segments.end(); ++it)
+            for(Node *segmentURL = DOMHelper::getFirstChildElementByName(segListNode, "SegmentURL");
+                segmentURL; segmentURL = DOMHelper::getNextSiblingElementByName(segmentURL, "SegmentURL"))
             {
-                Node *segmentURL = *it;
-
                 Segment *seg = new (std::nothrow) Segment(info);
                 if(!seg)
                     continue;
 
-                std::string mediaUrl = segmentURL->getAttributeValue("media");
-                if(!mediaUrl.empty())
-                    seg->setSourceUrl(mediaUrl);
+                const char *value = segmentURL->getAttributeView("media");
+                if(value && *value)
+                    seg->setSourceUrl(value);
 
-                if(segmentURL->hasAttribute("mediaRange"))
+                if((value = segmentURL->getAttributeView("mediaRange")))
                 {
-                    std::string range = segmentURL->getAttributeValue("mediaRange");
-                    size_t pos = range.find("-");
-                    seg->setByteRange(atoi(range.substr(0, pos).c_str()), atoi(range.substr(pos + 1, range.size()).c_str()));
+                    const char *end = strchr(value, '-');
+                    seg->setByteRange(atoi(value), atoi(end ? end + 1 : value));
                 }
 
                 seg->startTime.Set(nzStartTime);
@@ -513,28 +499,25 @@ void IsoffMainParser::parseTimeline(Node *node, AbstractMultipleSegmentBaseType
     SegmentTimeline *timeline = new (std::nothrow) SegmentTimeline(base);
     if(timeline)
     {
-        std::vector<Node *> elements = DOMHelper::getElementByTagName(node, "S", false);
-        std::vector<Node *>::const_iterator it;
-        for(it = elements.begin(); it != elements.end(); ++it)
+        for(Node *s = DOMHelper::getFirstChildElementByName(node, "S"); s;
+                        s = DOMHelper::getNextSiblingElementByName(s, "S"))
         {
-            const Node *s = *it;
-            if(!s->hasAttribute("d")) /* Mandatory */
+            const char *d = s->getAttributeView("d");
+            if(!d) /* Mandatory */
                 continue;
-            stime_t d = Integer<stime_t>(s->getAttributeValue("d"));
             int64_t r = 0; // never repeats by default
-            if(s->hasAttribute("r"))
+            const char *value;
+            if((value = s->getAttributeView("r")))
             {
-                r = Integer<int64_t>(s->getAttributeValue("r"));
+                r = Integer<int64_t>(value);
                 if(r < 0)
                     r = std::numeric_limits<unsigned>::max();
             }
 
-            if(s->hasAttribute("t"))
-            {
-                stime_t t = Integer<stime_t>(s->getAttributeValue("t"));
-                timeline->addElement(number, d, r, t);
-            }
-            else timeline->addElement(number, d, r);
+            if((value = s->getAttributeView("t")))
+                timeline->addElement(number, Integer<stime_t>(d), r, Integer<stime_t>(value));
+            else
+                timeline->addElement(number, Integer<stime_t>(d), r);
 
             number += (1 + r);
         }
@@ -39,6 +39,8 @@
 #include <vlc_strings.h>
 #include <vlc_stream.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <array>
 #include <unordered_map>
@@ -223,27 +225,144 @@ void M3U8Parser::fillAdaptsetFromMediainfo(const AttributesTag *mediatag,
     }
 }
 
-bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
+/*
+ * Rewrites a live media playlist to only the segments following the last
+ * one we already have, so that refreshes of long DVR windows only turn the
+ * newest lines into tags and segments. The state the skipped lines carried
+ * (discontinuity sequence, current key, init segment) is kept as header
+ * tags. Returns false when the playlist cannot be sliced, and the full
+ * playlist needs to be parsed.
+ */
+static bool slicePlaylistTail(const char *p, size_t len, uint64_t lastsequence,
+                              std::string &tail, uint64_t *windowstart)
 {
-    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
-    if(p_block)
+    const char * const end = p + len;
+    std::string header;
+    std::string keyline;
+    bool b_map = false;
+    uint64_t sequence = 0;
+    uint64_t discontinuitysequence = 0;
+    bool b_sequence = false;
+
+    while(p < end)
     {
-        stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
-        if(substream)
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        const char *line = p;
+        size_t linelen = (eol ? eol : end) - p;
+        if(linelen && line[linelen - 1] == '\r')
+            linelen--;
+        p = eol ? eol + 1 : end;
+
+        if(linelen == 0)
+            continue;
+
+        if(line[0] != '#') /* segment URI */
         {
-            std::list<Tag *> tagslist = parseEntries(substream);
-            vlc_stream_Delete(substream);
+            if(!b_sequence)
+            {
+                *windowstart = sequence;
+                b_sequence = true;
+                if(lastsequence < sequence)
+                    return false; /* fell out of the window */
+            }
+            if(sequence++ == lastsequence)
+                break;
+            continue;
+        }
 
-            parseSegments(p_obj, rep, tagslist);
+        auto startsWith = [line, linelen](const char *prefix, size_t prefixlen)
+        {
+            return linelen >= prefixlen && !std::memcmp(line, prefix, prefixlen);
+        };
+        auto decimal = [line, linelen](size_t offset)
+        {
+            return std::strtoull(std::string(line + offset, linelen - offset).c_str(),
+                                 nullptr, 10);
+        };
 
-            releaseTagsList(tagslist);
+        if(startsWith("#EXTINF", 7))
+            continue;
+        else if(startsWith("#EXT-X-MEDIA-SEQUENCE:", 22))
+            sequence = decimal(22);
+        else if(startsWith("#EXT-X-DISCONTINUITY-SEQUENCE:", 30))
+            discontinuitysequence = decimal(30);
+        else if(linelen == 20 && startsWith("#EXT-X-DISCONTINUITY", 20))
+            discontinuitysequence++;
+        else if(startsWith("#EXT-X-KEY:", 11))
+            keyline.assign(line, linelen);
+        else if(startsWith("#EXT-X-MAP:", 11))
+        {
+            if(!b_map) /* parser only uses the first one */
+                header.append(line, linelen).append("\n");
+            b_map = true;
         }
+        else if(startsWith("#EXT-X-BYTERANGE", 16) ||
+                startsWith("#EXT-X-PROGRAM-DATE-TIME", 24))
+            return false; /* offsets and times depend on previous segments */
+        else if(startsWith("#EXT-X-TARGETDURATION:", 22) ||
+                startsWith("#EXT-X-PLAYLIST-TYPE:", 21))
+            header.append(line, linelen).append("\n");
+    }
+
+    if(!b_sequence || sequence != lastsequence + 1)
+        return false; /* our last segment is not listed */
+
+    tail = "#EXTM3U\n";
+    tail.append(header);
+    tail.append("#EXT-X-MEDIA-SEQUENCE:").append(std::to_string(sequence)).append("\n");
+    tail.append("#EXT-X-DISCONTINUITY-SEQUENCE:")
+        .append(std::to_string(discontinuitysequence)).append("\n");
+    if(!keyline.empty())
+        tail.append(keyline).append("\n");
+    tail.append(p, end - p);
+    return true;
+}
+
+bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
+{
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    if(p_block)
+    {
+        appendSegmentsFromPlaylist(p_obj, rep, p_block->p_buffer, p_block->i_buffer);
         block_Release(p_block);
         return true;
     }
     return false;
 }
 
+void M3U8Parser::appendSegmentsFromPlaylist(vlc_object_t *p_obj, HLSRepresentation *rep,
+                                            const uint8_t *p_data, size_t i_data)
+{
+    std::string tail;
+    uint64_t windowstart = std::numeric_limits<uint64_t>::max();
+
+    /* Live refresh: only parse what follows our last segment */
+    const SegmentList *segmentList = rep->inheritSegmentList();
+    if(rep->initialized() && rep->isLive() && segmentList &&
+       segmentList->hasRelativeMediaTimes() && !segmentList->getSegments().empty())
+    {
+        const uint64_t lastsequence = segmentList->getSegments().back()->getSequenceNumber();
+        if(slicePlaylistTail(reinterpret_cast<const char *>(p_data), i_data,
+                             lastsequence, tail, &windowstart))
+        {
+            p_data = reinterpret_cast<const uint8_t *>(tail.data());
+            i_data = tail.size();
+        }
+        else windowstart = std::numeric_limits<uint64_t>::max();
+    }
+
+    stream_t *substream = vlc_stream_MemoryNew(p_obj, const_cast<uint8_t *>(p_data), i_data, true);
+    if(substream)
+    {
+        std::list<Tag *> tagslist = parseEntries(substream);
+        vlc_stream_Delete(substream);
+
+        parseSegments(p_obj, rep, tagslist, windowstart);
+
+        releaseTagsList(tagslist);
+    }
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -279,13 +398,16 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
-void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std::list<Tag *> &tagslist)
+void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std::list<Tag *> &tagslist,
+                               uint64_t windowstart)
 {
     bool b_pdt = tagslist.cend() != std::find_if(tagslist.cbegin(), tagslist.cend(),
                     [](const Tag *t){return t->getType() == SingleValueTag::EXTXPROGRAMDATETIME;});
     bool b_vod = tagslist.size() && tagslist.back()->getType() == SingleValueTag::EXTXENDLIST;
 
     SegmentList *segmentList = new SegmentList(rep, !b_vod && !b_pdt);
+    if(windowstart != std::numeric_limits<uint64_t>::max())
+        segmentList->setWindowStart(windowstart);
     const Timescale timescale = rep->inheritTimescale();
 
     rep->b_loaded = true;
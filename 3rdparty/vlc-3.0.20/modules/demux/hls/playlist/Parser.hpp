@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <list>
+#include <limits>
 
 #include <vlc_common.h>
 
@@ -60,6 +61,8 @@ namespace hls
 
                 M3U8 *             parse  (vlc_object_t *p_obj, stream_t *p_stream, const std::string &);
                 bool appendSegmentsFromPlaylistURI(vlc_object_t *, HLSRepresentation *);
+                void appendSegmentsFromPlaylist(vlc_object_t *, HLSRepresentation *,
+                                                const uint8_t *, size_t);
 
             private:
                 HLSRepresentation * createRepresentation(BaseAdaptationSet *, const AttributesTag *);
@@ -69,7 +72,8 @@ namespace hls
                                                      HLSRepresentation *);
                 void fillAdaptsetFromMediainfo(const AttributesTag *, const std::string &,
                                                const std::string &, BaseAdaptationSet *);
-                void parseSegments(vlc_object_t *, HLSRepresentation *, const std::list<Tag *>&);
+                void parseSegments(vlc_object_t *, HLSRepresentation *, const std::list<Tag *>&,
+                                   uint64_t = std::numeric_limits<uint64_t>::max());
                 std::list<Tag *> parseEntries(stream_t *);
                 adaptive::SharedResources *resources;
         };
@@ -0,0 +1,193 @@
+/*****************************************************************************
+ * ebml_walker.c : in-memory EBML element walker and block lacing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "ebml_walker.h"
+
+/* Reads a variable size integer of at most i_max bytes. Returns its length,
+ * or 0 if invalid or truncated. The length marker is kept if b_marker. */
+static size_t ReadVint( const uint8_t *p, size_t i_buf, size_t i_max,
+                        bool b_marker, uint64_t *pi_value )
+{
+    if( i_buf == 0 || p[0] == 0 )
+        return 0;
+
+    size_t i_len = 1 + clz8( p[0] );
+    if( i_len > i_max || i_len > i_buf )
+        return 0;
+
+    uint64_t i_value = b_marker ? p[0] : p[0] & (0xFF >> i_len);
+    for( size_t i = 1; i < i_len; i++ )
+        i_value = (i_value << 8) | p[i];
+
+    *pi_value = i_value;
+    return i_len;
+}
+
+int ebml_WalkerNext( ebml_walker_t *p_walker, ebml_element_t *p_el )
+{
+    const uint8_t *p = &p_walker->p_buf[p_walker->i_pos];
+    size_t i_buf = p_walker->i_buf - p_walker->i_pos;
+    uint64_t i_id, i_size;
+
+    if( i_buf == 0 )
+        return 0;
+
+    size_t i_id_len = ReadVint( p, i_buf, 4, true, &i_id );
+    if( i_id_len == 0 )
+        return -1;
+    size_t i_size_len = ReadVint( &p[i_id_len], i_buf - i_id_len, 8,
+                                  false, &i_size );
+    if( i_size_len == 0 )
+        return -1;
+
+    const size_t i_header = i_id_len + i_size_len;
+    /* all the value bits set */
+    if( i_size == (UINT64_C(1) << (7 * i_size_len)) - 1 )
+        i_size = EBML_SIZE_UNKNOWN;
+    else if( i_size > i_buf - i_header )
+        return -1;
+
+    p_el->i_id = i_id;
+    p_el->i_size = i_size;
+    p_el->i_offset = p_walker->i_pos;
+    p_el->i_header = i_header;
+    p_el->p_data = &p[i_header];
+
+    /* an element of unknown size can only be a master: its children follow */
+    p_walker->i_pos += i_header;
+    if( i_size != EBML_SIZE_UNKNOWN )
+        p_walker->i_pos += i_size;
+    return 1;
+}
+
+int mkv_BlockParse( mkv_block_t *p_block, const uint8_t *p_data, size_t i_data )
+{
+    uint64_t i_track;
+
+    if( i_data > UINT32_MAX )
+        return VLC_EGENERIC;
+
+    size_t i_pos = ReadVint( p_data, i_data, 8, false, &i_track );
+    if( i_pos == 0 || i_data - i_pos < 3 )
+        return VLC_EGENERIC;
+
+    p_block->i_track = i_track;
+    p_block->i_timecode = (int16_t)GetWBE( &p_data[i_pos] );
+    p_block->i_flags = p_data[i_pos + 2];
+    i_pos += 3;
+
+    const unsigned i_lacing = (p_block->i_flags & MKV_BLOCK_LACING) >> 1;
+    if( i_lacing == 0 )
+    {
+        p_block->i_frames = 1;
+        p_block->pi_offset[0] = i_pos;
+        p_block->pi_size[0] = i_data - i_pos;
+        return VLC_SUCCESS;
+    }
+
+    if( i_pos >= i_data )
+        return VLC_EGENERIC;
+    const unsigned i_frames = p_data[i_pos++] + 1;
+    uint32_t *pi_size = p_block->pi_size;
+    uint64_t i_laced = 0; /* sum of all the sizes but the last one */
+
+    switch( i_lacing )
+    {
+        case 1: /* Xiph: sizes as runs of 255 */
+            for( unsigned i = 0; i < i_frames - 1; i++ )
+            {
+                uint64_t i_size = 0;
+                uint8_t i_byte;
+                do
+                {
+                    if( i_pos >= i_data )
+                        return VLC_EGENERIC;
+                    i_byte = p_data[i_pos++];
+                    i_size += i_byte;
+                } while( i_byte == 0xFF );
+                if( i_size > i_data )
+                    return VLC_EGENERIC;
+                pi_size[i] = i_size;
+                i_laced += i_size;
+            }
+            break;
+
+        case 3: /* EBML: first size, then signed differences */
+        {
+            if( i_frames == 1 )
+                break;
+
+            uint64_t i_value;
+            size_t i_len = ReadVint( &p_data[i_pos], i_data - i_pos, 8,
+                                     false, &i_value );
+            if( i_len == 0 || i_value > i_data )
+                return VLC_EGENERIC;
+            i_pos += i_len;
+            pi_size[0] = i_value;
+            i_laced = i_value;
+
+            int64_t i_size = i_value;
+            for( unsigned i = 1; i < i_frames - 1; i++ )
+            {
+                i_len = ReadVint( &p_data[i_pos], i_data - i_pos, 8,
+                                  false, &i_value );
+                if( i_len == 0 )
+                    return VLC_EGENERIC;
+                i_pos += i_len;
+                /* biased by half the range of the vint */
+                i_size += (int64_t)i_value -
+                          ((INT64_C(1) << (7 * i_len - 1)) - 1);
+                if( i_size < 0 || (uint64_t)i_size > i_data )
+                    return VLC_EGENERIC;
+                pi_size[i] = i_size;
+                i_laced += i_size;
+            }
+            break;
+        }
+
+        case 2: /* fixed: all of the same size */
+            if( (i_data - i_pos) % i_frames )
+                return VLC_EGENERIC;
+            for( unsigned i = 0; i < i_frames - 1; i++ )
+                pi_size[i] = (i_data - i_pos) / i_frames;
+            i_laced = (i_data - i_pos) / i_frames * (i_frames - 1);
+            break;
+    }
+
+    if( i_laced > i_data - i_pos )
+        return VLC_EGENERIC;
+    pi_size[i_frames - 1] = i_data - i_pos - i_laced;
+
+    /* all the sizes are known: the frame offsets do not depend on each
+     * other any more */
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        p_block->pi_offset[i] = i_pos;
+        i_pos += pi_size[i];
+    }
+    p_block->i_frames = i_frames;
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * ebml_walker.h : in-memory EBML element walker and block lacing
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MKV_EBML_WALKER_H
+#define VLC_MKV_EBML_WALKER_H
+
+/* Walks the elements of a buffer already in memory (a prefetched cluster),
+ * without the per element allocations and reads of libebml. */
+
+#define EBML_ID_CLUSTER         0x1F43B675
+#define EBML_ID_CLUSTERTIMECODE 0xE7
+#define EBML_ID_BLOCKGROUP      0xA0
+#define EBML_ID_BLOCK           0xA1
+#define EBML_ID_SIMPLEBLOCK     0xA3
+
+#define EBML_SIZE_UNKNOWN UINT64_MAX
+
+typedef struct
+{
+    uint32_t       i_id;     /* with its length marker, as in the spec */
+    uint64_t       i_size;   /* EBML_SIZE_UNKNOWN: up to the end of the buffer */
+    size_t         i_offset; /* of the header, from the walked buffer */
+    size_t         i_header;
+    const uint8_t *p_data;
+} ebml_element_t;
+
+typedef struct
+{
+    const uint8_t *p_buf;
+    size_t         i_buf;
+    size_t         i_pos;
+} ebml_walker_t;
+
+static inline void ebml_WalkerInit( ebml_walker_t *p_walker,
+                                    const uint8_t *p_buf, size_t i_buf )
+{
+    p_walker->p_buf = p_buf;
+    p_walker->i_buf = i_buf;
+    p_walker->i_pos = 0;
+}
+
+/* Returns 1 and the next element, 0 at the end of the buffer, or -1 if the
+ * element is invalid or truncated (the walker then stays on it) */
+int ebml_WalkerNext( ebml_walker_t *, ebml_element_t * );
+
+/* Walks the data of a master element returned by p_parent */
+static inline void ebml_WalkerEnter( ebml_walker_t *p_walker,
+                                     const ebml_walker_t *p_parent,
+                                     const ebml_element_t *p_el )
+{
+    size_t i_size = p_el->i_size == EBML_SIZE_UNKNOWN ?
+                    p_parent->i_buf - p_el->i_offset - p_el->i_header :
+                    p_el->i_size;
+    ebml_WalkerInit( p_walker, p_el->p_data, i_size );
+}
+
+/* A (Simple)Block has at most 256 laced frames */
+#define MKV_BLOCK_FRAMES_MAX 256
+
+#define MKV_BLOCK_KEYFRAME    0x80
+#define MKV_BLOCK_INVISIBLE   0x08
+#define MKV_BLOCK_LACING      0x06
+#define MKV_BLOCK_DISCARDABLE 0x01
+
+typedef struct
+{
+    uint64_t i_track;
+    int16_t  i_timecode; /* relative to the cluster */
+    uint8_t  i_flags;
+    unsigned i_frames;
+    /* frames, from the start of the block data */
+    uint32_t pi_offset[MKV_BLOCK_FRAMES_MAX];
+    uint32_t pi_size[MKV_BLOCK_FRAMES_MAX];
+} mkv_block_t;
+
+/* Parses the header of a (Simple)Block and the boundaries of all its
+ * frames at once. Returns VLC_SUCCESS or VLC_EGENERIC if it is invalid. */
+int mkv_BlockParse( mkv_block_t *, const uint8_t *p_data, size_t i_data );
+
+#endif
@@ -28,11 +28,17 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
 
 #include <new>
 #include <iterator>
 #include <limits>
 
+/* Clusters up to this size are read at once and parsed from memory */
+#define MKV_CLUSTER_PREFETCH_MAX (32 << 20)
+/* Media announced ahead of the current cluster */
+#define MKV_READAHEAD (CLOCK_FREQ * 2)
+
 matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estream, KaxSegment *p_seg )
     :segment(p_seg)
     ,es(estream)
@@ -48,6 +54,9 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,i_attachments_position(-1)
     ,cluster(NULL)
     ,i_block_pos(0)
+    ,b_readahead(true)
+    ,i_readahead_end(0)
+    ,p_laced_data(NULL)
     ,p_segment_uid(NULL)
     ,p_prev_segment_uid(NULL)
     ,p_next_segment_uid(NULL)
@@ -483,6 +492,46 @@ void matroska_segment_c::IndexAppendCluster( KaxCluster *cluster )
     _seeker.add_cluster( cluster );
 }
 
+/* Announces the clusters of the next seconds to the access, up to the first
+ * cue point past them, as one range: the kernel read-ahead is then not left
+ * guessing from the block reads */
+void matroska_segment_c::ReadAhead( const KaxCluster *cluster )
+{
+    if( !b_readahead || !cluster->IsFiniteSize() )
+        return;
+
+    const vlc_tick_t i_until = vlc_tick_t( cluster->GlobalTimecode() / INT64_C( 1000 ) )
+                             + MKV_READAHEAD;
+    const uint64_t i_start = std::max<uint64_t>( cluster->GetEndPosition(),
+                                                 i_readahead_end );
+    uint64_t i_end = std::numeric_limits<uint64_t>::max();
+
+    for( SegmentSeeker::tracks_seekpoints_t::const_iterator it =
+            _seeker._tracks_seekpoints.begin();
+         it != _seeker._tracks_seekpoints.end(); ++it )
+    {
+        const SegmentSeeker::seekpoints_t &points = it->second;
+        for( SegmentSeeker::seekpoints_t::const_iterator sp = points.begin();
+             sp != points.end(); ++sp )
+        {
+            if( sp->pts > i_until && sp->fpos > i_start )
+            {
+                i_end = std::min( i_end, sp->fpos );
+                break;
+            }
+        }
+    }
+
+    if( i_end == std::numeric_limits<uint64_t>::max() )
+        return; /* no cue point that far */
+
+    if( !static_cast<vlc_stream_io_callback &>( es.I_O() )
+            .ReadAhead( i_start, i_end - i_start ) )
+        b_readahead = false; /* not supported */
+    else
+        i_readahead_end = i_end;
+}
+
 bool matroska_segment_c::PreloadClusters(uint64 i_cluster_pos)
 {
     struct ClusterHandlerPayload
@@ -813,6 +862,8 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
     SegmentSeeker::track_ids_t selected_tracks;
     SegmentSeeker::track_ids_t priority;
 
+    i_readahead_end = 0;
+
     // reset information for all tracks //
 
     for( tracks_map_t::iterator it = tracks.begin(); it != tracks.end(); ++it )
@@ -1184,6 +1235,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
     pp_simpleblock = NULL;
     pp_block = NULL;
     pp_additions = NULL;
+    p_laced_data = NULL;
 
     *pb_key_picture         = true;
     *pb_discardable_picture = false;
@@ -1215,6 +1267,11 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
         {
             vars.obj->cluster = &kcluster;
             vars.b_cluster_timecode = false;
+            /* One large read instead of many small ones per block */
+            if( kcluster.IsFiniteSize() &&
+                kcluster.GetSize() <= MKV_CLUSTER_PREFETCH_MAX )
+                static_cast<vlc_stream_io_callback &>( vars.obj->es.I_O() )
+                    .Prefetch( kcluster.GetDataStart(), kcluster.GetSize() );
             vars.ep->Down ();
         }
         E_CASE( KaxCues, kcue )
@@ -1237,6 +1294,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
             ktimecode.ReadData( vars.obj->es.I_O(), SCOPE_ALL_DATA );
             vars.obj->cluster->InitTimecode( static_cast<uint64>( ktimecode ), vars.obj->i_timescale );
             vars.obj->IndexAppendCluster( vars.obj->cluster );
+            vars.obj->ReadAhead( vars.obj->cluster );
             vars.b_cluster_timecode = true;
         }
         E_CASE( KaxClusterSilentTracks, ksilent )
@@ -1259,7 +1317,26 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
             }
 
             vars.simpleblock = &ksblock;
-            vars.simpleblock->ReadData( vars.obj->es.I_O() );
+
+            /* Within the prefetched cluster, libebml only reads the header
+             * and the frames are split in place, without a copy */
+            vlc_stream_io_callback & io =
+                static_cast<vlc_stream_io_callback &>( vars.obj->es.I_O() );
+            const uint8_t *p_data =
+                io.Peek( ksblock.GetElementPosition() + ksblock.HeadSize(),
+                         ksblock.GetSize() );
+            if( p_data != NULL &&
+                mkv_BlockParse( &vars.obj->laced, p_data,
+                                ksblock.GetSize() ) == VLC_SUCCESS )
+            {
+                vars.obj->p_laced_data = p_data;
+                vars.simpleblock->ReadData( io, SCOPE_PARTIAL_DATA );
+            }
+            else
+            {
+                vars.obj->p_laced_data = NULL;
+                vars.simpleblock->ReadData( io );
+            }
             vars.simpleblock->SetParent( *vars.obj->cluster );
 
             if( ksblock.IsKeyframe() )
@@ -36,6 +36,10 @@
 
 #include "Ebml_parser.hpp"
 
+extern "C" {
+#include "ebml_walker.h"
+}
+
 class EbmlParser;
 
 class chapter_edition_c;
@@ -109,6 +113,13 @@ public:
 
     KaxCluster              *cluster;
     uint64                  i_block_pos;
+    /* clusters announced to the access ahead of the demux, up to here */
+    bool                    b_readahead;
+    uint64                  i_readahead_end;
+    /* frames of the last SimpleBlock, when it was in the prefetched
+     * cluster (valid until the next BlockGet) */
+    const uint8_t           *p_laced_data;
+    mkv_block_t             laced;
     KaxSegmentUID           *p_segment_uid;
     KaxPrevUID              *p_prev_segment_uid;
     KaxNextUID              *p_next_segment_uid;
@@ -170,6 +181,7 @@ private:
     bool ParseCluster( KaxCluster *cluster, bool b_update_start_time = true, ScopeMode read_fully = SCOPE_ALL_DATA );
     bool ParseSimpleTags( SimpleTag* out, KaxTagSimple *tag, int level = 50 );
     void IndexAppendCluster( KaxCluster *cluster );
+    void ReadAhead( const KaxCluster *cluster );
     bool TrackInit( mkv_track_t * p_tk );
     void ComputeTrackPriority();
     void EnsureDuration();
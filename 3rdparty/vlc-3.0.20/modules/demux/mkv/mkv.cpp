@@ -536,23 +536,36 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     else
         block_size = block->GetSize();
 
-    const unsigned int i_number_frames = block != NULL ? block->NumberFrames() :
+    /* SimpleBlock split in place in the prefetched cluster */
+    const mkv_block_t *p_laced = simpleblock != NULL && p_segment->p_laced_data != NULL ?
+                                 &p_segment->laced : NULL;
+
+    const unsigned int i_number_frames = p_laced != NULL ? p_laced->i_frames :
+            block != NULL ? block->NumberFrames() :
             ( simpleblock != NULL ? simpleblock->NumberFrames() : 0 );
 
     for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
     {
         block_t *p_block;
-        DataBuffer *data;
-        if( simpleblock != NULL )
+        const uint8_t *p_data;
+        size_t i_data;
+        if( p_laced != NULL )
         {
-            data = &simpleblock->GetBuffer(i_frame);
+            p_data = &p_segment->p_laced_data[p_laced->pi_offset[i_frame]];
+            i_data = p_laced->pi_size[i_frame];
         }
         else
         {
-            data = &block->GetBuffer(i_frame);
+            DataBuffer *data;
+            if( simpleblock != NULL )
+                data = &simpleblock->GetBuffer(i_frame);
+            else
+                data = &block->GetBuffer(i_frame);
+            p_data = data->Buffer();
+            i_data = data->Size();
         }
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+        frame_size += i_data;
+        if( !p_data || i_data > frame_size || frame_size > block_size  )
         {
             msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
             break;
@@ -562,11 +575,11 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
         if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
             track.p_compression_data != NULL &&
             track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
+            p_block = MemToBlock( p_data, i_data, track.p_compression_data->GetSize() + extra_data );
         else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
+            p_block = packetize_wavpack( track, p_data, i_data );
         else
-            p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
+            p_block = MemToBlock( p_data, i_data, extra_data );
 
         if( p_block == NULL )
         {
@@ -27,6 +27,9 @@
 #include "matroska_segment.hpp"
 #include "demux.hpp"
 
+/* Largest cluster copied into memory when the source cannot be mapped */
+#define MKV_PREFETCH_COPY_MAX (1 << 20)
+
 /*****************************************************************************
  * Stream management
  *****************************************************************************/
@@ -34,6 +37,75 @@ vlc_stream_io_callback::vlc_stream_io_callback( stream_t *s_, bool b_owner_ )
                        : s( s_), b_owner( b_owner_ )
 {
     mb_eof = false;
+    b_fastseek = false;
+    if( s != NULL &&
+        vlc_stream_Control( s, STREAM_CAN_FASTSEEK, &b_fastseek ) )
+        b_fastseek = false;
+    p_prefetch = NULL;
+    i_prefetch_pos = i_cur_pos = 0;
+}
+
+void vlc_stream_io_callback::Prefetch( uint64_t i_offset, uint64_t i_size )
+{
+    /* Going back after a partial read of the prefetched data needs seeking,
+     * which must be cheap (not a new HTTP request, for instance) */
+    if( !b_fastseek || i_size == 0 || i_size > SIZE_MAX ||
+        getFilePointer() != i_offset )
+        return;
+
+    DropPrefetch( true );
+
+    /* In place in the file mapping: no copy, the stream is left at i_offset
+     * and synced when the position leaves the cluster */
+    block_t *p_block;
+    if( vlc_stream_Control( s, STREAM_GET_MAPPED_BLOCK, i_offset,
+                            static_cast<size_t>( i_size ), &p_block ) )
+    {
+        /* Otherwise the cluster is copied, which is only worth it while
+         * it stays in the CPU caches */
+        if( i_size > MKV_PREFETCH_COPY_MAX )
+            return;
+
+        p_block = vlc_stream_Block( s, i_size );
+        if( p_block == NULL )
+        {
+            /* Restore the position for the element by element path */
+            if( vlc_stream_Seek( s, i_offset ) )
+                mb_eof = true;
+            return;
+        }
+    }
+    p_prefetch = p_block;
+    i_prefetch_pos = i_cur_pos = i_offset;
+}
+
+const uint8_t *vlc_stream_io_callback::Peek( uint64_t i_offset,
+                                             uint64_t i_size ) const
+{
+    if( p_prefetch == NULL || i_offset < i_prefetch_pos ||
+        i_offset - i_prefetch_pos > p_prefetch->i_buffer ||
+        i_size > p_prefetch->i_buffer - ( i_offset - i_prefetch_pos ) )
+        return NULL;
+    return &p_prefetch->p_buffer[i_offset - i_prefetch_pos];
+}
+
+bool vlc_stream_io_callback::ReadAhead( uint64_t i_offset, uint64_t i_size )
+{
+    return vlc_stream_Control( s, STREAM_SET_READAHEAD,
+                               i_offset, i_size ) == VLC_SUCCESS;
+}
+
+void vlc_stream_io_callback::DropPrefetch( bool b_sync )
+{
+    if( p_prefetch == NULL )
+        return;
+
+    block_Release( p_prefetch );
+    p_prefetch = NULL;
+
+    if( b_sync && vlc_stream_Tell( s ) != i_cur_pos &&
+        vlc_stream_Seek( s, i_cur_pos ) )
+        mb_eof = true;
 }
 
 uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
@@ -41,14 +113,36 @@ uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
     if( i_size <= 0 || mb_eof )
         return 0;
 
+    size_t i_copied = 0;
+    if( p_prefetch != NULL )
+    {
+        const uint64_t i_end = i_prefetch_pos + p_prefetch->i_buffer;
+        if( i_cur_pos >= i_prefetch_pos && i_cur_pos < i_end )
+        {
+            i_copied = __MIN( i_size, i_end - i_cur_pos );
+            memcpy( p_buffer,
+                    &p_prefetch->p_buffer[i_cur_pos - i_prefetch_pos],
+                    i_copied );
+            i_cur_pos += i_copied;
+            if( i_copied == i_size )
+                return i_copied;
+            p_buffer = static_cast<uint8_t *>( p_buffer ) + i_copied;
+            i_size -= i_copied;
+        }
+        /* Past the cluster: back to the stream */
+        DropPrefetch( true );
+        if( mb_eof )
+            return i_copied;
+    }
+
     int i_ret = vlc_stream_Read( s, p_buffer, i_size );
-    return i_ret < 0 ? 0 : i_ret;
+    return i_copied + ( i_ret < 0 ? 0 : i_ret );
 }
 
 void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
 {
     int64_t i_pos, i_size;
-    int64_t i_current = vlc_stream_Tell( s );
+    int64_t i_current = getFilePointer();
 
     switch( mode )
     {
@@ -73,6 +167,19 @@ void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
     }
 
     mb_eof = false;
+    if( p_prefetch != NULL )
+    {
+        if( (uint64_t)i_pos >= i_prefetch_pos &&
+            (uint64_t)i_pos <= i_prefetch_pos + p_prefetch->i_buffer )
+        {
+            i_cur_pos = i_pos;
+            return;
+        }
+        DropPrefetch( false );
+        if( (uint64_t)i_pos == vlc_stream_Tell( s ) )
+            return;
+    }
+
     if( vlc_stream_Seek( s, i_pos ) )
     {
         mb_eof = true;
@@ -84,6 +191,8 @@ uint64 vlc_stream_io_callback::getFilePointer( void )
 {
     if ( s == NULL )
         return 0;
+    if( p_prefetch != NULL )
+        return i_cur_pos;
     return vlc_stream_Tell( s );
 }
 
@@ -104,6 +213,6 @@ uint64 vlc_stream_io_callback::toRead( void )
     if( i_size <= 0 )
         return UINT64_MAX;
 
-    return static_cast<uint64>( i_size - vlc_stream_Tell( s ) );
+    return static_cast<uint64>( i_size - getFilePointer() );
 }
 
@@ -32,18 +32,41 @@ class vlc_stream_io_callback: public IOCallback
     stream_t       *s;
     bool           mb_eof;
     bool           b_owner;
+    bool           b_fastseek;
+
+    /* Prefetched cluster: libebml reads are served from memory while the
+     * position is within it, the stream being synced when leaving it */
+    block_t        *p_prefetch;
+    uint64_t       i_prefetch_pos; /* stream offset of p_prefetch */
+    uint64_t       i_cur_pos;      /* current offset when p_prefetch is set */
+
+    void DropPrefetch( bool b_sync );
 
   public:
     vlc_stream_io_callback( stream_t *, bool owner );
 
     virtual ~vlc_stream_io_callback()
     {
+        if( p_prefetch )
+            block_Release( p_prefetch );
         if( b_owner )
             vlc_stream_Delete( s );
     }
 
     bool IsEOF() const { return mb_eof; }
 
+    /* Maps, or reads if small enough, i_size bytes at i_offset, the
+     * current position, in one go */
+    void Prefetch( uint64_t i_offset, uint64_t i_size );
+
+    /* Prefetched data at i_offset, valid until the position leaves the
+     * prefetched range, or NULL */
+    const uint8_t *Peek( uint64_t i_offset, uint64_t i_size ) const;
+
+    /* Announces that i_size bytes at i_offset will be read soon. Returns
+     * false if the stream does not support it. */
+    bool ReadAhead( uint64_t i_offset, uint64_t i_size );
+
     virtual uint32   read            ( void *p_buffer, size_t i_size);
     virtual void     setFilePointer  ( int64_t i_offset, seek_mode mode = seek_beginning );
     virtual size_t   write           ( const void *p_buffer, size_t i_size);
@@ -49,12 +49,44 @@ mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_n
             return NULL;
         }
         p_index->i_entries = i_num;
+        p_index->i_alloc = i_num;
         p_index->i_last_time = 0;
         p_index->i_tracks = i_tracks;
     }
     return p_index;
 }
 
+int MP4_Fragments_Index_Append( mp4_fragments_index_t *p_index, uint64_t i_pos,
+                                const stime_t *p_times, stime_t i_end_time )
+{
+    if( p_index->i_entries == p_index->i_alloc )
+    {
+        unsigned i_alloc = p_index->i_alloc * 2;
+        if( i_alloc <= p_index->i_alloc || SIZE_MAX / i_alloc < p_index->i_tracks )
+            return VLC_ENOMEM;
+
+        uint64_t *pi_pos = realloc( p_index->pi_pos, sizeof(*pi_pos) * i_alloc );
+        if( !pi_pos )
+            return VLC_ENOMEM;
+        p_index->pi_pos = pi_pos;
+
+        stime_t *p_alltimes = realloc( p_index->p_times, sizeof(*p_alltimes) *
+                                       i_alloc * p_index->i_tracks );
+        if( !p_alltimes )
+            return VLC_ENOMEM;
+        p_index->p_times = p_alltimes;
+        p_index->i_alloc = i_alloc;
+    }
+
+    p_index->pi_pos[p_index->i_entries] = i_pos;
+    memcpy( &p_index->p_times[(size_t)p_index->i_entries * p_index->i_tracks],
+            p_times, sizeof(*p_times) * p_index->i_tracks );
+    p_index->i_entries++;
+    if( p_index->i_last_time < i_end_time )
+        p_index->i_last_time = i_end_time;
+    return VLC_SUCCESS;
+}
+
 stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
                                               unsigned i_track_index, uint64_t i_moof_pos )
 {
@@ -93,6 +125,22 @@ bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index, stime_t *pi_tim
     return true;
 }
 
+bool MP4_Fragments_Index_LookupPos( mp4_fragments_index_t *p_index, uint64_t *pi_pos,
+                                    stime_t *pi_time, unsigned i_track_index )
+{
+    if( p_index->i_entries < 1 || i_track_index >= p_index->i_tracks ||
+        p_index->pi_pos[0] > *pi_pos )
+        return false;
+
+    size_t i = 1;
+    while( i < p_index->i_entries && p_index->pi_pos[i] <= *pi_pos )
+        i++;
+
+    *pi_pos = p_index->pi_pos[i - 1];
+    *pi_time = p_index->p_times[(i - 1) * p_index->i_tracks + i_track_index];
+    return true;
+}
+
 #ifdef MP4_VERBOSE
 void MP4_Fragments_Index_Dump( vlc_object_t *p_obj, const mp4_fragments_index_t *p_index,
                                uint32_t i_movie_timescale )
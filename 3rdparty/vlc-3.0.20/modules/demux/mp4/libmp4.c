@@ -249,6 +249,103 @@ MP4_Box_t * MP4_BoxExtract( MP4_Box_t **pp_chain, uint32_t i_type )
     return NULL;
 }
 
+/* Sample tables larger than this are read on demand, a window at a time */
+#define MP4_TABLE_WINDOW (1 << 16)
+
+/* Reads the entries of a sample table, from the current position, or only
+ * records where they are */
+static bool mp4_table_read( stream_t *s, const MP4_Box_t *box,
+                            MP4_Box_table_t *table, uint32_t count,
+                            uint32_t size )
+{
+    const uint64_t pos = vlc_stream_Tell( s );
+    const uint64_t bytes = (uint64_t) count * size;
+
+    if( pos + bytes > box->i_pos + box->i_size || bytes > SSIZE_MAX )
+        return false;
+
+    table->i_count = count;
+    table->i_size = size;
+
+    /* Leave the entries in the stream if it is the file itself, and not
+     * a decompressed movie header, and if it can be seeked back cheaply */
+    const MP4_Box_t *root = box;
+    while( root->p_father != NULL )
+        root = root->p_father;
+
+    bool b_fastseek;
+    if( bytes > MP4_TABLE_WINDOW && root->i_type == ATOM_root &&
+        vlc_stream_Control( s, STREAM_CAN_FASTSEEK, &b_fastseek ) == VLC_SUCCESS &&
+        b_fastseek )
+    {
+        uint64_t i_size;
+        if( vlc_stream_GetSize( s, &i_size ) == VLC_SUCCESS &&
+            pos + bytes > i_size )
+            return false; /* truncated */
+
+        table->p_stream = s;
+        table->i_pos = pos;
+        return true;
+    }
+
+    if( bytes == 0 )
+        return true;
+
+    table->p_window = malloc( bytes );
+    if( unlikely(table->p_window == NULL) )
+        return false;
+    if( vlc_stream_Read( s, table->p_window, bytes ) != (ssize_t) bytes )
+        return false;
+    table->i_loaded = count;
+    return true;
+}
+
+static void mp4_table_clean( MP4_Box_table_t *table )
+{
+    FREENULL( table->p_window );
+}
+
+const uint8_t *MP4_TableEntry( MP4_Box_table_t *p_table, uint32_t i_entry )
+{
+    assert( i_entry < p_table->i_count );
+
+    if( i_entry - p_table->i_first < p_table->i_loaded )
+        return &p_table->p_window[(i_entry - p_table->i_first) * p_table->i_size];
+    if( p_table->p_stream == NULL )
+        return NULL;
+
+    if( p_table->p_window == NULL )
+    {
+        p_table->p_window = malloc( MP4_TABLE_WINDOW );
+        if( unlikely(p_table->p_window == NULL) )
+            return NULL;
+    }
+
+    stream_t *s = p_table->p_stream;
+    const uint32_t i_window = MP4_TABLE_WINDOW / p_table->i_size;
+    const uint32_t i_first = i_entry - i_entry % i_window;
+    const uint32_t i_loaded = __MIN( i_window, p_table->i_count - i_first );
+    const size_t i_bytes = (size_t) i_loaded * p_table->i_size;
+    const uint64_t i_back = vlc_stream_Tell( s );
+    bool b_ok = MP4_Seek( s, p_table->i_pos +
+                             (uint64_t) i_first * p_table->i_size ) == VLC_SUCCESS &&
+                vlc_stream_Read( s, p_table->p_window, i_bytes ) == (ssize_t) i_bytes;
+
+    if( MP4_Seek( s, i_back ) != VLC_SUCCESS )
+        b_ok = false;
+    if( !b_ok )
+    {
+        msg_Err( s, "cannot read sample table entries at %"PRIu64,
+                 p_table->i_pos + (uint64_t) i_first * p_table->i_size );
+        p_table->i_loaded = 0;
+        return NULL;
+    }
+
+    p_table->i_first = i_first;
+    p_table->i_loaded = i_loaded;
+    return &p_table->p_window[(i_entry - i_first) * p_table->i_size];
+}
+
 /* Don't use vlc_stream_Seek directly */
 #undef vlc_stream_Seek
 #define vlc_stream_Seek(a,b) __NO__
@@ -1569,40 +1666,23 @@ static int MP4_ReadBox_dref( stream_t *p_stream, MP4_Box_t *p_box )
 
 static void MP4_FreeBox_stts( MP4_Box_t *p_box )
 {
-    FREENULL( p_box->data.p_stts->pi_sample_count );
-    FREENULL( p_box->data.p_stts->pi_sample_delta );
+    mp4_table_clean( &p_box->data.p_stts->entries );
 }
 
 static int MP4_ReadBox_stts( stream_t *p_stream, MP4_Box_t *p_box )
 {
-    uint32_t count;
-
-    MP4_READBOX_ENTER( MP4_Box_data_stts_t, MP4_FreeBox_stts );
-
-    MP4_GETVERSIONFLAGS( p_box->data.p_stts );
-    MP4_GET4BYTES( count );
-
-    if( UINT64_C(8) * count > i_read )
-    {
-        /*count = i_read / 8;*/
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_stts_t,
+                               mp4_box_headersize( p_box ) + 8,
+                               MP4_FreeBox_stts );
+    if( i_read < 8 )
         MP4_READBOX_EXIT( 0 );
-    }
 
-    p_box->data.p_stts->pi_sample_count = vlc_alloc( count, sizeof(uint32_t) );
-    p_box->data.p_stts->pi_sample_delta = vlc_alloc( count, sizeof(int32_t) );
-    p_box->data.p_stts->i_entry_count = count;
+    MP4_GETVERSIONFLAGS( p_box->data.p_stts );
+    MP4_GET4BYTES( p_box->data.p_stts->i_entry_count );
 
-    if( p_box->data.p_stts->pi_sample_count == NULL
-     || p_box->data.p_stts->pi_sample_delta == NULL )
-    {
+    if( !mp4_table_read( p_stream, p_box, &p_box->data.p_stts->entries,
+                         p_box->data.p_stts->i_entry_count, 8 ) )
         MP4_READBOX_EXIT( 0 );
-    }
-
-    for( uint32_t i = 0; i < count; i++ )
-    {
-        MP4_GET4BYTES( p_box->data.p_stts->pi_sample_count[i] );
-        MP4_GET4BYTES( p_box->data.p_stts->pi_sample_delta[i] );
-    }
 
 #ifdef MP4_VERBOSE
     msg_Dbg( p_stream, "read box: \"stts\" entry-count %d",
@@ -1615,37 +1695,27 @@ static int MP4_ReadBox_stts( stream_t *p_stream, MP4_Box_t *p_box )
 
 static void MP4_FreeBox_ctts( MP4_Box_t *p_box )
 {
-    FREENULL( p_box->data.p_ctts->pi_sample_count );
-    FREENULL( p_box->data.p_ctts->pi_sample_offset );
+    mp4_table_clean( &p_box->data.p_ctts->entries );
 }
 
 static int MP4_ReadBox_ctts( stream_t *p_stream, MP4_Box_t *p_box )
 {
-    uint32_t count;
-
-    MP4_READBOX_ENTER( MP4_Box_data_ctts_t, MP4_FreeBox_ctts );
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_ctts_t,
+                               mp4_box_headersize( p_box ) + 8,
+                               MP4_FreeBox_ctts );
+    if( i_read < 8 )
+        MP4_READBOX_EXIT( 0 );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_ctts );
-    MP4_GET4BYTES( count );
-
-    if( UINT64_C(8) * count > i_read )
-        MP4_READBOX_EXIT( 0 );
+    MP4_GET4BYTES( p_box->data.p_ctts->i_entry_count );
 
-    p_box->data.p_ctts->pi_sample_count = vlc_alloc( count, sizeof(uint32_t) );
-    p_box->data.p_ctts->pi_sample_offset = vlc_alloc( count, sizeof(int32_t) );
-    if( unlikely(p_box->data.p_ctts->pi_sample_count == NULL
-              || p_box->data.p_ctts->pi_sample_offset == NULL) )
+    if( !mp4_table_read( p_stream, p_box, &p_box->data.p_ctts->entries,
+                         p_box->data.p_ctts->i_entry_count, 8 ) )
         MP4_READBOX_EXIT( 0 );
-    p_box->data.p_ctts->i_entry_count = count;
-
-    for( uint32_t i = 0; i < count; i++ )
-    {
-        MP4_GET4BYTES( p_box->data.p_ctts->pi_sample_count[i] );
-        MP4_GET4BYTES( p_box->data.p_ctts->pi_sample_offset[i] );
-    }
 
 #ifdef MP4_VERBOSE
-    msg_Dbg( p_stream, "read box: \"ctts\" entry-count %"PRIu32, count );
+    msg_Dbg( p_stream, "read box: \"ctts\" entry-count %"PRIu32,
+             p_box->data.p_ctts->i_entry_count );
 
 #endif
     MP4_READBOX_EXIT( 1 );
@@ -3014,38 +3084,26 @@ static void MP4_FreeBox_sample_text( MP4_Box_t *p_box )
 
 static void MP4_FreeBox_stsz( MP4_Box_t *p_box )
 {
-    FREENULL( p_box->data.p_stsz->i_entry_size );
+    mp4_table_clean( &p_box->data.p_stsz->entries );
 }
 
 static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
 {
-    uint32_t count;
-
-    MP4_READBOX_ENTER( MP4_Box_data_stsz_t, MP4_FreeBox_stsz );
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_stsz_t,
+                               mp4_box_headersize( p_box ) + 12,
+                               MP4_FreeBox_stsz );
+    if( i_read < 12 )
+        MP4_READBOX_EXIT( 0 );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stsz );
 
     MP4_GET4BYTES( p_box->data.p_stsz->i_sample_size );
-    MP4_GET4BYTES( count );
-    p_box->data.p_stsz->i_sample_count = count;
+    MP4_GET4BYTES( p_box->data.p_stsz->i_sample_count );
 
-    if( p_box->data.p_stsz->i_sample_size == 0 )
-    {
-        if( UINT64_C(4) * count > i_read )
-            MP4_READBOX_EXIT( 0 );
-
-        p_box->data.p_stsz->i_entry_size =
-            vlc_alloc( count, sizeof(uint32_t) );
-        if( unlikely( !p_box->data.p_stsz->i_entry_size ) )
-            MP4_READBOX_EXIT( 0 );
-
-        for( uint32_t i = 0; i < count; i++ )
-        {
-            MP4_GET4BYTES( p_box->data.p_stsz->i_entry_size[i] );
-        }
-    }
-    else
-        p_box->data.p_stsz->i_entry_size = NULL;
+    if( p_box->data.p_stsz->i_sample_size == 0 &&
+        !mp4_table_read( p_stream, p_box, &p_box->data.p_stsz->entries,
+                         p_box->data.p_stsz->i_sample_count, 4 ) )
+        MP4_READBOX_EXIT( 0 );
 
 #ifdef MP4_VERBOSE
     msg_Dbg( p_stream, "read box: \"stsz\" sample-size %d sample-count %d",
@@ -3162,35 +3220,27 @@ static int MP4_ReadBox_tssy( stream_t *p_stream, MP4_Box_t *p_box )
 
 static void MP4_FreeBox_stco_co64( MP4_Box_t *p_box )
 {
-    FREENULL( p_box->data.p_co64->i_chunk_offset );
+    mp4_table_clean( &p_box->data.p_co64->entries );
 }
 
 static int MP4_ReadBox_stco_co64( stream_t *p_stream, MP4_Box_t *p_box )
 {
     const bool sixtyfour = p_box->i_type != ATOM_stco;
-    uint32_t count;
 
-    MP4_READBOX_ENTER( MP4_Box_data_co64_t, MP4_FreeBox_stco_co64 );
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_co64_t,
+                               mp4_box_headersize( p_box ) + 8,
+                               MP4_FreeBox_stco_co64 );
+    if( i_read < 8 )
+        MP4_READBOX_EXIT( 0 );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_co64 );
-    MP4_GET4BYTES( count );
+    MP4_GET4BYTES( p_box->data.p_co64->i_entry_count );
 
-    if( (sixtyfour ? UINT64_C(8) : UINT64_C(4)) * count > i_read )
+    if( !mp4_table_read( p_stream, p_box, &p_box->data.p_co64->entries,
+                         p_box->data.p_co64->i_entry_count,
+                         sixtyfour ? 8 : 4 ) )
         MP4_READBOX_EXIT( 0 );
 
-    p_box->data.p_co64->i_chunk_offset = vlc_alloc( count, sizeof(uint64_t) );
-    if( unlikely(p_box->data.p_co64->i_chunk_offset == NULL) )
-        MP4_READBOX_EXIT( 0 );
-    p_box->data.p_co64->i_entry_count = count;
-
-    for( uint32_t i = 0; i < count; i++ )
-    {
-        if( sixtyfour )
-            MP4_GET8BYTES( p_box->data.p_co64->i_chunk_offset[i] );
-        else
-            MP4_GET4BYTES( p_box->data.p_co64->i_chunk_offset[i] );
-    }
-
 #ifdef MP4_VERBOSE
     msg_Dbg( p_stream, "read box: \"co64\" entry-count %d",
                       p_box->data.p_co64->i_entry_count );
@@ -3201,33 +3251,24 @@ static int MP4_ReadBox_stco_co64( stream_t *p_stream, MP4_Box_t *p_box )
 
 static void MP4_FreeBox_stss( MP4_Box_t *p_box )
 {
-    FREENULL( p_box->data.p_stss->i_sample_number );
+    mp4_table_clean( &p_box->data.p_stss->entries );
 }
 
 static int MP4_ReadBox_stss( stream_t *p_stream, MP4_Box_t *p_box )
 {
-    uint32_t count;
-
-    MP4_READBOX_ENTER( MP4_Box_data_stss_t, MP4_FreeBox_stss );
+    MP4_READBOX_ENTER_PARTIAL( MP4_Box_data_stss_t,
+                               mp4_box_headersize( p_box ) + 8,
+                               MP4_FreeBox_stss );
+    if( i_read < 8 )
+        MP4_READBOX_EXIT( 0 );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stss );
-    MP4_GET4BYTES( count );
+    MP4_GET4BYTES( p_box->data.p_stss->i_entry_count );
 
-    if( UINT64_C(4) * count > i_read )
+    if( !mp4_table_read( p_stream, p_box, &p_box->data.p_stss->entries,
+                         p_box->data.p_stss->i_entry_count, 4 ) )
         MP4_READBOX_EXIT( 0 );
 
-    p_box->data.p_stss->i_sample_number = vlc_alloc( count, sizeof(uint32_t) );
-    if( unlikely( p_box->data.p_stss->i_sample_number == NULL ) )
-        MP4_READBOX_EXIT( 0 );
-    p_box->data.p_stss->i_entry_count = count;
-
-    for( uint32_t i = 0; i < count; i++ )
-    {
-        MP4_GET4BYTES( p_box->data.p_stss->i_sample_number[i] );
-        /* XXX in libmp4 sample begin at 0 */
-        p_box->data.p_stss->i_sample_number[i]--;
-    }
-
 #ifdef MP4_VERBOSE
     msg_Dbg( p_stream, "read box: \"stss\" entry-count %d",
                       p_box->data.p_stss->i_entry_count );
@@ -612,14 +612,29 @@ typedef struct MP4_Box_data_lcont_s
 /* XXX it's also a container with i_entry_count entry */
 } MP4_Box_data_lcont_t;
 
+/* Entries of a sample table, as stored in the file (big endian). Tables
+ * of fast seekable files larger than a window are not loaded, but read
+ * from the stream on demand, a window at a time. */
+typedef struct
+{
+    stream_t *p_stream; /* to read entries from, NULL if all are loaded */
+    uint64_t  i_pos;    /* of the first entry in the stream */
+    uint32_t  i_count;
+    uint32_t  i_size;   /* of an entry, in bytes */
+
+    uint32_t  i_first;  /* first entry of the window */
+    uint32_t  i_loaded; /* entries in the window */
+    uint8_t  *p_window;
+
+} MP4_Box_table_t;
+
 typedef struct MP4_Box_data_stts_s
 {
     uint8_t  i_version;
     uint32_t i_flags;
 
     uint32_t i_entry_count;
-    uint32_t *pi_sample_count; /* these are array */
-    int32_t  *pi_sample_delta;
+    MP4_Box_table_t entries; /* sample count, sample delta */
 
 } MP4_Box_data_stts_t;
 
@@ -629,9 +644,7 @@ typedef struct MP4_Box_data_ctts_s
     uint32_t i_flags;
 
     uint32_t i_entry_count;
-
-    uint32_t *pi_sample_count; /* these are array */
-    int32_t *pi_sample_offset;
+    MP4_Box_table_t entries; /* sample count, sample offset */
 
 } MP4_Box_data_ctts_t;
 
@@ -871,7 +884,7 @@ typedef struct MP4_Box_data_stsz_s
     uint32_t i_sample_size;
     uint32_t i_sample_count;
 
-    uint32_t *i_entry_size; /* array , empty if i_sample_size != 0 */
+    MP4_Box_table_t entries; /* sample sizes, empty if i_sample_size != 0 */
 
 } MP4_Box_data_stsz_t;
 
@@ -908,8 +921,7 @@ typedef struct MP4_Box_data_co64_s
     uint32_t i_flags;
 
     uint32_t i_entry_count;
-
-    uint64_t *i_chunk_offset;
+    MP4_Box_table_t entries; /* chunk offsets, on 32 bits for stco */
 
 } MP4_Box_data_co64_t;
 
@@ -920,8 +932,7 @@ typedef struct MP4_Box_data_stss_s
     uint32_t i_flags;
 
     uint32_t i_entry_count;
-
-    uint32_t *i_sample_number;
+    MP4_Box_table_t entries; /* sample numbers, starting at 1 */
 
 } MP4_Box_data_stss_t;
 
@@ -1889,6 +1900,21 @@ static const UUID_t PS3DDSBoxUUID = {
  ****************************************************************************/
 int MP4_Seek( stream_t *p_stream, uint64_t i_pos );
 
+/*****************************************************************************
+ * MP4_TableEntry : get an entry of a sample table
+ *****************************************************************************
+ *  Reads the window of the entry from the stream if needed, the stream
+ *  position is kept. Returns NULL on read error.
+ *****************************************************************************/
+const uint8_t *MP4_TableEntry( MP4_Box_table_t *p_table, uint32_t i_entry );
+
+static inline uint32_t MP4_TableGet32( MP4_Box_table_t *p_table,
+                                       uint32_t i_entry, unsigned i_field )
+{
+    const uint8_t *p_entry = MP4_TableEntry( p_table, i_entry );
+    return likely(p_entry != NULL) ? GetDWBE( &p_entry[4 * i_field] ) : 0;
+}
+
 /*****************************************************************************
  * MP4_BoxGetNextChunk : Parse the entire moof box.
  *****************************************************************************
@@ -34,7 +34,10 @@
 #include <vlc_aout.h>
 #include <vlc_plugin.h>
 #include <vlc_dialog.h>
+#include <vlc_atomic.h>
+#include <vlc_interrupt.h>
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
 #include "../codec/cc.h"
 #include "../av1_unpack.h"
@@ -70,6 +73,32 @@ static int   DemuxRef( demux_t *p_demux ){ (void)p_demux; return 0;}
 static int   DemuxFrag( demux_t * );
 static int   Control ( demux_t *, int, va_list );
 
+typedef struct
+{
+    unsigned i_track_ID;
+    uint32_t i_timescale;
+    uint32_t i_default_duration; /* from the trex, as moov is not shared */
+    stime_t  i_time;     /* end of the last indexed fragment (track timescale) */
+} mp4_fragindex_track_t;
+
+/* Builds p_fragsindex in background, reading the fragments with its own
+ * stream while the demuxer plays */
+typedef struct
+{
+    vlc_thread_t thread;
+    stream_t     *s;
+    atomic_bool  b_stop;
+    mp4_fragindex_track_t *p_tracks;
+
+    vlc_mutex_t  lock;   /* protects p_fragsindex and the following */
+    vlc_cond_t   wait;   /* signaled when the demuxer wait is over */
+    uint64_t     i_pos;  /* end of the last indexed fragment */
+    bool         b_done;
+    bool         b_interrupted; /* the demuxer wait was interrupted */
+    stime_t      i_wait_time; /* what the demuxer waits for, if any */
+    uint64_t     i_wait_pos;
+} mp4_fragindexer_t;
+
 struct demux_sys_t
 {
     MP4_Box_t    *p_root;      /* container for the whole file */
@@ -90,6 +119,7 @@ struct demux_sys_t
     bool         b_seekable;
     bool         b_fastseekable;
     bool         b_error;        /* unrecoverable */
+    bool         b_readahead;    /* announce upcoming chunks to the access */
 
     bool            b_index_probed;     /* mFra sync points index */
     bool            b_fragments_probed; /* moof segments index created */
@@ -122,10 +152,12 @@ struct demux_sys_t
     } hacks;
 
     mp4_fragments_index_t *p_fragsindex;
+    mp4_fragindexer_t     *p_indexer; /* running background indexer, or NULL */
 };
 
 #define DEMUX_INCREMENT (CLOCK_FREQ / 4) /* How far the pcr will go, each round */
 #define DEMUX_TRACK_MAX_PRELOAD (CLOCK_FREQ * 15) /* maximum preloading, to deal with interleaving */
+#define DEMUX_TRACK_READAHEAD (CLOCK_FREQ * 2) /* chunks announced ahead of each track */
 
 #define VLC_DEMUXER_EOS (VLC_DEMUXER_EGENERIC - 1)
 #define VLC_DEMUXER_FATAL (VLC_DEMUXER_EGENERIC - 2)
@@ -166,10 +198,16 @@ static void MP4_GetDefaultSizeAndDuration( MP4_Box_t *p_moov,
 
 static stime_t GetMoovTrackDuration( demux_sys_t *p_sys, unsigned i_track_ID );
 
-static int  ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented );
+static int  ProbeFragments( demux_t *p_demux, bool b_index, bool *pb_fragmented );
 static int  ProbeFragmentsChecked( demux_t *p_demux );
 static int  ProbeIndex( demux_t *p_demux );
 
+static void FragIndexerStart( demux_t * );
+static void FragIndexerStop( demux_sys_t * );
+static void FragIndexerPoll( demux_t * );
+static int  FragIndexLock( demux_sys_t *, stime_t, uint64_t );
+static void FragIndexUnlock( demux_sys_t * );
+
 static int FragCreateTrunIndex( demux_t *, MP4_Box_t *, MP4_Box_t *, stime_t, bool );
 
 static int FragGetMoofBySidxIndex( demux_t *p_demux, vlc_tick_t i_target_time,
@@ -295,94 +333,134 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
     return p_es;
 }
 
-static int MP4_ChunkAllocDtsEntries( mp4_chunk_t *ck )
-{
-    size_t entries = ck->i_entries_dts;
-
-    if( entries <= ARRAY_SIZE(ck->small_dts_buf) / 2 )
-    {
-        ck->p_sample_count_dts = ck->small_dts_buf;
-        ck->p_sample_delta_dts = ck->small_dts_buf + entries;
-        return 0;
-    }
-
-    uint32_t *buf = calloc( entries, sizeof( buf[0] ) * 2 );
-    if( unlikely(buf == NULL) )
-        return VLC_ENOMEM;
-
-    ck->p_sample_count_dts = buf;
-    ck->p_sample_delta_dts = buf + entries;
-    return 0;
-}
-
-static int MP4_ChunkAllocPtsEntries( mp4_chunk_t *ck )
-{
-    size_t entries = ck->i_entries_pts;
-
-    if( entries <= ARRAY_SIZE(ck->small_pts_buf) / 2 )
-    {
-        ck->p_sample_count_pts = ck->small_pts_buf;
-        ck->p_sample_offset_pts = ck->small_pts_buf + entries;
-        return 0;
-    }
-
-    uint32_t *buf = calloc( entries, sizeof( buf[0] ) * 2 );
-    if( unlikely(buf == NULL) )
-        return VLC_ENOMEM;
-
-    ck->p_sample_count_pts = buf;
-    ck->p_sample_offset_pts = buf + entries;
-    return 0;
-}
-
-static void MP4_ChunkDestroy( mp4_chunk_t *ck )
-{
-    if( ck->p_sample_count_dts != ck->small_dts_buf )
-        free( ck->p_sample_count_dts );
-    if( ck->p_sample_count_pts != ck->small_pts_buf )
-        free( ck->p_sample_count_pts );
-}
-
-static stime_t MP4_ChunkGetSampleDTS( const mp4_chunk_t *p_chunk,
+static stime_t MP4_ChunkGetSampleDTS( const mp4_track_t *p_track,
+                                      const mp4_chunk_t *p_chunk,
                                       uint32_t i_sample )
 {
-    uint32_t i_index = 0;
+    MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_index = p_chunk->i_dts_entry;
+    uint32_t i_skip = p_chunk->i_dts_skip;
     stime_t sdts = p_chunk->i_first_dts;
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    while( i_sample > 0 && i_index < stts->i_entry_count )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        uint32_t i_count = MP4_TableGet32( &stts->entries, i_index, 0 ) - i_skip;
+        uint32_t i_delta = MP4_TableGet32( &stts->entries, i_index, 1 );
+        if( i_sample > i_count )
         {
-            sdts += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index++];
+            sdts += (stime_t) i_count * i_delta;
+            i_sample -= i_count;
+            i_skip = 0;
+            i_index++;
         }
         else
         {
-            sdts += i_sample * p_chunk->p_sample_delta_dts[i_index];
+            sdts += (stime_t) i_sample * i_delta;
             break;
         }
     }
     return sdts;
 }
 
-static bool MP4_ChunkGetSampleCTSDelta( const mp4_chunk_t *p_chunk,
+static bool MP4_ChunkGetSampleCTSDelta( const mp4_track_t *p_track,
+                                        const mp4_chunk_t *p_chunk,
                                         uint32_t i_sample, stime_t *pi_delta )
 {
-    if( p_chunk->p_sample_count_pts && p_chunk->p_sample_offset_pts )
+    MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+    if( ctts == NULL )
+        return false;
+
+    i_sample += p_chunk->i_pts_skip;
+    for( uint32_t i_index = p_chunk->i_pts_entry;
+         i_index < ctts->i_entry_count; i_index++ )
     {
-        for( uint32_t i_index = 0; i_index < p_chunk->i_entries_pts ; i_index++ )
+        uint32_t i_count = MP4_TableGet32( &ctts->entries, i_index, 0 );
+        if( i_sample < i_count )
         {
-            if( i_sample < p_chunk->p_sample_count_pts[i_index] )
-            {
-                *pi_delta = p_chunk->p_sample_offset_pts[i_index];
-                return true;
-            }
-            i_sample -= p_chunk->p_sample_count_pts[i_index];
+            int64_t i_ctsdelta = (int32_t) MP4_TableGet32( &ctts->entries, i_index, 1 )
+                               + p_track->i_cts_shift;
+            *pi_delta = i_ctsdelta < 0 ? 0 : i_ctsdelta; /* should not be < 0 */
+            return true;
         }
+        i_sample -= i_count;
     }
     return false;
 }
 
+/* Moves a position in a stts or ctts table i_sample_count samples forward,
+ * adding up the durations if pi_duration is not NULL.
+ * Returns false if the table ends first. */
+static bool xTTS_Advance( uint32_t *pi_index, uint32_t *pi_skip,
+                          uint32_t i_sample_count,
+                          MP4_Box_table_t *p_table, uint32_t i_table_count,
+                          stime_t *pi_duration )
+{
+    while( i_sample_count > 0 )
+    {
+        if( *pi_index >= i_table_count )
+            return false;
+
+        uint32_t i_left = MP4_TableGet32( p_table, *pi_index, 0 ) - *pi_skip;
+        uint32_t i_delta = pi_duration ? MP4_TableGet32( p_table, *pi_index, 1 ) : 0;
+        if( i_left > i_sample_count )
+        {
+            if( pi_duration )
+                *pi_duration += (stime_t) i_sample_count * i_delta;
+            *pi_skip += i_sample_count;
+            break;
+        }
+
+        if( pi_duration )
+            *pi_duration += (stime_t) i_left * i_delta;
+        i_sample_count -= i_left;
+        *pi_skip = 0;
+        *pi_index += 1;
+    }
+
+    return true;
+}
+
+/* Computes the times of the chunks up to i_chunk included, going on with
+ * the walk of the stts and ctts tables from the last chunk done */
+static void MP4_TrackTimeChunks( demux_t *p_demux, mp4_track_t *p_track,
+                                 uint32_t i_chunk )
+{
+    MP4_Box_data_stts_t *stts = p_track->p_stts;
+    MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+
+    for( ; p_track->i_timed_chunk <= i_chunk &&
+           p_track->i_timed_chunk < p_track->i_chunk_count;
+           p_track->i_timed_chunk++ )
+    {
+        mp4_chunk_t *ck = &p_track->chunk[p_track->i_timed_chunk];
+        stime_t i_duration = 0;
+
+        ck->i_first_dts = p_track->i_next_dts;
+        ck->i_dts_entry = p_track->i_dts_entry;
+        ck->i_dts_skip = p_track->i_dts_skip;
+        ck->i_pts_entry = p_track->i_pts_entry;
+        ck->i_pts_skip = p_track->i_pts_skip;
+
+        if( stts != NULL &&
+            !xTTS_Advance( &p_track->i_dts_entry, &p_track->i_dts_skip,
+                           ck->i_sample_count, &stts->entries,
+                           stts->i_entry_count, &i_duration ) &&
+            ck->i_dts_entry < stts->i_entry_count )
+            msg_Err( p_demux, "invalid index counting total samples: "
+                     "stts table is too small" );
+
+        if( ctts != NULL &&
+            !xTTS_Advance( &p_track->i_pts_entry, &p_track->i_pts_skip,
+                           ck->i_sample_count, &ctts->entries,
+                           ctts->i_entry_count, NULL ) &&
+            ck->i_pts_entry < ctts->i_entry_count )
+            msg_Err( p_demux, "invalid index counting total samples: "
+                     "ctts table is too small" );
+
+        ck->i_duration = i_duration;
+        p_track->i_next_dts += i_duration;
+    }
+}
+
 static void MP4_TrackTimeApplyELST( const mp4_track_t *p_track, uint64_t i_movie_timescale,
                                     stime_t *pi_dts )
 {
@@ -409,9 +487,10 @@ static void MP4_TrackTimeApplyELST( const mp4_track_t *p_track, uint64_t i_movie
 static inline mtime_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
+    MP4_TrackTimeChunks( p_demux, p_track, p_track->i_chunk );
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
 
-    stime_t sdts = MP4_ChunkGetSampleDTS( p_chunk,
+    stime_t sdts = MP4_ChunkGetSampleDTS( p_track, p_chunk,
                                           p_track->i_sample - p_chunk->i_sample_first );
 
     /* now handle elst */
@@ -420,13 +499,13 @@ static inline mtime_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
     return MP4_rescale( sdts, p_track->i_timescale, CLOCK_FREQ );
 }
 
-static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, const mp4_track_t *p_track,
+static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
                                          mtime_t *pi_delta )
 {
-    VLC_UNUSED( p_demux );
+    MP4_TrackTimeChunks( p_demux, p_track, p_track->i_chunk );
     const mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
     stime_t delta;
-    if( !MP4_ChunkGetSampleCTSDelta( ck, p_track->i_sample - ck->i_sample_first, &delta ) )
+    if( !MP4_ChunkGetSampleCTSDelta( p_track, ck, p_track->i_sample - ck->i_sample_first, &delta ) )
         return false;
     *pi_delta = MP4_rescale( delta, p_track->i_timescale, CLOCK_FREQ );
     return true;
@@ -559,6 +638,8 @@ static void MP4_GetInterleaving( demux_t *p_demux, uint64_t *pi_max_contiguous,
         if( !cur->i_chunk_count )
             continue;
 
+        MP4_TrackTimeChunks( p_demux, cur, cur->i_chunk_count - 1 );
+
         if( tk == NULL || cur->chunk[0].i_offset < tk->chunk[0].i_offset )
             tk = cur;
     }
@@ -608,6 +689,87 @@ static void MP4_GetInterleaving( demux_t *p_demux, uint64_t *pi_max_contiguous,
         p_sys->track[i].i_chunk = 0;
 }
 
+static uint64_t MP4_ChunkGetSize( const mp4_track_t *p_track,
+                                  const mp4_chunk_t *p_chunk )
+{
+    if( p_track->i_sample_size )
+        return (uint64_t) p_chunk->i_sample_count * p_track->i_sample_size;
+
+    uint64_t i_size = 0;
+    for( uint32_t i = p_chunk->i_sample_first;
+         i < p_chunk->i_sample_first + p_chunk->i_sample_count &&
+         i < p_track->i_sample_count; i++ )
+        i_size += MP4_TableGet32( p_track->p_sample_size, i, 0 );
+    return i_size;
+}
+
+/* Announces the chunks of the next seconds of the track to the access */
+static void MP4_TrackReadAhead( demux_t *p_demux, mp4_track_t *p_track )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_track->i_chunk >= p_track->i_chunk_count )
+        return;
+    if( p_track->i_readahead_chunk < p_track->i_chunk )
+        p_track->i_readahead_chunk = p_track->i_chunk;
+
+    MP4_TrackTimeChunks( p_demux, p_track, p_track->i_chunk );
+    const stime_t i_limit = p_track->chunk[p_track->i_chunk].i_first_dts +
+            MP4_rescale( DEMUX_TRACK_READAHEAD, CLOCK_FREQ, p_track->i_timescale );
+
+    for( ; p_track->i_readahead_chunk < p_track->i_chunk_count;
+           p_track->i_readahead_chunk++ )
+    {
+        MP4_TrackTimeChunks( p_demux, p_track, p_track->i_readahead_chunk );
+        const mp4_chunk_t *ck = &p_track->chunk[p_track->i_readahead_chunk];
+        if( (stime_t) ck->i_first_dts > i_limit )
+            break;
+
+        uint64_t i_size = MP4_ChunkGetSize( p_track, ck );
+        if( i_size > 0 &&
+            vlc_stream_Control( p_demux->s, STREAM_SET_READAHEAD,
+                                ck->i_offset, i_size ) != VLC_SUCCESS )
+        {
+            p_sys->b_readahead = false; /* not supported */
+            break;
+        }
+    }
+}
+
+/* Checks if the chunks of the tracks are far apart, without changing the
+ * interleaving runs used by the non fast seekable demux path. Only the
+ * start of the file is checked: muxers keep the same layout all along, and
+ * the whole sample tables would be read at opening otherwise. */
+#define MP4_INTERLEAVING_CHUNKS 1024
+static bool MP4_IsBadlyInterleaved( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_bad = false;
+
+    for( unsigned i=0; i < p_sys->i_tracks && !b_bad; i++ )
+    {
+        mp4_track_t *tk = &p_sys->track[i];
+        uint64_t i_duration = 0;
+        uint64_t i_end = 0;
+
+        for( uint32_t j = 0; j < tk->i_chunk_count &&
+                             j < MP4_INTERLEAVING_CHUNKS && !b_bad; j++ )
+        {
+            MP4_TrackTimeChunks( p_demux, tk, j );
+            const mp4_chunk_t *ck = &tk->chunk[j];
+
+            /* Runs of chunks of this track longer than the max preload */
+            if( j > 0 && ck->i_offset != i_end )
+                i_duration = 0;
+            i_duration += ck->i_duration;
+            b_bad = MP4_rescale( i_duration, tk->i_timescale, CLOCK_FREQ )
+                    > DEMUX_TRACK_MAX_PRELOAD;
+            i_end = ck->i_offset + MP4_ChunkGetSize( tk, ck );
+        }
+    }
+    return b_bad;
+}
+
 static block_t * MP4_Block_Convert( demux_t *p_demux, const mp4_track_t *p_track, block_t *p_block )
 {
     /* might have some encap */
@@ -1035,13 +1197,22 @@ static int Open( vlc_object_t * p_this )
 
         if ( p_sys->b_seekable )
         {
+            const bool b_background = p_sys->b_fastseekable && !p_sidx &&
+                                      p_demux->s->psz_url != NULL;
             if( !p_sys->b_fragmented /* as unknown */ )
             {
                 /* Probe remaining to check if there's really fragments
-                   or if that file is just ready to append fragments */
-                ProbeFragments( p_demux, (p_sys->i_duration == 0), &p_sys->b_fragmented );
+                   or if that file is just ready to append fragments.
+                   If the index can be built in background, only look
+                   for the first fragment */
+                ProbeFragments( p_demux, !b_background &&
+                                ( p_sys->b_fastseekable || p_sys->i_duration == 0 ),
+                                &p_sys->b_fragmented );
             }
 
+            if( b_background && p_sys->b_fragmented )
+                FragIndexerStart( p_demux );
+
             if( vlc_stream_Seek( p_demux->s, p_sys->p_moov->i_pos ) != VLC_SUCCESS )
                 goto error;
         }
@@ -1075,6 +1246,15 @@ static int Open( vlc_object_t * p_this )
         else if( i_max_continuity > DEMUX_TRACK_MAX_PRELOAD )
             msg_Warn( p_demux, "that media doesn't look properly interleaved, will need to seek");
     }
+    else if( p_sys->i_tracks > 1 && p_demux->pf_demux == Demux )
+    {
+        /* Local files: the tracks are read in time order. If they are far
+         * apart, the kernel read-ahead would not follow, so tell the access
+         * what comes next. */
+        p_sys->b_readahead = MP4_IsBadlyInterleaved( p_demux );
+        if( p_sys->b_readahead )
+            msg_Dbg( p_demux, "media is not interleaved, enabling read-ahead hints" );
+    }
 
     /* */
     LoadChapter( p_demux );
@@ -1271,6 +1451,9 @@ static int DemuxTrack( demux_t *p_demux, mp4_track_t *tk, uint64_t i_readpos,
     if( tk->b_chapters_source )
         return VLC_DEMUXER_SUCCESS;
 
+    if( p_demux->p_sys->b_readahead )
+        MP4_TrackReadAhead( p_demux, tk );
+
     uint32_t i_run_seq = MP4_TrackGetRunSeq( tk );
     vlc_tick_t i_current_nzdts = MP4_TrackGetDTS( p_demux, tk );
     const vlc_tick_t i_demux_max_nzdts =(i_max_preload < UINT_MAX)
@@ -1726,8 +1909,9 @@ static int FragSeekToTime( demux_t *p_demux, vlc_tick_t i_nztime, bool b_accurat
     stime_t  i_segment_time = INT64_MAX;
     vlc_tick_t i_sync_time = i_nztime;
 
+    /* While indexing, the duration is only known up to the indexed part */
     const uint64_t i_duration = __MAX(p_sys->i_duration, p_sys->i_cumulated_duration);
-    if ( !p_sys->i_timescale || !i_duration || !p_sys->b_seekable )
+    if ( !p_sys->i_timescale || (!i_duration && !p_sys->p_indexer) || !p_sys->b_seekable )
          return VLC_EGENERIC;
 
     uint64_t i_backup_pos = vlc_stream_Tell( p_demux->s );
@@ -1770,7 +1954,14 @@ static int FragSeekToTime( demux_t *p_demux, vlc_tick_t i_nztime, bool b_accurat
         if( p_sys->b_fragments_probed && p_sys->p_fragsindex )
         {
             stime_t i_basetime = MP4_rescale( i_sync_time, CLOCK_FREQ, p_sys->i_timescale );
-            if( !MP4_Fragments_Index_Lookup( p_sys->p_fragsindex, &i_basetime, &i64, i_seek_track_index ) )
+            bool b_found = false;
+            if( FragIndexLock( p_sys, i_basetime, 0 ) == VLC_SUCCESS )
+            {
+                b_found = MP4_Fragments_Index_Lookup( p_sys->p_fragsindex, &i_basetime,
+                                                      &i64, i_seek_track_index );
+                FragIndexUnlock( p_sys );
+            }
+            if( !b_found )
             {
                 p_sys->b_error = (vlc_stream_Seek( p_demux->s, i_backup_pos ) != VLC_SUCCESS);
                 return VLC_EGENERIC;
@@ -1834,8 +2025,30 @@ static int FragSeekToPos( demux_t *p_demux, double f, bool b_accurate )
     if ( !p_sys->b_seekable || !p_sys->i_timescale )
         return VLC_EGENERIC;
 
+    FragIndexerPoll( p_demux );
     uint64_t i_duration = __MAX(p_sys->i_duration, p_sys->i_cumulated_duration);
-    if( !i_duration && !p_sys->b_fragments_probed )
+    uint64_t i_size;
+    if( p_sys->p_indexer && !p_sys->i_duration &&
+        !MP4_BoxGet( p_sys->p_moov, "mvex/mehd" ) &&
+        vlc_stream_GetSize( p_demux->s, &i_size ) == VLC_SUCCESS )
+    {
+        /* The duration is only known up to the indexed part until the end
+         * is indexed: rather than waiting for the whole file, seek by byte
+         * offset to the fragment at that position, once it is indexed */
+        uint64_t i_pos = f * i_size;
+        stime_t i_time = 0;
+        if( FragIndexLock( p_sys, -1, i_pos ) != VLC_SUCCESS )
+            return VLC_EGENERIC;
+        if( !MP4_Fragments_Index_LookupPos( p_sys->p_fragsindex, &i_pos, &i_time,
+                                            GetSeekTrackIndex( p_sys ) ) )
+            i_time = 0; /* before the first fragment */
+        FragIndexUnlock( p_sys );
+
+        msg_Dbg( p_demux, "seeking to fragment at byte offset %"PRIu64, i_pos );
+        return FragSeekToTime( p_demux, MP4_rescale( i_time, p_sys->i_timescale,
+                                                     CLOCK_FREQ ), b_accurate );
+    }
+    else if( !i_duration && !p_sys->b_fragments_probed )
     {
         int i_ret = ProbeFragmentsChecked( p_demux );
         if( i_ret != VLC_SUCCESS )
@@ -1924,6 +2137,8 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     int64_t i64, *pi64;
     bool b;
 
+    FragIndexerPoll( p_demux );
+
     const uint64_t i_duration = __MAX(p_sys->i_duration, p_sys->i_cumulated_duration);
 
     switch( i_query )
@@ -2182,6 +2397,9 @@ static void Close ( vlc_object_t * p_this )
 
     msg_Dbg( p_demux, "freeing all memory" );
 
+    if( p_sys->p_indexer )
+        FragIndexerStop( p_sys );
+
     FragResetContext( p_sys );
 
     MP4_BoxFree( p_sys->p_root );
@@ -2381,19 +2599,16 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     }
 
     /* first we read chunk offset */
+    MP4_Box_table_t *p_offsets = &BOXDATA(p_co64)->entries;
     for( i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
     {
         mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
+        const uint8_t *p_entry = MP4_TableEntry( p_offsets, i_chunk );
+        if( p_entry == NULL )
+            return VLC_EGENERIC;
 
-        ck->i_offset = BOXDATA(p_co64)->i_chunk_offset[i_chunk];
-
-        ck->i_first_dts = 0;
-        ck->i_entries_dts = 0;
-        ck->p_sample_count_dts = NULL;
-        ck->p_sample_delta_dts = NULL;
-        ck->i_entries_pts = 0;
-        ck->p_sample_count_pts = NULL;
-        ck->p_sample_offset_pts = NULL;
+        ck->i_offset = p_offsets->i_size == 8 ? GetQWBE( p_entry )
+                                              : GetDWBE( p_entry );
     }
 
     /* now we read index for SampleEntry( soun vide mp4a mp4v ...)
@@ -2455,54 +2670,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
-{
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
-    {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_ENOVAR;
-        }
-
-        if ( i_index_samples_left )
-        {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
-    }
-
-    return VLC_SUCCESS;
-}
-
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2542,16 +2709,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     {
         /* 2: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = &stsz->entries;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2564,121 +2722,22 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         }
     }
 
-    /* Use stts table to create a sample number -> dts table.
-     * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+    /* The stts and ctts tables are not expanded, nor walked here: each
+     * chunk records where its first sample is in them when it is first
+     * needed, and sample times are computed on demand from there. */
 
-    vlc_tick_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
-    else
-    {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
-
-        msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
-
-        /* Create sample -> dts table per chunk */
-        uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
-
-        for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
-        {
-            mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* save first dts */
-            ck->i_first_dts = i_next_dts;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            i_ret = MP4_ChunkAllocDtsEntries( ck );
-            if( i_ret )
-            {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return i_ret;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-            }
-        }
-    }
-
+    p_demux_track->p_stts = p_box->data.p_stts;
+    msg_Dbg( p_demux, "STTS table of %"PRIu32" entries",
+             p_demux_track->p_stts->i_entry_count );
 
     /* Find ctts
      *  Gives the delta between decoding time (dts) and composition table (pts)
@@ -2686,100 +2745,22 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
-
-        msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
-
-        int64_t i_cts_shift = 0;
         const MP4_Box_t *p_cslg = MP4_BoxGet( p_demux_track->p_stbl, "cslg" );
         if( p_cslg && BOXDATA(p_cslg) )
-            i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
-
-        /* Create pts-dts table per chunk */
-        uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
-
-        for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
-        {
-            mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
+            p_demux_track->i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
 
-            /* allocate them */
-            i_ret = MP4_ChunkAllocPtsEntries( ck );
-            if( i_ret )
-            {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return i_ret;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
-            {
-                int64_t i_ctsdelta = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                if( i_ctsdelta < 0 ) /* should not */
-                    i_ctsdelta = 0;
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
-            }
-        }
+        p_demux_track->p_ctts = p_box->data.p_ctts;
+        msg_Dbg( p_demux, "CTTS table of %"PRIu32" entries",
+                 p_demux_track->p_ctts->i_entry_count );
     }
 
-    msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples length:%"PRId64"s",
-             p_demux_track->i_track_ID, p_demux_track->i_sample_count,
-             i_next_dts / p_demux_track->i_timescale );
+    p_demux_track->i_timed_chunk = 0;
+    p_demux_track->i_dts_entry = p_demux_track->i_dts_skip = 0;
+    p_demux_track->i_pts_entry = p_demux_track->i_pts_skip = 0;
+    p_demux_track->i_next_dts = 0;
+
+    msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples",
+             p_demux_track->i_track_ID, p_demux_track->i_sample_count );
 
     return VLC_SUCCESS;
 }
@@ -2791,7 +2772,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
  */
 static void TrackGetESSampleRate( demux_t *p_demux,
                                   unsigned *pi_num, unsigned *pi_den,
-                                  const mp4_track_t *p_track,
+                                  mp4_track_t *p_track,
                                   unsigned i_sd_index,
                                   unsigned i_chunk )
 {
@@ -2814,6 +2795,7 @@ static void TrackGetESSampleRate( demux_t *p_demux,
         return;
 
     /* */
+    MP4_TrackTimeChunks( p_demux, p_track, p_track->i_chunk_count - 1 );
     const mp4_chunk_t *p_chunk = &p_track->chunk[i_chunk];
     while( p_chunk > &p_track->chunk[0] &&
            p_chunk[-1].i_sample_description_index == i_sd_index )
@@ -2958,20 +2940,26 @@ static int TrackGetNearestSeekPoint( demux_t *p_demux, mp4_track_t *p_track,
     const MP4_Box_t *p_stss;
     if( ( p_stss = MP4_BoxGet( p_track->p_stbl, "stss" ) ) )
     {
-        const MP4_Box_data_stss_t *p_stss_data = BOXDATA(p_stss);
+        MP4_Box_data_stss_t *p_stss_data = BOXDATA(p_stss);
         msg_Dbg( p_demux, "track[Id 0x%x] using Sync Sample Box (stss)",
                  p_track->i_track_ID );
-        for( unsigned i_index = 0; i_index < p_stss_data->i_entry_count; i_index++ )
+        /* last sync sample at or before i_sample, or the first one.
+           Sample numbers start at 1 in the table */
+        uint32_t i_low = 0, i_high = p_stss_data->i_entry_count;
+        while( i_high - i_low > 1 )
+        {
+            uint32_t i_mid = i_low + (i_high - i_low) / 2;
+            if( MP4_TableGet32( &p_stss_data->entries, i_mid, 0 ) - 1 <= i_sample )
+                i_low = i_mid;
+            else
+                i_high = i_mid;
+        }
+        if( p_stss_data->i_entry_count > 0 )
         {
-            if( i_index >= p_stss_data->i_entry_count - 1 ||
-                i_sample < p_stss_data->i_sample_number[i_index+1] )
-            {
-                *pi_sync_sample = p_stss_data->i_sample_number[i_index];
-                msg_Dbg( p_demux, "stss gives %d --> %" PRIu32 " (sample number)",
-                         i_sample, *pi_sync_sample );
-                i_ret = VLC_SUCCESS;
-                break;
-            }
+            *pi_sync_sample = MP4_TableGet32( &p_stss_data->entries, i_low, 0 ) - 1;
+            msg_Dbg( p_demux, "stss gives %d --> %" PRIu32 " (sample number)",
+                     i_sample, *pi_sync_sample );
+            i_ret = VLC_SUCCESS;
         }
     }
 
@@ -3029,7 +3017,6 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
     uint64_t     i_dts;
     unsigned int i_sample;
     unsigned int i_chunk;
-    int          i_index;
 
     /* FIXME see if it's needed to check p_track->i_chunk_count */
     if( p_track->i_chunk_count == 0 )
@@ -3073,50 +3060,53 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = MP4_rescale( i_start, CLOCK_FREQ, p_track->i_timescale );
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
-    {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
+    /* chunks are in decoding order: look for the last one starting at or
+       before i_start, the next sample search will check the end. Only the
+       chunks up to the first one starting after i_start need their times */
+    while( p_track->i_timed_chunk < p_track->i_chunk_count &&
+           ( p_track->i_timed_chunk == 0 ||
+             p_track->chunk[p_track->i_timed_chunk - 1].i_first_dts <= (uint64_t)i_start ) )
+        MP4_TrackTimeChunks( p_demux, p_track, p_track->i_timed_chunk );
+
+    unsigned int i_low = 0, i_high = p_track->i_timed_chunk - 1;
+    while( i_low < i_high )
+    {
+        unsigned int i_mid = i_low + (i_high - i_low + 1) / 2;
+        if( p_track->chunk[i_mid].i_first_dts <= (uint64_t)i_start )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
     }
+    i_chunk = i_low;
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-    for( i_index = 0;  i_index < p_track->chunk[i_chunk].i_entries_dts &&
-                       i_sample < p_track->chunk[i_chunk].i_sample_count; )
-    {
-        if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
-        {
-            i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
-
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_index = ck->i_dts_entry;
+    uint32_t i_skip = ck->i_dts_skip;
+    uint32_t i_left = ck->i_sample_count;
+
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
+    while( i_left > 0 && i_index < stts->i_entry_count )
+    {
+        uint32_t i_count = __MIN( MP4_TableGet32( &stts->entries, i_index, 0 ) - i_skip,
+                                  i_left );
+        uint32_t i_delta = MP4_TableGet32( &stts->entries, i_index, 1 );
+
+        if( i_dts + (uint64_t) i_count * i_delta < (uint64_t)i_start )
+        {
+            i_dts    += (uint64_t) i_count * i_delta;
+            i_sample += i_count;
+            i_left   -= i_count;
+            i_skip    = 0;
             i_index++;
         }
         else
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
-            {
-                break;
-            }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+            if( i_delta > 0 )
+                i_sample += ( i_start - i_dts ) / i_delta;
             break;
         }
     }
@@ -3198,6 +3188,7 @@ static int TrackGotoChunkSample( demux_t *p_demux, mp4_track_t *p_track,
     p_track->i_chunk    = i_chunk;
     p_track->chunk[i_chunk].i_sample = i_sample - p_track->chunk[i_chunk].i_sample_first;
     p_track->i_sample   = i_sample;
+    p_track->i_readahead_chunk = i_chunk;
 
     return p_track->b_selected ? VLC_SUCCESS : VLC_EGENERIC;
 }
@@ -3558,16 +3549,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            MP4_ChunkDestroy( &p_track->chunk[i_chunk] );
-    }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 
@@ -3691,7 +3674,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         *pi_nb_samples = 1;
 
         if( p_track->i_sample_size == 0 ) /* all sizes are different */
-            return p_track->p_sample_size[p_track->i_sample];
+            return MP4_TableGet32( p_track->p_sample_size, p_track->i_sample, 0 );
         else
             return p_track->i_sample_size;
     }
@@ -3724,7 +3707,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         if( p_track->i_sample_size == 0 )
         {
             *pi_nb_samples = 1;
-            return p_track->p_sample_size[p_track->i_sample];
+            return MP4_TableGet32( p_track->p_sample_size, p_track->i_sample, 0 );
         }
 
         if( p_soun->i_qt_version == 1 )
@@ -3735,7 +3718,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
                 if ( p_track->i_sample_size )
                     return p_track->i_sample_size;
                 else
-                    return p_track->p_sample_size[p_track->i_sample];
+                    return MP4_TableGet32( p_track->p_sample_size, p_track->i_sample, 0 );
             }
             else if ( p_soun->i_compressionid != 0 || p_soun->i_bytes_per_sample > 1 ) /* compressed */
             {
@@ -3818,7 +3801,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         {
             (*pi_nb_samples)++;
             if ( p_track->i_sample_size == 0 )
-                i_size += p_track->p_sample_size[i];
+                i_size += MP4_TableGet32( p_track->p_sample_size, i, 0 );
             else
                 i_size += MP4_GetFixedSampleSize( p_track, p_soun );
 
@@ -3889,7 +3872,7 @@ static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
         for( i_sample = p_track->chunk[p_track->i_chunk].i_sample_first;
              i_sample < p_track->i_sample; i_sample++ )
         {
-            i_pos += p_track->p_sample_size[i_sample];
+            i_pos += MP4_TableGet32( p_track->p_sample_size, i_sample, 0 );
         }
     }
 
@@ -4098,10 +4081,10 @@ static stime_t GetMoovTrackDuration( demux_sys_t *p_sys, unsigned i_track_ID )
     return 0;
 }
 
-static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
-                                  unsigned i_track_ID, stime_t *p_duration )
+static bool GetMoofTrackDuration( const mp4_fragindex_track_t *p_track,
+                                  MP4_Box_t *p_moof, stime_t *p_duration )
 {
-    if ( !p_moof || !p_moov )
+    if ( !p_moof || !p_track->i_timescale )
         return false;
 
     MP4_Box_t *p_traf = MP4_BoxGet( p_moof, "traf" );
@@ -4115,31 +4098,7 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
 
         const MP4_Box_t *p_tfhd = MP4_BoxGet( p_traf, "tfhd" );
         const MP4_Box_t *p_trun = MP4_BoxGet( p_traf, "trun" );
-        if ( !p_tfhd || !p_trun || i_track_ID != BOXDATA(p_tfhd)->i_track_ID )
-        {
-           p_traf = p_traf->p_next;
-           continue;
-        }
-
-        uint32_t i_track_timescale = 0;
-        uint32_t i_track_defaultsampleduration = 0;
-
-        /* set trex for defaults */
-        MP4_Box_t *p_trex = MP4_GetTrexByTrackID( p_moov, BOXDATA(p_tfhd)->i_track_ID );
-        if ( p_trex )
-        {
-            i_track_defaultsampleduration = BOXDATA(p_trex)->i_default_sample_duration;
-        }
-
-        MP4_Box_t *p_trak = MP4_GetTrakByTrackID( p_moov, BOXDATA(p_tfhd)->i_track_ID );
-        if ( p_trak )
-        {
-            MP4_Box_t *p_mdhd = MP4_BoxGet( p_trak, "mdia/mdhd" );
-            if ( p_mdhd )
-                i_track_timescale = BOXDATA(p_mdhd)->i_timescale;
-        }
-
-        if ( !i_track_timescale )
+        if ( !p_tfhd || !p_trun || p_track->i_track_ID != BOXDATA(p_tfhd)->i_track_ID )
         {
            p_traf = p_traf->p_next;
            continue;
@@ -4169,7 +4128,7 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
             else
             {
                 i_traf_duration += p_trundata->i_sample_count *
-                        i_track_defaultsampleduration;
+                        p_track->i_default_duration;
             }
 
             p_trun = p_trun->p_next;
@@ -4182,7 +4141,57 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
     return true;
 }
 
-static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
+static void FragIndexInitTracks( demux_sys_t *p_sys, mp4_fragindex_track_t *p_tracks )
+{
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        p_tracks[i].i_track_ID = p_sys->track[i].i_track_ID;
+        p_tracks[i].i_timescale = p_sys->track[i].i_timescale;
+        MP4_Box_t *p_trex = MP4_GetTrexByTrackID( p_sys->p_moov, p_tracks[i].i_track_ID );
+        p_tracks[i].i_default_duration = ( p_trex && BOXDATA(p_trex) ) ?
+                                         BOXDATA(p_trex)->i_default_sample_duration : 0;
+        /* Set first fragment time offset from moov */
+        p_tracks[i].i_time = MP4_rescale( GetMoovTrackDuration( p_sys, p_tracks[i].i_track_ID ),
+                                          p_sys->i_timescale, p_tracks[i].i_timescale );
+    }
+}
+
+/* Sets the start time of each track in a moof, from its tfdt or from the end
+ * of the previous moof, and returns the end time of the moof.
+ * Only reads the moof and the tracks state, so that it can run on the
+ * indexer thread. */
+static stime_t FragIndexMoof( uint32_t i_movie_timescale,
+                              MP4_Box_t *p_moof, unsigned i_tracks,
+                              mp4_fragindex_track_t *p_tracks, stime_t *p_times )
+{
+    stime_t i_end_time = 0;
+
+    for( unsigned i=0; i<i_tracks; i++ )
+    {
+        mp4_fragindex_track_t *p_track = &p_tracks[i];
+        stime_t i_duration = 0;
+        MP4_Box_t *p_tfdt = NULL;
+        MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_track->i_track_ID );
+        if( p_traf )
+            p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+
+        if( p_tfdt && BOXDATA(p_tfdt) )
+            p_track->i_time = p_tfdt->data.p_tfdt->i_base_media_decode_time;
+
+        p_times[i] = MP4_rescale( p_track->i_time, p_track->i_timescale, i_movie_timescale );
+
+        if( GetMoofTrackDuration( p_track, p_moof, &i_duration ) )
+            p_track->i_time += i_duration;
+
+        stime_t i_movietime = MP4_rescale( p_track->i_time, p_track->i_timescale, i_movie_timescale );
+        if( i_end_time < i_movietime )
+            i_end_time = i_movietime;
+    }
+
+    return i_end_time;
+}
+
+static int ProbeFragments( demux_t *p_demux, bool b_index, bool *pb_fragmented )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
@@ -4194,7 +4203,7 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
     if( !p_vroot )
         return VLC_EGENERIC;
 
-    if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) )
+    if( p_sys->b_seekable && b_index )
     {
         MP4_ReadBoxContainerChildren( p_demux->s, p_vroot, NULL ); /* Get the rest of the file */
         p_sys->b_fragments_probed = true;
@@ -4210,14 +4219,15 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
                 return VLC_EGENERIC;
             }
 
-            stime_t *pi_track_times = calloc( p_sys->i_tracks, sizeof(*pi_track_times) );
-            if( !pi_track_times )
+            mp4_fragindex_track_t *p_tracks = vlc_alloc( p_sys->i_tracks, sizeof(*p_tracks) );
+            if( !p_tracks )
             {
                 MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
                 p_sys->p_fragsindex = NULL;
                 MP4_BoxFree( p_vroot );
                 return VLC_EGENERIC;
             }
+            FragIndexInitTracks( p_sys, p_tracks );
 
             unsigned index = 0;
 
@@ -4226,46 +4236,14 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
                 if( p_moof->i_type != ATOM_moof )
                     continue;
 
-                for( unsigned i=0; i<p_sys->i_tracks; i++ )
-                {
-                    stime_t i_duration = 0;
-                    MP4_Box_t *p_tfdt = NULL;
-                    MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
-                    if( p_traf )
-                        p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
-
-                    /* Set first fragment time offset from moov */
-                    if( index == 0 )
-                        pi_track_times[i] = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
-
-                    if( p_tfdt && BOXDATA(p_tfdt) )
-                    {
-                        pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
-                    }
-                    else if( index == 0 ) /* Set first fragment time offset from moov */
-                    {
-                        i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
-                        pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
-                    }
-
-                    stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                    p_sys->p_fragsindex->p_times[index * p_sys->i_tracks + i] = i_movietime;
-
-                    if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
-                        pi_track_times[i] += i_duration;
-                }
-
+                p_sys->p_fragsindex->i_last_time =
+                    FragIndexMoof( p_sys->i_timescale, p_moof,
+                                   p_sys->i_tracks, p_tracks,
+                                   &p_sys->p_fragsindex->p_times[index * p_sys->i_tracks] );
                 p_sys->p_fragsindex->pi_pos[index++] = p_moof->i_pos;
             }
 
-            for( unsigned i=0; i<p_sys->i_tracks; i++ )
-            {
-                stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                if( p_sys->p_fragsindex->i_last_time < i_movietime )
-                    p_sys->p_fragsindex->i_last_time = i_movietime;
-            }
-
-            free( pi_track_times );
+            free( p_tracks );
 #ifdef MP4_VERBOSE
             MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
 #endif
@@ -4294,6 +4272,203 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
     return VLC_SUCCESS;
 }
 
+static void *FragIndexerThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    mp4_fragindexer_t *p_indexer = p_sys->p_indexer;
+    const uint32_t stoplist[] = { ATOM_moof, 0 };
+
+    stime_t *p_times = vlc_alloc( p_sys->i_tracks, sizeof(*p_times) );
+
+    while( p_times && !atomic_load( &p_indexer->b_stop ) )
+    {
+        /* Only keep one fragment in memory at a time */
+        MP4_Box_t *p_vroot = MP4_BoxNew( ATOM_root );
+        if( !p_vroot )
+            break;
+        MP4_ReadBoxContainerChildren( p_indexer->s, p_vroot, stoplist );
+
+        MP4_Box_t *p_moof = p_vroot->p_last;
+        if( !p_moof || p_moof->i_type != ATOM_moof )
+        {
+            MP4_BoxFree( p_vroot );
+            break;
+        }
+
+        stime_t i_end_time = FragIndexMoof( p_sys->i_timescale, p_moof,
+                                            p_sys->i_tracks, p_indexer->p_tracks, p_times );
+
+        vlc_mutex_lock( &p_indexer->lock );
+        int i_ret = MP4_Fragments_Index_Append( p_sys->p_fragsindex, p_moof->i_pos,
+                                                p_times, i_end_time );
+        p_indexer->i_pos = p_moof->i_pos + p_moof->i_size;
+        if( p_sys->p_fragsindex->i_last_time > p_indexer->i_wait_time &&
+            p_indexer->i_pos >= p_indexer->i_wait_pos )
+            vlc_cond_signal( &p_indexer->wait );
+        vlc_mutex_unlock( &p_indexer->lock );
+
+        MP4_BoxFree( p_vroot );
+        if( i_ret != VLC_SUCCESS )
+            break;
+    }
+
+    free( p_times );
+
+    vlc_mutex_lock( &p_indexer->lock );
+    p_indexer->b_done = true;
+    vlc_cond_signal( &p_indexer->wait );
+    vlc_mutex_unlock( &p_indexer->lock );
+
+    return NULL;
+}
+
+static void FragIndexerStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    mp4_fragindexer_t *p_indexer = malloc( sizeof(*p_indexer) );
+    if( !p_indexer )
+        return;
+
+    p_indexer->p_tracks = vlc_alloc( p_sys->i_tracks, sizeof(*p_indexer->p_tracks) );
+    p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, 64 );
+    p_indexer->s = vlc_stream_NewURL( p_demux, p_demux->s->psz_url );
+    if( !p_indexer->p_tracks || !p_sys->p_fragsindex || !p_indexer->s ||
+        vlc_stream_Seek( p_indexer->s, p_sys->p_moov->i_pos + p_sys->p_moov->i_size ) )
+        goto error;
+
+    p_sys->p_fragsindex->i_entries = 0; /* appended by the indexer */
+    FragIndexInitTracks( p_sys, p_indexer->p_tracks );
+    atomic_init( &p_indexer->b_stop, false );
+    vlc_mutex_init( &p_indexer->lock );
+    vlc_cond_init( &p_indexer->wait );
+    p_indexer->i_pos = 0;
+    p_indexer->b_done = false;
+    p_indexer->b_interrupted = false;
+    p_indexer->i_wait_time = INT64_MAX;
+    p_indexer->i_wait_pos = 0;
+
+    p_sys->p_indexer = p_indexer;
+    if( vlc_clone( &p_indexer->thread, FragIndexerThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        p_sys->p_indexer = NULL;
+        vlc_cond_destroy( &p_indexer->wait );
+        vlc_mutex_destroy( &p_indexer->lock );
+        goto error;
+    }
+
+    p_sys->b_fragments_probed = true;
+    msg_Dbg( p_demux, "indexing fragments in background" );
+    return;
+
+error:
+    if( p_indexer->s )
+        vlc_stream_Delete( p_indexer->s );
+    MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+    p_sys->p_fragsindex = NULL;
+    free( p_indexer->p_tracks );
+    free( p_indexer );
+}
+
+static void FragIndexerStop( demux_sys_t *p_sys )
+{
+    mp4_fragindexer_t *p_indexer = p_sys->p_indexer;
+
+    atomic_store( &p_indexer->b_stop, true );
+    vlc_join( p_indexer->thread, NULL );
+
+    vlc_stream_Delete( p_indexer->s );
+    vlc_cond_destroy( &p_indexer->wait );
+    vlc_mutex_destroy( &p_indexer->lock );
+    free( p_indexer->p_tracks );
+    free( p_indexer );
+    p_sys->p_indexer = NULL;
+}
+
+/* Updates the duration with the indexed fragments, and releases the
+ * indexer once it has completed the index */
+static void FragIndexerPoll( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    mp4_fragindexer_t *p_indexer = p_sys->p_indexer;
+
+    if( !p_indexer )
+        return;
+
+    const bool b_mehd = MP4_BoxGet( p_sys->p_moov, "mvex/mehd" ) != NULL;
+
+    vlc_mutex_lock( &p_indexer->lock );
+    bool b_done = p_indexer->b_done;
+    if( !b_done && !b_mehd &&
+        p_sys->i_cumulated_duration < (uint64_t)p_sys->p_fragsindex->i_last_time )
+        p_sys->i_cumulated_duration = p_sys->p_fragsindex->i_last_time;
+    vlc_mutex_unlock( &p_indexer->lock );
+    if( !b_done )
+        return;
+
+    FragIndexerStop( p_sys );
+    msg_Dbg( p_demux, "fragments index complete, %u entries",
+             p_sys->p_fragsindex->i_entries );
+#ifdef MP4_VERBOSE
+    MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
+#endif
+
+    if( !b_mehd )
+        p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
+}
+
+static void FragIndexInterrupt( void *data )
+{
+    mp4_fragindexer_t *p_indexer = data;
+
+    vlc_mutex_lock( &p_indexer->lock );
+    p_indexer->b_interrupted = true;
+    vlc_cond_signal( &p_indexer->wait );
+    vlc_mutex_unlock( &p_indexer->lock );
+}
+
+/* Locks p_fragsindex against the indexer, after waiting for it to index
+ * past the given movie time and stream position. Fails without the lock if
+ * the wait is interrupted (the input is stopping). */
+static int FragIndexLock( demux_sys_t *p_sys, stime_t i_time, uint64_t i_pos )
+{
+    mp4_fragindexer_t *p_indexer = p_sys->p_indexer;
+
+    if( !p_indexer )
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_indexer->lock );
+    p_indexer->b_interrupted = false;
+    vlc_mutex_unlock( &p_indexer->lock );
+
+    /* The interrupt callback takes the indexer lock: (un)register unlocked */
+    vlc_interrupt_register( FragIndexInterrupt, p_indexer );
+
+    vlc_mutex_lock( &p_indexer->lock );
+    p_indexer->i_wait_time = i_time;
+    p_indexer->i_wait_pos = i_pos;
+    while( !p_indexer->b_done && !p_indexer->b_interrupted &&
+           ( p_sys->p_fragsindex->i_last_time <= i_time || p_indexer->i_pos < i_pos ) )
+        vlc_cond_wait( &p_indexer->wait, &p_indexer->lock );
+    p_indexer->i_wait_time = INT64_MAX;
+    vlc_mutex_unlock( &p_indexer->lock );
+
+    if( vlc_interrupt_unregister() == EINTR )
+        return VLC_EGENERIC;
+
+    /* The index only grows: what was waited for is still there */
+    vlc_mutex_lock( &p_indexer->lock );
+    return VLC_SUCCESS;
+}
+
+static void FragIndexUnlock( demux_sys_t *p_sys )
+{
+    if( p_sys->p_indexer )
+        vlc_mutex_unlock( &p_sys->p_indexer->lock );
+}
+
 static int ProbeFragmentsChecked( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -4641,12 +4816,14 @@ static int FragCreateTrunIndex( demux_t *p_demux, MP4_Box_t *p_moof,
             }
 
             /* After seek we should have probed fragments */
-            if( !b_has_base_media_decode_time && p_sys->p_fragsindex )
+            if( !b_has_base_media_decode_time && p_sys->p_fragsindex &&
+                FragIndexLock( p_sys, -1, p_moof->i_pos + 1 ) == VLC_SUCCESS )
             {
                 unsigned i_track_index = (p_track - p_sys->track);
                 assert(&p_sys->track[i_track_index] == p_track);
                 i_traf_start_time = MP4_Fragment_Index_GetTrackStartTime( p_sys->p_fragsindex,
                                                                           i_track_index, p_moof->i_pos );
+                FragIndexUnlock( p_sys );
                 i_traf_start_time = MP4_rescale( i_traf_start_time,
                                                  p_sys->i_timescale, p_track->i_timescale );
                 b_has_base_media_decode_time = true;
@@ -47,15 +47,13 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-    uint32_t     small_dts_buf[4];
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    uint32_t     *p_sample_offset_pts;  /* pts-dts */
-    uint32_t     small_pts_buf[4];
+    /* position of the first sample of the chunk in the stts and ctts
+       tables of the track: entry, and samples of that entry before it.
+       Sample times are computed from there on demand. */
+    uint32_t     i_dts_entry;
+    uint32_t     i_dts_skip;
+    uint32_t     i_pts_entry;
+    uint32_t     i_pts_skip;
 
     /* TODO if needed add pts
         but quickly *add* support for edts and seeking */
@@ -112,6 +110,7 @@ typedef struct
       the sample is located */
     uint32_t         i_sample;       /* next sample to read */
     uint32_t         i_chunk;        /* chunk where next sample is stored */
+    uint32_t         i_readahead_chunk; /* next chunk to announce to the access */
     /* total count of chunk and sample */
     uint32_t         i_chunk_count;
     uint32_t         i_sample_count;
@@ -121,8 +120,22 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    MP4_Box_table_t  *p_sample_size; /* stsz table, owned by the box */
+
+    /* timing tables, owned by the boxes. p_ctts can be NULL */
+    MP4_Box_data_stts_t *p_stts;
+    MP4_Box_data_ctts_t *p_ctts;
+    int64_t          i_cts_shift;    /* cslg composition to decoding shift */
+
+    /* The chunk times are computed on demand, walking the stts and ctts
+       tables: chunks before i_timed_chunk are done, and the walk stands
+       at the first sample of that chunk */
+    uint32_t         i_timed_chunk;
+    uint32_t         i_dts_entry;
+    uint32_t         i_dts_skip;
+    uint32_t         i_pts_entry;
+    uint32_t         i_pts_skip;
+    stime_t          i_next_dts;
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
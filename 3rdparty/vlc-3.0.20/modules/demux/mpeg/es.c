@@ -36,12 +36,15 @@
 #include <vlc_codec.h>
 #include <vlc_codecs.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 
 #include "../../packetizer/a52.h"
 #include "../../packetizer/dts_header.h"
+#include "../../packetizer/mpegaudio.h"
 #include "../meta_engine/ID3Tag.h"
 #include "../meta_engine/ID3Text.h"
 #include "../meta_engine/ID3Meta.h"
+#include "../seekindex.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -92,6 +95,10 @@ typedef struct
     const char *psz_name;
     int  (*pf_probe)( demux_t *p_demux, int64_t *pi_offset );
     int  (*pf_init)( demux_t *p_demux );
+    /* Returns the size, samples and rate of the frame starting with the
+     * i_frame_header bytes given, or -1, used to index the frames */
+    int  (*pf_frame)( const uint8_t *p_peek, unsigned *pi_samples, unsigned *pi_rate );
+    int  i_frame_header;
 } codec_t;
 
 typedef struct
@@ -119,6 +126,37 @@ typedef struct
     sync_table_ctx_t current;
 } sync_table_t;
 
+#define ES_INDEX_INTERVAL (CLOCK_FREQ / 4) /* between two seek points */
+#define ES_INDEX_BUFFER   65536
+#define ES_INDEX_FRAMES   0 /* seek index cache tracks */
+#define ES_INDEX_LENGTH   1
+
+typedef struct
+{
+    uint64_t   i_pos;
+    vlc_tick_t i_time; /* from the first frame */
+} es_index_point_t;
+
+/* Seek points built in background by walking the frame headers with its
+ * own stream, while the demuxer plays, or loaded from the seek index cache */
+typedef struct
+{
+    vlc_thread_t thread;
+    stream_t     *s;
+    atomic_bool  b_stop;
+    bool         b_joined;
+    demux_index_t *p_cache;
+    bool         b_cached;
+
+    vlc_mutex_t  lock;  /* protects the following */
+    es_index_point_t *p_points;
+    size_t       i_points;
+    size_t       i_alloc;
+    vlc_tick_t   i_length; /* exact duration, once done */
+    bool         b_done;
+    bool         b_complete; /* walked to the end of the stream */
+} es_index_t;
+
 struct demux_sys_t
 {
     codec_t codec;
@@ -161,6 +199,8 @@ struct demux_sys_t
     float rgf_replay_peak[AUDIO_REPLAY_GAIN_MAX];
 
     sync_table_t mllt;
+
+    es_index_t *p_index;
 };
 
 static int MpgaProbe( demux_t *p_demux, int64_t *pi_offset );
@@ -180,25 +220,39 @@ static int MlpProbe( demux_t *p_demux, int64_t *pi_offset );
 static int ThdProbe( demux_t *p_demux, int64_t *pi_offset );
 static int MlpInit( demux_t *p_demux );
 
+static int MpgaGetFrameInfo( const uint8_t *, unsigned *, unsigned * );
+static int AacGetFrameInfo( const uint8_t *, unsigned *, unsigned * );
+static int A52GetFrameInfo( const uint8_t *, unsigned *, unsigned * );
+static int EA52GetFrameInfo( const uint8_t *, unsigned *, unsigned * );
+
 static bool Parse( demux_t *p_demux, block_t **pp_output );
 static uint64_t SeekByMlltTable( demux_t *p_demux, vlc_tick_t *pi_time );
 
+static void IndexStart( demux_t *p_demux );
+static void IndexStop( es_index_t *p_index );
+static bool IndexGetLength( es_index_t *p_index, vlc_tick_t *pi_length );
+static int  SeekByIndex( demux_t *p_demux, vlc_tick_t i_time, bool b_precise );
+
 static const codec_t p_codecs[] = {
-    { VLC_CODEC_MP4A, false, "mp4 audio",  AacProbe,  AacInit },
-    { VLC_CODEC_MPGA, false, "mpeg audio", MpgaProbe, MpgaInit },
-    { VLC_CODEC_A52, true,  "a52 audio",  A52Probe,  A52Init },
-    { VLC_CODEC_EAC3, true,  "eac3 audio", EA52Probe, A52Init },
-    { VLC_CODEC_DTS, false, "dts audio",  DtsProbe,  DtsInit },
-    { VLC_CODEC_MLP, false, "mlp audio",  MlpProbe,  MlpInit },
-    { VLC_CODEC_TRUEHD, false, "TrueHD audio",  ThdProbe,  MlpInit },
-
-    { 0, false, NULL, NULL, NULL }
+    { VLC_CODEC_MP4A, false, "mp4 audio",  AacProbe,  AacInit,
+      AacGetFrameInfo, 7 },
+    { VLC_CODEC_MPGA, false, "mpeg audio", MpgaProbe, MpgaInit,
+      MpgaGetFrameInfo, 4 },
+    { VLC_CODEC_A52, true,  "a52 audio",  A52Probe,  A52Init,
+      A52GetFrameInfo, VLC_A52_HEADER_SIZE },
+    { VLC_CODEC_EAC3, true,  "eac3 audio", EA52Probe, A52Init,
+      EA52GetFrameInfo, VLC_A52_HEADER_SIZE },
+    { VLC_CODEC_DTS, false, "dts audio",  DtsProbe,  DtsInit, NULL, 0 },
+    { VLC_CODEC_MLP, false, "mlp audio",  MlpProbe,  MlpInit, NULL, 0 },
+    { VLC_CODEC_TRUEHD, false, "TrueHD audio",  ThdProbe,  MlpInit, NULL, 0 },
+
+    { 0, false, NULL, NULL, NULL, NULL, 0 }
 };
 
 static int VideoInit( demux_t *p_demux );
 
 static const codec_t codec_m4v = {
-    VLC_CODEC_MP4V, false, "mp4 video", NULL,  VideoInit
+    VLC_CODEC_MP4V, false, "mp4 video", NULL,  VideoInit, NULL, 0
 };
 
 /*****************************************************************************
@@ -262,6 +316,9 @@ static int OpenCommon( demux_t *p_demux,
         }
     }
 
+    if( p_sys->codec.pf_frame )
+        IndexStart( p_demux );
+
     for( ;; )
     {
         if( Parse( p_demux, &p_sys->p_packetized_data ) )
@@ -371,6 +428,8 @@ static void Close( vlc_object_t * p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( p_sys->p_index )
+        IndexStop( p_sys->p_index );
     if( p_sys->p_packetized_data )
         block_ChainRelease( p_sys->p_packetized_data );
     if( p_sys->mllt.p_bits )
@@ -404,6 +463,15 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         case DEMUX_GET_LENGTH:
         {
             va_list ap;
+            vlc_tick_t i_length;
+
+            /* Exact once all the frames are indexed */
+            if( p_sys->p_index && IndexGetLength( p_sys->p_index, &i_length ) )
+            {
+                pi64 = va_arg( args, int64_t * );
+                *pi64 = i_length;
+                return VLC_SUCCESS;
+            }
 
             va_copy ( ap, args );
             i_ret = demux_vaControlHelper( p_demux->s, p_sys->i_stream_offset,
@@ -433,6 +501,19 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         case DEMUX_SET_TIME:
         {
+            if( p_sys->p_index )
+            {
+                va_list ap;
+
+                va_copy( ap, args );
+                int64_t i_time = va_arg( ap, int64_t );
+                bool b_precise = va_arg( ap, int );
+                va_end( ap );
+
+                if( SeekByIndex( p_demux, i_time, b_precise ) == VLC_SUCCESS )
+                    return VLC_SUCCESS;
+                /* Not indexed that far yet */
+            }
             if( p_sys->mllt.p_bits )
             {
                 int64_t i_time = va_arg(args, int64_t);
@@ -550,6 +631,342 @@ static bool Parse( demux_t *p_demux, block_t **pp_output )
     return b_eof;
 }
 
+/*****************************************************************************
+ * Frame index
+ *****************************************************************************/
+static void *IndexThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    es_index_t *p_index = p_sys->p_index;
+    const int i_header = p_sys->codec.i_frame_header;
+
+    uint8_t *p_buf = malloc( ES_INDEX_BUFFER );
+    size_t i_buf = 0, i_off = 0;
+    uint64_t i_buf_pos = p_sys->i_stream_offset;
+    date_t date;
+    bool b_date = false;
+    vlc_tick_t i_next = 0;
+    bool b_eof = false, b_refill = false;
+
+    while( p_buf && !atomic_load( &p_index->b_stop ) )
+    {
+        if( !b_eof && ( i_off + i_header > i_buf || b_refill ) )
+        {
+            /* Refill, keeping the start of a header or skipping the end
+             * of the last frame */
+            if( i_off < i_buf )
+                memmove( p_buf, &p_buf[i_off], i_buf - i_off );
+            else if( i_off > i_buf &&
+                     vlc_stream_Read( p_index->s, NULL, i_off - i_buf ) !=
+                     (ssize_t)(i_off - i_buf) )
+                break;
+            i_buf_pos += i_off;
+            i_buf = i_off < i_buf ? i_buf - i_off : 0;
+            i_off = 0;
+            b_refill = false;
+
+            ssize_t i_read = vlc_stream_Read( p_index->s, &p_buf[i_buf],
+                                              ES_INDEX_BUFFER - i_buf );
+            if( i_read <= 0 )
+                b_eof = true;
+            else
+                i_buf += i_read;
+            continue;
+        }
+        if( i_off + i_header > i_buf )
+            break; /* end of stream */
+
+        unsigned i_samples, i_rate;
+        int i_size = p_sys->codec.pf_frame( &p_buf[i_off], &i_samples, &i_rate );
+        if( i_size <= 0 )
+        {
+            i_off++; /* resync */
+            continue;
+        }
+
+        /* A header pattern may appear within the payload: the sync is only
+         * accepted if the next frame header follows */
+        if( i_off + i_size + i_header <= i_buf )
+        {
+            unsigned i_next_samples, i_next_rate;
+            if( p_sys->codec.pf_frame( &p_buf[i_off + i_size], &i_next_samples,
+                                       &i_next_rate ) <= 0 )
+            {
+                i_off++;
+                continue;
+            }
+        }
+        else if( !b_eof && i_off > 0 )
+        {
+            b_refill = true; /* read the next header first */
+            continue;
+        }
+
+        if( !b_date )
+        {
+            date_Init( &date, i_rate, 1 );
+            date_Set( &date, 0 );
+            b_date = true;
+        }
+        else if( date.i_divider_num != i_rate )
+            date_Change( &date, i_rate, 1 );
+
+        const vlc_tick_t i_time = date_Get( &date );
+        if( i_time >= i_next )
+        {
+            vlc_mutex_lock( &p_index->lock );
+            if( p_index->i_points == p_index->i_alloc )
+            {
+                size_t i_alloc = p_index->i_alloc ? p_index->i_alloc * 2 : 256;
+                es_index_point_t *p_points = realloc( p_index->p_points,
+                                                      i_alloc * sizeof(*p_points) );
+                if( unlikely(p_points == NULL) )
+                {
+                    vlc_mutex_unlock( &p_index->lock );
+                    break;
+                }
+                p_index->p_points = p_points;
+                p_index->i_alloc = i_alloc;
+            }
+            p_index->p_points[p_index->i_points].i_pos = i_buf_pos + i_off;
+            p_index->p_points[p_index->i_points].i_time = i_time;
+            p_index->i_points++;
+            vlc_mutex_unlock( &p_index->lock );
+            i_next = i_time + ES_INDEX_INTERVAL;
+        }
+
+        date_Increment( &date, i_samples );
+        i_off += i_size;
+    }
+
+    const bool b_complete = b_eof && !atomic_load( &p_index->b_stop );
+    const vlc_tick_t i_length = b_date ? date_Get( &date ) : 0;
+    free( p_buf );
+
+    vlc_mutex_lock( &p_index->lock );
+    p_index->i_length = i_length;
+    p_index->b_done = true;
+    p_index->b_complete = b_complete;
+    const size_t i_points = p_index->i_points;
+    vlc_mutex_unlock( &p_index->lock );
+
+    if( b_complete )
+        msg_Dbg( p_demux, "indexed %zu seek points, duration %"PRId64" ms",
+                 i_points, i_length / 1000 );
+    return NULL;
+}
+
+/* Takes the points of a complete index from the cache */
+static bool IndexLoad( es_index_t *p_index )
+{
+    demux_index_entry_t length, before, point;
+
+    if( !(demux_IndexLookup( p_index->p_cache, ES_INDEX_LENGTH, INT64_MAX,
+                             &length, NULL ) & DEMUX_INDEX_BEFORE) ||
+        length.i_time <= 0 )
+        return false;
+
+    int64_t i_time = INT64_MIN;
+    while( demux_IndexLookup( p_index->p_cache, ES_INDEX_FRAMES, i_time,
+                              &before, &point ) & DEMUX_INDEX_AFTER )
+    {
+        if( p_index->i_points == p_index->i_alloc )
+        {
+            size_t i_alloc = p_index->i_alloc ? p_index->i_alloc * 2 : 256;
+            es_index_point_t *p_points = realloc( p_index->p_points,
+                                                  i_alloc * sizeof(*p_points) );
+            if( unlikely(p_points == NULL) )
+                break;
+            p_index->p_points = p_points;
+            p_index->i_alloc = i_alloc;
+        }
+        p_index->p_points[p_index->i_points].i_pos = point.i_pos;
+        p_index->p_points[p_index->i_points].i_time = point.i_time;
+        p_index->i_points++;
+        i_time = point.i_time;
+    }
+
+    if( p_index->i_points == 0 )
+        return false;
+    p_index->i_length = length.i_time;
+    p_index->b_done = p_index->b_complete = true;
+    p_index->b_cached = true;
+    return true;
+}
+
+/* Gives the points of a complete index to the cache, evenly spread over
+ * the whole stream if there are too many */
+static void IndexSave( es_index_t *p_index )
+{
+    const size_t i_step = p_index->i_points / (DEMUX_INDEX_MAX - 1) + 1;
+
+    for( size_t i = 0; i < p_index->i_points; i += i_step )
+        demux_IndexAdd( p_index->p_cache, ES_INDEX_FRAMES,
+                        p_index->p_points[i].i_time,
+                        p_index->p_points[i].i_pos );
+    demux_IndexAdd( p_index->p_cache, ES_INDEX_LENGTH, p_index->i_length, 0 );
+}
+
+static void IndexStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_fastseekable;
+    const uint8_t *p_peek;
+    unsigned i_samples, i_rate;
+
+    /* Only index local files, starting with a frame we can parse */
+    if( p_demux->s->psz_url == NULL ||
+        vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fastseekable ) ||
+        !b_fastseekable ||
+        vlc_stream_Peek( p_demux->s, &p_peek, p_sys->codec.i_frame_header ) <
+            p_sys->codec.i_frame_header ||
+        p_sys->codec.pf_frame( p_peek, &i_samples, &i_rate ) <= 0 )
+        return;
+
+    es_index_t *p_index = malloc( sizeof(*p_index) );
+    if( unlikely(p_index == NULL) )
+        return;
+
+    atomic_init( &p_index->b_stop, false );
+    p_index->s = NULL;
+    p_index->b_joined = true;
+    p_index->b_cached = false;
+    vlc_mutex_init( &p_index->lock );
+    p_index->p_points = NULL;
+    p_index->i_points = p_index->i_alloc = 0;
+    p_index->i_length = 0;
+    p_index->b_done = p_index->b_complete = false;
+
+    /* Seek points of a previous playback, if the file did not change */
+    p_index->p_cache = demux_IndexOpen( p_demux, "es" );
+    if( p_index->p_cache && IndexLoad( p_index ) )
+    {
+        msg_Dbg( p_demux, "using %zu cached seek points", p_index->i_points );
+        p_sys->p_index = p_index;
+        return;
+    }
+
+    p_index->s = vlc_stream_NewURL( p_demux, p_demux->s->psz_url );
+    if( p_index->s == NULL )
+        goto error;
+
+    /* The index offsets must be those of the demuxer stream, which starts
+     * after the ID3v2 or APEv2 tags */
+    stream_t *p_skiptags = vlc_stream_FilterNew( p_index->s, "skiptags" );
+    if( p_skiptags != NULL )
+        p_index->s = p_skiptags;
+
+    uint64_t i_size, i_index_size;
+    if( vlc_stream_GetSize( p_demux->s, &i_size ) ||
+        vlc_stream_GetSize( p_index->s, &i_index_size ) ||
+        i_size != i_index_size ||
+        vlc_stream_Seek( p_index->s, p_sys->i_stream_offset ) )
+        goto error;
+
+    p_index->b_joined = false;
+    p_sys->p_index = p_index;
+    if( vlc_clone( &p_index->thread, IndexThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        p_sys->p_index = NULL;
+        goto error;
+    }
+    return;
+
+error:
+    if( p_index->s )
+        vlc_stream_Delete( p_index->s );
+    if( p_index->p_cache )
+        demux_IndexClose( p_index->p_cache );
+    vlc_mutex_destroy( &p_index->lock );
+    free( p_index->p_points );
+    free( p_index );
+}
+
+/* Releases the indexer thread and stream, keeping the points */
+static void IndexJoin( es_index_t *p_index )
+{
+    if( p_index->b_joined )
+        return;
+    atomic_store( &p_index->b_stop, true );
+    vlc_join( p_index->thread, NULL );
+    vlc_stream_Delete( p_index->s );
+    p_index->b_joined = true;
+}
+
+static void IndexStop( es_index_t *p_index )
+{
+    IndexJoin( p_index );
+    if( p_index->p_cache )
+    {
+        if( p_index->b_complete && !p_index->b_cached && p_index->i_length > 0 )
+            IndexSave( p_index );
+        demux_IndexClose( p_index->p_cache );
+    }
+    vlc_mutex_destroy( &p_index->lock );
+    free( p_index->p_points );
+    free( p_index );
+}
+
+static bool IndexGetLength( es_index_t *p_index, vlc_tick_t *pi_length )
+{
+    vlc_mutex_lock( &p_index->lock );
+    const bool b_done = p_index->b_done;
+    *pi_length = p_index->i_length;
+    vlc_mutex_unlock( &p_index->lock );
+
+    if( b_done )
+        IndexJoin( p_index );
+    return b_done && *pi_length > 0;
+}
+
+static int SeekByIndex( demux_t *p_demux, vlc_tick_t i_time, bool b_precise )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    es_index_t *p_index = p_sys->p_index;
+
+    vlc_mutex_lock( &p_index->lock );
+    /* The point before i_time is final once a later one is known */
+    if( p_index->i_points == 0 ||
+        ( !p_index->b_done && p_index->p_points[p_index->i_points - 1].i_time <= i_time ) )
+    {
+        vlc_mutex_unlock( &p_index->lock );
+        return VLC_EGENERIC;
+    }
+
+    size_t lo = 0, hi = p_index->i_points;
+    while( lo + 1 < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_index->p_points[mid].i_time <= i_time )
+            lo = mid;
+        else
+            hi = mid;
+    }
+    const es_index_point_t point = p_index->p_points[lo];
+    vlc_mutex_unlock( &p_index->lock );
+
+    if( vlc_stream_Seek( p_demux->s, point.i_pos ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    /* Restart the packetizer timeline on the frame */
+    if( p_sys->p_packetized_data )
+        block_ChainRelease( p_sys->p_packetized_data );
+    p_sys->p_packetized_data = NULL;
+    if( p_sys->p_packetizer->pf_flush )
+        p_sys->p_packetizer->pf_flush( p_sys->p_packetizer );
+    p_sys->b_start = true;
+    p_sys->i_pts = 0;
+    p_sys->i_bytes = 0;
+    p_sys->i_time_offset = point.i_time;
+
+    if( b_precise )
+        es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
+                        VLC_TICK_0 + i_time );
+    return VLC_SUCCESS;
+}
+
 /* Check to apply to WAVE fmt header */
 static int GenericFormatCheck( int i_format, const uint8_t *p_head )
 {
@@ -758,6 +1175,24 @@ static int MpgaGetFrameSamples( uint32_t h )
     }
 }
 
+static int MpgaGetFrameInfo( const uint8_t *p_peek, unsigned *pi_samples,
+                             unsigned *pi_rate )
+{
+    unsigned i_channels, i_channels_conf, i_chan_mode, i_bit_rate;
+    unsigned i_max_frame_size, i_layer;
+
+    if( !MpgaCheckSync( p_peek ) )
+        return -1;
+
+    int i_size = mpga_SyncInfo( GetDWBE( p_peek ), &i_channels,
+                                &i_channels_conf, &i_chan_mode, pi_rate,
+                                &i_bit_rate, pi_samples, &i_max_frame_size,
+                                &i_layer );
+    if( i_size <= 0 || i_bit_rate == 0 ) /* free format */
+        return -1;
+    return i_size;
+}
+
 static int MpgaProbe( demux_t *p_demux, int64_t *pi_offset )
 {
     const int pi_wav[] = { WAVE_FORMAT_MPEG, WAVE_FORMAT_MPEGLAYER3, WAVE_FORMAT_UNKNOWN };
@@ -1093,6 +1528,27 @@ static int AacProbe( demux_t *p_demux, int64_t *pi_offset )
     *pi_offset = i_offset;
     return VLC_SUCCESS;
 }
+static int AacGetFrameInfo( const uint8_t *p_peek, unsigned *pi_samples,
+                            unsigned *pi_rate )
+{
+    static const unsigned pi_sample_rates[16] =
+    {
+        96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
+        16000, 12000, 11025, 8000,  7350,  0,     0,     0
+    };
+
+    /* ADTS only */
+    if( p_peek[0] != 0xff || (p_peek[1] & 0xf6) != 0xf0 )
+        return -1;
+
+    const int i_size = ((p_peek[3] & 0x03) << 11) | (p_peek[4] << 3) | (p_peek[5] >> 5);
+    *pi_rate = pi_sample_rates[(p_peek[2] >> 2) & 0x0f];
+    *pi_samples = 1024 * ((p_peek[6] & 0x03) + 1);
+    if( *pi_rate == 0 || i_size < 7 )
+        return -1;
+    return i_size;
+}
+
 static int AacInit( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -1128,6 +1584,41 @@ static int A52CheckSync( const uint8_t *p_peek, bool *p_big_endian, int *pi_samp
         *pi_samples = header.i_samples;
     return header.i_size;
 }
+static int A52GetFrameInfoCommon( const uint8_t *p_peek, unsigned *pi_samples,
+                                  unsigned *pi_rate, bool b_eac3 )
+{
+    vlc_a52_header_t header = { .b_eac3 = false };
+    uint8_t p_tmp[VLC_A52_HEADER_SIZE];
+
+    if( p_peek[0] != 0x0b || p_peek[1] != 0x77 )
+    {
+        swab( p_peek, p_tmp, VLC_A52_HEADER_SIZE );
+        p_peek = p_tmp;
+    }
+
+    if( vlc_a52_header_Parse( &header, p_peek, VLC_A52_HEADER_SIZE ) ||
+        !header.b_eac3 != !b_eac3 || header.i_rate == 0 )
+        return -1;
+
+    /* Dependent substreams complete the samples of their main frame */
+    if( header.b_eac3 && header.eac3.strmtyp == EAC3_STRMTYP_DEPENDENT )
+        *pi_samples = 0;
+    else
+        *pi_samples = header.i_samples;
+    *pi_rate = header.i_rate;
+    return header.i_size;
+}
+static int A52GetFrameInfo( const uint8_t *p_peek, unsigned *pi_samples,
+                            unsigned *pi_rate )
+{
+    return A52GetFrameInfoCommon( p_peek, pi_samples, pi_rate, false );
+}
+static int EA52GetFrameInfo( const uint8_t *p_peek, unsigned *pi_samples,
+                             unsigned *pi_rate )
+{
+    return A52GetFrameInfoCommon( p_peek, pi_samples, pi_rate, true );
+}
+
 static int EA52CheckSyncProbe( const uint8_t *p_peek, int *pi_samples )
 {
     bool b_dummy;
@@ -51,6 +51,8 @@
 #include "timestamps.h"
 
 #include "ts.h"
+#include "ts_classify.h"
+#include "../seekindex.h"
 
 #include "../../codec/scte18.h"
 #include "../opus.h"
@@ -195,17 +197,18 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk, size_
 static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr );
 
+static void ReleaseTSPacket( block_t *p_pkt );
+static void DropTSPackets( demux_sys_t *p_sys );
+static uint64_t TellTS( demux_sys_t *p_sys );
+static int SeekTS( demux_sys_t *p_sys, uint64_t i_pos );
+static const uint8_t * ReadTSPacketInPlace( demux_t *p_demux );
+static void SkipUnusedTSPackets( demux_t *p_demux );
 static block_t* ReadTSPacket( demux_t *p_demux );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, vlc_tick_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 
-#define TS_PACKET_SIZE_188 188
-#define TS_PACKET_SIZE_192 192
-#define TS_PACKET_SIZE_204 204
-#define TS_PACKET_SIZE_MAX 204
-#define TS_HEADER_SIZE 4
 
 #define PROBE_CHUNK_COUNT 500
 #define PROBE_MAX         (PROBE_CHUNK_COUNT * 10)
@@ -396,6 +399,7 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->arib.b25stream = NULL;
     p_sys->stream = p_demux->s;
+    p_sys->p_index = NULL;
 
     p_sys->b_broken_charset = false;
 
@@ -530,6 +534,13 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    p_sys->read.p_stream = NULL;
+    DropTSPackets( p_sys );
+
+    /* Cache of the PCR positions found while seeking */
+    if( p_sys->b_canfastseek )
+        p_sys->p_index = demux_IndexOpen( p_demux, "ts" );
+
     if( !p_sys->b_access_control && var_CreateGetBool( p_demux, "ts-pmtfix-waitdata" ) )
         p_sys->es_creation = DELAY_ES;
     else
@@ -592,6 +603,9 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    if( p_sys->p_index )
+        demux_IndexClose( p_sys->p_index );
+
     free( p_sys );
 }
 
@@ -638,18 +652,31 @@ static int Demux( demux_t *p_demux )
     {
         bool         b_frame = false;
         int          i_header = 0;
-        block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        block_t      pkt, *p_pkt = &pkt;
+
+        SkipUnusedTSPackets( p_demux );
+        const uint8_t *p_data = ReadTSPacketInPlace( p_demux );
+        if( !p_data )
         {
             return VLC_DEMUXER_EOF;
         }
 
+        /* The packet is processed in place, and only copied to a real block
+         * if its payload is gathered for an ES */
+        block_Init( &pkt, (uint8_t *)&p_data[p_sys->i_packet_header_size],
+                    p_sys->i_packet_size - p_sys->i_packet_header_size );
+        pkt.pf_release = ReleaseTSPacket;
+
         if( p_sys->b_start_record )
         {
             /* Enable recording once synchronized */
             vlc_stream_Control( p_sys->stream, STREAM_SET_RECORD_STATE, true,
                                 "ts" );
             p_sys->b_start_record = false;
+            /* The packets read ahead went past the recorder: read them
+             * again. Live streams only record from the next read. */
+            if( p_sys->b_canseek )
+                SeekTS( p_sys, TellTS( p_sys ) );
         }
 
         /* Early reject truncated packets from hw devices */
@@ -731,6 +758,13 @@ static int Demux( demux_t *p_demux )
                 continue;
             }
 
+            if( p_pid->u.p_stream->transport != TS_TRANSPORT_IGNORE )
+            {
+                p_pkt = block_Duplicate( &pkt );
+                if( unlikely(p_pkt == NULL) )
+                    continue;
+            }
+
             if( p_pid->u.p_stream->transport == TS_TRANSPORT_PES )
             {
                 b_frame = GatherPESData( p_demux, p_pid, p_pkt, i_header );
@@ -947,7 +981,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TellTS( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -994,7 +1028,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            SeekTS( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1717,12 +1751,273 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     return b_ret;
 }
 
+static void ReleaseTSPacket( block_t *p_pkt )
+{
+    /* Packets read in place are owned by the demuxer */
+    VLC_UNUSED(p_pkt);
+}
+
+static void DropTSPackets( demux_sys_t *p_sys )
+{
+    p_sys->read.i_start = p_sys->read.i_end = 0;
+    p_sys->read.i_hdr = p_sys->read.i_hdr_end = 0;
+}
+
+/* Forgets the packets read ahead if the stream was read or seeked behind our
+ * back. When a stream filter is inserted (ARIB CAM), the packets already read
+ * from the former stream are demuxed first, as the filter reads on after
+ * them. */
+static void CheckTSPackets( demux_sys_t *p_sys )
+{
+    if( p_sys->read.p_stream != p_sys->stream )
+    {
+        p_sys->read.p_stream = p_sys->stream;
+        p_sys->read.i_pos = vlc_stream_Tell( p_sys->stream );
+    }
+    else if( p_sys->read.i_pos != vlc_stream_Tell( p_sys->stream ) )
+        DropTSPackets( p_sys );
+}
+
+/* Stream offset of the next packet to demux */
+static uint64_t TellTS( demux_sys_t *p_sys )
+{
+    CheckTSPackets( p_sys );
+
+    const uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+    const size_t i_left = p_sys->read.i_end - p_sys->read.i_start;
+    return ( i_pos > i_left ) ? i_pos - i_left : 0;
+}
+
+static int SeekTS( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    DropTSPackets( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+/* Makes at least i_min bytes available at the read position. The stream is
+ * read a whole batch of packets at once, straight into the demuxer buffer,
+ * where the packets are then processed in place. Live streams are not waited
+ * for beyond what the source has delivered so far. */
+static bool FillTSPackets( demux_sys_t *p_sys, size_t i_min )
+{
+    const size_t i_size = p_sys->i_packet_size * TS_READ_BATCH;
+    const size_t i_left = p_sys->read.i_end - p_sys->read.i_start;
+
+    assert( i_min <= i_size );
+    if( i_left >= i_min )
+        return true;
+
+    /* Keep the remains of the previous batch, if any */
+    memmove( p_sys->read.buffer, &p_sys->read.buffer[p_sys->read.i_start],
+             i_left );
+    p_sys->read.i_start = 0;
+    p_sys->read.i_end = i_left;
+    p_sys->read.i_hdr = p_sys->read.i_hdr_end = 0;
+
+    while( p_sys->read.i_end < i_min )
+    {
+        uint8_t *p_dst = &p_sys->read.buffer[p_sys->read.i_end];
+        const size_t i_len = i_size - p_sys->read.i_end;
+        ssize_t i_read;
+
+        if( p_sys->b_canseek )
+            i_read = vlc_stream_Read( p_sys->stream, p_dst, i_len );
+        else
+            i_read = vlc_stream_ReadPartial( p_sys->stream, p_dst, i_len );
+        if( i_read <= 0 )
+            break;
+        p_sys->read.i_end += i_read;
+    }
+
+    p_sys->read.i_pos = vlc_stream_Tell( p_sys->stream );
+    p_sys->read.p_stream = p_sys->stream;
+    return p_sys->read.i_end >= i_min;
+}
+
+/* Drops whole packets from the head of the buffer */
+static void ConsumeTSPackets( demux_sys_t *p_sys, size_t i_count )
+{
+    p_sys->read.i_start += i_count * p_sys->i_packet_size;
+    assert( p_sys->read.i_start <= p_sys->read.i_end );
+    /* Headers extracted ahead remain valid */
+    p_sys->read.i_hdr = __MIN( p_sys->read.i_hdr + i_count,
+                               p_sys->read.i_hdr_end );
+}
+
+/* Returns the next TS packet, additional header included, from the demuxer
+ * buffer. It remains valid until the next call. */
+static const uint8_t * ReadTSPacketInPlace( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p_data;
+
+    CheckTSPackets( p_sys );
+
+    for( ;; )
+    {
+        if( !FillTSPackets( p_sys, p_sys->i_packet_size ) )
+        {
+            int64_t size = stream_Size( p_sys->stream );
+            if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
+                msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+            else
+                msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            return NULL;
+        }
+
+        /* Check sync byte, after the header (BluRay streams).
+         * re-sync logic would skip the header (by adjusting packet start), but this would result in losing first and last ts packets.
+         * First packet is usually PAT, and losing it means losing whole first GOP. This is fatal with still-image based menus.
+         */
+        p_data = &p_sys->read.buffer[p_sys->read.i_start];
+        if( p_data[p_sys->i_packet_header_size] == 0x47 )
+            break;
+
+        /* Re-sync */
+        msg_Warn( p_demux, "lost synchro" );
+        p_sys->read.i_hdr = p_sys->read.i_hdr_end = 0;
+        for( ;; )
+        {
+            size_t i_skip = 0;
+
+            if( !FillTSPackets( p_sys, p_sys->i_packet_size + 1 ) )
+            {
+                msg_Dbg( p_demux, "eof ?" );
+                return NULL;
+            }
+
+            p_data = &p_sys->read.buffer[p_sys->read.i_start];
+            const size_t i_left = p_sys->read.i_end - p_sys->read.i_start;
+            while( i_skip < i_left - p_sys->i_packet_size )
+            {
+                if( p_data[i_skip + p_sys->i_packet_header_size] == 0x47 &&
+                        p_data[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
+                {
+                    break;
+                }
+                i_skip++;
+            }
+            msg_Dbg( p_demux, "skipping %zu bytes of garbage at %"PRIu64,
+                     i_skip, TellTS( p_sys ) );
+            p_sys->read.i_start += i_skip;
+
+            if( i_skip < i_left - p_sys->i_packet_size )
+            {
+                break;
+            }
+        }
+        msg_Dbg( p_demux, "resynced at %" PRIu64, TellTS( p_sys ) );
+    }
+
+    ConsumeTSPackets( p_sys, 1 );
+    return p_data;
+}
+
+/* Whether packets of a PID can be dropped without any processing */
+static bool PIDIsUnused( demux_sys_t *p_sys, uint16_t i_pid )
+{
+    if( i_pid == 0x1FFF ) /* Null packets */
+        return true;
+
+    const ts_pid_t *p_pid = GetPID( p_sys, i_pid );
+    return SEEN(p_pid) && p_pid->type == TYPE_STREAM &&
+           !(p_pid->i_flags & FLAG_FILTERED);
+}
+
+/* Keeps the continuity and scrambling state of skipped packets, so that it
+ * is up to date if their ES gets selected */
+static void UpdateSkippedPIDState( demux_t *p_demux, ts_pid_t *p_pid,
+                                   uint32_t h, const uint8_t *p_pkt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( TS_HDR_PAYLOAD(h) && p_sys->b_cc_check )
+    {
+        p_pid->i_cc = TS_HDR_CC(h);
+        p_pid->i_dup = 0;
+        memcpy( p_pid->prevpktbytes, &p_pkt[1], PREVPKTKEEPBYTES );
+    }
+
+    /* Descrambled packets are not flagged as scrambled either */
+    UpdatePIDScrambledState( p_demux, p_pid,
+                             TS_HDR_SCRAMBLING(h) && p_sys->csa == NULL );
+}
+
+/* Skips the packets of unselected ES at the head of the peek buffer.
+ * Their headers are extracted once per batch, and they are dropped before
+ * any per-packet processing. Packets with an adaptation field are left to
+ * the regular path, as they may carry a PCR. */
+static void SkipUnusedTSPackets( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->b_access_control || p_sys->b_start_record ||
+        p_sys->es_creation == DELAY_ES || !SEEN(GetPID(p_sys, 0)) )
+        return;
+
+    CheckTSPackets( p_sys );
+    if( p_sys->read.i_hdr == p_sys->read.i_hdr_end )
+        p_sys->read.i_hdr = p_sys->read.i_hdr_end = 0;
+
+    const size_t i_buffered = __MIN( ( p_sys->read.i_end - p_sys->read.i_start )
+                                     / p_sys->i_packet_size, TS_READ_BATCH );
+    if( i_buffered < 2 )
+        return;
+
+    const uint8_t *p_peek = &p_sys->read.buffer[p_sys->read.i_start];
+
+    /* Extract the headers once, then reuse them until they are consumed */
+    if( p_sys->read.i_hdr_end == 0 )
+        p_sys->read.i_hdr_end =
+            ts_packets_Classify( &p_peek[p_sys->i_packet_header_size],
+                                 p_sys->i_packet_size, i_buffered,
+                                 p_sys->read.hdr );
+
+    const uint32_t *hdr = &p_sys->read.hdr[p_sys->read.i_hdr];
+    const size_t i_count = p_sys->read.i_hdr_end - p_sys->read.i_hdr;
+
+    size_t i_skip = 0;
+    unsigned i_last_pid = 0x2000; /* invalid PID */
+    ts_pid_t *p_pid = NULL;
+    bool b_unused = false;
+
+    for( ; i_skip < i_count; i_skip++ )
+    {
+        const uint32_t h = hdr[i_skip];
+
+        if( TS_HDR_TEI(h) || TS_HDR_AF(h) )
+            break;
+        if( TS_HDR_PID(h) != i_last_pid )
+        {
+            i_last_pid = TS_HDR_PID(h);
+            b_unused = PIDIsUnused( p_sys, i_last_pid );
+            p_pid = (i_last_pid != 0x1FFF) ? GetPID( p_sys, i_last_pid ) : NULL;
+        }
+        if( !b_unused )
+            break;
+        if( p_pid != NULL )
+            UpdateSkippedPIDState( p_demux, p_pid, h,
+                                   &p_peek[i_skip * p_sys->i_packet_size +
+                                           p_sys->i_packet_header_size] );
+    }
+
+    if( i_skip == 0 )
+        return;
+
+    ConsumeTSPackets( p_sys, i_skip );
+    p_sys->b_end_preparse = true;
+}
+
+/* Reads a packet straight from the stream, for probing and seeking */
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
     block_t     *p_pkt;
 
+    /* The packets read ahead by Demux() were dropped by SeekTS() */
+    assert( p_sys->read.i_start == p_sys->read.i_end );
+
     /* Get a new TS packet */
     if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
     {
@@ -1906,13 +2201,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return SeekTS( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellTS( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1921,6 +2216,25 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
         return VLC_EGENERIC;
 
     bool b_found = false;
+
+    /* Narrow the search to the known positions around the time */
+    if( p_sys->p_index )
+    {
+        demux_index_entry_t before, after;
+        int i_known = demux_IndexLookup( p_sys->p_index, p_pmt->i_number,
+                                         i_scaledtime, &before, &after );
+
+        if( (i_known & DEMUX_INDEX_BEFORE) &&
+            i_scaledtime - before.i_time < TO_SCALE(VLC_TICK_0 + CLOCK_FREQ / 2) &&
+            SeekTS( p_sys, before.i_pos ) == VLC_SUCCESS )
+            return VLC_SUCCESS;
+        if( (i_known & DEMUX_INDEX_BEFORE) && before.i_pos < i_tail_pos )
+            i_head_pos = before.i_pos;
+        if( (i_known & DEMUX_INDEX_AFTER) &&
+            after.i_pos >= i_head_pos + 2 * p_sys->i_packet_size )
+            i_tail_pos = after.i_pos - p_sys->i_packet_size;
+    }
+
     while( (i_head_pos + p_sys->i_packet_size) <= i_tail_pos && !b_found )
     {
         /* Round i_pos to a multiple of p_sys->i_packet_size */
@@ -1928,7 +2242,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( SeekTS( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1981,7 +2295,11 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
 
             if( i_pcr != -1 )
             {
-                int64_t i_diff = i_scaledtime - TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+                i_pcr = TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+                if( p_sys->p_index )
+                    demux_IndexAdd( p_sys->p_index, p_pmt->i_number, i_pcr, i_pos );
+
+                int64_t i_diff = i_scaledtime - i_pcr;
                 if ( i_diff < 0 )
                     i_tail_pos = (i_splitpos >= p_sys->i_packet_size) ? i_splitpos - p_sys->i_packet_size : 0;
                 else if( i_diff < TO_SCALE(VLC_TICK_0 + CLOCK_FREQ / 2) ) // 500ms
@@ -1999,7 +2317,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        vlc_stream_Seek( p_sys->stream, i_initial_pos );
+        SeekTS( p_sys, i_initial_pos );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -2108,7 +2426,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellTS( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2121,7 +2439,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( SeekTS( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2131,7 +2449,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( SeekTS( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2140,7 +2458,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellTS( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2153,7 +2471,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( SeekTS( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2163,7 +2481,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( SeekTS( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2214,14 +2532,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TellTS( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TellTS( p_sys );
             }
         }
     }
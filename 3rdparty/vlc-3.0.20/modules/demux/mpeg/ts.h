@@ -29,6 +29,14 @@ typedef struct csa_t csa_t;
 
 #define TS_PSI_PAT_PID 0x00
 
+#define TS_PACKET_SIZE_188 188
+#define TS_PACKET_SIZE_192 192
+#define TS_PACKET_SIZE_204 204
+#define TS_PACKET_SIZE_MAX 204
+#define TS_HEADER_SIZE 4
+
+#define TS_READ_BATCH 256 /* packets read at once, at most */
+
 typedef enum ts_standards_e
 {
     TS_STANDARD_AUTO = 0,
@@ -60,6 +68,19 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    struct
+    {
+        size_t   i_start;  /* offset of the next packet in the buffer */
+        size_t   i_end;    /* end of the data read in the buffer */
+        uint64_t i_pos;    /* stream offset at the end of the data read */
+        stream_t *p_stream; /* stream the data was read from */
+        uint32_t hdr[TS_READ_BATCH]; /* headers of buffered packets */
+        size_t   i_hdr;     /* header of the packet at i_start */
+        size_t   i_hdr_end; /* end of the headers extracted so far */
+        uint8_t  buffer[TS_READ_BATCH * TS_PACKET_SIZE_MAX]; /* packets
+                                                    processed in place */
+    } read;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -130,6 +151,9 @@ struct demux_sys_t
 
     /* */
     bool        b_start_record;
+
+    /* Persistent seek points, NULL if not cached */
+    struct demux_index_t *p_index;
 };
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * ts_classify.h: TS packet headers batch extraction
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_CLASSIFY_H
+#define VLC_TS_CLASSIFY_H
+
+#include <vlc_cpu.h>
+
+#if defined(HAVE_SSE2_INTRINSICS) && defined(__GNUC__)
+# include <immintrin.h>
+# define TS_CLASSIFY_X86
+#endif
+
+/* Fields of a TS packet header, as returned by ts_packets_Classify() */
+#define TS_HDR_SYNC(h)  ((h) >> 24)
+#define TS_HDR_TEI(h)   ((h) & 0x800000)
+#define TS_HDR_PUSI(h)  ((h) & 0x400000)
+#define TS_HDR_PID(h)   (((h) >> 8) & 0x1fff)
+#define TS_HDR_SCRAMBLING(h) ((h) & 0xc0)
+#define TS_HDR_AF(h)    ((h) & 0x20)
+#define TS_HDR_PAYLOAD(h) ((h) & 0x10)
+#define TS_HDR_CC(h)    ((h) & 0x0f)
+
+static inline size_t ts_packets_Classify_C( const uint8_t *p, size_t i_stride,
+                                            size_t i_count, uint32_t *p_hdr )
+{
+    for( size_t i = 0; i < i_count; i++, p += i_stride )
+    {
+        if( p[0] != 0x47 )
+            return i;
+        p_hdr[i] = GetDWBE( p );
+    }
+    return i_count;
+}
+
+#ifdef TS_CLASSIFY_X86
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i ts_packet_LoadHeader_SSE2( const uint8_t *p )
+{
+    int32_t w;
+    memcpy( &w, p, 4 ); /* movd */
+    return _mm_cvtsi32_si128( w );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static inline size_t ts_packets_Classify_SSE2( const uint8_t *p, size_t i_stride,
+                                               size_t i_count, uint32_t *p_hdr )
+{
+    const __m128i sync = _mm_set1_epi32( 0x47 );
+    const __m128i low = _mm_set1_epi32( 0xff );
+    size_t i = 0;
+
+    for( ; i + 4 <= i_count; i += 4, p += 4 * i_stride )
+    {
+        /* No gather before AVX2: 4 loads interleaved into one vector */
+        const __m128i v01 = _mm_unpacklo_epi32(
+            ts_packet_LoadHeader_SSE2( p ),
+            ts_packet_LoadHeader_SSE2( &p[i_stride] ) );
+        const __m128i v23 = _mm_unpacklo_epi32(
+            ts_packet_LoadHeader_SSE2( &p[2 * i_stride] ),
+            ts_packet_LoadHeader_SSE2( &p[3 * i_stride] ) );
+        __m128i v = _mm_unpacklo_epi64( v01, v23 );
+
+        /* The sync byte is the lowest one of each little endian word */
+        const __m128i ok = _mm_cmpeq_epi32( _mm_and_si128( v, low ), sync );
+
+        /* Byte swap each header word */
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        v = _mm_shufflelo_epi16( v, 0xb1 );
+        v = _mm_shufflehi_epi16( v, 0xb1 );
+        _mm_storeu_si128( (__m128i *)&p_hdr[i], v );
+
+        const int mask = _mm_movemask_ps( _mm_castsi128_ps( ok ) );
+        if( mask != 0xf )
+            return i + ctz( ~mask );
+    }
+    return i + ts_packets_Classify_C( p, i_stride, i_count - i, &p_hdr[i] );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static inline size_t ts_packets_Classify_AVX2( const uint8_t *p, size_t i_stride,
+                                               size_t i_count, uint32_t *p_hdr )
+{
+    const __m256i sync = _mm256_set1_epi32( 0x47 );
+    const __m256i bswap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+    const int s = i_stride;
+    const __m256i offsets = _mm256_setr_epi32( 0, s, 2 * s, 3 * s,
+                                               4 * s, 5 * s, 6 * s, 7 * s );
+    size_t i = 0;
+
+    for( ; i + 8 <= i_count; i += 8, p += 8 * i_stride )
+    {
+        __m256i v = _mm256_i32gather_epi32( (const int *)p, offsets, 1 );
+        v = _mm256_shuffle_epi8( v, bswap );
+
+        const __m256i ok = _mm256_cmpeq_epi32( _mm256_srli_epi32( v, 24 ), sync );
+        _mm256_storeu_si256( (__m256i *)&p_hdr[i], v );
+
+        const int mask = _mm256_movemask_ps( _mm256_castsi256_ps( ok ) );
+        if( mask != 0xff )
+            return i + ctz( ~mask );
+    }
+    return i + ts_packets_Classify_C( p, i_stride, i_count - i, &p_hdr[i] );
+}
+#endif
+
+/**
+ * Extracts the headers of a run of TS packets.
+ *
+ * \param p first packet, starting with its sync byte
+ * \param i_stride packet size
+ * \param i_count number of packets
+ * \param p_hdr array of i_count host endian header words
+ * \return number of leading packets with a valid sync byte
+ */
+static inline size_t ts_packets_Classify( const uint8_t *p, size_t i_stride,
+                                          size_t i_count, uint32_t *p_hdr )
+{
+#ifdef TS_CLASSIFY_X86
+    if( vlc_CPU_AVX2() )
+        return ts_packets_Classify_AVX2( p, i_stride, i_count, p_hdr );
+    if( vlc_CPU_SSE2() )
+        return ts_packets_Classify_SSE2( p, i_stride, i_count, p_hdr );
+#endif
+    return ts_packets_Classify_C( p, i_stride, i_count, p_hdr );
+}
+
+#endif
@@ -0,0 +1,387 @@
+/*****************************************************************************
+ * seekindex.c: persistent seek index cache for demuxers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_configuration.h>
+
+#include "seekindex.h"
+
+#define INDEX_MAGIC      "VLCSIDX1"
+#define INDEX_HEADER     (8 + 8 + 8 + 4)
+#define INDEX_ENTRY      (4 + 8 + 8)
+#define INDEX_MAX        DEMUX_INDEX_MAX /* 80 KiB */
+#define INDEX_FILES_MAX  256  /* files in the cache directory */
+
+typedef struct
+{
+    uint32_t i_track;
+    int64_t  i_time;
+    uint64_t i_pos;
+} index_point_t;
+
+struct demux_index_t
+{
+    vlc_object_t *p_obj;
+    char         *psz_path;
+    uint64_t     i_size;  /* identity of the indexed file */
+    int64_t      i_mtime;
+    bool         b_dirty;
+
+    size_t        i_points;
+    size_t        i_alloc;
+    index_point_t *p_points; /* sorted by track then time */
+};
+
+static char *IndexPath( const char *psz_file, const char *psz_name )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir == NULL )
+        return NULL;
+
+    /* FNV-1a of the file path */
+    uint64_t i_hash = UINT64_C(0xcbf29ce484222325);
+    for( const char *p = psz_file; *p; p++ )
+        i_hash = (i_hash ^ (uint8_t)*p) * UINT64_C(0x100000001b3);
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%s"DIR_SEP"seekindex"DIR_SEP"%s-%016"PRIx64".idx",
+                  psz_dir, psz_name, i_hash ) < 0 )
+        psz_path = NULL;
+    free( psz_dir );
+    return psz_path;
+}
+
+/* Index of the first point not lower than (track, time) */
+static size_t IndexFind( const demux_index_t *p_idx, uint32_t i_track,
+                         int64_t i_time )
+{
+    size_t lo = 0, hi = p_idx->i_points;
+
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const index_point_t *p = &p_idx->p_points[mid];
+
+        if( p->i_track < i_track ||
+            (p->i_track == i_track && p->i_time < i_time) )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void IndexLoad( demux_index_t *p_idx )
+{
+    FILE *stream = vlc_fopen( p_idx->psz_path, "rb" );
+    if( stream == NULL )
+        return;
+
+    uint8_t hdr[INDEX_HEADER];
+    if( fread( hdr, sizeof(hdr), 1, stream ) != 1 ||
+        memcmp( hdr, INDEX_MAGIC, 8 ) ||
+        GetQWBE( &hdr[8] ) != p_idx->i_size ||
+        (int64_t)GetQWBE( &hdr[16] ) != p_idx->i_mtime )
+        goto out; /* Other version or file changed: rebuild */
+
+    uint32_t i_count = GetDWBE( &hdr[24] );
+    if( i_count == 0 || i_count > INDEX_MAX )
+        goto out;
+
+    index_point_t *p_points = vlc_alloc( i_count, sizeof(*p_points) );
+    if( unlikely(p_points == NULL) )
+        goto out;
+
+    for( uint32_t i = 0; i < i_count; i++ )
+    {
+        uint8_t entry[INDEX_ENTRY];
+
+        if( fread( entry, sizeof(entry), 1, stream ) != 1 )
+        {
+            free( p_points );
+            goto out;
+        }
+        p_points[i].i_track = GetDWBE( &entry[0] );
+        p_points[i].i_time = GetQWBE( &entry[4] );
+        p_points[i].i_pos = GetQWBE( &entry[12] );
+
+        /* Reject the index altogether if it is not what IndexSave() wrote:
+         * points sorted by track then time, and within the file */
+        if( p_points[i].i_pos >= p_idx->i_size ||
+            (i > 0 && (p_points[i].i_track < p_points[i - 1].i_track ||
+                       (p_points[i].i_track == p_points[i - 1].i_track &&
+                        p_points[i].i_time <= p_points[i - 1].i_time))) )
+        {
+            msg_Warn( p_idx->p_obj, "invalid seek index %s", p_idx->psz_path );
+            free( p_points );
+            goto out;
+        }
+    }
+
+    p_idx->p_points = p_points;
+    p_idx->i_points = p_idx->i_alloc = i_count;
+    msg_Dbg( p_idx->p_obj, "loaded %"PRIu32" seek points from %s",
+             i_count, p_idx->psz_path );
+out:
+    fclose( stream );
+}
+
+typedef struct
+{
+    char  *psz_path;
+    time_t i_mtime;
+} index_file_t;
+
+static int IndexFileCmp( const void *a, const void *b )
+{
+    const index_file_t *fa = a, *fb = b;
+
+    /* Most recently written first */
+    return (fa->i_mtime < fb->i_mtime) - (fa->i_mtime > fb->i_mtime);
+}
+
+/* Deletes the least recently written index files beyond INDEX_FILES_MAX */
+static void IndexTrim( vlc_object_t *p_obj, const char *psz_dir )
+{
+    DIR *dir = vlc_opendir( psz_dir );
+    if( dir == NULL )
+        return;
+
+    index_file_t *p_files = NULL;
+    size_t i_files = 0, i_alloc = 0;
+    const char *psz_name;
+
+    while( (psz_name = vlc_readdir( dir )) != NULL )
+    {
+        size_t i_len = strlen( psz_name );
+        if( i_len < 4 || strcmp( &psz_name[i_len - 4], ".idx" ) )
+            continue;
+
+        char *psz_path;
+        struct stat st;
+        if( asprintf( &psz_path, "%s"DIR_SEP"%s", psz_dir, psz_name ) < 0 )
+            break;
+        if( vlc_stat( psz_path, &st ) )
+        {
+            free( psz_path );
+            continue;
+        }
+
+        if( i_files == i_alloc )
+        {
+            i_alloc = i_alloc ? i_alloc * 2 : 64;
+            index_file_t *p_realloc = realloc( p_files,
+                                               i_alloc * sizeof(*p_files) );
+            if( unlikely(p_realloc == NULL) )
+            {
+                free( psz_path );
+                break;
+            }
+            p_files = p_realloc;
+        }
+        p_files[i_files].psz_path = psz_path;
+        p_files[i_files].i_mtime = st.st_mtime;
+        i_files++;
+    }
+    closedir( dir );
+
+    if( i_files > INDEX_FILES_MAX )
+        qsort( p_files, i_files, sizeof(*p_files), IndexFileCmp );
+
+    for( size_t i = 0; i < i_files; i++ )
+    {
+        if( i >= INDEX_FILES_MAX )
+        {
+            msg_Dbg( p_obj, "removing seek index %s", p_files[i].psz_path );
+            vlc_unlink( p_files[i].psz_path );
+        }
+        free( p_files[i].psz_path );
+    }
+    free( p_files );
+}
+
+static void IndexSave( demux_index_t *p_idx )
+{
+    char *psz_dir = strdup( p_idx->psz_path );
+    if( unlikely(psz_dir == NULL) )
+        return;
+    /* Create the cache directory, then the seekindex one */
+    *strrchr( psz_dir, DIR_SEP_CHAR ) = '\0';
+    char *psz_sep = strrchr( psz_dir, DIR_SEP_CHAR );
+    *psz_sep = '\0';
+    vlc_mkdir( psz_dir, 0700 );
+    *psz_sep = DIR_SEP_CHAR;
+    vlc_mkdir( psz_dir, 0700 );
+
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.tmp", p_idx->psz_path ) < 0 )
+    {
+        free( psz_dir );
+        return;
+    }
+
+    FILE *stream = vlc_fopen( psz_tmp, "wb" );
+    if( stream == NULL )
+    {
+        msg_Warn( p_idx->p_obj, "cannot write seek index %s: %s", psz_tmp,
+                  vlc_strerror_c(errno) );
+        free( psz_tmp );
+        free( psz_dir );
+        return;
+    }
+
+    uint8_t hdr[INDEX_HEADER];
+    memcpy( hdr, INDEX_MAGIC, 8 );
+    SetQWBE( &hdr[8], p_idx->i_size );
+    SetQWBE( &hdr[16], p_idx->i_mtime );
+    SetDWBE( &hdr[24], p_idx->i_points );
+    bool b_error = fwrite( hdr, sizeof(hdr), 1, stream ) != 1;
+
+    for( size_t i = 0; i < p_idx->i_points && !b_error; i++ )
+    {
+        const index_point_t *p = &p_idx->p_points[i];
+        uint8_t entry[INDEX_ENTRY];
+
+        SetDWBE( &entry[0], p->i_track );
+        SetQWBE( &entry[4], p->i_time );
+        SetQWBE( &entry[12], p->i_pos );
+        b_error = fwrite( entry, sizeof(entry), 1, stream ) != 1;
+    }
+
+    if( fclose( stream ) || b_error ||
+        vlc_rename( psz_tmp, p_idx->psz_path ) )
+        vlc_unlink( psz_tmp );
+    else
+    {
+        msg_Dbg( p_idx->p_obj, "saved %zu seek points to %s",
+                 p_idx->i_points, p_idx->psz_path );
+        IndexTrim( p_idx->p_obj, psz_dir );
+    }
+    free( psz_tmp );
+    free( psz_dir );
+}
+
+demux_index_t *demux_IndexOpen( demux_t *p_demux, const char *psz_name )
+{
+    struct stat st;
+
+    if( p_demux->psz_file == NULL ||
+        !var_InheritBool( p_demux, "input-seek-index" ) ||
+        vlc_stat( p_demux->psz_file, &st ) || !S_ISREG( st.st_mode ) )
+        return NULL;
+
+    demux_index_t *p_idx = malloc( sizeof(*p_idx) );
+    if( unlikely(p_idx == NULL) )
+        return NULL;
+
+    p_idx->psz_path = IndexPath( p_demux->psz_file, psz_name );
+    if( p_idx->psz_path == NULL )
+    {
+        free( p_idx );
+        return NULL;
+    }
+    p_idx->p_obj = VLC_OBJECT(p_demux);
+    p_idx->i_size = st.st_size;
+    p_idx->i_mtime = st.st_mtime;
+    p_idx->b_dirty = false;
+    p_idx->i_points = p_idx->i_alloc = 0;
+    p_idx->p_points = NULL;
+
+    IndexLoad( p_idx );
+    return p_idx;
+}
+
+void demux_IndexClose( demux_index_t *p_idx )
+{
+    if( p_idx->b_dirty )
+        IndexSave( p_idx );
+    free( p_idx->p_points );
+    free( p_idx->psz_path );
+    free( p_idx );
+}
+
+void demux_IndexAdd( demux_index_t *p_idx, unsigned i_track,
+                     int64_t i_time, uint64_t i_pos )
+{
+    size_t i = IndexFind( p_idx, i_track, i_time );
+
+    if( i < p_idx->i_points && p_idx->p_points[i].i_track == i_track &&
+        p_idx->p_points[i].i_time == i_time )
+        return; /* Already known */
+    if( p_idx->i_points >= INDEX_MAX )
+        return;
+
+    if( p_idx->i_points == p_idx->i_alloc )
+    {
+        size_t i_alloc = p_idx->i_alloc ? p_idx->i_alloc * 2 : 64;
+        index_point_t *p_points = realloc( p_idx->p_points,
+                                           i_alloc * sizeof(*p_points) );
+        if( unlikely(p_points == NULL) )
+            return;
+        p_idx->p_points = p_points;
+        p_idx->i_alloc = i_alloc;
+    }
+
+    memmove( &p_idx->p_points[i + 1], &p_idx->p_points[i],
+             (p_idx->i_points - i) * sizeof(*p_idx->p_points) );
+    p_idx->p_points[i].i_track = i_track;
+    p_idx->p_points[i].i_time = i_time;
+    p_idx->p_points[i].i_pos = i_pos;
+    p_idx->i_points++;
+    p_idx->b_dirty = true;
+}
+
+int demux_IndexLookup( const demux_index_t *p_idx, unsigned i_track,
+                       int64_t i_time, demux_index_entry_t *p_before,
+                       demux_index_entry_t *p_after )
+{
+    int i_ret = 0;
+
+    /* First point strictly after i_time */
+    size_t i = IndexFind( p_idx, i_track, i_time );
+    if( i < p_idx->i_points && p_idx->p_points[i].i_track == i_track &&
+        p_idx->p_points[i].i_time == i_time )
+        i++;
+
+    if( i > 0 && p_idx->p_points[i - 1].i_track == i_track )
+    {
+        p_before->i_time = p_idx->p_points[i - 1].i_time;
+        p_before->i_pos = p_idx->p_points[i - 1].i_pos;
+        i_ret |= DEMUX_INDEX_BEFORE;
+    }
+    if( p_after != NULL && i < p_idx->i_points &&
+        p_idx->p_points[i].i_track == i_track )
+    {
+        p_after->i_time = p_idx->p_points[i].i_time;
+        p_after->i_pos = p_idx->p_points[i].i_pos;
+        i_ret |= DEMUX_INDEX_AFTER;
+    }
+    return i_ret;
+}
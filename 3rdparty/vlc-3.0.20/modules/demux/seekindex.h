@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * seekindex.h: persistent seek index cache for demuxers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_DEMUX_SEEKINDEX_H
+#define VLC_DEMUX_SEEKINDEX_H
+
+/*
+ * Demuxers of containers without a native index record the time to offset
+ * points they discover while seeking or scanning. The points are kept
+ * sorted in memory and saved in the user cache directory when the demuxer
+ * is closed, so that the next opening of the same local file can seek
+ * without scanning again. A cached index is only reused if the size and
+ * modification time of the file did not change.
+ */
+
+typedef struct demux_index_t demux_index_t;
+
+#define DEMUX_INDEX_MAX 4096 /* points per file, further ones are dropped */
+
+typedef struct
+{
+    int64_t  i_time;  /* in the demuxer own time base */
+    uint64_t i_pos;   /* byte offset in the stream */
+} demux_index_entry_t;
+
+/**
+ * Opens the seek index of the demuxed file, loading the cached points.
+ *
+ * \param psz_name identifies the demuxer and version of the index content
+ * \return NULL if the input is not a local file or on error
+ */
+demux_index_t *demux_IndexOpen( demux_t *p_demux, const char *psz_name );
+
+/**
+ * Saves the index if new points were added, and releases it.
+ */
+void demux_IndexClose( demux_index_t * );
+
+/**
+ * Records a time to offset point of a track.
+ */
+void demux_IndexAdd( demux_index_t *, unsigned i_track,
+                     int64_t i_time, uint64_t i_pos );
+
+/**
+ * Looks up the points of a track surrounding a time.
+ *
+ * \param p_before set to the last point at or before i_time
+ * \param p_after set to the first point after i_time, may be NULL
+ * \return bit 0 set if p_before was found, bit 1 set if p_after was found
+ */
+int demux_IndexLookup( const demux_index_t *, unsigned i_track, int64_t i_time,
+                       demux_index_entry_t *p_before,
+                       demux_index_entry_t *p_after );
+
+#define DEMUX_INDEX_BEFORE 0x1
+#define DEMUX_INDEX_AFTER  0x2
+
+#endif
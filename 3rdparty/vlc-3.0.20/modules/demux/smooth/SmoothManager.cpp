@@ -33,6 +33,7 @@
 #include <vlc_stream.h>
 #include <vlc_demux.h>
 #include <vlc_charset.h>
+#include <cstring>
 #include <time.h>
 
 using namespace adaptive;
@@ -176,7 +177,7 @@ bool SmoothManager::reactivateStream(AbstractStream *stream)
 
 bool SmoothManager::isSmoothStreaming(xml::Node *root)
 {
-    return root->getName() == "SmoothStreamingMedia";
+    return !strcmp(root->getName(), "SmoothStreamingMedia");
 }
 
 bool SmoothManager::mimeMatched(const std::string &mime)
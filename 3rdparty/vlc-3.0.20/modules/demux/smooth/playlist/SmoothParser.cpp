@@ -73,10 +73,11 @@ static SegmentTimeline *createTimeline(Node *streamIndexNode)
             const Node *chunk = *it;
              /* Detect repeats, as r attribute only has been added in late smooth */
             bool b_cur_is_repeat = true; /* If our current chunk has repeated previous content */
+            const char *value;
 
-            if(chunk->hasAttribute("n"))
+            if((value = chunk->getAttributeView("n")))
             {
-                cur.number = Integer<uint64_t>(chunk->getAttributeValue("n"));
+                cur.number = Integer<uint64_t>(value);
                 b_cur_is_repeat &= (cur.number == prev.number + 1 + prev.repeat);
             }
             else
@@ -84,25 +85,27 @@ static SegmentTimeline *createTimeline(Node *streamIndexNode)
                 cur.number = prev.number + prev.repeat + 1;
             }
 
-            if(chunk->hasAttribute("d"))
+            if((value = chunk->getAttributeView("d")))
             {
-                cur.duration = Integer<uint64_t>(chunk->getAttributeValue("d"));
+                cur.duration = Integer<uint64_t>(value);
                 b_cur_is_repeat &= (cur.duration == prev.duration);
             }
             else
             {
-                if(it != chunks.end())
+                if(it + 1 != chunks.end())
                 {
                     const Node *nextchunk = *(it + 1);
-                    cur.duration = Integer<uint64_t>(nextchunk->getAttributeValue("t"))
-                                 - Integer<uint64_t>(chunk->getAttributeValue("t"));
+                    const char *nextt = nextchunk->getAttributeView("t");
+                    const char *t = chunk->getAttributeView("t");
+                    cur.duration = Integer<uint64_t>(nextt ? nextt : "")
+                                 - Integer<uint64_t>(t ? t : "");
                     b_cur_is_repeat &= (cur.duration == prev.duration);
                 }
             }
 
-            if(chunk->hasAttribute("t"))
+            if((value = chunk->getAttributeView("t")))
             {
-                cur.time = Integer<uint64_t>(chunk->getAttributeValue("t"));
+                cur.time = Integer<uint64_t>(value);
                 b_cur_is_repeat &= (cur.time == prev.time + (prev.duration * (prev.repeat + 1)));
             }
             else
@@ -111,9 +114,9 @@ static SegmentTimeline *createTimeline(Node *streamIndexNode)
             }
 
             uint64_t explicit_repeat_count = 0;
-            if(chunk->hasAttribute("r"))
+            if((value = chunk->getAttributeView("r")))
             {
-                explicit_repeat_count = Integer<uint64_t>(chunk->getAttributeValue("r"));
+                explicit_repeat_count = Integer<uint64_t>(value);
                 /* #segments = repeat count ! as MS has a really broken notion of repetition */
                 if(explicit_repeat_count > 0)
                     explicit_repeat_count -= 1;
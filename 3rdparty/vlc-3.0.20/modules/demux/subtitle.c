@@ -118,15 +118,19 @@ enum subtitle_type_e
     SUB_TYPE_SCC,      /* Scenarist Closed Caption */
 };
 
+/* Lines are read from the stream as the parsers need them. The last returned
+ * line stays valid until the next TextGetLine() call. */
 typedef struct
 {
-    size_t  i_line_count;
-    size_t  i_line;
-    char    **line;
+    stream_t *s;
+    char    *psz_line;    /* last returned line */
+    char    *psz_next;    /* line read ahead by TextIsEOF() */
+    bool    b_next;       /* psz_next is set (NULL at end of stream) */
+    bool    b_previous;   /* return psz_line again */
 } text_t;
 
-static int  TextLoad( text_t *, stream_t *s );
-static void TextUnload( text_t * );
+static void TextInit( text_t *, stream_t *s );
+static void TextClean( text_t * );
 
 typedef struct
 {
@@ -177,9 +181,10 @@ struct demux_sys_t
 
     struct
     {
-        subtitle_t *p_array;
+        subtitle_t *p_array;  /* sorted by start time */
         size_t      i_count;
         size_t      i_current;
+        int64_t    *p_end_max; /* running maximum of the cue ends */
     } subtitles;
 
     int64_t     i_length;
@@ -246,7 +251,8 @@ static const struct
 static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
-static void Fix( demux_t * );
+static int  Fix( demux_t * );
+static size_t SubtitleFind( const demux_sys_t *, int64_t );
 static char * get_language_from_filename( const char * );
 
 /*****************************************************************************
@@ -328,6 +334,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
     p_sys->subtitles.p_array  = NULL;
+    p_sys->subtitles.p_end_max = NULL;
 
     p_sys->props.psz_header         = NULL;
     p_sys->props.i_microsecperframe = 40000;
@@ -652,20 +659,20 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Load the whole file */
+    /* Parse the file in a single pass */
     text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    TextInit( &txtlines, p_demux->s );
 
-    /* Parse it */
-    for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
+    for( size_t i_max = 0; i_max < SIZE_MAX / 2 / sizeof(subtitle_t); )
     {
         if( p_sys->subtitles.i_count >= i_max )
         {
-            i_max += 500;
-            subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
+            i_max = i_max ? i_max * 2 : 500;
+            subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array,
+                                             sizeof(subtitle_t) * i_max );
             if( p_realloc == NULL )
             {
-                TextUnload( &txtlines );
+                TextClean( &txtlines );
                 Close( p_this );
                 return VLC_ENOMEM;
             }
@@ -679,23 +686,26 @@ static int Open ( vlc_object_t *p_this )
 
         p_sys->subtitles.i_count++;
     }
-    /* Unload */
-    TextUnload( &txtlines );
+    TextClean( &txtlines );
 
     msg_Dbg(p_demux, "loaded %zu subtitles", p_sys->subtitles.i_count );
 
     /* Fix subtitle (order and time) *** */
+    if( Fix( p_demux ) )
+    {
+        Close( p_this );
+        return VLC_ENOMEM;
+    }
     p_sys->subtitles.i_current = 0;
     p_sys->i_length = 0;
     if( p_sys->subtitles.i_count > 0 )
-        p_sys->i_length = p_sys->subtitles.p_array[p_sys->subtitles.i_count-1].i_stop;
+        p_sys->i_length = p_sys->subtitles.p_end_max[p_sys->subtitles.i_count-1];
 
     /* *** add subtitle ES *** */
     if( p_sys->props.i_type == SUB_TYPE_SSA1 ||
              p_sys->props.i_type == SUB_TYPE_SSA2_4 ||
              p_sys->props.i_type == SUB_TYPE_ASS )
     {
-        Fix( p_demux );
         es_format_Init( &fmt, SPU_ES, VLC_CODEC_SSA );
     }
     else if( p_sys->props.i_type == SUB_TYPE_SCC )
@@ -749,6 +759,7 @@ static void Close( vlc_object_t *p_this )
     for( size_t i = 0; i < p_sys->subtitles.i_count; i++ )
         free( p_sys->subtitles.p_array[i].psz_text );
     free( p_sys->subtitles.p_array );
+    free( p_sys->subtitles.p_end_max );
     free( p_sys->props.psz_header );
 
     free( p_sys );
@@ -785,12 +796,8 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             i64 = va_arg( args, int64_t );
             p_sys->b_first_time = true;
             p_sys->i_next_demux_date = i64;
-            for( size_t i = 0; i < p_sys->subtitles.i_count; i++ )
-            {
-                if( p_sys->subtitles.p_array[i].i_start > i64 && i > 0 )
-                    break;
-                p_sys->subtitles.i_current = i;
-            }
+            if( p_sys->subtitles.i_count > 0 )
+                p_sys->subtitles.i_current = SubtitleFind( p_sys, i64 );
             return VLC_SUCCESS;
 
         case DEMUX_GET_POSITION:
@@ -899,80 +906,130 @@ static int subtitle_cmp( const void *first, const void *second )
      * as result can be > INT_MAX */
     return result == 0 ? 0 : result > 0 ? 1 : -1;
 }
+static int64_t subtitle_end( const subtitle_t *p_subtitle )
+{
+    /* Cues without a valid end last until the next one */
+    return __MAX( p_subtitle->i_start, p_subtitle->i_stop );
+}
+
 /*****************************************************************************
- * Fix: fix time stamp and order of subtitle
+ * Fix: fix order of subtitle and build the seek index
  *****************************************************************************/
-static void Fix( demux_t *p_demux )
+static int Fix( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
+    subtitle_t *p_array = p_sys->subtitles.p_array;
+    const size_t i_count = p_sys->subtitles.i_count;
 
     /* *** fix order (to be sure...) *** */
-    qsort( p_sys->subtitles.p_array, p_sys->subtitles.i_count, sizeof( p_sys->subtitles.p_array[0] ), subtitle_cmp);
-}
+    for( size_t i = 1; i < i_count; i++ )
+    {
+        if( p_array[i].i_start < p_array[i - 1].i_start )
+        {
+            qsort( p_array, i_count, sizeof( *p_array ), subtitle_cmp );
+            break;
+        }
+    }
 
-static int TextLoad( text_t *txt, stream_t *s )
-{
-    size_t i_line_max;
-
-    /* init txt */
-    i_line_max          = 500;
-    txt->i_line_count   = 0;
-    txt->i_line         = 0;
-    txt->line           = calloc( i_line_max, sizeof( char * ) );
-    if( !txt->line )
+    /* Cues can overlap: the running maximum of their ends tells from which
+     * cue on something may still be displayed at a given time */
+    if( i_count == 0 )
+        return VLC_SUCCESS;
+    int64_t *p_end_max = vlc_alloc( i_count, sizeof( *p_end_max ) );
+    if( unlikely(p_end_max == NULL) )
         return VLC_ENOMEM;
 
-    /* load the complete file */
-    for( ;; )
-    {
-        char *psz = vlc_stream_ReadLine( s );
+    p_end_max[0] = subtitle_end( &p_array[0] );
+    for( size_t i = 1; i < i_count; i++ )
+        p_end_max[i] = __MAX( p_end_max[i - 1], subtitle_end( &p_array[i] ) );
+    p_sys->subtitles.p_end_max = p_end_max;
+    return VLC_SUCCESS;
+}
 
-        if( psz == NULL )
-            break;
+/*****************************************************************************
+ * SubtitleFind: first cue to demux to display the subtitles of i_time
+ *****************************************************************************/
+static size_t SubtitleFind( const demux_sys_t *p_sys, int64_t i_time )
+{
+    const subtitle_t *p_array = p_sys->subtitles.p_array;
+    size_t lo = 0, hi = p_sys->subtitles.i_count;
 
-        txt->line[txt->i_line_count] = psz;
-        if( txt->i_line_count + 1 >= i_line_max )
-        {
-            i_line_max += 100;
-            char **p_realloc = realloc( txt->line, i_line_max * sizeof( char * ) );
-            if( p_realloc == NULL )
-                return VLC_ENOMEM;
-            txt->line = p_realloc;
-        }
-        txt->i_line_count++;
+    /* Cues starting at or before i_time */
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_array[mid].i_start <= i_time )
+            lo = mid + 1;
+        else
+            hi = mid;
     }
 
-    if( txt->i_line_count == 0 )
+    /* First of them still displayed at i_time, else the next cue */
+    hi = lo;
+    lo = 0;
+    while( lo < hi )
     {
-        free( txt->line );
-        return VLC_EGENERIC;
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_sys->subtitles.p_end_max[mid] <= i_time )
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    return lo;
+}
 
-    return VLC_SUCCESS;
+static void TextInit( text_t *txt, stream_t *s )
+{
+    txt->s          = s;
+    txt->psz_line   = NULL;
+    txt->psz_next   = NULL;
+    txt->b_next     = false;
+    txt->b_previous = false;
 }
-static void TextUnload( text_t *txt )
+
+static void TextClean( text_t *txt )
 {
-    if( txt->i_line_count )
-    {
-        for( size_t i = 0; i < txt->i_line_count; i++ )
-            free( txt->line[i] );
-        free( txt->line );
-    }
-    txt->i_line       = 0;
-    txt->i_line_count = 0;
+    free( txt->psz_line );
+    free( txt->psz_next );
+    TextInit( txt, txt->s );
 }
 
 static char *TextGetLine( text_t *txt )
 {
-    if( txt->i_line >= txt->i_line_count )
-        return( NULL );
+    if( txt->b_previous )
+    {
+        txt->b_previous = false;
+        return txt->psz_line;
+    }
 
-    return txt->line[txt->i_line++];
+    free( txt->psz_line );
+    if( txt->b_next )
+    {
+        txt->psz_line = txt->psz_next;
+        txt->psz_next = NULL;
+        txt->b_next = false;
+    }
+    else
+        txt->psz_line = vlc_stream_ReadLine( txt->s );
+    return txt->psz_line;
 }
+
 static void TextPreviousLine( text_t *txt )
 {
-    if( txt->i_line > 0 )
-        txt->i_line--;
+    if( txt->psz_line != NULL )
+        txt->b_previous = true;
+}
+
+static bool TextIsEOF( text_t *txt )
+{
+    if( txt->b_previous )
+        return false;
+    if( !txt->b_next )
+    {
+        txt->psz_next = vlc_stream_ReadLine( txt->s );
+        txt->b_next = true;
+    }
+    return txt->psz_next == NULL;
 }
 
 /*****************************************************************************
@@ -1641,7 +1698,7 @@ static int ParseAQT(vlc_object_t *p_obj, subs_properties_t *p_props, text_t *txt
                  return VLC_ENOMEM;
             strcat( psz_text, s );
             strcat( psz_text, "\n" );
-            if( txt->i_line == txt->i_line_count )
+            if( TextIsEOF( txt ) )
                 break;
         }
     }
@@ -513,6 +513,11 @@ static int Control( stream_extractor_t* p_extractor, int i_query, va_list args )
             *va_arg( args, uint64_t* ) = archive_entry_size( p_sys->p_entry );
             break;
 
+        /* Offsets within the entry are not offsets within the source */
+        case STREAM_GET_MAPPED_BLOCK:
+        case STREAM_SET_READAHEAD:
+            return VLC_EGENERIC;
+
         default:
             return vlc_stream_vaControl( p_extractor->source, i_query, args );
     }
@@ -45,6 +45,9 @@ vlc_module_end()
 
 static int Control( stream_t *p_stream, int i_query, va_list args )
 {
+    /* The data is modified by Read() */
+    if( i_query == STREAM_GET_MAPPED_BLOCK )
+        return VLC_EGENERIC;
     return vlc_stream_vaControl( p_stream->p_source, i_query, args );
 }
 
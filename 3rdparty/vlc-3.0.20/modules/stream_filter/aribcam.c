@@ -244,6 +244,9 @@ static int Seek( stream_t *p_stream, uint64_t i_pos )
  */
 static int Control( stream_t *p_stream, int i_query, va_list args )
 {
+    /* The data is modified by Read() */
+    if( i_query == STREAM_GET_MAPPED_BLOCK )
+        return VLC_EGENERIC;
     return vlc_stream_vaControl( p_stream->p_source, i_query, args );
 }
 
@@ -127,6 +127,9 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_GET_TITLE_INFO:
         case STREAM_GET_TITLE:
         case STREAM_GET_SEEKPOINT:
+        case STREAM_GET_MAPPED_BLOCK:
+        case STREAM_GET_READAHEAD_STATS:
+        case STREAM_SET_READAHEAD:
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
         case STREAM_SET_PRIVATE_ID_STATE:
@@ -379,6 +379,8 @@ static int Control(stream_t *stream, int query, va_list args)
             return VLC_SUCCESS;
         case STREAM_GET_SIGNAL:
         case STREAM_GET_TAGS:
+        case STREAM_GET_MAPPED_BLOCK:
+        case STREAM_GET_READAHEAD_STATS:
             return VLC_EGENERIC;
         case STREAM_SET_PAUSE_STATE:
         {
@@ -392,6 +394,7 @@ static int Control(stream_t *stream, int query, va_list args)
         }
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
+        case STREAM_SET_READAHEAD:
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
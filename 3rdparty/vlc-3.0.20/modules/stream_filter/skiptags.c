@@ -186,6 +186,27 @@ static int Control(stream_t *stream, int query, va_list args)
             *va_arg(args, uint64_t *) = size - sys->header_skip;
         return i_ret;
     }
+    else if(query == STREAM_GET_MAPPED_BLOCK)
+    {
+        uint64_t offset = va_arg(args, uint64_t);
+        size_t size = va_arg(args, size_t);
+        block_t **pp_block = va_arg(args, block_t **);
+
+        if (unlikely(offset + sys->header_skip < offset))
+            return VLC_EGENERIC;
+        return vlc_stream_Control(stream->p_source, query,
+                                  sys->header_skip + offset, size, pp_block);
+    }
+    else if(query == STREAM_SET_READAHEAD)
+    {
+        uint64_t offset = va_arg(args, uint64_t);
+        uint64_t size = va_arg(args, uint64_t);
+
+        if (unlikely(offset + sys->header_skip < offset))
+            return VLC_EGENERIC;
+        return vlc_stream_Control(stream->p_source, query,
+                                  sys->header_skip + offset, size);
+    }
 
     return vlc_stream_vaControl(stream->p_source, query, args);
 }
@@ -53,6 +53,7 @@
 #include "resource.h"
 
 #include "../video_output/vout_control.h"
+#include "../misc/tracer.h"
 
 /*
  * Possibles values set in p_owner->reload atomic
@@ -1126,6 +1127,8 @@ static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
     unsigned i_lost = 0;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    vlc_trace_instant( "decoder output", p_pic->date );
+
     int ret = DecoderPlayVideo( p_dec, p_pic, &i_lost );
 
     p_owner->pf_update_stat( p_owner, 1, i_lost );
@@ -1245,6 +1248,8 @@ static int DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
     unsigned lost = 0;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    vlc_trace_instant( "decoder output", p_aout_buf->i_pts );
+
     int ret = DecoderPlayAudio( p_dec, p_aout_buf, &lost );
 
     p_owner->pf_update_stat( p_owner, 1, lost );
@@ -1341,8 +1346,17 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block );
 static void DecoderDecode( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
+#ifdef ENABLE_TRACING
+    vlc_tick_t date = VLC_TICK_INVALID;
+
+    if( p_block != NULL )
+        date = p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts
+                                                  : p_block->i_dts;
+#endif
 
+    vlc_trace_begin( "decode", date );
     int ret = p_dec->pf_decode( p_dec, p_block );
+    vlc_trace_end( "decode", date );
     switch( ret )
     {
         case VLCDEC_SUCCESS:
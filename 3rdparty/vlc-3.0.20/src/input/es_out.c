@@ -49,6 +49,7 @@
 #include "item.h"
 
 #include "../stream_output/stream_output.h"
+#include "../misc/tracer.h"
 
 #include <vlc_iso_lang.h>
 /* FIXME we should find a better way than including that */
@@ -2043,6 +2044,8 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     assert( p_block->p_next == NULL );
 
+    vlc_trace_instant( "demux packet", p_block->i_dts );
+
     if( libvlc_stats( p_input ) )
     {
         uint64_t i_total;
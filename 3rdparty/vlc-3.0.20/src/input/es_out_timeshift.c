@@ -37,6 +37,14 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#endif
+#ifdef _WIN32
+#  include <fcntl.h>
+#  include <io.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -161,19 +169,40 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Backing shared by all the storages of a timeshift thread */
+typedef struct
+{
+    const char *psz_tmp_path;
+    int64_t    i_mem_max;   /* Max size in bytes of the blocks kept in memory */
+    int64_t    i_mem_size;  /* Size in bytes reserved by the memory storages */
+
+    /* Spill file, split in slots of i_slot_size bytes */
+    int        fd;          /* -1 until a storage is spilled */
+#ifdef _WIN32
+    char       *psz_file;   /* Filename */
+#endif
+    size_t     i_slot_size;
+    unsigned   i_slots;
+    bool       *pb_slot_used;
+
+    /* Statistics */
+    uint64_t   i_mem_blocks;
+    uint64_t   i_spill_blocks;
+} ts_pool_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
     ts_storage_t *p_next;
+    ts_pool_t    *p_pool;
 
     /* */
-#ifdef _WIN32
-    char    *psz_file;  /* Filename */
+    int     i_slot;     /* Spill file slot, or -1 if blocks are kept in memory */
+#ifdef HAVE_MMAP
+    uint8_t *p_map;     /* Mapping of the slot */
 #endif
     size_t  i_file_max; /* Max size in bytes */
     int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
 
     /* */
     int      i_cmd_r;
@@ -187,8 +216,6 @@ typedef struct
     vlc_thread_t   thread;
     input_thread_t *p_input;
     es_out_t       *p_out;
-    int64_t        i_tmp_size_max;
-    const char     *psz_tmp_path;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -208,6 +235,7 @@ typedef struct
     vlc_tick_t     i_buffering_delay;
 
     /* */
+    ts_pool_t      pool;
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
 
@@ -227,6 +255,7 @@ struct es_out_sys_t
 
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    int64_t        i_mem_max;         /* Maximal memory used in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -266,13 +295,20 @@ static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static void         TsPoolClean( input_thread_t *, ts_pool_t * );
+
+static ts_storage_t *TsStorageNew( ts_pool_t * );
 static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStorageWrite( ts_storage_t *, size_t i_offset, const void *, size_t );
+static int          TsStorageRead( ts_storage_t *, size_t i_offset, void *, size_t );
+
+static int          TsPoolGetSlot( ts_pool_t *, ts_storage_t * );
+static void         TsPoolPutSlot( ts_pool_t *, ts_storage_t * );
 
 static void CmdClean( ts_cmd_t * );
 static void cmd_cleanup_routine( void *p ) { CmdClean( p ); }
@@ -344,6 +380,9 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    p_sys->i_mem_max = var_InheritInteger( p_input, "input-timeshift-memory" )
+                       * 1024 * 1024;
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -788,8 +827,11 @@ static int TsStart( es_out_t *p_out )
     if( !p_ts )
         return VLC_EGENERIC;
 
-    p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
-    p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->pool.psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->pool.i_mem_max = p_sys->i_mem_max;
+    p_ts->pool.fd = -1;
+    /* Slots are mapped independently: keep them page aligned */
+    p_ts->pool.i_slot_size = (p_sys->i_tmp_size_max + 0xffff) & ~0xffff;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -848,6 +890,7 @@ static void TsStop( ts_thread_t *p_ts )
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
     if( p_ts->p_storage_r )
         TsStorageDelete( p_ts->p_storage_r );
+    TsPoolClean( p_ts->p_input, &p_ts->pool );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -858,7 +901,7 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = TsStorageNew( &p_ts->pool );
 
         if( !p_storage )
         {
@@ -881,7 +924,7 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
     }
 
     /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    TsStoragePushCmd( p_ts->p_storage_w, p_cmd );
 
     vlc_cond_signal( &p_ts->wait );
 
@@ -1102,46 +1145,34 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static ts_storage_t *TsStorageNew( ts_pool_t *p_pool )
 {
     ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
     if( unlikely(p_storage == NULL) )
         return NULL;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
-    {
-        free( p_storage );
-        return NULL;
-    }
+    p_storage->p_next = NULL;
+    p_storage->p_pool = p_pool;
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
+    /* Keep the blocks in memory as long as the budget allows it, and only
+     * spill them to the temporary file afterwards */
+    const int64_t i_mem_free = p_pool->i_mem_max - p_pool->i_mem_size;
+    if( i_mem_free >= 1*1024*1024 )
     {
-        vlc_close( fd );
-        vlc_unlink( psz_file );
-        goto error;
+        p_storage->i_slot = -1;
+        p_storage->i_file_max = __MIN( (size_t)i_mem_free, p_pool->i_slot_size );
+        p_pool->i_mem_size += p_storage->i_file_max;
     }
-
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
+    else
     {
-        fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
-        goto error;
+        p_storage->i_slot = TsPoolGetSlot( p_pool, p_storage );
+        if( p_storage->i_slot < 0 )
+        {
+            free( p_storage );
+            return NULL;
+        }
+        p_storage->i_file_max = p_pool->i_slot_size;
     }
-
-#ifndef _WIN32
-    vlc_unlink( psz_file );
-    free( psz_file );
-#else
-    p_storage->psz_file = psz_file;
-#endif
-    p_storage->p_next = NULL;
-
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
     p_storage->i_file_size = 0;
 
     /* */
@@ -1149,7 +1180,6 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     p_storage->i_cmd_r = 0;
     p_storage->i_cmd_max = 30000;
     p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
     if( !p_storage->p_cmd )
     {
@@ -1157,10 +1187,6 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
     return p_storage;
-error:
-    free( psz_file );
-    free( p_storage );
-    return NULL;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1175,12 +1201,10 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
-#ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
-#endif
+    if( p_storage->i_slot >= 0 )
+        TsPoolPutSlot( p_storage->p_pool, p_storage );
+    else
+        p_storage->p_pool->i_mem_size -= p_storage->i_file_max;
     free( p_storage );
 }
 
@@ -1211,7 +1235,7 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     ts_cmd_t cmd = *p_cmd;
 
@@ -1220,29 +1244,38 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
+        const size_t i_size = sizeof(*p_block) + p_block->i_buffer;
 
-        cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        if( p_storage->i_slot < 0 )
+        {
+            /* The block itself is kept, without any copy */
+            p_storage->i_file_size += i_size;
+            p_storage->p_pool->i_mem_blocks++;
+            p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+            return;
+        }
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        /* A block larger than the slot cannot be spilled */
+        if( p_storage->i_file_size + i_size > p_storage->i_file_max )
         {
             block_Release( p_block );
             return;
         }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
+
+        cmd.u.send.p_block = NULL;
+        cmd.u.send.i_offset = p_storage->i_file_size;
+
+        if( TsStorageWrite( p_storage, cmd.u.send.i_offset,
+                            p_block, sizeof(*p_block) ) ||
+            TsStorageWrite( p_storage, cmd.u.send.i_offset + sizeof(*p_block),
+                            p_block->p_buffer, p_block->i_buffer ) )
         {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
+            block_Release( p_block );
+            return;
         }
-        p_storage->i_file_size += p_block->i_buffer;
+        p_storage->i_file_size += i_size;
+        p_storage->p_pool->i_spill_blocks++;
         block_Release( p_block );
-
-        if( b_flush )
-            fflush( p_storage->p_filew );
     }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
@@ -1251,13 +1284,13 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    if( p_cmd->i_type == C_SEND && p_storage->i_slot >= 0 )
     {
         block_t block;
 
         if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+            !TsStorageRead( p_storage, p_cmd->u.send.i_offset,
+                            &block, sizeof(block) ) )
         {
             block_t *p_block = block_Alloc( block.i_buffer );
             if( p_block )
@@ -1267,18 +1300,160 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
                 p_block->i_flags    = block.i_flags;
                 p_block->i_length   = block.i_length;
                 p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+                if( TsStorageRead( p_storage,
+                                   p_cmd->u.send.i_offset + sizeof(block),
+                                   p_block->p_buffer, block.i_buffer ) )
+                    p_block->i_buffer = 0;
             }
             p_cmd->u.send.p_block = p_block;
         }
         else
         {
-            //perror( "TsStoragePopCmd" );
             p_cmd->u.send.p_block = block_Alloc( 1 );
         }
     }
 }
 
+static int TsStorageWrite( ts_storage_t *p_storage, size_t i_offset,
+                           const void *p_data, size_t i_size )
+{
+    assert( i_offset + i_size <= p_storage->i_file_max );
+#ifdef HAVE_MMAP
+    memcpy( &p_storage->p_map[i_offset], p_data, i_size );
+    return VLC_SUCCESS;
+#else
+    const ts_pool_t *p_pool = p_storage->p_pool;
+    const off_t i_pos = (off_t)p_storage->i_slot * p_pool->i_slot_size + i_offset;
+
+    if( lseek( p_pool->fd, i_pos, SEEK_SET ) != i_pos )
+        return VLC_EGENERIC;
+    while( i_size > 0 )
+    {
+        ssize_t i_ret = write( p_pool->fd, p_data, i_size );
+        if( i_ret <= 0 )
+            return VLC_EGENERIC;
+        p_data = (const uint8_t *)p_data + i_ret;
+        i_size -= i_ret;
+    }
+    return VLC_SUCCESS;
+#endif
+}
+static int TsStorageRead( ts_storage_t *p_storage, size_t i_offset,
+                          void *p_data, size_t i_size )
+{
+    if( i_offset + i_size > (size_t)p_storage->i_file_size )
+        return VLC_EGENERIC;
+#ifdef HAVE_MMAP
+    memcpy( p_data, &p_storage->p_map[i_offset], i_size );
+    return VLC_SUCCESS;
+#else
+    const ts_pool_t *p_pool = p_storage->p_pool;
+    const off_t i_pos = (off_t)p_storage->i_slot * p_pool->i_slot_size + i_offset;
+
+    if( lseek( p_pool->fd, i_pos, SEEK_SET ) != i_pos )
+        return VLC_EGENERIC;
+    while( i_size > 0 )
+    {
+        ssize_t i_ret = read( p_pool->fd, p_data, i_size );
+        if( i_ret <= 0 )
+            return VLC_EGENERIC;
+        p_data = (uint8_t *)p_data + i_ret;
+        i_size -= i_ret;
+    }
+    return VLC_SUCCESS;
+#endif
+}
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+static int TsPoolGetSlot( ts_pool_t *p_pool, ts_storage_t *p_storage )
+{
+    if( p_pool->fd == -1 )
+    {
+        char *psz_file;
+
+        p_pool->fd = GetTmpFile( &psz_file, p_pool->psz_tmp_path );
+        if( p_pool->fd == -1 )
+            return -1;
+#ifndef _WIN32
+        vlc_unlink( psz_file );
+        free( psz_file );
+#else
+        setmode( p_pool->fd, O_BINARY );
+        p_pool->psz_file = psz_file;
+#endif
+    }
+
+    unsigned i_slot = 0;
+    while( i_slot < p_pool->i_slots && p_pool->pb_slot_used[i_slot] )
+        i_slot++;
+
+    if( i_slot == p_pool->i_slots )
+    {
+        /* Grow the file by one slot */
+        bool *pb_used = realloc( p_pool->pb_slot_used,
+                                 (p_pool->i_slots + 1) * sizeof(*pb_used) );
+        if( unlikely(pb_used == NULL) )
+            return -1;
+        p_pool->pb_slot_used = pb_used;
+#ifdef HAVE_MMAP
+        /* Reserve the disk blocks now: a mapped page that cannot be written
+         * back for lack of space would raise SIGBUS instead of an error */
+        const off_t i_size = (off_t)(p_pool->i_slots + 1) * p_pool->i_slot_size;
+# if defined(_POSIX_ADVISORY_INFO) && _POSIX_ADVISORY_INFO > 0
+        if( posix_fallocate( p_pool->fd, i_size - p_pool->i_slot_size,
+                             p_pool->i_slot_size ) )
+            return -1;
+# else
+        if( ftruncate( p_pool->fd, i_size ) )
+            return -1;
+# endif
+#endif
+        pb_used[p_pool->i_slots++] = false;
+    }
+
+#ifdef HAVE_MMAP
+    void *p_map = mmap( NULL, p_pool->i_slot_size, PROT_READ|PROT_WRITE,
+                        MAP_SHARED, p_pool->fd,
+                        (off_t)i_slot * p_pool->i_slot_size );
+    if( p_map == MAP_FAILED )
+        return -1;
+    p_storage->p_map = p_map;
+#else
+    VLC_UNUSED(p_storage);
+#endif
+    p_pool->pb_slot_used[i_slot] = true;
+    return i_slot;
+}
+static void TsPoolPutSlot( ts_pool_t *p_pool, ts_storage_t *p_storage )
+{
+    assert( p_pool->pb_slot_used[p_storage->i_slot] );
+#ifdef HAVE_MMAP
+    munmap( p_storage->p_map, p_pool->i_slot_size );
+#endif
+    p_pool->pb_slot_used[p_storage->i_slot] = false;
+}
+static void TsPoolClean( input_thread_t *p_input, ts_pool_t *p_pool )
+{
+    assert( p_pool->i_mem_size == 0 );
+
+    if( p_pool->i_mem_blocks > 0 || p_pool->i_spill_blocks > 0 )
+        msg_Dbg( p_input, "timeshift stored %"PRIu64" blocks in memory and "
+                 "%"PRIu64" blocks in %u file slots", p_pool->i_mem_blocks,
+                 p_pool->i_spill_blocks, p_pool->i_slots );
+
+    free( p_pool->pb_slot_used );
+    if( p_pool->fd != -1 )
+    {
+        vlc_close( p_pool->fd );
+#ifdef _WIN32
+        vlc_unlink( p_pool->psz_file );
+        free( p_pool->psz_file );
+#endif
+    }
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -39,6 +39,7 @@
 #include "event.h"
 #include "es_out.h"
 #include "es_out_timeshift.h"
+#include "../misc/tracer.h"
 #include "demux.h"
 #include "item.h"
 #include "resource.h"
@@ -575,7 +576,11 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed )
     }
 
     if( i_ret == VLC_DEMUXER_SUCCESS )
+    {
+        vlc_trace_begin( "demux", VLC_TICK_INVALID );
         i_ret = demux_Demux( p_demux );
+        vlc_trace_end( "demux", VLC_TICK_INVALID );
+    }
 
     i_ret = i_ret > 0 ? VLC_DEMUXER_SUCCESS : ( i_ret < 0 ? VLC_DEMUXER_EGENERIC : VLC_DEMUXER_EOF);
 
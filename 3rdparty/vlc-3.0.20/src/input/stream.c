@@ -52,6 +52,7 @@ typedef struct stream_priv_t
     block_t *peek;
     uint64_t offset;
     bool eof;
+    bool seek_pending; /* the source lags behind offset (mapped blocks) */
 
     /* UTF-16 and UTF-32 file reading */
     struct {
@@ -89,6 +90,7 @@ stream_t *vlc_stream_CommonNew(vlc_object_t *parent,
     priv->peek = NULL;
     priv->offset = 0;
     priv->eof = false;
+    priv->seek_pending = false;
 
     /* UTF16 and UTF32 text file conversion */
     priv->text.conv = (vlc_iconv_t)(-1);
@@ -384,6 +386,23 @@ static ssize_t vlc_stream_CopyBlock(block_t **restrict pp,
     return likely(len > 0) ? (ssize_t)len : -1;
 }
 
+/**
+ * Moves the source to the stream offset, if mapped blocks were taken since
+ * the source was last accessed.
+ */
+static int vlc_stream_SyncSource(stream_t *s)
+{
+    stream_priv_t *priv = (stream_priv_t *)s;
+
+    if (likely(!priv->seek_pending))
+        return VLC_SUCCESS;
+
+    int ret = s->pf_seek(s, priv->offset);
+    if (ret == VLC_SUCCESS)
+        priv->seek_pending = false;
+    return ret;
+}
+
 static ssize_t vlc_stream_ReadRaw(stream_t *s, void *buf, size_t len)
 {
     stream_priv_t *priv = (stream_priv_t *)s;
@@ -394,6 +413,9 @@ static ssize_t vlc_stream_ReadRaw(stream_t *s, void *buf, size_t len)
     if (vlc_killed())
         return 0;
 
+    if (vlc_stream_SyncSource(s) != VLC_SUCCESS)
+        return 0;
+
     if (s->pf_read != NULL)
     {
         assert(priv->block == NULL);
@@ -547,6 +569,11 @@ block_t *vlc_stream_ReadBlock(stream_t *s)
         block = priv->block;
         priv->block = NULL;
     }
+    else if (vlc_stream_SyncSource(s) != VLC_SUCCESS)
+    {
+        priv->eof = true;
+        return NULL;
+    }
     else if (s->pf_block != NULL)
     {
         priv->eof = false;
@@ -631,6 +658,7 @@ int vlc_stream_Seek(stream_t *s, uint64_t offset)
         return ret;
 
     priv->offset = offset;
+    priv->seek_pending = false;
 
     if (peek != NULL)
     {
@@ -666,6 +694,7 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
                 return ret;
 
             priv->offset = 0;
+            priv->seek_pending = false;
 
             if (priv->peek != NULL)
             {
@@ -685,6 +714,9 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
     return s->pf_control(s, cmd, args);
 }
 
+/* Smaller reads are cheaper to copy than to reference */
+#define STREAM_MAPPED_MIN 4096
+
 /**
  * Read data into a block.
  *
@@ -693,13 +725,42 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
  * @return a block of data, or NULL on error
  @ note The block size may be shorter than requested if the end-of-stream was
  * reached.
+ * @note Large blocks may reference the stream data in place, without copy
+ * (see STREAM_GET_MAPPED_BLOCK).
  */
 block_t *vlc_stream_Block( stream_t *s, size_t size )
 {
+    stream_priv_t *priv = (stream_priv_t *)s;
+
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
-    block_t *block = block_Alloc( size );
+    block_t *block;
+
+    if( size >= STREAM_MAPPED_MIN )
+    {   /* Reference the data in place if the source can (local files) */
+        uint64_t offset = vlc_stream_Tell( s );
+
+        if( vlc_stream_Control( s, STREAM_GET_MAPPED_BLOCK, offset, size,
+                                &block ) == VLC_SUCCESS )
+        {
+            if( priv->peek == NULL && priv->block == NULL
+             && s->pf_seek != NULL )
+            {   /* Nothing buffered: only seek the source (through all the
+                 * stream filters) when it is read from again, so that
+                 * consecutive mapped blocks do not seek at all. */
+                priv->offset += block->i_buffer;
+                priv->eof = false;
+                priv->seek_pending = true;
+                return block;
+            }
+            if( vlc_stream_Seek( s, offset + block->i_buffer ) == VLC_SUCCESS )
+                return block;
+            block_Release( block );
+        }
+    }
+
+    block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
 
@@ -112,8 +112,11 @@ static int Control( stream_t *s, int i_query, va_list args )
         case STREAM_GET_META:
         case STREAM_GET_CONTENT_TYPE:
         case STREAM_GET_SIGNAL:
+        case STREAM_GET_MAPPED_BLOCK:
+        case STREAM_GET_READAHEAD_STATS:
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
+        case STREAM_SET_READAHEAD:
             return VLC_EGENERIC;
 
         case STREAM_SET_PAUSE_STATE:
@@ -480,6 +480,12 @@ static const char *const ppsz_pos_descriptions[] =
     "This avoids flooding the message log with debug output from the " \
     "video output synchronization mechanism.")
 
+#define PICTURE_CACHE_TEXT N_("Picture buffer cache size (MiB)")
+#define PICTURE_CACHE_LONGTEXT N_( \
+    "Released picture buffers are kept up to this size and reused by " \
+    "pictures of the same size, e.g. when the video resolution switches " \
+    "back and forth. 0 disables the cache.")
+
 #define KEYBOARD_EVENTS_TEXT N_("Key press events")
 #define KEYBOARD_EVENTS_LONGTEXT N_( \
     "This enables VLC hotkeys from the (non-embedded) video window." )
@@ -647,6 +653,12 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define INPUT_SEEK_INDEX_TEXT N_("Cache seek indexes")
+#define INPUT_SEEK_INDEX_LONGTEXT N_( \
+    "Keep the seek points found in local files without an index in the " \
+    "user cache directory, so that later seeks in the same files are faster. " \
+    "This leaves a trace of the played files." )
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -683,8 +695,13 @@ static const char *const ppsz_prefres[] = {
 
 #define INPUT_TIMESHIFT_GRANULARITY_TEXT N_("Timeshift granularity")
 #define INPUT_TIMESHIFT_GRANULARITY_LONGTEXT N_( \
-    "This is the maximum size in bytes of the temporary files " \
-    "that will be used to store the timeshifted streams." )
+    "This is the size in bytes of the chunks, in memory or in the " \
+    "temporary file, that will be used to store the timeshifted streams." )
+
+#define INPUT_TIMESHIFT_MEMORY_TEXT N_("Timeshift memory (MiB)")
+#define INPUT_TIMESHIFT_MEMORY_LONGTEXT N_( \
+    "Amount of memory used to keep timeshifted streams before they are " \
+    "spilled to the temporary file. Set to 0 to always use the file." )
 
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
@@ -1038,6 +1055,24 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Log messages are queued in a bounded ring and written to the log " \
+    "by a background thread, so that slow log outputs do not delay the " \
+    "emitting threads. Messages are dropped if the ring is full, and " \
+    "messages above the --verbose or --log-verbose level are dropped " \
+    "before they are formatted.")
+
+#define LOG_ASYNC_RECORDS_TEXT N_("Asynchronous log ring size")
+#define LOG_ASYNC_RECORDS_LONGTEXT N_( \
+    "Maximum number of log messages pending in the asynchronous log ring " \
+    "(rounded up to a power of two).")
+
+#define TRACE_FILE_TEXT N_("Pipeline trace file")
+#define TRACE_FILE_LONGTEXT N_( \
+    "Records demux, decoder, filter and display events, and writes them " \
+    "to this file in the Chrome trace event format on exit.")
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1568,6 +1603,9 @@ vlc_module_begin ()
               SKIP_FRAMES_LONGTEXT, true )
     add_bool( "quiet-synchro", 0, QUIET_SYNCHRO_TEXT,
               QUIET_SYNCHRO_LONGTEXT, true )
+    add_integer( "picture-cache-size", 64,
+                 PICTURE_CACHE_TEXT, PICTURE_CACHE_LONGTEXT, true )
+        change_integer_range( 0, 4096 )
     add_bool( "keyboard-events", true, KEYBOARD_EVENTS_TEXT,
               KEYBOARD_EVENTS_LONGTEXT, true )
     add_bool( "mouse-events", true, MOUSE_EVENTS_TEXT,
@@ -1767,6 +1805,8 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_bool( "input-seek-index", false,
+              INPUT_SEEK_INDEX_TEXT, INPUT_SEEK_INDEX_LONGTEXT, true )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -1927,6 +1967,9 @@ vlc_module_begin ()
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-memory", 64, INPUT_TIMESHIFT_MEMORY_TEXT,
+                 INPUT_TIMESHIFT_MEMORY_LONGTEXT, true )
+        change_integer_range( 0, 4096 )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2058,6 +2101,18 @@ vlc_module_begin ()
               HPRIORITY_LONGTEXT, false )
 #endif
 
+    add_bool( "log-async", false, LOG_ASYNC_TEXT,
+              LOG_ASYNC_LONGTEXT, true )
+    add_integer_with_range( "log-async-records", 1024, 16, 65536,
+                            LOG_ASYNC_RECORDS_TEXT, LOG_ASYNC_RECORDS_LONGTEXT,
+                            true )
+
+#ifdef ENABLE_TRACING
+    add_savefile( "trace-file", NULL, TRACE_FILE_TEXT, TRACE_FILE_LONGTEXT,
+                  true )
+        change_volatile()
+#endif
+
 #define CLOCK_SOURCE_TEXT N_("Clock source")
 #ifdef _WIN32
     add_string( "clock-source", NULL, CLOCK_SOURCE_TEXT, CLOCK_SOURCE_TEXT, true )
@@ -66,6 +66,8 @@
 #include "libvlc.h"
 #include "playlist/playlist_internal.h"
 #include "misc/variables.h"
+#include "misc/picture.h"
+#include "misc/tracer.h"
 
 #include <vlc_vlm.h>
 
@@ -93,6 +95,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv = libvlc_priv (p_libvlc);
     priv->playlist = NULL;
     priv->p_vlm = NULL;
+    priv->picture_arena = false;
 
     vlc_ExitInit( &priv->exit );
 
@@ -163,6 +166,12 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     vlc_LogInit(p_libvlc);
 
+    picture_arena_Hold(
+        (size_t)var_InheritInteger( p_libvlc, "picture-cache-size" ) << 20 );
+    priv->picture_arena = true;
+
+    vlc_trace_Init( p_libvlc );
+
     /*
      * Support for gettext
      */
@@ -418,6 +427,21 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
 
     libvlc_InternalActionsClean( p_libvlc );
 
+    vlc_trace_Deinit( p_libvlc );
+
+    if( priv->picture_arena )
+    {
+        picture_arena_stats_t arena;
+
+        picture_arena_GetStats( &arena );
+        msg_Dbg( p_libvlc, "picture buffers: %"PRIu64" recycled, %"PRIu64
+                 " allocated, %"PRIu64" evicted, %"PRIu64" dropped, %zu bytes"
+                 " peak", arena.hits, arena.misses, arena.evictions,
+                 arena.drops, arena.peak );
+        picture_arena_Release();
+        priv->picture_arena = false;
+    }
+
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
@@ -41,8 +41,11 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
+typedef struct vlc_logger_async_t vlc_logger_async_t;
+
 struct vlc_logger_t
 {
     VLC_COMMON_MEMBERS
@@ -50,8 +53,13 @@ struct vlc_logger_t
     vlc_log_cb log;
     void *sys;
     module_t *module;
+    vlc_logger_async_t *async; /**< Ring (with the lock held) */
+    atomic_int threshold; /**< Most verbose message type passed on */
 };
 
+static void vlc_vaLogAsync(vlc_logger_async_t *, int, const vlc_log_t *,
+                           const char *, va_list);
+
 static void vlc_vaLogCallback(libvlc_int_t *vlc, int type,
                               const vlc_log_t *item, const char *format,
                               va_list ap)
@@ -93,6 +101,18 @@ void vlc_vaLog (vlc_object_t *obj, int type, const char *module,
     if (obj != NULL && obj->obj.flags & OBJECT_FLAGS_QUIET)
         return;
 
+    vlc_logger_t *logger = NULL;
+    if (obj != NULL)
+    {
+        logger = libvlc_priv(obj->obj.libvlc)->logger;
+        assert(logger != NULL);
+
+        /* Before anything is formatted or queued */
+        if (type > atomic_load_explicit(&logger->threshold,
+                                        memory_order_relaxed))
+            return;
+    }
+
     /* Get basename from the module filename */
     char *p = strrchr(module, '/');
     if (p != NULL)
@@ -136,8 +156,20 @@ void vlc_vaLog (vlc_object_t *obj, int type, const char *module,
 #endif
 
     /* Pass message to the callback */
-    if (obj != NULL)
-        vlc_vaLogCallback(obj->obj.libvlc, type, &msg, format, args);
+    if (logger != NULL)
+    {
+        vlc_rwlock_rdlock(&logger->lock);
+        if (logger->async != NULL)
+        {
+            vlc_vaLogAsync(logger->async, type, &msg, format, args);
+            vlc_rwlock_unlock(&logger->lock);
+        }
+        else
+        {
+            vlc_rwlock_unlock(&logger->lock);
+            vlc_vaLogCallback(obj->obj.libvlc, type, &msg, format, args);
+        }
+    }
 }
 
 /**
@@ -292,6 +324,253 @@ static void vlc_vaLogDiscard(void *d, int type, const vlc_log_t *item,
     (void) d; (void) type; (void) item; (void) format; (void) ap;
 }
 
+/*** Asynchronous logging ***/
+
+#define LOG_ASYNC_MODULE_MAX 32
+#define LOG_ASYNC_HEADER_MAX 64
+#define LOG_ASYNC_TEXT_MAX 256
+
+/**
+ * Fixed-size log record.
+ *
+ * The message is formatted by the emitting thread into the record, since
+ * the format arguments (e.g. strings) may not outlive the vlc_Log() call.
+ * Longer messages are truncated.
+ */
+typedef struct
+{
+    atomic_size_t seq; /**< Ring sequence number of the record */
+    int type;
+    vlc_log_t meta;
+    char module[LOG_ASYNC_MODULE_MAX];
+    char header[LOG_ASYNC_HEADER_MAX];
+    char text[LOG_ASYNC_TEXT_MAX];
+} vlc_log_record_t;
+
+/**
+ * Bounded lock-free ring of log records.
+ *
+ * Emitting threads claim records with a compare-and-swap on the head counter
+ * and never block: if the ring is full, the message is dropped and counted.
+ * A background thread drains the records in order and passes them to the
+ * configured logger. Other threads can drain the ring too, in order to flush
+ * it (see vlc_LogAsyncFlush()).
+ */
+struct vlc_logger_async_t
+{
+    vlc_logger_t *logger;
+    vlc_thread_t thread;
+    vlc_sem_t wait;
+    vlc_mutex_t lock; /**< Serializes draining */
+    atomic_bool stop;
+    atomic_size_t head; /**< Next record to claim */
+    size_t tail; /**< Next record to drain (with the lock held) */
+    size_t mask;
+    atomic_uint dropped; /**< Dropped messages not reported yet */
+    uint64_t total_dropped; /**< Dropped messages (with the lock held) */
+    vlc_log_record_t records[];
+};
+
+static void vlc_vaLogAsync(vlc_logger_async_t *async, int type,
+                           const vlc_log_t *item, const char *format,
+                           va_list ap)
+{
+    size_t pos = atomic_load_explicit(&async->head, memory_order_relaxed);
+    vlc_log_record_t *rec;
+
+    for (;;)
+    {
+        rec = &async->records[pos & async->mask];
+
+        size_t seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&async->head, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {   /* Ring full: never stall the emitting thread */
+            atomic_fetch_add_explicit(&async->dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        }
+        else
+            pos = atomic_load_explicit(&async->head, memory_order_relaxed);
+    }
+
+    rec->type = type;
+    rec->meta = *item;
+    strlcpy(rec->module, item->psz_module, sizeof (rec->module));
+    rec->meta.psz_module = rec->module;
+    if (item->psz_header != NULL)
+    {
+        strlcpy(rec->header, item->psz_header, sizeof (rec->header));
+        rec->meta.psz_header = rec->header;
+    }
+    if (vsnprintf(rec->text, sizeof (rec->text), format, ap) < 0)
+        strcpy(rec->text, "message lost");
+
+    atomic_store_explicit(&rec->seq, pos + 1, memory_order_release);
+    vlc_sem_post(&async->wait);
+}
+
+static void vlc_LogAsyncDrain(vlc_logger_async_t *async)
+{
+    vlc_logger_t *logger = async->logger;
+    libvlc_int_t *vlc = logger->obj.libvlc;
+
+    for (;;)
+    {
+        vlc_log_record_t *rec = &async->records[async->tail & async->mask];
+
+        /* Stop at the first record not published yet (if any). Its emitter
+         * will post the semaphore once it is done. */
+        if (atomic_load_explicit(&rec->seq, memory_order_acquire)
+             != async->tail + 1)
+            break;
+
+        vlc_LogCallback(vlc, rec->type, &rec->meta, "%s", rec->text);
+
+        atomic_store_explicit(&rec->seq, async->tail + async->mask + 1,
+                              memory_order_release);
+        async->tail++;
+    }
+
+    unsigned dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                                memory_order_relaxed);
+    if (dropped > 0)
+    {
+        vlc_log_t meta = {
+            .i_object_id = (uintptr_t)logger,
+            .psz_object_type = "logger",
+            .psz_module = "core",
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .tid = vlc_thread_id(),
+        };
+
+        async->total_dropped += dropped;
+        vlc_LogCallback(vlc, VLC_MSG_WARN, &meta,
+                        "%u log message(s) dropped (ring full)", dropped);
+    }
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    vlc_logger_async_t *async = data;
+
+    do
+    {
+        vlc_sem_wait(&async->wait);
+        vlc_mutex_lock(&async->lock);
+        vlc_LogAsyncDrain(async);
+        vlc_mutex_unlock(&async->lock);
+    }
+    while (!atomic_load(&async->stop));
+
+    return NULL;
+}
+
+/**
+ * Passes the messages queued so far to the logger before returning.
+ */
+static void vlc_LogAsyncFlush(vlc_logger_t *logger)
+{
+    vlc_logger_async_t *async = logger->async;
+
+    vlc_mutex_lock(&async->lock);
+    vlc_LogAsyncDrain(async);
+    vlc_mutex_unlock(&async->lock);
+}
+
+/**
+ * Most verbose message type that the log outputs may show, according to
+ * --verbose (or VLC_VERBOSE) and to the file logger own --log-verbose.
+ */
+static int vlc_LogAsyncThreshold(vlc_object_t *obj)
+{
+    const char *str = getenv("VLC_VERBOSE");
+    int verbosity = (str != NULL) ? atoi(str)
+                                  : var_InheritInteger(obj, "verbose");
+
+    if (config_GetType("log-verbose"))
+        verbosity = __MAX(verbosity, var_InheritInteger(obj, "log-verbose"));
+    return VLC_MSG_ERR + __MAX(verbosity, -1);
+}
+
+static void vlc_LogAsyncStart(vlc_logger_t *logger, int64_t count)
+{
+    size_t size = 16;
+
+    while (size < (uint64_t)count && size < 65536)
+        size <<= 1;
+
+    vlc_logger_async_t *async = malloc(sizeof (*async)
+                                       + size * sizeof (async->records[0]));
+    if (unlikely(async == NULL))
+        return;
+
+    vlc_sem_init(&async->wait, 0);
+    vlc_mutex_init(&async->lock);
+    atomic_init(&async->stop, false);
+    atomic_init(&async->head, 0);
+    async->tail = 0;
+    async->mask = size - 1;
+    atomic_init(&async->dropped, 0);
+    async->total_dropped = 0;
+    for (size_t i = 0; i < size; i++)
+        atomic_init(&async->records[i].seq, i);
+    async->logger = logger;
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_mutex_destroy(&async->lock);
+        vlc_sem_destroy(&async->wait);
+        free(async);
+        return;
+    }
+
+    vlc_rwlock_wrlock(&logger->lock);
+    logger->async = async;
+    vlc_rwlock_unlock(&logger->lock);
+    atomic_store(&logger->threshold,
+                 vlc_LogAsyncThreshold(VLC_OBJECT(logger)));
+
+    msg_Dbg(logger, "asynchronous logging with %zu records of %zu bytes",
+            size, sizeof (async->records[0]));
+}
+
+static void vlc_LogAsyncStop(vlc_logger_t *logger)
+{
+    vlc_logger_async_t *async = logger->async;
+
+    /* Back to synchronous logging, then flush what is left */
+    vlc_rwlock_wrlock(&logger->lock);
+    logger->async = NULL;
+    vlc_rwlock_unlock(&logger->lock);
+    atomic_store(&logger->threshold, VLC_MSG_DBG);
+
+    atomic_store(&async->stop, true);
+    vlc_sem_post(&async->wait);
+    vlc_join(async->thread, NULL);
+    vlc_LogAsyncDrain(async);
+
+    if (async->total_dropped > 0)
+        msg_Warn(logger, "%"PRIu64" log message(s) dropped in total",
+                 async->total_dropped);
+
+    vlc_mutex_destroy(&async->lock);
+    vlc_sem_destroy(&async->wait);
+    free(async);
+}
+
 static int vlc_logger_load(void *func, va_list ap)
 {
     vlc_log_cb (*activate)(vlc_object_t *, void **) = func;
@@ -330,6 +609,8 @@ int vlc_LogPreinit(libvlc_int_t *vlc)
         return -1;
 
     vlc_rwlock_init(&logger->lock);
+    logger->async = NULL;
+    atomic_init(&logger->threshold, VLC_MSG_DBG);
 
     if (vlc_LogEarlyOpen(logger))
     {
@@ -379,6 +660,9 @@ int vlc_LogInit(libvlc_int_t *vlc)
     if (early_sys != NULL)
         vlc_LogEarlyClose(logger, early_sys);
 
+    if (var_InheritBool(vlc, "log-async"))
+        vlc_LogAsyncStart(logger, var_InheritInteger(vlc, "log-async-records"));
+
     return 0;
 }
 
@@ -400,6 +684,11 @@ void vlc_LogSet(libvlc_int_t *vlc, vlc_log_cb cb, void *opaque)
     if (cb == NULL)
         cb = vlc_vaLogDiscard;
 
+    /* Messages logged so far go to the previous logger, as in synchronous
+     * mode: the caller may tear its callback data down after this. */
+    if (logger->async != NULL)
+        vlc_LogAsyncFlush(logger);
+
     vlc_rwlock_wrlock(&logger->lock);
     sys = logger->sys;
     module = logger->module;
@@ -408,6 +697,8 @@ void vlc_LogSet(libvlc_int_t *vlc, vlc_log_cb cb, void *opaque)
     logger->sys = opaque;
     logger->module = NULL;
     vlc_rwlock_unlock(&logger->lock);
+    /* The callback filters the messages itself */
+    atomic_store(&logger->threshold, VLC_MSG_DBG);
 
     if (module != NULL)
         vlc_module_unload(vlc, module, vlc_logger_unload, sys);
@@ -426,6 +717,9 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
     if (unlikely(logger == NULL))
         return;
 
+    if (logger->async != NULL)
+        vlc_LogAsyncStop(logger);
+
     if (logger->module != NULL)
         vlc_module_unload(vlc, logger->module, vlc_logger_unload, logger->sys);
     else
@@ -71,12 +71,13 @@ static int AllocatePicture( picture_t *p_pic )
     }
 
     i_bytes = (i_bytes + 63) & ~63; /* must be a multiple of 64 */
-    uint8_t *p_data = aligned_alloc( 64, i_bytes );
+    uint8_t *p_data = picture_arena_Alloc( i_bytes );
     if( i_bytes > 0 && p_data == NULL )
     {
         p_pic->i_planes = 0;
         return VLC_EGENERIC;
     }
+    ((picture_priv_t *)p_pic)->size = i_bytes;
 
     /* Fill the p_pixels field for each plane */
     p_pic->p[0].p_pixels = p_data;
@@ -119,7 +120,9 @@ static void picture_DestroyFromResource( picture_t *p_picture )
  */
 static void picture_Destroy( picture_t *p_picture )
 {
-    aligned_free( p_picture->p[0].p_pixels );
+    picture_priv_t *priv = (picture_priv_t *)p_picture;
+
+    picture_arena_Free( p_picture->p[0].p_pixels, priv->size );
     free( p_picture );
 }
 
@@ -242,6 +245,7 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
 
     atomic_init( &priv->gc.refs, 1 );
     priv->gc.opaque = NULL;
+    priv->size = 0;
 
     if( p_resource )
     {
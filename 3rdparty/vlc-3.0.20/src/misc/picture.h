@@ -30,4 +30,46 @@ typedef struct
         void (*destroy)(picture_t *);
         void *opaque;
     } gc;
+    size_t size; /**< Size of the pixels allocation (if any) */
 } picture_priv_t;
+
+/** Default upper bound of the picture buffer arena (bytes) */
+#define PICTURE_ARENA_DEFAULT_LIMIT (64 << 20) /* see "picture-cache-size" */
+
+typedef struct
+{
+    uint64_t hits; /**< Allocations served from the arena */
+    uint64_t misses; /**< Allocations served from the heap */
+    uint64_t evictions; /**< Cached buffers freed to make room */
+    uint64_t drops; /**< Released buffers not cached, as over the limit */
+    size_t cached; /**< Bytes currently held by the arena */
+    size_t peak; /**< High-water mark of the held bytes */
+} picture_arena_stats_t;
+
+/**
+ * Allocates a 64-bytes aligned pixel buffer, preferably recycling a buffer
+ * of the same size from the arena.
+ * \param size buffer size in bytes (multiple of 64)
+ */
+void *picture_arena_Alloc(size_t size);
+
+/**
+ * Returns a buffer from picture_arena_Alloc() to the arena, or frees it if
+ * the arena is full.
+ */
+void picture_arena_Free(void *, size_t size);
+
+/**
+ * Registers a user (LibVLC instance) of the arena.
+ * The first user sets the maximum number of bytes held by the arena (0
+ * disables it); the limit is ignored for the other users.
+ */
+void picture_arena_Hold(size_t limit);
+
+/**
+ * Unregisters a user of the arena. The last user frees all the buffers held
+ * by the arena; buffers returned afterwards are freed directly.
+ */
+void picture_arena_Release(void);
+
+void picture_arena_GetStats(picture_arena_stats_t *);
@@ -0,0 +1,265 @@
+/*****************************************************************************
+ * picture_arena.c : recycling of picture pixel buffers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include "picture.h"
+
+/*
+ * Pixel buffers of released pictures are kept in per-size LIFO lists, so
+ * that pools created again with a recently used format (e.g. when adaptive
+ * streaming switches back and forth between representations) do not hit the
+ * heap and fault fresh pages in. The cache is bounded by a byte limit; when
+ * it is exceeded, the least recently used sizes are evicted first.
+ *
+ * The arena is shared by all the LibVLC instances of the process: the first
+ * instance sets the limit, and the last one flushes the cache. From then on,
+ * and until an instance holds it again, buffers are freed directly.
+ */
+
+#define ARENA_ALIGN   64
+#define ARENA_BUCKETS 8
+
+struct arena_buffer
+{
+    struct arena_buffer *next; /* stored in the cached buffer itself */
+};
+
+struct arena_bucket
+{
+    size_t size; /* buffer size in bytes, 0 if the bucket is unused */
+    struct arena_buffer *head;
+    unsigned count;
+    uint64_t last_use;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned users;
+    bool released; /* by its last user */
+    size_t limit;
+    uint64_t clock;
+    picture_arena_stats_t stats;
+    struct arena_bucket buckets[ARENA_BUCKETS];
+} arena = {
+    .lock = VLC_STATIC_MUTEX,
+    .limit = PICTURE_ARENA_DEFAULT_LIMIT,
+};
+
+static struct arena_bucket *BucketFind(size_t size)
+{
+    for (unsigned i = 0; i < ARENA_BUCKETS; i++)
+        if (arena.buckets[i].size == size)
+            return &arena.buckets[i];
+    return NULL;
+}
+
+/**
+ * Empties a bucket, moving its buffers to a list to free without the lock.
+ */
+static void BucketEvict(struct arena_bucket *b, struct arena_buffer **list)
+{
+    while (b->head != NULL)
+    {
+        struct arena_buffer *buf = b->head;
+
+        b->head = buf->next;
+        buf->next = *list;
+        *list = buf;
+        arena.stats.cached -= b->size;
+        arena.stats.evictions++;
+    }
+    b->size = 0;
+    b->count = 0;
+}
+
+/**
+ * Finds the least recently used bucket, other than the given one.
+ */
+static struct arena_bucket *BucketLRU(const struct arena_bucket *except)
+{
+    struct arena_bucket *lru = NULL;
+
+    for (unsigned i = 0; i < ARENA_BUCKETS; i++)
+    {
+        struct arena_bucket *b = &arena.buckets[i];
+
+        if (b == except || b->size == 0)
+            continue;
+        if (lru == NULL || b->last_use < lru->last_use)
+            lru = b;
+    }
+    return lru;
+}
+
+static void FreeList(struct arena_buffer *list)
+{
+    while (list != NULL)
+    {
+        struct arena_buffer *next = list->next;
+
+        aligned_free(list);
+        list = next;
+    }
+}
+
+void *picture_arena_Alloc(size_t size)
+{
+    assert((size % ARENA_ALIGN) == 0);
+
+    if (size < sizeof (struct arena_buffer))
+        return aligned_alloc(ARENA_ALIGN, size);
+
+    vlc_mutex_lock(&arena.lock);
+
+    struct arena_bucket *b = BucketFind(size);
+    if (b != NULL && b->head != NULL)
+    {
+        struct arena_buffer *buf = b->head;
+
+        b->head = buf->next;
+        b->count--;
+        b->last_use = ++arena.clock;
+        arena.stats.cached -= size;
+        arena.stats.hits++;
+        vlc_mutex_unlock(&arena.lock);
+        return buf;
+    }
+
+    arena.stats.misses++;
+    vlc_mutex_unlock(&arena.lock);
+    return aligned_alloc(ARENA_ALIGN, size);
+}
+
+void picture_arena_Free(void *data, size_t size)
+{
+    struct arena_buffer *evicted = NULL;
+
+    if (data == NULL)
+        return;
+    if (size < sizeof (struct arena_buffer))
+    {
+        aligned_free(data);
+        return;
+    }
+
+    vlc_mutex_lock(&arena.lock);
+    if (arena.released || arena.limit == 0)
+    {   /* Not caching */
+        vlc_mutex_unlock(&arena.lock);
+        aligned_free(data);
+        return;
+    }
+    if (size > arena.limit)
+        goto drop;
+
+    struct arena_bucket *b = BucketFind(size);
+    if (b == NULL)
+    {
+        b = BucketFind(0);
+        if (b == NULL)
+        {   /* No free bucket: recycle the least recently used size */
+            b = BucketLRU(NULL);
+            BucketEvict(b, &evicted);
+        }
+        b->size = size;
+    }
+
+    while (arena.stats.cached + size > arena.limit)
+    {
+        struct arena_bucket *lru = BucketLRU(b);
+
+        if (lru == NULL)
+        {
+            if (b->head == NULL)
+                b->size = 0;
+            goto drop;
+        }
+        BucketEvict(lru, &evicted);
+    }
+
+    struct arena_buffer *buf = data;
+
+    buf->next = b->head;
+    b->head = buf;
+    b->count++;
+    b->last_use = ++arena.clock;
+    arena.stats.cached += size;
+    if (arena.stats.cached > arena.stats.peak)
+        arena.stats.peak = arena.stats.cached;
+    vlc_mutex_unlock(&arena.lock);
+
+    FreeList(evicted);
+    return;
+
+drop:
+    arena.stats.drops++;
+    vlc_mutex_unlock(&arena.lock);
+    FreeList(evicted);
+    aligned_free(data);
+}
+
+void picture_arena_Hold(size_t limit)
+{
+    struct arena_buffer *evicted = NULL;
+
+    vlc_mutex_lock(&arena.lock);
+    if (arena.users++ == 0)
+    {
+        arena.released = false;
+        arena.limit = limit;
+        for (struct arena_bucket *b = BucketLRU(NULL);
+             b != NULL && arena.stats.cached > limit; b = BucketLRU(NULL))
+            BucketEvict(b, &evicted);
+    }
+    vlc_mutex_unlock(&arena.lock);
+
+    FreeList(evicted);
+}
+
+void picture_arena_Release(void)
+{
+    struct arena_buffer *evicted = NULL;
+
+    vlc_mutex_lock(&arena.lock);
+    assert(arena.users > 0);
+    if (--arena.users == 0)
+    {
+        for (unsigned i = 0; i < ARENA_BUCKETS; i++)
+            BucketEvict(&arena.buckets[i], &evicted);
+        arena.released = true;
+    }
+    vlc_mutex_unlock(&arena.lock);
+
+    FreeList(evicted);
+}
+
+void picture_arena_GetStats(picture_arena_stats_t *stats)
+{
+    vlc_mutex_lock(&arena.lock);
+    *stats = arena.stats;
+    vlc_mutex_unlock(&arena.lock);
+}
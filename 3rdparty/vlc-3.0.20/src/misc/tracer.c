@@ -0,0 +1,295 @@
+/*****************************************************************************
+ * tracer.c: pipeline trace points and Chrome trace exporter
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef ENABLE_TRACING
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
+#include "../libvlc.h"
+#include "tracer.h"
+
+#define TRACE_EVENTS 65536 /* per thread */
+
+struct vlc_trace_event
+{
+    const char *name;
+    vlc_tick_t date;
+    int64_t arg;
+    char phase;
+};
+
+/**
+ * Per-thread event buffer.
+ *
+ * Only the owner thread writes events, and resets the buffer on its first
+ * event of a tracing session; it publishes the session, then the events by
+ * incrementing count, with release semantics, so that the exporter can read
+ * the published events without locking.
+ */
+struct vlc_trace_buffer
+{
+    struct vlc_trace_buffer *next;
+    unsigned long tid;
+    bool retired; /**< Owner thread has exited (protected by tracer.lock) */
+    atomic_uint session; /**< Session of the events */
+    atomic_uint count; /**< Published events */
+    atomic_uint dropped; /**< Events lost because the buffer was full */
+    struct vlc_trace_event events[TRACE_EVENTS];
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_threadvar_t key;
+    bool key_created;
+    atomic_bool enabled;
+    atomic_uint session; /**< Incremented by each vlc_trace_Init() */
+    libvlc_int_t *owner;
+    char *path;
+    struct vlc_trace_buffer *buffers;
+} tracer = {
+    .lock = VLC_STATIC_MUTEX,
+    .enabled = ATOMIC_VAR_INIT(false),
+    .session = ATOMIC_VAR_INIT(0),
+};
+
+/* Whether the events of the buffer are to be written by vlc_trace_Deinit() */
+static bool vlc_trace_IsCurrent(const struct vlc_trace_buffer *buf)
+{
+    return tracer.owner != NULL
+        && atomic_load_explicit(&buf->session, memory_order_acquire)
+           == atomic_load_explicit(&tracer.session, memory_order_relaxed);
+}
+
+static void vlc_trace_Retire(void *data)
+{
+    struct vlc_trace_buffer *buf = data;
+
+    vlc_mutex_lock(&tracer.lock);
+    if (vlc_trace_IsCurrent(buf))
+        buf->retired = true; /* freed once written */
+    else
+    {
+        struct vlc_trace_buffer **pp = &tracer.buffers;
+
+        while (*pp != buf)
+            pp = &(*pp)->next;
+        *pp = buf->next;
+        free(buf);
+    }
+    vlc_mutex_unlock(&tracer.lock);
+}
+
+static struct vlc_trace_buffer *vlc_trace_GetBuffer(unsigned session)
+{
+    struct vlc_trace_buffer *buf = vlc_threadvar_get(tracer.key);
+    if (likely(buf != NULL))
+    {
+        if (atomic_load_explicit(&buf->session,
+                                 memory_order_relaxed) != session)
+        {   /* First event of this session */
+            atomic_store_explicit(&buf->count, 0, memory_order_relaxed);
+            atomic_store_explicit(&buf->dropped, 0, memory_order_relaxed);
+            atomic_store_explicit(&buf->session, session,
+                                  memory_order_release);
+        }
+        return buf;
+    }
+
+    buf = malloc(sizeof (*buf));
+    if (unlikely(buf == NULL))
+        return NULL;
+
+    buf->tid = vlc_thread_id();
+    buf->retired = false;
+    atomic_init(&buf->session, session);
+    atomic_init(&buf->count, 0);
+    atomic_init(&buf->dropped, 0);
+
+    if (vlc_threadvar_set(tracer.key, buf))
+    {
+        free(buf);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&tracer.lock);
+    buf->next = tracer.buffers;
+    tracer.buffers = buf;
+    vlc_mutex_unlock(&tracer.lock);
+    return buf;
+}
+
+void vlc_trace_Event(const char *name, char phase, int64_t arg)
+{
+    if (!atomic_load_explicit(&tracer.enabled, memory_order_relaxed))
+        return;
+
+    unsigned session = atomic_load_explicit(&tracer.session,
+                                            memory_order_relaxed);
+    struct vlc_trace_buffer *buf = vlc_trace_GetBuffer(session);
+    if (unlikely(buf == NULL))
+        return;
+
+    unsigned i = atomic_load_explicit(&buf->count, memory_order_relaxed);
+    if (unlikely(i >= TRACE_EVENTS))
+    {
+        atomic_fetch_add_explicit(&buf->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    struct vlc_trace_event *ev = &buf->events[i];
+
+    ev->name = name;
+    ev->date = mdate();
+    ev->arg = arg;
+    ev->phase = phase;
+    atomic_store_explicit(&buf->count, i + 1, memory_order_release);
+}
+
+void vlc_trace_Init(libvlc_int_t *vlc)
+{
+    char *path = var_InheritString(vlc, "trace-file");
+    if (path == NULL)
+        return;
+
+    vlc_mutex_lock(&tracer.lock);
+    if (tracer.owner != NULL)
+    {
+        vlc_mutex_unlock(&tracer.lock);
+        msg_Warn(vlc, "already tracing to %s, ignoring %s", tracer.path, path);
+        free(path);
+        return;
+    }
+
+    if (!tracer.key_created)
+    {   /* The key is never deleted: traced threads may outlive LibVLC */
+        if (vlc_threadvar_create(&tracer.key, vlc_trace_Retire))
+        {
+            vlc_mutex_unlock(&tracer.lock);
+            free(path);
+            return;
+        }
+        tracer.key_created = true;
+    }
+
+    /* The buffers of running threads are reset by their owner */
+    atomic_fetch_add(&tracer.session, 1);
+    tracer.owner = vlc;
+    tracer.path = path;
+    atomic_store(&tracer.enabled, true);
+    vlc_mutex_unlock(&tracer.lock);
+
+    msg_Dbg(vlc, "tracing pipeline events to %s", path);
+}
+
+static void vlc_trace_Write(FILE *stream, const struct vlc_trace_buffer *buf,
+                            unsigned count, bool *first)
+{
+    const int pid = getpid();
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const struct vlc_trace_event *ev = &buf->events[i];
+
+        fprintf(stream, "%s\n{\"name\":\"%s\",\"cat\":\"vlc\",\"ph\":\"%c\","
+                "\"ts\":%"PRId64",\"pid\":%d,\"tid\":%lu",
+                *first ? "" : ",", ev->name, ev->phase, ev->date, pid,
+                buf->tid);
+        if (ev->phase == 'i')
+            fputs(",\"s\":\"t\"", stream);
+        if (ev->arg != VLC_TICK_INVALID)
+            fprintf(stream, ",\"args\":{\"ts\":%"PRId64"}", ev->arg);
+        fputc('}', stream);
+        *first = false;
+    }
+}
+
+void vlc_trace_Deinit(libvlc_int_t *vlc)
+{
+    vlc_mutex_lock(&tracer.lock);
+    if (tracer.owner != vlc)
+    {
+        vlc_mutex_unlock(&tracer.lock);
+        return;
+    }
+
+    atomic_store(&tracer.enabled, false);
+
+    FILE *stream = vlc_fopen(tracer.path, "wt");
+    if (stream == NULL)
+        msg_Err(vlc, "cannot write trace file %s: %s", tracer.path,
+                vlc_strerror_c(errno));
+    else
+        fputs("{\"traceEvents\":[", stream);
+
+    unsigned long long total = 0, dropped = 0;
+    bool first = true;
+
+    for (struct vlc_trace_buffer **pp = &tracer.buffers, *buf; (buf = *pp);)
+    {
+        if (vlc_trace_IsCurrent(buf))
+        {   /* Otherwise, no events in this session */
+            unsigned count = atomic_load_explicit(&buf->count,
+                                                  memory_order_acquire);
+
+            if (stream != NULL)
+                vlc_trace_Write(stream, buf, count, &first);
+            total += count;
+            dropped += atomic_load(&buf->dropped);
+        }
+
+        if (buf->retired)
+        {   /* Owner thread is gone: nobody references the buffer anymore */
+            *pp = buf->next;
+            free(buf);
+        }
+        else
+            pp = &buf->next;
+    }
+
+    if (stream != NULL)
+    {
+        fputs("\n],\"displayTimeUnit\":\"ms\"}\n", stream);
+        if (fclose(stream))
+            msg_Err(vlc, "cannot write trace file %s: %s", tracer.path,
+                    vlc_strerror_c(errno));
+        else
+            msg_Dbg(vlc, "wrote %llu trace events to %s", total, tracer.path);
+    }
+    if (dropped > 0)
+        msg_Warn(vlc, "%llu trace events dropped (buffers full)", dropped);
+
+    free(tracer.path);
+    tracer.path = NULL;
+    tracer.owner = NULL;
+    vlc_mutex_unlock(&tracer.lock);
+}
+
+#endif /* ENABLE_TRACING */
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * tracer.h: pipeline trace points
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_TRACER_H
+# define LIBVLC_TRACER_H 1
+
+/**
+ * \defgroup tracer Pipeline tracing
+ * \ingroup misc
+ *
+ * Trace points record timestamped events into per-thread buffers, without
+ * locking. When the "trace-file" option is set, the events are written to
+ * that file in the Chrome trace event format (viewable with Perfetto or
+ * chrome://tracing) when the LibVLC instance is cleaned up.
+ *
+ * Trace points are only compiled if VLC is configured with --enable-tracing.
+ * Otherwise, the macros below expand to nothing.
+ *
+ * Event names must be string literals (or at least outlive the tracer).
+ * The argument is typically the timestamp of the processed data, so that a
+ * frame can be followed across threads; VLC_TICK_INVALID means none.
+ * @{
+ */
+
+#ifdef ENABLE_TRACING
+void vlc_trace_Init(libvlc_int_t *);
+void vlc_trace_Deinit(libvlc_int_t *);
+void vlc_trace_Event(const char *name, char phase, int64_t arg);
+
+/** Begins a duration event on the calling thread */
+# define vlc_trace_begin(name, arg) vlc_trace_Event(name, 'B', arg)
+/** Ends the last duration event begun on the calling thread */
+# define vlc_trace_end(name, arg) vlc_trace_Event(name, 'E', arg)
+/** Records an instantaneous event */
+# define vlc_trace_instant(name, arg) vlc_trace_Event(name, 'i', arg)
+#else
+# define vlc_trace_Init(vlc) ((void)(vlc))
+# define vlc_trace_Deinit(vlc) ((void)(vlc))
+# define vlc_trace_begin(name, arg) ((void)0)
+# define vlc_trace_end(name, arg) ((void)0)
+# define vlc_trace_instant(name, arg) ((void)0)
+#endif
+
+/** @} */
+
+#endif
@@ -28,9 +28,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -73,7 +70,8 @@ typedef struct callback_table_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     i_hash;   /**< Hash of the name, see VarHash() */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -141,22 +139,113 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/**
+ * Hashes a variable name (32-bits FNV-1a).
+ */
+static uint32_t VarHash( const char *psz_name )
+{
+    uint32_t hash = 2166136261u;
+
+    for( const unsigned char *p = (const unsigned char *)psz_name; *p; p++ )
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
+}
+
+/**
+ * Finds the slot holding a variable in a table.
+ * \return the slot, or NULL if there is no such variable
+ */
+static variable_t **VarTableFind( vlc_var_table_t *tab, const char *psz_name,
+                                  uint32_t hash )
+{
+    if( tab->capacity == 0 )
+        return NULL;
+
+    size_t mask = tab->capacity - 1;
+
+    for( size_t i = hash & mask;; i = (i + 1) & mask )
+    {
+        variable_t *var = tab->slots[i];
+
+        if( var == NULL )
+            return NULL;
+        if( var->i_hash == hash && !strcmp( var->psz_name, psz_name ) )
+            return &tab->slots[i];
+    }
+}
+
+static void VarTablePut( variable_t **slots, size_t capacity, variable_t *var )
 {
-    const variable_t *va = a, *vb = b;
+    size_t mask = capacity - 1;
+    size_t i = var->i_hash & mask;
+
+    while( slots[i] != NULL )
+        i = (i + 1) & mask;
+    slots[i] = var;
+}
+
+/**
+ * Inserts a variable in a table, which must not hold the same name already.
+ */
+static int VarTableInsert( vlc_var_table_t *tab, variable_t *var )
+{
+    if( (tab->count + 1) * 4 > tab->capacity * 3 )
+    {   /* Keep at least one quarter of the slots free */
+        size_t capacity = tab->capacity ? tab->capacity * 2 : 8;
+        variable_t **slots = calloc( capacity, sizeof (*slots) );
+        if( unlikely(slots == NULL) )
+            return VLC_ENOMEM;
+
+        for( size_t i = 0; i < tab->capacity; i++ )
+            if( tab->slots[i] != NULL )
+                VarTablePut( slots, capacity, tab->slots[i] );
+
+        free( tab->slots );
+        tab->slots = slots;
+        tab->capacity = capacity;
+    }
+
+    VarTablePut( tab->slots, tab->capacity, var );
+    tab->count++;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Removes a variable from its slot of a table.
+ *
+ * The following entries of the probe sequence are shifted backward, so that
+ * no tombstones are needed.
+ */
+static void VarTableRemove( vlc_var_table_t *tab, variable_t **slot )
+{
+    size_t mask = tab->capacity - 1;
+    size_t hole = slot - tab->slots;
+
+    for( size_t i = (hole + 1) & mask; tab->slots[i] != NULL;
+         i = (i + 1) & mask )
+    {
+        size_t home = tab->slots[i]->i_hash & mask;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+        /* Move the entry unless its home slot lies cyclically in (hole, i] */
+        if( (i > hole) ? (home <= hole || home > i)
+                       : (home <= hole && home > i) )
+        {
+            tab->slots[hole] = tab->slots[i];
+            hole = i;
+        }
+    }
+    tab->slots[hole] = NULL;
+    tab->count--;
 }
 
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
+    uint32_t hash = VarHash( psz_name );
     variable_t **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
+    pp_var = VarTableFind( &priv->var_table, psz_name, hash );
     return (pp_var != NULL) ? *pp_var : NULL;
 }
 
@@ -286,9 +375,8 @@ static void TriggerListCallback(vlc_object_t *obj, variable_t *var,
 /**
  * Initialize a vlc variable
  *
- * We hash the given string and insert it into the sorted list. The insertion
- * may require slow memory copies, but think about what we gain in the log(n)
- * lookup phase when setting/getting the variable value!
+ * We hash the given string and insert it into the object hash table, so that
+ * the lookups when setting/getting the variable value are in constant time.
  *
  * \param p_this The object in which to create the variable
  * \param psz_name The name of the variable
@@ -304,6 +392,7 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -367,13 +456,16 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    pp_var = VarTableFind( &p_priv->var_table, psz_name, p_var->i_hash );
+    if( pp_var == NULL ) /* Variable create */
+    {
+        ret = VarTableInsert( &p_priv->var_table, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
+        p_oldvar = *pp_var;
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
         p_oldvar->i_usage++;
         p_oldvar->i_type |= i_type & VLC_VAR_ISCOMMAND;
@@ -389,51 +481,49 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
 /**
  * Destroy a vlc variable
  *
- * Look for the variable and destroy it if it is found. As in var_Create we
- * do a call to memmove() but we have performance counterparts elsewhere.
+ * Look for the variable and destroy it if it is found.
  *
  * \param p_this The object that holds the variable
  * \param psz_name The name of the variable
  */
 void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
 {
-    variable_t *p_var;
+    variable_t **pp_var, *p_var = NULL;
 
     assert( p_this );
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
 
-    p_var = Lookup( p_this, psz_name );
-    if( p_var == NULL )
+    vlc_mutex_lock( &p_priv->var_lock );
+    pp_var = VarTableFind( &p_priv->var_table, psz_name, VarHash( psz_name ) );
+    if( pp_var == NULL )
         msg_Dbg( p_this, "attempt to destroy nonexistent variable \"%s\"",
                  psz_name );
-    else if( --p_var->i_usage == 0 )
+    else if( --(*pp_var)->i_usage == 0 )
     {
+        p_var = *pp_var;
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        VarTableRemove( &p_priv->var_table, pp_var );
     }
     else
-    {
-        assert(p_var->i_usage != -1u);
-        p_var = NULL;
-    }
+        assert((*pp_var)->i_usage != -1u);
     vlc_mutex_unlock( &p_priv->var_lock );
 
     if( p_var != NULL )
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
+    vlc_var_table_t *tab = &priv->var_table;
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( size_t i = 0; i < tab->capacity; i++ )
+        if( tab->slots[i] != NULL )
+            Destroy( tab->slots[i] );
+
+    free( tab->slots );
+    *tab = (vlc_var_table_t){ NULL, 0, 0 };
 }
 
 #undef var_Change
@@ -1309,13 +1399,16 @@ void var_FreeList( vlc_value_t *p_val, vlc_value_t *p_val2 )
     }
 }
 
-static void DumpVariable(const void *data, const VISIT which, const int depth)
+static int DumpCompare(const void *a, const void *b)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
+    const variable_t *va = *(const variable_t **)a;
+    const variable_t *vb = *(const variable_t **)b;
 
-    const variable_t *var = *(const variable_t **)data;
+    return strcmp(va->psz_name, vb->psz_name);
+}
+
+static void DumpVariable(const variable_t *var)
+{
     const char *typename = "unknown";
 
     switch (var->i_type & VLC_VAR_TYPE)
@@ -1370,39 +1463,50 @@ static void DumpVariable(const void *data, const VISIT which, const int depth)
 
 void DumpVariables(vlc_object_t *obj)
 {
-    vlc_mutex_lock(&vlc_internals(obj)->var_lock);
-    if (vlc_internals(obj)->var_root == NULL)
+    vlc_object_internals_t *priv = vlc_internals(obj);
+    const vlc_var_table_t *tab = &priv->var_table;
+
+    vlc_mutex_lock(&priv->var_lock);
+    if (tab->count == 0)
         puts(" `-o No variables");
     else
-        twalk(vlc_internals(obj)->var_root, DumpVariable);
-    vlc_mutex_unlock(&vlc_internals(obj)->var_lock);
-}
+    {   /* Print in name order, as the hash table order is meaningless */
+        variable_t **vars = vlc_alloc(tab->count, sizeof (*vars));
+        if (vars != NULL)
+        {
+            size_t n = 0;
 
-static thread_local void *twalk_ctx;
+            for (size_t i = 0; i < tab->capacity; i++)
+                if (tab->slots[i] != NULL)
+                    vars[n++] = tab->slots[i];
 
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
+            qsort(vars, n, sizeof (*vars), DumpCompare);
+            for (size_t i = 0; i < n; i++)
+                DumpVariable(vars[i]);
+            free(vars);
+        }
+    }
+    vlc_mutex_unlock(&priv->var_lock);
 }
 
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
+    const vlc_var_table_t *tab = &priv->var_table;
 
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (size_t i = 0; i < tab->capacity; i++)
+    {
+        if (tab->slots[i] == NULL)
+            continue;
+
+        char *dup = strdup(tab->slots[i]->psz_name);
+        if (dup != NULL)
+            ARRAY_APPEND(names, dup);
+    }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
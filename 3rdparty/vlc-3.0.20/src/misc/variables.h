@@ -27,6 +27,21 @@
 # include <vlc_atomic.h>
 
 struct vlc_res;
+struct variable_t;
+
+/**
+ * Open-addressing hash table of object variables.
+ *
+ * Variables are stored by pointer with linear probing; the table is kept at
+ * most three quarters full so that a probe sequence always ends on an empty
+ * slot. It is protected by the owning object var_lock.
+ */
+typedef struct vlc_var_table
+{
+    struct variable_t **slots; /**< Slots (NULL if empty) */
+    size_t capacity; /**< Number of slots: zero or a power of two */
+    size_t count; /**< Number of variables in the table */
+} vlc_var_table_t;
 
 /**
  * Private LibVLC data for each object.
@@ -39,7 +54,7 @@ struct vlc_object_internals
     char           *psz_name; /* given name */
 
     /* Object variables */
-    void           *var_root;
+    vlc_var_table_t var_table;
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
@@ -40,6 +40,8 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -52,6 +54,10 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef __linux__
+# include <sys/epoll.h>
+# define HTTPD_EPOLL 1
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -68,6 +74,8 @@
 
 static void httpd_ClientDestroy(httpd_client_t *cl);
 static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+static void httpd_HostWakeUp(httpd_host_t *host);
+static void httpd_HostWakeUpClear(httpd_host_t *host);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -100,6 +108,19 @@ struct httpd_host_t
 
     /* TLS data */
     vlc_tls_creds_t *p_tls;
+
+#ifdef HTTPD_EPOLL
+    /* listening sockets, wake up pipe and edge triggered clients */
+    int          epfd;
+    /* clients destroyed outside of the host thread, which may leave stale
+     * pointers in the events of the current epoll_wait() */
+    unsigned     i_removed;
+#endif
+#ifndef _WIN32
+    /* written when streams get new data for waiting clients */
+    int          wakeup[2];
+    atomic_bool  wakeup_pending;
+#endif
 };
 
 
@@ -130,6 +151,7 @@ enum
     HTTPD_CLIENT_SEND_DONE,
 
     HTTPD_CLIENT_WAITING,
+    HTTPD_CLIENT_STREAMING,
 
     HTTPD_CLIENT_DEAD,
 
@@ -147,6 +169,13 @@ struct httpd_client_t
     bool    b_stream_mode;
     uint8_t i_state;
 
+    /* the socket did not return EAGAIN since the last readiness event */
+    bool    b_readable;
+    bool    b_writable;
+
+    /* sending straight from that stream buffer */
+    httpd_stream_t *stream;
+
     vlc_tick_t i_timeout_date;
 
     /* buffer for reading header */
@@ -618,6 +647,30 @@ struct httpd_stream_t
     httpd_header * p_http_headers;
 };
 
+/* Moves the client position to where it can read, returns the number of
+ * bytes available there. The stream lock must be held. */
+static int64_t httpd_StreamAvailable(httpd_stream_t *stream,
+                                     httpd_client_t *cl, int64_t *offset)
+{
+    if (*offset >= stream->i_buffer_pos)
+        return 0;    /* wait, no data available */
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            return 0;
+
+        /* seek to the new keyframe */
+        *offset = stream->i_last_keyframe_seen_pos;
+        cl->i_keyframe_wait_to_pass = -1;
+    }
+
+    if (*offset + stream->i_buffer_size < stream->i_buffer_pos)
+        *offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+
+    return stream->i_buffer_pos - *offset;
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -630,24 +683,8 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
     if (answer->i_body_offset > 0) {
         int     i_pos;
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
-
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
-        }
-
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
+        int64_t i_write = httpd_StreamAvailable(stream, cl, &answer->i_body_offset);
         i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
 
         if (i_write > HTTPD_CL_BUFSIZE)
             i_write = HTTPD_CL_BUFSIZE;
@@ -694,6 +731,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         if (query->i_type != HTTPD_MSG_HEAD) {
             cl->b_stream_mode = true;
+            cl->stream = stream;
             vlc_mutex_lock(&stream->lock);
             /* Send the header */
             if (stream->i_header > 0) {
@@ -837,6 +875,8 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
     httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
 
     vlc_mutex_unlock(&stream->lock);
+
+    httpd_HostWakeUp(stream->url->host);
     return VLC_SUCCESS;
 }
 
@@ -974,10 +1014,44 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->timeout_sec = timeout_sec;
     host->p_tls    = p_tls;
 
+#ifndef _WIN32
+    if (vlc_pipe(host->wakeup)) {
+        msg_Err(p_this, "cannot create wake up pipe: %s",
+                vlc_strerror_c(errno));
+        host->wakeup[0] = host->wakeup[1] = -1;
+        goto error;
+    }
+    atomic_init(&host->wakeup_pending, false);
+#endif
+#ifdef HTTPD_EPOLL
+    host->i_removed = 0;
+    host->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (host->epfd != -1) {
+        struct epoll_event ev = { .events = EPOLLIN };
+
+        for (unsigned i = 0; i < host->nfd; i++) {
+            ev.data.ptr = &host->fds[i];
+            epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->fds[i], &ev);
+        }
+        ev.data.ptr = &host->wakeup[0];
+        epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->wakeup[0], &ev);
+    } else
+        msg_Warn(p_this, "cannot create epoll instance: %s",
+                 vlc_strerror_c(errno));
+#endif
+
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
                    VLC_THREAD_PRIORITY_LOW)) {
         msg_Err(p_this, "cannot spawn http host thread");
+#ifdef HTTPD_EPOLL
+        if (host->epfd != -1)
+            vlc_close(host->epfd);
+#endif
+#ifndef _WIN32
+        vlc_close(host->wakeup[0]);
+        vlc_close(host->wakeup[1]);
+#endif
         goto error;
     }
 
@@ -1001,6 +1075,31 @@ error:
     return NULL;
 }
 
+/* Interrupts the host thread wait, so that streaming clients catch up with
+ * new data. Only one byte is ever pending in the pipe. */
+static void httpd_HostWakeUp(httpd_host_t *host)
+{
+#ifndef _WIN32
+    if (!atomic_exchange(&host->wakeup_pending, true))
+        if (write(host->wakeup[1], &(char){ 0 }, 1) < 0)
+            atomic_store(&host->wakeup_pending, false);
+#else
+    VLC_UNUSED(host);
+#endif
+}
+
+static void httpd_HostWakeUpClear(httpd_host_t *host)
+{
+#ifndef _WIN32
+    char c;
+
+    if (read(host->wakeup[0], &c, 1) > 0)
+        atomic_store(&host->wakeup_pending, false);
+#else
+    VLC_UNUSED(host);
+#endif
+}
+
 /* delete a host */
 void httpd_HostDelete(httpd_host_t *host)
 {
@@ -1035,6 +1134,14 @@ void httpd_HostDelete(httpd_host_t *host)
     }
     TAB_CLEAN(host->i_client, host->client);
 
+#ifdef HTTPD_EPOLL
+    if (host->epfd != -1)
+        vlc_close(host->epfd);
+#endif
+#ifndef _WIN32
+    vlc_close(host->wakeup[0]);
+    vlc_close(host->wakeup[1]);
+#endif
     vlc_tls_Delete(host->p_tls);
     net_ListenClose(host->fds);
     vlc_cond_destroy(&host->wait);
@@ -1112,6 +1219,9 @@ void httpd_UrlDelete(httpd_url_t *url)
         /* TODO complete it */
         msg_Warn(host, "force closing connections");
         TAB_REMOVE(host->i_client, host->client, client);
+#ifdef HTTPD_EPOLL
+        host->i_removed++;
+#endif
         httpd_ClientDestroy(client);
         i--;
     }
@@ -1196,6 +1306,7 @@ static void httpd_ClientInit(httpd_client_t *cl)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->stream = NULL;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1230,6 +1341,8 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock)
     cl->i_ref   = 0;
     cl->sock    = sock;
     cl->url     = NULL;
+    cl->b_readable = true;
+    cl->b_writable = true;
 
     httpd_ClientInit(cl);
     return cl;
@@ -1240,15 +1353,30 @@ ssize_t httpd_NetRecv (httpd_client_t *cl, uint8_t *p, size_t i_len)
 {
     vlc_tls_t *sock = cl->sock;
     struct iovec iov = { .iov_base = p, .iov_len = i_len };
-    return sock->readv(sock, &iov, 1);
+    ssize_t val = sock->readv(sock, &iov, 1);
+
+    if (val < 0 && errno == EAGAIN)
+        cl->b_readable = false;
+    return val;
 }
 
 static
-ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
+ssize_t httpd_NetSendv (httpd_client_t *cl, const struct iovec *iov,
+                        unsigned count)
 {
     vlc_tls_t *sock = cl->sock;
+    ssize_t val = sock->writev(sock, iov, count);
+
+    if (val < 0 && errno == EAGAIN)
+        cl->b_writable = false;
+    return val;
+}
+
+static
+ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
+{
     const struct iovec iov = { .iov_base = (void *)p, .iov_len = i_len };
-    return sock->writev(sock, &iov, 1);
+    return httpd_NetSendv(cl, &iov, 1);
 }
 
 
@@ -1618,6 +1746,22 @@ static int httpd_ClientSend(httpd_client_t *cl)
     cl->i_buffer += i_len;
 
     if (cl->i_buffer >= cl->i_buffer_size) {
+        if (cl->answer.i_body == 0 && cl->answer.i_body_offset > 0
+         && cl->stream != NULL) {
+            /* headers are out, send the stream straight from its buffer */
+            int64_t i_offset = cl->answer.i_body_offset;
+
+            httpd_MsgClean(&cl->answer);
+            cl->answer.i_body_offset = i_offset;
+            free(cl->p_buffer);
+            cl->p_buffer = NULL;
+            cl->i_buffer = 0;
+            cl->i_buffer_size = 0;
+
+            cl->i_state = HTTPD_CLIENT_STREAMING;
+            return 0;
+        }
+
         if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
             /* catch more body data */
             int     i_msg = cl->query.i_type;
@@ -1642,6 +1786,57 @@ static int httpd_ClientSend(httpd_client_t *cl)
         } else /* send finished */
             cl->i_state = HTTPD_CLIENT_SEND_DONE;
     }
+
+    return 0;
+}
+
+/* Sends pending stream data directly out of the stream circular buffer,
+ * without an intermediate per-client copy. */
+static int httpd_StreamClientSend(httpd_client_t *cl)
+{
+    httpd_stream_t *stream = cl->stream;
+    struct iovec iov[2];
+    unsigned count = 0;
+
+    vlc_mutex_lock(&stream->lock);
+
+    int64_t *offset = &cl->answer.i_body_offset;
+    int64_t i_write = httpd_StreamAvailable(stream, cl, offset);
+    if (i_write <= 0) {
+        vlc_mutex_unlock(&stream->lock);
+        return -1;    /* wait, no data available */
+    }
+    /* The muxer waits for the lock: bound the time spent in the socket or
+     * in the TLS layer with it held, as the copying path does */
+    if (i_write > HTTPD_CL_BUFSIZE)
+        i_write = HTTPD_CL_BUFSIZE;
+
+    int i_pos = *offset % stream->i_buffer_size;
+    size_t i_first = __MIN(i_write, stream->i_buffer_size - i_pos);
+
+    iov[count].iov_base = &stream->p_buffer[i_pos];
+    iov[count++].iov_len = i_first;
+    if ((int64_t)i_first < i_write) { /* wraps around */
+        iov[count].iov_base = stream->p_buffer;
+        iov[count++].iov_len = i_write - i_first;
+    }
+
+    ssize_t i_len = httpd_NetSendv(cl, iov, count);
+    if (i_len > 0)
+        *offset += i_len;
+    vlc_mutex_unlock(&stream->lock);
+
+    if (i_len < 0) {
+#if defined(_WIN32)
+        if (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+        if (errno == EAGAIN)
+#endif
+            return -1;
+
+        /* Connection failed, or hung up (EPIPE) */
+        cl->i_state = HTTPD_CLIENT_DEAD;
+    }
     return 0;
 }
 
@@ -1698,12 +1893,31 @@ auth_failed:
 
 static void httpdLoop(httpd_host_t *host)
 {
-    struct pollfd ufd[host->nfd + host->i_client];
-    unsigned nfd;
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        ufd[nfd].fd = host->fds[nfd];
+#ifdef HTTPD_EPOLL
+    const bool b_epoll = host->epfd != -1;
+#else
+    const bool b_epoll = false;
+#endif
+#ifndef _WIN32
+    const bool b_wakeup = true;
+#else
+    const bool b_wakeup = false;
+#endif
+    struct pollfd ufd[b_epoll ? 1 : host->nfd + host->i_client + 1];
+    unsigned nfd = 0;
+
+    if (!b_epoll) {
+        for (nfd = 0; nfd < host->nfd; nfd++) {
+            ufd[nfd].fd = host->fds[nfd];
+            ufd[nfd].events = POLLIN;
+            ufd[nfd].revents = 0;
+        }
+#ifndef _WIN32
+        ufd[nfd].fd = host->wakeup[0];
         ufd[nfd].events = POLLIN;
         ufd[nfd].revents = 0;
+        nfd++;
+#endif
     }
 
     /* add all socket that should be read/write and close dead connection */
@@ -1722,14 +1936,22 @@ static void httpdLoop(httpd_host_t *host)
 
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING:
-                val = httpd_ClientRecv(cl);
+                if (cl->b_readable)
+                    val = httpd_ClientRecv(cl);
                 break;
             case HTTPD_CLIENT_SENDING:
-                val = httpd_ClientSend(cl);
+                if (cl->b_writable)
+                    val = httpd_ClientSend(cl);
+                break;
+            case HTTPD_CLIENT_STREAMING:
+                if (cl->b_writable)
+                    val = httpd_StreamClientSend(cl);
                 break;
             case HTTPD_CLIENT_TLS_HS_IN:
             case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
+                if (cl->i_state == HTTPD_CLIENT_TLS_HS_IN ? cl->b_readable
+                                                          : cl->b_writable)
+                    httpd_ClientTlsHandshake(host, cl);
                 break;
         }
 
@@ -1739,6 +1961,11 @@ static void httpdLoop(httpd_host_t *host)
                         cl->i_timeout_date < now)))) {
             TAB_REMOVE(host->i_client, host->client, cl);
             i_client--;
+#ifdef HTTPD_EPOLL
+            if (b_epoll)
+                epoll_ctl(host->epfd, EPOLL_CTL_DEL,
+                          vlc_tls_GetFD(cl->sock), NULL);
+#endif
             httpd_ClientDestroy(cl);
             continue;
         }
@@ -1748,21 +1975,23 @@ static void httpdLoop(httpd_host_t *host)
             delay = 0;
         }
 
-        struct pollfd *pufd = ufd + nfd;
-        assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
-
-        pufd->fd = vlc_tls_GetFD(cl->sock);
-        pufd->events = pufd->revents = 0;
+        short events = 0;
 
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING:
             case HTTPD_CLIENT_TLS_HS_IN:
-                pufd->events = POLLIN;
+                events = POLLIN;
                 break;
 
             case HTTPD_CLIENT_SENDING:
             case HTTPD_CLIENT_TLS_HS_OUT:
-                pufd->events = POLLOUT;
+                events = POLLOUT;
+                break;
+
+            case HTTPD_CLIENT_STREAMING:
+                /* otherwise, the stream wakes us up when it gets data */
+                if (!cl->b_writable)
+                    events = POLLOUT;
                 break;
 
             case HTTPD_CLIENT_RECEIVE_DONE: {
@@ -1975,19 +2204,56 @@ static void httpdLoop(httpd_host_t *host)
             }
         }
 
-        if (pufd->events != 0)
-            nfd++;
+        if (events != 0) {
+            if (!b_epoll) {
+                assert (nfd < sizeof (ufd) / sizeof (ufd[0]));
+                ufd[nfd].fd = vlc_tls_GetFD(cl->sock);
+                ufd[nfd].events = events;
+                ufd[nfd].revents = 0;
+                nfd++;
+            }
+        }
         /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-        else if (delay != 0)
+        else if (delay != 0
+              && (cl->i_state != HTTPD_CLIENT_STREAMING || !b_wakeup))
             delay = 20;
     }
+#ifdef HTTPD_EPOLL
+    unsigned i_removed = host->i_removed;
+#endif
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
 
-    while (poll(ufd, nfd, delay) < 0)
+    bool accept_fds[host->nfd];
+    memset(accept_fds, 0, sizeof (accept_fds));
+
+#ifdef HTTPD_EPOLL
+    struct epoll_event ev[64];
+    int nev = 0;
+
+    if (b_epoll) {
+        while ((nev = epoll_wait(host->epfd, ev, sizeof (ev) / sizeof (ev[0]),
+                                 delay)) < 0)
+        {
+            if (errno != EINTR)
+                msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+        }
+    }
+    else
+#endif
     {
-        if (errno != EINTR)
-            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+        while (poll(ufd, nfd, delay) < 0)
+        {
+            if (errno != EINTR)
+                msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+        }
+
+        for (unsigned i = 0; i < host->nfd; i++)
+            accept_fds[i] = ufd[i].revents != 0;
+#ifndef _WIN32
+        if (ufd[host->nfd].revents != 0)
+            httpd_HostWakeUpClear(host);
+#endif
     }
 
     canc = vlc_savecancel();
@@ -1995,14 +2261,54 @@ static void httpdLoop(httpd_host_t *host)
 
     now = mdate();
 
+#ifdef HTTPD_EPOLL
+    /* Mark the clients ready for I/O */
+    for (int i = 0; i < nev; i++) {
+        void *ptr = ev[i].data.ptr;
+
+        if (ptr == &host->wakeup[0]) {
+            httpd_HostWakeUpClear(host);
+            continue;
+        }
+        if (ptr >= (void *)&host->fds[0] && ptr < (void *)&host->fds[host->nfd]) {
+            accept_fds[(int *)ptr - host->fds] = true;
+            continue;
+        }
+
+        httpd_client_t *cl = ptr;
+
+        if (i_removed != host->i_removed) {
+            /* the client may have been destroyed while we were waiting */
+            int j = 0;
+            while (j < host->i_client && host->client[j] != cl)
+                j++;
+            if (j == host->i_client)
+                continue;
+        }
+
+        uint32_t revents = ev[i].events;
+        if (revents & (EPOLLERR|EPOLLHUP|EPOLLRDHUP))
+            revents |= EPOLLIN|EPOLLOUT;
+        if (revents & EPOLLIN)
+            cl->b_readable = true;
+        if (revents & EPOLLOUT)
+            cl->b_writable = true;
+    }
+
+    if (!b_epoll)
+#endif
+    /* Without edge notifications, try I/O on every client */
+    for (int i = 0; i < host->i_client; i++) {
+        host->client[i]->b_readable = true;
+        host->client[i]->b_writable = true;
+    }
+
     /* Handle server sockets (accept new connections) */
     for (nfd = 0; nfd < host->nfd; nfd++) {
         httpd_client_t *cl;
-        int fd = ufd[nfd].fd;
+        int fd = host->fds[nfd];
 
-        assert (fd == host->fds[nfd]);
-
-        if (ufd[nfd].revents == 0)
+        if (!accept_fds[nfd])
             continue;
 
         /* */
@@ -2034,9 +2340,30 @@ static void httpdLoop(httpd_host_t *host)
         }
 
         cl = httpd_ClientNew(sk);
+        if (unlikely(cl == NULL))
+        {
+            vlc_tls_Close(sk);
+            continue;
+        }
         if (host->b_no_timeout)
             host->timeout_sec = 0;
 
+#ifdef HTTPD_EPOLL
+        if (b_epoll)
+        {
+            struct epoll_event cev = {
+                .events = EPOLLIN|EPOLLOUT|EPOLLRDHUP|EPOLLET,
+                .data.ptr = cl,
+            };
+
+            if (epoll_ctl(host->epfd, EPOLL_CTL_ADD, fd, &cev))
+            {
+                httpd_ClientDestroy(cl);
+                continue;
+            }
+        }
+#endif
+
         if (host->p_tls != NULL)
             cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
 
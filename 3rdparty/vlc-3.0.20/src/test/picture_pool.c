@@ -23,6 +23,7 @@
 #endif
 
 #include <stdbool.h>
+#include <stdio.h>
 #undef NDEBUG
 #include <assert.h>
 
@@ -106,6 +107,75 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+/* Simulates a video output reconfigured by adaptive streaming switching
+ * representations: pools are torn down and created again at each switch. */
+static void test_switches(void)
+{
+    static const unsigned sizes[][2] = {
+        { 1920, 1080 }, { 1280, 720 }, { 854, 480 },
+    };
+    const unsigned count = sizeof (sizes) / sizeof (sizes[0]);
+    void *planes[PICTURES];
+    picture_t *pics[PICTURES];
+    video_format_t vfmt;
+
+    /* Buffers of a format used again must be recycled */
+    video_format_Setup(&vfmt, VLC_CODEC_I420, 1280, 720, 1280, 720, 1, 1);
+    pool = picture_pool_NewFromFormat(&vfmt, PICTURES);
+    assert(pool != NULL);
+    for (unsigned i = 0; i < PICTURES; i++)
+    {
+        pics[i] = picture_pool_Get(pool);
+        planes[i] = pics[i]->p[0].p_pixels;
+    }
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+
+    pool = picture_pool_NewFromFormat(&vfmt, PICTURES);
+    assert(pool != NULL);
+    for (unsigned i = 0; i < PICTURES; i++)
+    {
+        bool found = false;
+
+        pics[i] = picture_pool_Get(pool);
+        for (unsigned j = 0; j < PICTURES; j++)
+            found = found || pics[i]->p[0].p_pixels == planes[j];
+        assert(found);
+    }
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+
+    mtime_t start = mdate();
+
+    for (unsigned i = 0; i < 100; i++)
+    {
+        const unsigned *size = sizes[i % count];
+
+        video_format_Setup(&vfmt, VLC_CODEC_I420, size[0], size[1],
+                           size[0], size[1], 1, 1);
+        pool = picture_pool_NewFromFormat(&vfmt, PICTURES);
+        assert(pool != NULL);
+
+        /* Touch the pictures, as a decoder would */
+        for (unsigned j = 0; j < PICTURES; j++)
+        {
+            pics[j] = picture_pool_Get(pool);
+            assert(pics[j] != NULL);
+            for (int k = 0; k < pics[j]->i_planes; k++)
+                memset(pics[j]->p[k].p_pixels, 0x80,
+                       pics[j]->p[k].i_pitch * pics[j]->p[k].i_lines);
+        }
+        for (unsigned j = 0; j < PICTURES; j++)
+            picture_Release(pics[j]);
+        picture_pool_Release(pool);
+    }
+
+    printf("resolution switch: %"PRId64" us on average\n",
+           (mdate() - start) / 100);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -122,6 +192,7 @@ int main(void)
 
     test(false);
     test(true);
+    test_switches();
 
     return 0;
 }
@@ -54,6 +54,7 @@
 #include "display.h"
 #include "window.h"
 #include "../misc/variables.h"
+#include "../misc/tracer.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -894,7 +895,9 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
         vout->p->displayed.timestamp     = decoded->date;
         vout->p->displayed.is_interlaced = !decoded->b_progressive;
 
+        vlc_trace_begin("filter", decoded->date);
         picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
+        vlc_trace_end("filter", VLC_TICK_INVALID);
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
@@ -973,9 +976,11 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     vout_chrono_Start(&vout->p->render);
 
+    vlc_trace_begin("interactive filter", torender->date);
     vlc_mutex_lock(&vout->p->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(vout->p->filter.chain_interactive, torender);
     vlc_mutex_unlock(&vout->p->filter.lock);
+    vlc_trace_end("interactive filter", VLC_TICK_INVALID);
 
     if (!filtered)
         return VLC_EGENERIC;
@@ -1140,6 +1145,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         return VLC_EGENERIC;
     }
 
+    vlc_trace_begin("display prepare", todisplay->date);
     if (sys->display.use_dr) {
         vout_display_Prepare(vd, todisplay, subpic);
     } else {
@@ -1153,6 +1159,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
             subpic = NULL;
         }
     }
+    vlc_trace_end("display prepare", VLC_TICK_INVALID);
 
     vout_chrono_Stop(&vout->p->render);
 #if 0
@@ -1175,7 +1182,9 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    vlc_trace_begin("display", todisplay->date);
     vout_display_Display(vd, todisplay, subpic);
+    vlc_trace_end("display", VLC_TICK_INVALID);
 
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
 
@@ -39,6 +39,39 @@ static void test_core (const char ** argv, int argc)
     libvlc_release (vlc);
 }
 
+static void test_log_cb (void *data, int level, const libvlc_log_t *ctx,
+                         const char *fmt, va_list ap)
+{
+    unsigned *count = data;
+
+    (void) level; (void) ctx; (void) fmt; (void) ap;
+    (*count)++;
+}
+
+static void test_async_log (void)
+{
+    const char *argv[] = {
+        "-vvv", "--vout=vdummy", "--log-async", "--log-async-records=16",
+    };
+    libvlc_instance_t *vlc;
+    unsigned count = 0;
+
+    log ("Testing asynchronous logging\n");
+
+    vlc = libvlc_new (sizeof (argv) / sizeof (argv[0]), argv);
+    assert (vlc != NULL);
+
+    /* Announcement messages are queued, then flushed when the callback is
+     * replaced, before libvlc_log_unset() returns */
+    libvlc_log_set (vlc, test_log_cb, &count);
+    libvlc_log_unset (vlc);
+    assert (count >= 4);
+
+    unsigned flushed = count;
+    libvlc_release (vlc);
+    assert (count == flushed);
+}
+
 static void test_moduledescriptionlist (libvlc_module_description_t *list)
 {
     libvlc_module_description_t *module = list;
@@ -104,6 +137,7 @@ int main (void)
     test_core (test_defaults_args, test_defaults_nargs);
     test_audiovideofilterlists (test_defaults_args, test_defaults_nargs);
     test_audio_output ();
+    test_async_log ();
 
     return 0;
 }
@@ -0,0 +1,309 @@
+/*****************************************************************************
+ * file.c: file access large block read throughput test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+
+#include "../../../modules/access/readahead.h"
+
+#ifdef HAVE_MMAP
+/* A high bit rate 4K video file: frames of a few hundred KiB, each read with
+ * a small header first, as demuxers do */
+#define FILE_SIZE  (128 << 20)
+#define FRAME_MIN  (64 << 10)
+#define FRAME_MAX  (1 << 20)
+#define HEADER     16
+#define SEEKS      64
+
+/* Every 64-bits word of the file contains its own offset */
+static void CreateFile(int fd)
+{
+    static uint64_t buf[(1 << 20) / 8];
+
+    for (uint64_t off = 0; off < FILE_SIZE; off += sizeof (buf))
+    {
+        for (size_t i = 0; i < ARRAY_SIZE(buf); i++)
+            buf[i] = off + i * 8;
+        assert(write(fd, buf, sizeof (buf)) == sizeof (buf));
+    }
+}
+
+/* Checks the data like a decoder would go through it */
+static void CheckData(const uint8_t *p, size_t len, uint64_t offset)
+{
+    assert((offset % 8) == 0 && (len % 8) == 0);
+
+    for (size_t i = 0; i < len; i += 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, p + i, 8);
+        assert(word == offset + i);
+    }
+}
+
+static mtime_t ThreadTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * CLOCK_FREQ + ts.tv_nsec / (1000000000 / CLOCK_FREQ);
+}
+
+static void test_read(libvlc_int_t *obj, const char *url, bool map)
+{
+    uint8_t header[HEADER];
+    unsigned seed = 42;
+
+    var_SetBool(obj, "file-mmap", map);
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+
+    mtime_t cpu = ThreadTime(), start = mdate();
+    uint64_t offset = 0;
+    unsigned frames = 0;
+
+    /* sequential playback */
+    while (offset < FILE_SIZE)
+    {
+        assert(vlc_stream_Read(s, header, HEADER) == HEADER);
+        CheckData(header, HEADER, offset);
+        offset += HEADER;
+
+        size_t size = FRAME_MIN + (rand_r(&seed) % (FRAME_MAX - FRAME_MIN));
+        size &= ~(size_t)7;
+        if (size > FILE_SIZE - offset)
+            size = FILE_SIZE - offset;
+
+        block_t *block = vlc_stream_Block(s, size);
+        assert(block != NULL && block->i_buffer == size);
+        CheckData(block->p_buffer, size, offset);
+        block_Release(block);
+        offset += size;
+        assert(vlc_stream_Tell(s) == offset);
+        frames++;
+    }
+    assert(vlc_stream_Read(s, header, 1) == 0);
+
+    cpu = ThreadTime() - cpu;
+    start = mdate() - start;
+    log("  %s: %u frames, %.0f MiB/s, %"PRId64" us CPU per MiB\n",
+        map ? "mapped" : "copied", frames,
+        FILE_SIZE * (double)CLOCK_FREQ / (1 << 20) / (start ? start : 1),
+        cpu / (FILE_SIZE >> 20));
+
+    /* seeking between mapped and copied reads */
+    for (unsigned i = 0; i < SEEKS; i++)
+    {
+        offset = (rand_r(&seed) % (FILE_SIZE - FRAME_MAX)) & ~(uint64_t)7;
+        assert(vlc_stream_Seek(s, offset) == VLC_SUCCESS);
+
+        block_t *block = vlc_stream_Block(s, FRAME_MIN);
+        assert(block != NULL && block->i_buffer == FRAME_MIN);
+        CheckData(block->p_buffer, FRAME_MIN, offset);
+        block_Release(block);
+        offset += FRAME_MIN;
+
+        const uint8_t *peek;
+        assert(vlc_stream_Peek(s, &peek, HEADER) == HEADER);
+        CheckData(peek, HEADER, offset);
+        assert(vlc_stream_Tell(s) == offset);
+    }
+
+    vlc_stream_Delete(s);
+}
+
+static void test_readahead_ranges(void)
+{
+    file_range_t pending[FILE_RA_SLOTS];
+    unsigned count = 0;
+
+    /* ranges with a small gap are merged, both ways */
+    assert(file_ranges_Add(pending, &count, (file_range_t){ 1 << 20, 2 << 20 }));
+    assert(!file_ranges_Add(pending, &count,
+                            (file_range_t){ (2 << 20) + FILE_RA_MERGE, 3 << 20 }));
+    assert(!file_ranges_Add(pending, &count,
+                            (file_range_t){ 0, (1 << 20) - FILE_RA_MERGE }));
+    assert(count == 1);
+    assert(pending[0].start == 0 && pending[0].end == (3 << 20));
+
+    /* overlapping and contained ranges too */
+    assert(!file_ranges_Add(pending, &count, (file_range_t){ 100, 200 }));
+    assert(!file_ranges_Add(pending, &count,
+                            (file_range_t){ 2 << 20, 4 << 20 }));
+    assert(count == 1);
+    assert(pending[0].start == 0 && pending[0].end == (4 << 20));
+
+    /* not with a larger gap */
+    uint64_t far = (4 << 20) + FILE_RA_MERGE + 1;
+    assert(file_ranges_Add(pending, &count, (file_range_t){ far, far + 1 }));
+    assert(count == 2);
+
+    /* nor beyond the largest request */
+    assert(!file_ranges_Add(pending, &count,
+                            (file_range_t){ 4 << 20, FILE_RA_MAX }));
+    assert(file_ranges_Add(pending, &count,
+                           (file_range_t){ FILE_RA_MAX, FILE_RA_MAX + 1 }));
+    assert(count == 3);
+    assert(pending[0].start == 0 && pending[0].end == FILE_RA_MAX);
+    assert(pending[1].start == far && pending[1].end == far + 1);
+    assert(pending[2].start == FILE_RA_MAX);
+
+    assert(file_ranges_Cover(pending, count, 0, FILE_RA_MAX));
+    assert(file_ranges_Cover(pending, count, far, far + 1));
+    assert(!file_ranges_Cover(pending, count, FILE_RA_MAX, FILE_RA_MAX + 2));
+    assert(!file_ranges_Cover(pending, count, FILE_RA_MAX - 1,
+                              FILE_RA_MAX + 1));
+
+    /* once the slots are full, the oldest range is dropped */
+    count = 0;
+    for (uint64_t i = 0; i < FILE_RA_SLOTS + 4; i++)
+        assert(file_ranges_Add(pending, &count,
+                               (file_range_t){ i << 24, (i << 24) + 1 }));
+    assert(count == FILE_RA_SLOTS);
+    assert(pending[0].start == (UINT64_C(4) << 24));
+    assert(pending[FILE_RA_SLOTS - 1].start ==
+           ((uint64_t)(FILE_RA_SLOTS + 3) << 24));
+}
+
+#ifdef HAVE_POSIX_FADVISE
+/* Reads are counted as hits once announced and passed to the kernel */
+static void test_readahead(libvlc_int_t *obj, const char *url)
+{
+    uint64_t hits, misses, bytes;
+    uint8_t buf[FRAME_MIN];
+
+    var_SetBool(obj, "file-mmap", false);
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+    assert(vlc_stream_Control(s, STREAM_GET_READAHEAD_STATS,
+                              &hits, &misses, &bytes) != VLC_SUCCESS);
+
+    /* two hints merged in one request */
+    assert(vlc_stream_Control(s, STREAM_SET_READAHEAD,
+                              (uint64_t)(16 << 20), (uint64_t)(1 << 20))
+           == VLC_SUCCESS);
+    assert(vlc_stream_Control(s, STREAM_SET_READAHEAD,
+                              (uint64_t)(17 << 20), (uint64_t)(1 << 20))
+           == VLC_SUCCESS);
+    do
+    {
+        mwait(mdate() + CLOCK_FREQ / 100);
+        assert(vlc_stream_Control(s, STREAM_GET_READAHEAD_STATS,
+                                  &hits, &misses, &bytes) == VLC_SUCCESS);
+    }
+    while (bytes < (2 << 20));
+    assert(bytes == (2 << 20));
+    assert(hits == 0 && misses == 0);
+
+    assert(vlc_stream_Seek(s, 16 << 20) == VLC_SUCCESS);
+    assert(vlc_stream_Read(s, buf, sizeof (buf)) == sizeof (buf));
+    CheckData(buf, sizeof (buf), 16 << 20);
+    assert(vlc_stream_Seek(s, 64 << 20) == VLC_SUCCESS);
+    assert(vlc_stream_Read(s, buf, sizeof (buf)) == sizeof (buf));
+    CheckData(buf, sizeof (buf), 64 << 20);
+
+    assert(vlc_stream_Control(s, STREAM_GET_READAHEAD_STATS,
+                              &hits, &misses, &bytes) == VLC_SUCCESS);
+    assert(hits > 0 && misses > 0);
+    log("  read-ahead: %"PRIu64" hits, %"PRIu64" misses\n", hits, misses);
+
+    vlc_stream_Delete(s);
+}
+#endif
+
+/* The file is truncated within the mapped window: the next block must be
+ * read up to the new end instead of referencing pages beyond it */
+static void test_truncate(libvlc_int_t *obj, const char *url, const char *path)
+{
+    var_SetBool(obj, "file-mmap", true);
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+
+    block_t *block = vlc_stream_Block(s, FRAME_MIN);
+    assert(block != NULL && block->i_buffer == FRAME_MIN);
+    CheckData(block->p_buffer, FRAME_MIN, 0);
+    block_Release(block);
+
+    assert(truncate(path, 2 * FRAME_MIN) == 0);
+
+    block = vlc_stream_Block(s, FRAME_MAX);
+    assert(block != NULL && block->i_buffer == FRAME_MIN);
+    CheckData(block->p_buffer, FRAME_MIN, FRAME_MIN);
+    block_Release(block);
+    assert(vlc_stream_Block(s, FRAME_MAX) == NULL);
+
+    vlc_stream_Delete(s);
+}
+
+int main(void)
+{
+    libvlc_instance_t *vlc;
+    char path[] = "/tmp/vlc-test-file-XXXXXX";
+
+    test_init();
+
+    int fd = vlc_mkstemp(path);
+    if (fd == -1)
+        return 77;
+    CreateFile(fd);
+    close(fd);
+
+    char *url = vlc_path2uri(path, NULL);
+    assert(url != NULL);
+
+    log("Testing large block reads from a local file\n");
+    vlc = libvlc_new(test_defaults_nargs, test_defaults_args);
+    assert(vlc != NULL);
+
+    var_Create(vlc->p_libvlc_int, "file-mmap", VLC_VAR_BOOL);
+    test_read(vlc->p_libvlc_int, url, false);
+    test_read(vlc->p_libvlc_int, url, true);
+
+    log("Testing the read-ahead planner\n");
+    test_readahead_ranges();
+#ifdef HAVE_POSIX_FADVISE
+    test_readahead(vlc->p_libvlc_int, url);
+#endif
+    test_truncate(vlc->p_libvlc_int, url, path);
+
+    libvlc_release(vlc);
+    free(url);
+    unlink(path);
+    return 0;
+}
+#else
+int main(void)
+{
+    return 77;
+}
+#endif
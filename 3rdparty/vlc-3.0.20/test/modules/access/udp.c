@@ -0,0 +1,254 @@
+/*****************************************************************************
+ * udp.c: UDP access loopback throughput test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+
+#ifdef HAVE_RECVMMSG /* sendmmsg() comes along */
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+
+#define DGRAM_SIZE   1316 /* 7 TS packets, as used for IPTV */
+#define ROUND_LENGTH (CLOCK_FREQ / 4)
+#define END_OF_ROUND UINT32_MAX
+#define ROUND_GRACE  (CLOCK_FREQ / 2) /* for the end marker */
+#define SEND_BATCH   64
+
+struct round
+{
+    int      fd;
+    uint32_t id;
+    unsigned mbps;
+    uint32_t sent;
+    uint32_t lost;
+    double   received_mbps;
+};
+
+/* Sends datagrams at the round bit rate, paced every millisecond, then
+ * marks the end of the round a few times in case some are lost */
+static void *Send(void *data)
+{
+    struct round *r = data;
+    static uint8_t bufs[SEND_BATCH][DGRAM_SIZE];
+    struct iovec iov[SEND_BATCH];
+    struct mmsghdr msgs[SEND_BATCH];
+    double per_tick = r->mbps * 1e6 / 8 / DGRAM_SIZE / 1000;
+    double credit = 0.;
+    mtime_t start = mdate(), deadline = start;
+
+    memset(msgs, 0, sizeof (msgs));
+    for (unsigned i = 0; i < SEND_BATCH; i++)
+    {
+        memset(bufs[i], 0x47, DGRAM_SIZE);
+        SetDWBE(bufs[i], r->id);
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = DGRAM_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    r->sent = 0;
+
+    /* the sender must not be the bottleneck: send in batches too */
+    while (deadline - start < ROUND_LENGTH)
+    {
+        for (credit += per_tick; credit >= 1.;)
+        {
+            unsigned n = credit < SEND_BATCH ? credit : SEND_BATCH;
+
+            for (unsigned i = 0; i < n; i++)
+                SetDWBE(bufs[i] + 4, r->sent + i);
+
+            int val = sendmmsg(r->fd, msgs, n, 0);
+            if (val <= 0)
+                break;
+            r->sent += val;
+            credit -= val;
+        }
+        deadline += 1000;
+        mwait(deadline);
+    }
+
+    SetDWBE(bufs[0] + 4, END_OF_ROUND);
+    for (unsigned i = 0; i < 20; i++)
+    {
+        deadline += CLOCK_FREQ / 100;
+        mwait(deadline);
+        send(r->fd, bufs[0], DGRAM_SIZE, 0);
+    }
+    return NULL;
+}
+
+static mtime_t ThreadTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * CLOCK_FREQ + ts.tv_nsec / (1000000000 / CLOCK_FREQ);
+}
+
+/* Runs one round, checks that the datagrams come whole and in order.
+ * Returns false if the end of the round was not seen. */
+static bool RunRound(stream_t *access, struct round *r)
+{
+    vlc_thread_t th;
+    uint32_t received = 0, next = 0;
+    mtime_t cpu = ThreadTime(), start = mdate(), end = start;
+    const mtime_t deadline = start + ROUND_LENGTH + ROUND_GRACE;
+    bool complete = false;
+
+    if (vlc_clone(&th, Send, r, VLC_THREAD_PRIORITY_LOW))
+        assert(!"Thread error");
+
+    while (mdate() < deadline)
+    {
+        block_t *block = vlc_stream_ReadBlock(access);
+
+        if (block == NULL)
+        {
+            if (vlc_stream_Eof(access))
+                break; /* time-out: every end marker was lost */
+            continue;
+        }
+        assert(block->i_buffer == DGRAM_SIZE);
+
+        uint32_t id = GetDWBE(block->p_buffer);
+        uint32_t seq = GetDWBE(block->p_buffer + 4);
+
+        for (size_t i = 8; i < DGRAM_SIZE; i++)
+            assert(block->p_buffer[i] == 0x47);
+        block_Release(block);
+        if (id != r->id)
+            continue; /* late end marker of the previous round */
+        if (seq == END_OF_ROUND)
+        {
+            complete = true;
+            break;
+        }
+        /* the loopback does not reorder: only losses leave gaps */
+        assert(seq >= next);
+        next = seq + 1;
+        received++;
+        end = mdate();
+    }
+    cpu = ThreadTime() - cpu;
+    vlc_join(th, NULL);
+
+    assert(next <= r->sent);
+    r->lost = r->sent - received;
+    r->received_mbps = received * (DGRAM_SIZE * 8.)
+                     / (end > start ? end - start : 1);
+    log("  %4u Mbit/s: sent %6"PRIu32", lost %6"PRIu32", "
+        "%5.1f Mbit/s received, %4"PRId64" ns CPU per datagram%s\n", r->mbps,
+        r->sent, r->lost, r->received_mbps,
+        received ? cpu * (1000000000 / CLOCK_FREQ) / received : 0,
+        complete ? "" : ", end of round lost");
+    return complete;
+}
+
+static void test_throughput(libvlc_int_t *obj)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof (addr);
+    char mrl[32];
+
+    /* find a free port */
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    assert(bind(fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&addr, &addrlen) == 0);
+    close(fd);
+
+    var_Create(obj, "udp-rcvbuf", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "udp-rcvbuf", 4 << 20);
+    var_Create(obj, "udp-timeout", VLC_VAR_INTEGER);
+    var_SetInteger(obj, "udp-timeout", 1);
+
+    snprintf(mrl, sizeof (mrl), "udp://@127.0.0.1:%u", ntohs(addr.sin_port));
+    stream_t *access = vlc_access_NewMRL(VLC_OBJECT(obj), mrl);
+    assert(access != NULL);
+
+    struct round r = { .fd = socket(AF_INET, SOCK_DGRAM, 0) };
+    assert(r.fd != -1);
+    assert(connect(r.fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+
+    /* Larger datagrams than expected are truncated once, then the ring
+     * slots grow to fit them */
+    static uint8_t big[3 * DGRAM_SIZE];
+    for (unsigned i = 0; i < 2; i++)
+    {
+        assert(send(r.fd, big, sizeof (big), 0) == sizeof (big));
+
+        block_t *block = vlc_stream_ReadBlock(access);
+        assert(block != NULL);
+        assert(!(block->i_flags & BLOCK_FLAG_CORRUPTED) == (i > 0));
+        if (i > 0)
+            assert(block->i_buffer == sizeof (big));
+        block_Release(block);
+    }
+
+    /* Losses depend on the machine load: they are only reported. From a
+     * modest IPTV multicast bundle, double the rate until some occur. */
+    double best = 0.;
+    for (r.mbps = 50; r.mbps <= 12800; r.mbps *= 2)
+    {
+        if (!RunRound(access, &r) || r.lost > 0)
+            break;
+        best = r.received_mbps;
+        r.id++;
+    }
+    log("  max sustained rate without loss: %.0f Mbit/s\n", best);
+
+    close(r.fd);
+    vlc_stream_Delete(access);
+}
+
+int main(void)
+{
+    libvlc_instance_t *vlc;
+
+    test_init();
+
+    log("Testing the UDP access receive rate\n");
+    vlc = libvlc_new(test_defaults_nargs, test_defaults_args);
+    assert(vlc != NULL);
+
+    test_throughput(vlc->p_libvlc_int);
+
+    libvlc_release(vlc);
+    return 0;
+}
+#else
+int main(void)
+{
+    return 77;
+}
+#endif
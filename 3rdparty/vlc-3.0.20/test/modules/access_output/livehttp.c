@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * livehttp.c: HTTP Live streaming output segment writer test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+/* 100 ms blocks of 7 TS packets, in 1 s segments: a segment is closed by
+ * the block that reaches its length, so it holds 9 blocks */
+#define BLOCKS      300
+#define BLOCK_SIZE  (7 * 188)
+#define BLOCK_LEN   (CLOCK_FREQ / 10)
+#define SEGMENTS    ((BLOCKS + 8) / 9)
+
+static char dir[] = "/tmp/vlc-test-livehttp-XXXXXX";
+
+static uint8_t StreamByte(uint64_t offset)
+{
+    return offset * 7 + (offset >> 8);
+}
+
+/* Reads the index while the segments are written: every index seen must
+ * be whole, list the segments in order, and only list segments that are
+ * complete, i.e. that do not change afterwards. */
+struct watcher
+{
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    bool stop;
+    unsigned listed;
+    unsigned reads;
+    off_t sizes[SEGMENTS + 1];
+};
+
+static char *SegmentPath(unsigned n)
+{
+    char *path;
+    assert(asprintf(&path, "%s/seg-%03u.ts", dir, n) >= 0);
+    return path;
+}
+
+static void CheckIndex(struct watcher *w, const char *index)
+{
+    FILE *f = fopen(index, "rt");
+    if (f == NULL)
+        return; /* not written yet */
+
+    char line[256];
+    unsigned n = 0;
+    bool first = true;
+
+    while (fgets(line, sizeof (line), f) != NULL)
+    {
+        size_t len = strlen(line);
+        assert(len > 0 && line[len - 1] == '\n');
+        if (first)
+            assert(!strcmp(line, "#EXTM3U\n"));
+        first = false;
+        if (line[0] == '#')
+            continue;
+
+        unsigned seg;
+        assert(sscanf(line, "seg-%u.ts", &seg) == 1);
+        assert(seg == ++n);
+        assert(seg <= SEGMENTS);
+
+        char *path = SegmentPath(seg);
+        struct stat st;
+        assert(stat(path, &st) == 0);
+        free(path);
+        assert(st.st_size > 0 && st.st_size % 188 == 0);
+        if (w->sizes[seg] == 0)
+            w->sizes[seg] = st.st_size;
+        else
+            assert(w->sizes[seg] == st.st_size);
+    }
+    fclose(f);
+
+    assert(!first);
+    assert(n >= w->listed);
+    w->listed = n;
+    w->reads++;
+}
+
+static void *Watch(void *data)
+{
+    struct watcher *w = data;
+    char *index;
+    assert(asprintf(&index, "%s/index.m3u8", dir) >= 0);
+
+    vlc_mutex_lock(&w->lock);
+    while (!w->stop)
+    {
+        vlc_mutex_unlock(&w->lock);
+        CheckIndex(w, index);
+        mwait(mdate() + CLOCK_FREQ / 1000);
+        vlc_mutex_lock(&w->lock);
+    }
+    vlc_mutex_unlock(&w->lock);
+
+    CheckIndex(w, index);
+    free(index);
+    return NULL;
+}
+
+/* The segments, in index order, hold the whole stream in order */
+static void CheckSegments(const struct watcher *w)
+{
+    uint64_t offset = 0;
+
+    for (unsigned seg = 1; seg <= w->listed; seg++)
+    {
+        char *path = SegmentPath(seg);
+        FILE *f = fopen(path, "rb");
+        assert(f != NULL);
+
+        off_t size = 0;
+        int c;
+        while ((c = getc(f)) != EOF)
+        {
+            assert(c == StreamByte(offset));
+            offset++;
+            size++;
+        }
+        fclose(f);
+        assert(size == w->sizes[seg]);
+        unlink(path);
+        free(path);
+    }
+    assert(offset == (uint64_t)BLOCKS * BLOCK_SIZE);
+}
+
+static void test_livehttp(libvlc_int_t *obj)
+{
+    struct watcher w = { .stop = false };
+    char *access, *path;
+
+    assert(asprintf(&access, "livehttp{seglen=1,splitanywhere,delsegs=false,"
+                    "writer-queue=1,index=%s/index.m3u8,"
+                    "index-url=seg-###.ts}", dir) >= 0);
+    assert(asprintf(&path, "%s/seg-###.ts", dir) >= 0);
+
+    vlc_mutex_init(&w.lock);
+    assert(vlc_clone(&w.thread, Watch, &w, VLC_THREAD_PRIORITY_LOW) == 0);
+
+    sout_access_out_t *out = sout_AccessOutNew(obj, access, path);
+    assert(out != NULL);
+    free(access);
+    free(path);
+
+    uint64_t offset = 0;
+    for (unsigned i = 0; i < BLOCKS; i++)
+    {
+        block_t *block = block_Alloc(BLOCK_SIZE);
+        assert(block != NULL);
+        for (size_t j = 0; j < BLOCK_SIZE; j++)
+            block->p_buffer[j] = StreamByte(offset++);
+        block->i_dts = block->i_pts = VLC_TICK_0 + i * BLOCK_LEN;
+        block->i_length = BLOCK_LEN;
+        assert(sout_AccessOutWrite(out, block) >= 0);
+    }
+    /* flushes the last segment and ends the index */
+    sout_AccessOutDelete(out);
+
+    vlc_mutex_lock(&w.lock);
+    w.stop = true;
+    vlc_mutex_unlock(&w.lock);
+    vlc_join(w.thread, NULL);
+    vlc_mutex_destroy(&w.lock);
+
+    log("  %u segments, index read %u times while writing\n",
+        w.listed, w.reads);
+    assert(w.listed == SEGMENTS);
+
+    /* the final index is the complete one */
+    char *index;
+    assert(asprintf(&index, "%s/index.m3u8", dir) >= 0);
+    FILE *f = fopen(index, "rt");
+    assert(f != NULL);
+    char line[256];
+    bool end = false;
+    while (fgets(line, sizeof (line), f) != NULL)
+        end = !strcmp(line, "#EXT-X-ENDLIST\n");
+    fclose(f);
+    assert(end);
+    unlink(index);
+    free(index);
+
+    CheckSegments(&w);
+}
+
+int main(void)
+{
+    test_init();
+    assert(mkdtemp(dir) != NULL);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    log("Testing the segment writer order and the index updates\n");
+    test_livehttp(vlc->p_libvlc_int);
+
+    libvlc_release(vlc);
+    assert(rmdir(dir) == 0);
+    return 0;
+}
@@ -0,0 +1,337 @@
+/*****************************************************************************
+ * ebml_walker.c: matroska in-memory cluster walker and lacing test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+
+#include "../../libvlc/test.h"
+#include "../../../modules/demux/mkv/ebml_walker.c"
+
+/* 32 MiB clusters of audio blocks of 8 laced frames, as the largest
+ * prefetched cluster */
+#define CLUSTER_SIZE (32 << 20)
+#define LACES        8
+#define ROUNDS       4
+
+static uint8_t FrameByte(unsigned block, unsigned frame, size_t i)
+{
+    return block * 31 + frame * 7 + i;
+}
+
+static size_t FrameSize(unsigned block, unsigned frame, unsigned lacing)
+{
+    if (lacing == 2) /* fixed */
+        return 200 + block % 50;
+    return 100 + (block * 13 + frame * 89) % 400;
+}
+
+/* Writes value on len bytes, with the length marker */
+static uint8_t *PutVint(uint8_t *p, uint64_t value, unsigned len)
+{
+    value |= UINT64_C(1) << (7 * len);
+    for (unsigned i = 0; i < len; i++)
+        p[i] = value >> (8 * (len - 1 - i));
+    return p + len;
+}
+
+static unsigned VintLen(uint64_t value)
+{
+    unsigned len = 1;
+    while (value >= (UINT64_C(1) << (7 * len)) - 1)
+        len++;
+    return len;
+}
+
+static uint8_t *PutSignedVint(uint8_t *p, int64_t value)
+{
+    unsigned len = 1;
+    while (llabs(value) >= (INT64_C(1) << (7 * len - 1)) - 1)
+        len++;
+    return PutVint(p, value + ((INT64_C(1) << (7 * len - 1)) - 1), len);
+}
+
+static uint8_t *PutId(uint8_t *p, uint32_t id)
+{
+    unsigned len = id > 0xFFFFFF ? 4 : id > 0xFFFF ? 3 : id > 0xFF ? 2 : 1;
+    for (unsigned i = 0; i < len; i++)
+        p[i] = id >> (8 * (len - 1 - i));
+    return p + len;
+}
+
+/* Block of track 1 + block % 3, with the lacing type block % 4 */
+static size_t WriteBlock(uint8_t *p, unsigned block)
+{
+    const unsigned lacing = block % 4;
+    const unsigned frames = lacing ? LACES : 1;
+    uint8_t *q = p;
+
+    q = PutVint(q, 1 + block % 3, 1);
+    SetWBE(q, block % 1000 - 500);
+    q[2] = (block % 10 == 0 ? MKV_BLOCK_KEYFRAME : 0) | (lacing << 1);
+    q += 3;
+
+    if (lacing)
+    {
+        *(q++) = frames - 1;
+        for (unsigned f = 0; f < frames - 1; f++)
+        {
+            size_t size = FrameSize(block, f, lacing);
+            if (lacing == 1)
+            {
+                for (; size >= 255; size -= 255)
+                    *(q++) = 255;
+                *(q++) = size;
+            }
+            else if (lacing == 3)
+            {
+                if (f == 0)
+                    q = PutVint(q, size, VintLen(size));
+                else
+                    q = PutSignedVint(q, (int64_t)size -
+                                         FrameSize(block, f - 1, lacing));
+            }
+        }
+    }
+
+    for (unsigned f = 0; f < frames; f++)
+        for (size_t i = 0; i < FrameSize(block, f, lacing); i++)
+            *(q++) = FrameByte(block, f, i);
+    return q - p;
+}
+
+/* Cluster of unknown size with a timecode, SimpleBlocks, and a BlockGroup
+ * every 16 blocks. Returns the number of blocks. */
+static unsigned WriteCluster(uint8_t *buf, size_t size, size_t *written)
+{
+    static uint8_t block[4096];
+    uint8_t *p = PutId(buf, EBML_ID_CLUSTER);
+    unsigned blocks = 0;
+
+    *(p++) = 0xFF; /* unknown size */
+    p = PutId(p, EBML_ID_CLUSTERTIMECODE);
+    p = PutVint(p, 2, 1);
+    SetWBE(p, 1000);
+    p += 2;
+
+    for (;;)
+    {
+        size_t len = WriteBlock(block, blocks);
+        const bool group = blocks % 16 == 15;
+        size_t need = 1 + 4 + len + (group ? 1 + 4 : 0);
+
+        if ((size_t)(p - buf) + need > size)
+            break;
+        if (group)
+        {
+            p = PutId(p, EBML_ID_BLOCKGROUP);
+            p = PutVint(p, 1 + 4 + len, 4);
+            p = PutId(p, EBML_ID_BLOCK);
+        }
+        else
+            p = PutId(p, EBML_ID_SIMPLEBLOCK);
+        p = PutVint(p, len, 4);
+        memcpy(p, block, len);
+        p += len;
+        blocks++;
+    }
+    *written = p - buf;
+    return blocks;
+}
+
+static void CheckBlock(const mkv_block_t *b, const uint8_t *data,
+                       size_t size, unsigned block)
+{
+    const unsigned lacing = block % 4;
+    const unsigned frames = lacing ? LACES : 1;
+
+    assert(b->i_track == 1 + block % 3);
+    assert(b->i_timecode == (int16_t)(block % 1000 - 500));
+    assert(!!(b->i_flags & MKV_BLOCK_KEYFRAME) == (block % 10 == 0));
+    assert(b->i_frames == frames);
+    for (unsigned f = 0; f < frames; f++)
+    {
+        assert(b->pi_size[f] == FrameSize(block, f, lacing));
+        assert(b->pi_offset[f] + b->pi_size[f] <= size);
+        const uint8_t *frame = &data[b->pi_offset[f]];
+        assert(frame[0] == FrameByte(block, f, 0));
+        assert(frame[b->pi_size[f] - 1] ==
+               FrameByte(block, f, b->pi_size[f] - 1));
+    }
+    assert(b->pi_offset[frames - 1] + b->pi_size[frames - 1] == size);
+}
+
+/* Walks the cluster, checking every block if check. Returns the number
+ * of frames. */
+static unsigned WalkCluster(const uint8_t *buf, size_t size, bool check,
+                            unsigned blocks)
+{
+    static mkv_block_t b;
+    ebml_walker_t top, cluster;
+    ebml_element_t el;
+    unsigned block = 0, frames = 0;
+
+    ebml_WalkerInit(&top, buf, size);
+    assert(ebml_WalkerNext(&top, &el) == 1);
+    assert(el.i_id == EBML_ID_CLUSTER && el.i_size == EBML_SIZE_UNKNOWN);
+    ebml_WalkerEnter(&cluster, &top, &el);
+
+    int val;
+    while ((val = ebml_WalkerNext(&cluster, &el)) == 1)
+    {
+        switch (el.i_id)
+        {
+            case EBML_ID_CLUSTERTIMECODE:
+                assert(el.i_size == 2 && GetWBE(el.p_data) == 1000);
+                continue;
+            case EBML_ID_BLOCKGROUP:
+            {
+                ebml_walker_t group;
+                ebml_WalkerEnter(&group, &cluster, &el);
+                assert(ebml_WalkerNext(&group, &el) == 1);
+                assert(el.i_id == EBML_ID_BLOCK);
+                assert(ebml_WalkerNext(&group, &el) == 0);
+                break;
+            }
+            case EBML_ID_SIMPLEBLOCK:
+                break;
+            default:
+                assert(!"unexpected element");
+        }
+        assert(mkv_BlockParse(&b, el.p_data, el.i_size) == VLC_SUCCESS);
+        if (check)
+            CheckBlock(&b, el.p_data, el.i_size, block);
+        frames += b.i_frames;
+        block++;
+    }
+    assert(val == 0);
+    assert(block == blocks);
+    return frames;
+}
+
+static void test_invalid(void)
+{
+    static mkv_block_t b;
+    ebml_walker_t w;
+    ebml_element_t el;
+
+    /* no length marker in the first byte */
+    static const uint8_t zero[] = { 0x00, 0x81, 0x00 };
+    ebml_WalkerInit(&w, zero, sizeof (zero));
+    assert(ebml_WalkerNext(&w, &el) == -1);
+
+    /* ID longer than 4 bytes */
+    static const uint8_t id[] = { 0x08, 0x00, 0x00, 0x00, 0x00, 0x80 };
+    ebml_WalkerInit(&w, id, sizeof (id));
+    assert(ebml_WalkerNext(&w, &el) == -1);
+
+    /* data beyond the buffer, the walker stays on the element */
+    static const uint8_t trunc[] = { 0xA3, 0x85, 0x81, 0x00, 0x00, 0x00 };
+    ebml_WalkerInit(&w, trunc, sizeof (trunc));
+    assert(ebml_WalkerNext(&w, &el) == -1);
+    assert(w.i_pos == 0);
+    ebml_WalkerInit(&w, trunc, sizeof (trunc) - 1);
+    assert(ebml_WalkerNext(&w, &el) == -1);
+
+    /* 2 frames of 1 and 2 bytes */
+    static const uint8_t xiph[] = { 0x81, 0, 0, 0x02, 1, 1, 0xA, 0xB, 0xB };
+    assert(mkv_BlockParse(&b, xiph, sizeof (xiph)) == VLC_SUCCESS);
+    assert(b.i_frames == 2 && b.pi_size[0] == 1 && b.pi_size[1] == 2);
+    assert(b.pi_offset[0] == 6 && b.pi_offset[1] == 7);
+    /* Xiph size beyond the data */
+    assert(mkv_BlockParse(&b, xiph, 6) == VLC_EGENERIC);
+    /* lace count missing */
+    assert(mkv_BlockParse(&b, xiph, 4) == VLC_EGENERIC);
+
+    /* 3 fixed frames in 7 bytes */
+    static const uint8_t fixed[] = { 0x81, 0, 0, 0x04, 2, 1, 2, 3, 4, 5, 6, 7 };
+    assert(mkv_BlockParse(&b, fixed, sizeof (fixed)) == VLC_EGENERIC);
+    assert(mkv_BlockParse(&b, fixed, sizeof (fixed) - 1) == VLC_SUCCESS);
+    assert(b.i_frames == 3 && b.pi_size[2] == 2 && b.pi_offset[2] == 9);
+
+    /* EBML lacing: 3 frames of 2, 1 and 2 bytes, then a negative size */
+    static const uint8_t ebml[] = { 0x81, 0, 0, 0x06, 2, 0x82, 0xBE,
+                                    1, 1, 2, 3, 3 };
+    assert(mkv_BlockParse(&b, ebml, sizeof (ebml)) == VLC_SUCCESS);
+    assert(b.i_frames == 3);
+    assert(b.pi_size[0] == 2 && b.pi_size[1] == 1 && b.pi_size[2] == 2);
+    assert(b.pi_offset[0] == 7 && b.pi_offset[2] == 10);
+    static const uint8_t negative[] = { 0x81, 0, 0, 0x06, 2, 0x81, 0xBC,
+                                        1, 2, 3 };
+    assert(mkv_BlockParse(&b, negative, sizeof (negative)) == VLC_EGENERIC);
+
+    /* a single laced frame has no size */
+    static const uint8_t single[] = { 0x81, 0, 0, 0x06, 0, 1, 2, 3 };
+    assert(mkv_BlockParse(&b, single, sizeof (single)) == VLC_SUCCESS);
+    assert(b.i_frames == 1 && b.pi_offset[0] == 5 && b.pi_size[0] == 3);
+
+    /* 2 bytes track number */
+    static const uint8_t track[] = { 0x40, 0x80, 0xFF, 0xFF, 0x80 };
+    assert(mkv_BlockParse(&b, track, sizeof (track)) == VLC_SUCCESS);
+    assert(b.i_track == 128 && b.i_timecode == -1 && b.i_frames == 1);
+    assert(b.pi_size[0] == 0);
+}
+
+int main(void)
+{
+    test_init();
+
+    log("Testing invalid elements and blocks\n");
+    test_invalid();
+
+    uint8_t *buf = malloc(CLUSTER_SIZE);
+    uint8_t *copy = malloc(CLUSTER_SIZE);
+    assert(buf != NULL && copy != NULL);
+
+    size_t size;
+    unsigned blocks = WriteCluster(buf, CLUSTER_SIZE, &size);
+    log("Walking a %zu MiB cluster of %u blocks\n", size >> 20, blocks);
+    unsigned frames = WalkCluster(buf, size, true, blocks);
+
+    /* the cost of the walk, against a single copy of the cluster */
+    mtime_t walk = 0, memcpy_time = 0;
+    for (unsigned i = 0; i < ROUNDS; i++)
+    {
+        mtime_t start = mdate();
+        assert(WalkCluster(buf, size, false, blocks) == frames);
+        walk += mdate() - start;
+
+        start = mdate();
+        memcpy(copy, buf, size);
+        memcpy_time += mdate() - start;
+        assert(copy[size - 1] == buf[size - 1]);
+    }
+
+    log("  %u frames, walked and split in %"PRId64" us per cluster "
+        "(%"PRId64" MiB/s), copied in %"PRId64" us (%"PRId64" MiB/s)\n",
+        frames, walk / ROUNDS,
+        walk > 0 ? (int64_t)((uint64_t)size * ROUNDS * CLOCK_FREQ / walk) >> 20 : 0,
+        memcpy_time / ROUNDS,
+        memcpy_time > 0 ? (int64_t)((uint64_t)size * ROUNDS * CLOCK_FREQ / memcpy_time) >> 20 : 0);
+
+    free(copy);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*****************************************************************************
+ * es.c: MPEG audio demuxer frame index and seek test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+/* VBR MPEG-1 layer III, mono at 44.1 kHz, silent */
+#define FRAMES   4000
+#define SAMPLES  1152
+#define RATE     44100
+#define INTERVAL (CLOCK_FREQ / 4 + CLOCK_FREQ * SAMPLES / RATE) /* points */
+
+static const unsigned bitrates[15] = {
+    0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320,
+};
+
+static unsigned FrameBitrate(unsigned i)
+{
+    return 1 + (i * 7 + i / 5) % 14;
+}
+
+static bool FramePadding(unsigned i)
+{
+    return i % 3 == 0;
+}
+
+static size_t FrameSize(unsigned i)
+{
+    return 144000 * bitrates[FrameBitrate(i)] / RATE + FramePadding(i);
+}
+
+static void WriteFile(const char *path)
+{
+    static uint8_t frame[1500];
+    FILE *f = fopen(path, "wb");
+
+    assert(f != NULL);
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        frame[0] = 0xff;
+        frame[1] = 0xfb; /* MPEG-1 layer III, no CRC */
+        frame[2] = (FrameBitrate(i) << 4) | (FramePadding(i) << 1);
+        frame[3] = 0xc0; /* mono */
+        assert(fwrite(frame, FrameSize(i), 1, f) == 1);
+    }
+    assert(fclose(f) == 0);
+}
+
+/* Records the frames of a linear playback, then checks those after seeks */
+struct checker
+{
+    es_out_t out;
+    mtime_t pts[FRAMES];
+    unsigned count;
+    bool linear;
+    unsigned next; /* expected frame, after the first one once seeked */
+    mtime_t display; /* next display time */
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    assert(fmt->i_cat == AUDIO_ES);
+    assert(fmt->i_codec == VLC_CODEC_MPGA);
+    return (es_out_id_t *)out;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct checker *c = (struct checker *)out;
+
+    assert(id == (es_out_id_t *)out);
+    if (c->linear)
+    {
+        assert(c->count < FRAMES);
+        assert(block->i_buffer == FrameSize(c->count));
+        c->pts[c->count] = block->i_pts;
+    }
+    else
+    {
+        if (c->count == 0)
+        {   /* the first frame after a seek: find it in the linear playback */
+            c->next = 0;
+            while (c->next < FRAMES && c->pts[c->next] != block->i_pts)
+                c->next++;
+        }
+        assert(c->next < FRAMES);
+        /* the timeline restarts on the frame: the rounding of the sample
+         * count to microseconds may differ by one */
+        assert(llabs(block->i_pts - c->pts[c->next]) <= 1);
+        assert(block->i_buffer == FrameSize(c->next));
+        c->next++;
+    }
+    c->count++;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    struct checker *c = (struct checker *)out;
+
+    if (query == ES_OUT_SET_NEXT_DISPLAY_TIME)
+        c->display = va_arg(args, int64_t);
+    return VLC_SUCCESS;
+}
+
+/* Seeks, then checks that playback restarts on the indexed frame before */
+static void SeekTo(demux_t *demux, struct checker *c, mtime_t time,
+                   bool precise)
+{
+    c->count = 0;
+    c->display = VLC_TS_INVALID;
+    assert(demux_Control(demux, DEMUX_SET_TIME, time, precise)
+           == VLC_SUCCESS);
+    while (c->count < 10)
+        assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+
+    const mtime_t first = c->pts[c->next - c->count];
+    assert(first <= VLC_TS_0 + time);
+    assert(VLC_TS_0 + time - first < INTERVAL);
+    assert(c->display == (precise ? VLC_TS_0 + time : VLC_TS_INVALID));
+}
+
+static void test_es(libvlc_int_t *obj, const char *path)
+{
+    struct checker c = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+        },
+        .linear = true,
+    };
+    char *url = vlc_path2uri(path, NULL);
+    assert(url != NULL);
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+    demux_t *demux = demux_New(VLC_OBJECT(obj), "mp3", path, s, &c.out);
+    assert(demux != NULL);
+    free(url);
+
+    /* every frame, timed by sample count */
+    int ret;
+    while ((ret = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+    assert(ret == VLC_DEMUXER_EOF);
+    assert(c.count == FRAMES);
+
+    date_t date;
+    date_Init(&date, RATE, 1);
+    date_Set(&date, 0);
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        assert(c.pts[i] == VLC_TS_0 + date_Get(&date));
+        date_Increment(&date, SAMPLES);
+    }
+
+    /* exact once indexed, unlike the bitrate estimate */
+    const mtime_t length = date_Get(&date);
+    int64_t val;
+    while (demux_Control(demux, DEMUX_GET_LENGTH, &val) != VLC_SUCCESS
+        || val != length)
+        mwait(mdate() + CLOCK_FREQ / 100);
+
+    c.linear = false;
+    SeekTo(demux, &c, 0, false);
+    SeekTo(demux, &c, 30 * CLOCK_FREQ + 500000, false);
+    SeekTo(demux, &c, 77777777, true);
+    SeekTo(demux, &c, 12 * CLOCK_FREQ, true);
+    SeekTo(demux, &c, length - CLOCK_FREQ, false);
+
+    /* the same frames until the end */
+    while ((ret = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+    assert(ret == VLC_DEMUXER_EOF);
+    assert(c.next == FRAMES);
+
+    demux_Delete(demux);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/vlc-test-es-XXXXXX";
+    int fd = mkstemp(path);
+
+    test_init();
+
+    assert(fd != -1);
+    close(fd);
+    WriteFile(path);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    log("Testing the MPEG audio frame index\n");
+    test_es(vlc->p_libvlc_int, path);
+
+    libvlc_release(vlc);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,573 @@
+/*****************************************************************************
+ * mp4.c: MP4 demuxer open time, memory and seek test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+/* A 11.6 hours long 25 fps video track, with the worst case sample tables:
+ * one stts and one ctts entry per sample */
+#define SAMPLES    (1 << 20)
+#define CHUNK      16
+#define GOP        32
+#define TIMESCALE  90000
+#define DURATION   3600
+
+/* Sample durations alternate around DURATION */
+static int64_t SampleDts(uint32_t i)
+{
+    return (int64_t)DURATION * i - 3 * (i & 1);
+}
+
+static uint32_t SampleDuration(uint32_t i)
+{
+    return (i & 1) ? DURATION + 3 : DURATION - 3;
+}
+
+/* I P B B */
+static uint32_t SampleCts(uint32_t i)
+{
+    static const uint32_t offsets[4] = {
+        DURATION, 3 * DURATION, 0, DURATION / 2,
+    };
+    return offsets[i % 4];
+}
+
+static uint32_t SampleSize(uint32_t i)
+{
+    return 8 + (i % 4);
+}
+
+static mtime_t SampleTime(int64_t t)
+{
+    return VLC_TS_0 + t * CLOCK_FREQ / TIMESCALE;
+}
+
+static void W8(FILE *f, uint8_t v)
+{
+    putc(v, f);
+}
+
+static void W16(FILE *f, uint16_t v)
+{
+    W8(f, v >> 8);
+    W8(f, v);
+}
+
+static void W32(FILE *f, uint32_t v)
+{
+    W16(f, v >> 16);
+    W16(f, v);
+}
+
+static void WZero(FILE *f, size_t n)
+{
+    while (n-- > 0)
+        W8(f, 0);
+}
+
+static long BoxStart(FILE *f, const char *type)
+{
+    long pos = ftell(f);
+
+    W32(f, 0);
+    fwrite(type, 4, 1, f);
+    return pos;
+}
+
+static long FullBoxStart(FILE *f, const char *type, uint32_t flags)
+{
+    long pos = BoxStart(f, type);
+
+    W32(f, flags);
+    return pos;
+}
+
+static void BoxEnd(FILE *f, long pos)
+{
+    long end = ftell(f);
+
+    fseek(f, pos, SEEK_SET);
+    W32(f, end - pos);
+    fseek(f, end, SEEK_SET);
+}
+
+static void WriteMatrix(FILE *f)
+{
+    static const uint32_t matrix[9] = {
+        0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000,
+    };
+
+    for (unsigned i = 0; i < 9; i++)
+        W32(f, matrix[i]);
+}
+
+/* The track of the first samples, all in chunks if any */
+static void WriteTrak(FILE *f, uint32_t samples, const uint32_t *chunks)
+{
+    long box, trak, mdia, minf, stbl;
+
+    trak = BoxStart(f, "trak");
+    box = FullBoxStart(f, "tkhd", 3);
+    W32(f, 0); W32(f, 0);
+    W32(f, 1); W32(f, 0);
+    W32(f, (uint64_t)samples * DURATION * 1000 / TIMESCALE);
+    WZero(f, 16);
+    WriteMatrix(f);
+    W32(f, 320 << 16); W32(f, 240 << 16);
+    BoxEnd(f, box);
+
+    mdia = BoxStart(f, "mdia");
+    box = FullBoxStart(f, "mdhd", 0);
+    W32(f, 0); W32(f, 0);
+    W32(f, TIMESCALE);
+    W32(f, samples * DURATION);
+    W16(f, 0x55c4); W16(f, 0);
+    BoxEnd(f, box);
+
+    box = FullBoxStart(f, "hdlr", 0);
+    W32(f, 0);
+    fwrite("vide", 4, 1, f);
+    WZero(f, 13);
+    BoxEnd(f, box);
+
+    minf = BoxStart(f, "minf");
+    box = FullBoxStart(f, "vmhd", 1);
+    WZero(f, 8);
+    BoxEnd(f, box);
+
+    long dinf = BoxStart(f, "dinf");
+    long dref = FullBoxStart(f, "dref", 0);
+    W32(f, 1);
+    box = FullBoxStart(f, "url ", 1);
+    BoxEnd(f, box);
+    BoxEnd(f, dref);
+    BoxEnd(f, dinf);
+
+    stbl = BoxStart(f, "stbl");
+    long stsd = FullBoxStart(f, "stsd", 0);
+    W32(f, 1);
+    box = BoxStart(f, "mp4v");
+    WZero(f, 6); W16(f, 1);
+    WZero(f, 16);
+    W16(f, 320); W16(f, 240);
+    W32(f, 0x480000); W32(f, 0x480000);
+    W32(f, 0);
+    W16(f, 1);
+    WZero(f, 32);
+    W16(f, 24); W16(f, 0xffff);
+    BoxEnd(f, box);
+    BoxEnd(f, stsd);
+
+    box = FullBoxStart(f, "stts", 0);
+    W32(f, samples);
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        W32(f, 1);
+        W32(f, SampleDuration(i));
+    }
+    BoxEnd(f, box);
+
+    if (samples > 0)
+    {
+        box = FullBoxStart(f, "ctts", 0);
+        W32(f, samples);
+        for (uint32_t i = 0; i < samples; i++)
+        {
+            W32(f, 1);
+            W32(f, SampleCts(i));
+        }
+        BoxEnd(f, box);
+
+        box = FullBoxStart(f, "stss", 0);
+        W32(f, samples / GOP);
+        for (uint32_t i = 0; i < samples; i += GOP)
+            W32(f, i + 1);
+        BoxEnd(f, box);
+    }
+
+    box = FullBoxStart(f, "stsc", 0);
+    W32(f, samples > 0);
+    if (samples > 0)
+    {
+        W32(f, 1); W32(f, CHUNK); W32(f, 1);
+    }
+    BoxEnd(f, box);
+
+    box = FullBoxStart(f, "stsz", 0);
+    W32(f, 0);
+    W32(f, samples);
+    for (uint32_t i = 0; i < samples; i++)
+        W32(f, SampleSize(i));
+    BoxEnd(f, box);
+
+    box = FullBoxStart(f, "stco", 0);
+    W32(f, samples / CHUNK);
+    for (uint32_t i = 0; i < samples / CHUNK; i++)
+        W32(f, chunks[i]);
+    BoxEnd(f, box);
+
+    BoxEnd(f, stbl);
+    BoxEnd(f, minf);
+    BoxEnd(f, mdia);
+    BoxEnd(f, trak);
+}
+
+static void WriteHeader(FILE *f, uint32_t samples)
+{
+    long box = FullBoxStart(f, "mvhd", 0);
+    W32(f, 0); W32(f, 0);
+    W32(f, 1000);
+    W32(f, (uint64_t)samples * DURATION * 1000 / TIMESCALE);
+    W32(f, 0x10000); W16(f, 0x100); WZero(f, 10);
+    WriteMatrix(f);
+    WZero(f, 24);
+    W32(f, 2);
+    BoxEnd(f, box);
+}
+
+static void WriteFtyp(FILE *f)
+{
+    long box = BoxStart(f, "ftyp");
+    fwrite("isom", 4, 1, f);
+    W32(f, 0x200);
+    fwrite("isommp41", 8, 1, f);
+    BoxEnd(f, box);
+}
+
+static void WriteFile(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    uint32_t *chunks = malloc((SAMPLES / CHUNK) * sizeof (*chunks));
+    long box;
+
+    assert(f != NULL && chunks != NULL);
+
+    WriteFtyp(f);
+
+    /* Samples start with their number */
+    box = BoxStart(f, "mdat");
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        if (i % CHUNK == 0)
+            chunks[i / CHUNK] = ftell(f);
+        W32(f, i);
+        WZero(f, SampleSize(i) - 4);
+    }
+    BoxEnd(f, box);
+
+    long moov = BoxStart(f, "moov");
+    WriteHeader(f, SAMPLES);
+    WriteTrak(f, SAMPLES, chunks);
+    BoxEnd(f, moov);
+
+    assert(fclose(f) == 0);
+    free(chunks);
+}
+
+/* The same samples in fragments of a GOP, without any duration nor index:
+ * the fragments have to be walked to know either */
+#define FRAGMENTS  (SAMPLES / 4 / GOP)
+
+static long fragments[FRAGMENTS];
+static long fragmented_size;
+
+static void WriteFragmentedFile(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    long box;
+
+    assert(f != NULL);
+
+    WriteFtyp(f);
+
+    long moov = BoxStart(f, "moov");
+    WriteHeader(f, 0);
+    WriteTrak(f, 0, NULL);
+    long mvex = BoxStart(f, "mvex");
+    box = FullBoxStart(f, "trex", 0);
+    W32(f, 1); W32(f, 1);
+    W32(f, 0); W32(f, 0); W32(f, 0);
+    BoxEnd(f, box);
+    BoxEnd(f, mvex);
+    BoxEnd(f, moov);
+
+    for (uint32_t n = 0; n < FRAGMENTS; n++)
+    {
+        const uint32_t first = n * GOP;
+
+        fragments[n] = ftell(f);
+        long moof = BoxStart(f, "moof");
+        box = FullBoxStart(f, "mfhd", 0);
+        W32(f, n + 1);
+        BoxEnd(f, box);
+
+        long traf = BoxStart(f, "traf");
+        box = FullBoxStart(f, "tfhd", 0x020000); /* default base is moof */
+        W32(f, 1);
+        BoxEnd(f, box);
+        box = FullBoxStart(f, "tfdt", 0x01000000);
+        W32(f, 0); W32(f, SampleDts(first));
+        BoxEnd(f, box);
+
+        /* data offset, sample duration, size, flags and CTS offset */
+        box = FullBoxStart(f, "trun", 0xF01);
+        W32(f, GOP);
+        long offset = ftell(f);
+        W32(f, 0);
+        for (uint32_t i = first; i < first + GOP; i++)
+        {
+            W32(f, SampleDuration(i));
+            W32(f, SampleSize(i));
+            W32(f, (i % GOP) ? 0x01010000 : 0x02000000);
+            W32(f, SampleCts(i));
+        }
+        BoxEnd(f, box);
+        BoxEnd(f, traf);
+        BoxEnd(f, moof);
+
+        long mdat = ftell(f);
+        fseek(f, offset, SEEK_SET);
+        W32(f, mdat + 8 - moof);
+        fseek(f, mdat, SEEK_SET);
+
+        box = BoxStart(f, "mdat");
+        for (uint32_t i = first; i < first + GOP; i++)
+        {
+            W32(f, i);
+            WZero(f, SampleSize(i) - 4);
+        }
+        BoxEnd(f, box);
+    }
+
+    fragmented_size = ftell(f);
+    assert(fclose(f) == 0);
+}
+
+/* Checks that the demuxed samples come in order, with their own timestamps */
+struct checker
+{
+    es_out_t out;
+    uint32_t next;
+    unsigned count;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) fmt;
+    return (es_out_id_t *)out;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct checker *c = (struct checker *)out;
+
+    assert(id == (es_out_id_t *)out);
+    assert(block->i_buffer >= 4);
+
+    uint32_t i = GetDWBE(block->p_buffer);
+
+    assert(i == c->next);
+    assert(block->i_buffer == SampleSize(i));
+    assert(block->i_dts == SampleTime(SampleDts(i)));
+    assert(block->i_pts == SampleTime(SampleDts(i) + SampleCts(i)));
+
+    c->next = i + 1;
+    c->count++;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            (void) va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        default:
+            return VLC_SUCCESS;
+    }
+}
+
+static size_t ResidentBytes(void)
+{
+    FILE *stream = fopen("/proc/self/statm", "r");
+    unsigned long size, resident = 0;
+
+    if (stream == NULL)
+        return 0;
+    if (fscanf(stream, "%lu %lu", &size, &resident) != 2)
+        resident = 0;
+    fclose(stream);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Demuxes a few GOPs from the current position, starting with a sample */
+static void DemuxSome(demux_t *demux, struct checker *c, uint32_t first)
+{
+    c->count = 0;
+    c->next = first;
+    while (c->count < 4 * GOP)
+        assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+}
+
+static void test_mp4(libvlc_int_t *obj, const char *path)
+{
+    struct checker c = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+        },
+    };
+    char *url = vlc_path2uri(path, NULL);
+    assert(url != NULL);
+
+    size_t rss = ResidentBytes();
+    mtime_t start = mdate();
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+    demux_t *demux = demux_New(VLC_OBJECT(obj), "mp4", path, s, &c.out);
+    assert(demux != NULL);
+
+    mtime_t open_time = mdate() - start;
+    rss = ResidentBytes() - rss;
+    free(url);
+
+    log("  open %"PRId64" ms, %zu KiB more resident memory\n",
+        open_time / 1000, rss / 1024);
+
+    DemuxSome(demux, &c, 0);
+
+    /* Seek all over the file, then read on from there */
+    mtime_t seek_time = 0;
+    unsigned seeks = 0;
+
+    for (uint32_t i = SAMPLES - 1000; i > GOP; i = i * 7 / 10, seeks++)
+    {
+        mtime_t target = SampleTime(SampleDts(i)) - VLC_TS_0;
+
+        start = mdate();
+        assert(demux_Control(demux, DEMUX_SET_TIME, (int64_t)target,
+                             false) == VLC_SUCCESS);
+        seek_time += mdate() - start;
+        DemuxSome(demux, &c, i - i % GOP); /* from the previous sync sample */
+    }
+
+    log("  %u seeks, %"PRId64" us per seek\n", seeks, seek_time / seeks);
+    demux_Delete(demux);
+}
+
+/* Time to the first frame and of the first seek, while the fragments are
+ * still being indexed */
+static void test_fragments(libvlc_int_t *obj, const char *path)
+{
+    struct checker c = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+        },
+    };
+    char *url = vlc_path2uri(path, NULL);
+    assert(url != NULL);
+
+    mtime_t start = mdate();
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+    demux_t *demux = demux_New(VLC_OBJECT(obj), "mp4", path, s, &c.out);
+    assert(demux != NULL);
+    free(url);
+
+    while (c.count == 0)
+        assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    mtime_t first_frame = mdate() - start;
+    DemuxSome(demux, &c, c.next);
+
+    /* The duration is not known before the end: the position is a byte
+     * offset, within the fragment starting before it */
+    const double pos = 0.9;
+    unsigned n = FRAGMENTS - 1;
+    while (fragments[n] > pos * fragmented_size)
+        n--;
+
+    start = mdate();
+    assert(demux_Control(demux, DEMUX_SET_POSITION, pos, false) == VLC_SUCCESS);
+    mtime_t seek_time = mdate() - start;
+    DemuxSome(demux, &c, n * GOP);
+
+    log("  first frame after %"PRId64" us, first seek %"PRId64" us\n",
+        first_frame, seek_time);
+    demux_Delete(demux);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/vlc-test-mp4-XXXXXX";
+    int fd = mkstemp(path);
+
+    test_init();
+
+    assert(fd != -1);
+    close(fd);
+    log("Generating a %u samples MP4 file\n", SAMPLES);
+    WriteFile(path);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    log("Testing the MP4 demuxer sample tables\n");
+    test_mp4(vlc->p_libvlc_int, path);
+
+    log("Generating a %u samples fragmented MP4 file\n", FRAGMENTS * GOP);
+    WriteFragmentedFile(path);
+    log("Testing the MP4 demuxer fragments\n");
+    test_fragments(vlc->p_libvlc_int, path);
+
+    libvlc_release(vlc);
+    unlink(path);
+    return 0;
+}
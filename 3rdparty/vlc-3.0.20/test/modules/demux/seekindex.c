@@ -0,0 +1,331 @@
+/*****************************************************************************
+ * seekindex.c: demuxers seek index cache test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+#include "../../../modules/demux/seekindex.c"
+
+#define FILE_SIZE 100000
+#define FRAMES    2000 /* 52 s of VBR MPEG audio */
+
+const char vlc_module_name[] = "test_seekindex";
+
+static char cache_dir[] = "/tmp/vlc-test-seekindex-XXXXXX";
+static char media[] = "/tmp/vlc-test-seekindex-media-XXXXXX";
+
+static void WriteMedia(size_t size)
+{
+    FILE *f = fopen(media, "wb");
+    assert(f != NULL);
+    for (size_t i = 0; i < size; i++)
+        putc(i, f);
+    fclose(f);
+}
+
+/* Only file in the seekindex cache directory */
+static char *IndexFile(void)
+{
+    char *dir;
+    assert(asprintf(&dir, "%s/vlc/seekindex", cache_dir) >= 0);
+    DIR *d = opendir(dir);
+    char *path = NULL;
+
+    if (d != NULL)
+    {
+        const struct dirent *ent;
+        while ((ent = readdir(d)) != NULL)
+            if (ent->d_name[0] != '.')
+            {
+                assert(path == NULL);
+                assert(asprintf(&path, "%s/%s", dir, ent->d_name) >= 0);
+            }
+        closedir(d);
+    }
+    free(dir);
+    return path;
+}
+
+static void test_points(demux_t *demux)
+{
+    demux_index_entry_t before, after;
+    demux_index_t *idx = demux_IndexOpen(demux, "test");
+    assert(idx != NULL);
+
+    /* nothing cached yet */
+    assert(demux_IndexLookup(idx, 0, 0, &before, &after) == 0);
+
+    demux_IndexAdd(idx, 0, 3000, 30000);
+    demux_IndexAdd(idx, 0, 1000, 10000);
+    demux_IndexAdd(idx, 0, 2000, 20000);
+    demux_IndexAdd(idx, 0, 2000, 20001); /* already known */
+    demux_IndexAdd(idx, 1, 1500, 15000);
+
+    assert(demux_IndexLookup(idx, 0, 2500, &before, &after) ==
+           (DEMUX_INDEX_BEFORE | DEMUX_INDEX_AFTER));
+    assert(before.i_time == 2000 && before.i_pos == 20000);
+    assert(after.i_time == 3000 && after.i_pos == 30000);
+    assert(demux_IndexLookup(idx, 0, 2000, &before, &after) ==
+           (DEMUX_INDEX_BEFORE | DEMUX_INDEX_AFTER));
+    assert(before.i_time == 2000 && after.i_time == 3000);
+    assert(demux_IndexLookup(idx, 0, 500, &before, &after) == DEMUX_INDEX_AFTER);
+    assert(after.i_time == 1000);
+    assert(demux_IndexLookup(idx, 0, 5000, &before, NULL) == DEMUX_INDEX_BEFORE);
+    assert(before.i_time == 3000);
+    /* tracks don't mix */
+    assert(demux_IndexLookup(idx, 1, 5000, &before, &after) == DEMUX_INDEX_BEFORE);
+    assert(before.i_time == 1500);
+    assert(demux_IndexLookup(idx, 2, 5000, &before, &after) == 0);
+
+    assert(IndexFile() == NULL);
+    demux_IndexClose(idx);
+
+    /* saved on close, and loaded at the next opening */
+    char *path = IndexFile();
+    assert(path != NULL);
+    free(path);
+
+    idx = demux_IndexOpen(demux, "test");
+    assert(idx != NULL);
+    assert(demux_IndexLookup(idx, 0, 2500, &before, &after) ==
+           (DEMUX_INDEX_BEFORE | DEMUX_INDEX_AFTER));
+    assert(before.i_time == 2000 && before.i_pos == 20000);
+    assert(after.i_time == 3000 && after.i_pos == 30000);
+    assert(demux_IndexLookup(idx, 1, 1500, &before, NULL) == DEMUX_INDEX_BEFORE);
+    assert(before.i_pos == 15000);
+    demux_IndexClose(idx);
+}
+
+static void test_changed(demux_t *demux)
+{
+    demux_index_entry_t before;
+
+    /* another file size: the cached points are not used, then replaced */
+    WriteMedia(FILE_SIZE / 2);
+    demux_index_t *idx = demux_IndexOpen(demux, "test");
+    assert(idx != NULL);
+    assert(demux_IndexLookup(idx, 0, 2500, &before, NULL) == 0);
+    demux_IndexAdd(idx, 0, 1000, 10000);
+    demux_IndexClose(idx);
+
+    idx = demux_IndexOpen(demux, "test");
+    assert(idx != NULL);
+    assert(demux_IndexLookup(idx, 0, 2500, &before, NULL) == DEMUX_INDEX_BEFORE);
+    assert(before.i_time == 1000);
+    demux_IndexClose(idx);
+}
+
+static void test_invalid(demux_t *demux)
+{
+    demux_index_entry_t before;
+    char *path = IndexFile();
+    assert(path != NULL);
+
+    /* a point beyond the end of the file */
+    FILE *f = fopen(path, "r+b");
+    assert(f != NULL);
+    uint8_t pos[8];
+    SetQWBE(pos, FILE_SIZE);
+    assert(fseek(f, INDEX_HEADER + 12, SEEK_SET) == 0);
+    assert(fwrite(pos, sizeof (pos), 1, f) == 1);
+    fclose(f);
+
+    demux_index_t *idx = demux_IndexOpen(demux, "test");
+    assert(idx != NULL);
+    assert(demux_IndexLookup(idx, 0, 2500, &before, NULL) == 0);
+    demux_IndexClose(idx);
+
+    /* truncated */
+    assert(truncate(path, INDEX_HEADER + INDEX_ENTRY / 2) == 0);
+    idx = demux_IndexOpen(demux, "test");
+    assert(idx != NULL);
+    assert(demux_IndexLookup(idx, 0, 2500, &before, NULL) == 0);
+    demux_IndexClose(idx);
+
+    unlink(path);
+    free(path);
+}
+
+/* MPEG-1 layer III frames at 44.1 kHz, alternating 128 and 160 kbit/s */
+static void WriteMpga(void)
+{
+    FILE *f = fopen(media, "wb");
+    assert(f != NULL);
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        const uint8_t hdr[4] = { 0xFF, 0xFB, (i & 1) ? 0xA0 : 0x90, 0x44 };
+        const size_t size = (i & 1) ? 522 : 417;
+
+        fwrite(hdr, sizeof (hdr), 1, f);
+        for (size_t j = sizeof (hdr); j < size; j++)
+            putc(0, f);
+    }
+    fclose(f);
+}
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) out; (void) fmt;
+    return (es_out_id_t *)(uintptr_t)1;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    (void) out; (void) id;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out; (void) query; (void) args;
+    return VLC_SUCCESS;
+}
+
+static es_out_t es_out = {
+    .pf_add = EsOutAdd,
+    .pf_send = EsOutSend,
+    .pf_del = EsOutDel,
+    .pf_control = EsOutControl,
+};
+
+static demux_t *OpenEs(libvlc_int_t *vlc)
+{
+    char *url = vlc_path2uri(media, NULL);
+    assert(url != NULL);
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(vlc), url);
+    assert(s != NULL);
+    free(url);
+
+    demux_t *demux = demux_New(VLC_OBJECT(vlc), "es", media, s, &es_out);
+    assert(demux != NULL);
+    return demux;
+}
+
+/* The ES demuxer frame index is saved once complete, and reused */
+static void test_es(libvlc_int_t *vlc)
+{
+    date_t date;
+    date_Init(&date, 44100, 1);
+    date_Set(&date, 0);
+    date_Increment(&date, FRAMES * 1152);
+    const int64_t exact = date_Get(&date);
+
+    WriteMpga();
+    var_Create(vlc, "input-seek-index", VLC_VAR_BOOL);
+    var_SetBool(vlc, "input-seek-index", true);
+
+    demux_t *demux = OpenEs(vlc);
+    int64_t length = 0;
+    for (unsigned i = 0; i < 200 && length != exact; i++)
+    {
+        if (i > 0)
+            mwait(mdate() + CLOCK_FREQ / 20);
+        assert(demux_Control(demux, DEMUX_GET_LENGTH, &length) == VLC_SUCCESS);
+    }
+    assert(length == exact);
+    assert(IndexFile() == NULL);
+    demux_Delete(demux); /* and the stream */
+
+    char *path = IndexFile();
+    assert(path != NULL);
+    assert(strstr(path, "/es-") != NULL);
+
+    /* exact from the start, and seekable from the cached points */
+    demux = OpenEs(vlc);
+    assert(demux_Control(demux, DEMUX_GET_LENGTH, &length) == VLC_SUCCESS);
+    assert(length == exact);
+    assert(demux_Control(demux, DEMUX_SET_TIME, exact / 2, true) == VLC_SUCCESS);
+    assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    demux_Delete(demux); /* and the stream */
+
+    unlink(path);
+    free(path);
+}
+
+static void test_seekindex(libvlc_int_t *vlc)
+{
+    demux_t *demux = vlc_object_create(vlc, sizeof (*demux));
+    assert(demux != NULL);
+    demux->psz_file = media;
+
+    /* off by default */
+    assert(demux_IndexOpen(demux, "test") == NULL);
+    var_Create(demux, "input-seek-index", VLC_VAR_BOOL);
+    var_SetBool(demux, "input-seek-index", true);
+
+    /* only regular files */
+    demux->psz_file = cache_dir;
+    assert(demux_IndexOpen(demux, "test") == NULL);
+    demux->psz_file = media;
+
+    test_points(demux);
+    test_changed(demux);
+    test_invalid(demux);
+
+    vlc_object_release(demux);
+}
+
+int main(void)
+{
+    test_init();
+
+    assert(mkdtemp(cache_dir) != NULL);
+    int fd = mkstemp(media);
+    assert(fd >= 0);
+    close(fd);
+    WriteMedia(FILE_SIZE);
+    setenv("XDG_CACHE_HOME", cache_dir, 1);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+    test_seekindex(vlc->p_libvlc_int);
+    test_es(vlc->p_libvlc_int);
+    libvlc_release(vlc);
+
+    unlink(media);
+    char path[sizeof (cache_dir) + sizeof ("/vlc/seekindex")];
+    snprintf(path, sizeof (path), "%s/vlc/seekindex", cache_dir);
+    rmdir(path);
+    snprintf(path, sizeof (path), "%s/vlc", cache_dir);
+    rmdir(path);
+    rmdir(cache_dir);
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*****************************************************************************
+ * subtitle.c: text subtitles demuxer parsing and seek index test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+/* A few cues out of order, one of them displayed over the next ones, then
+ * a long run of ordered one second cues */
+#define CUES     20000
+#define CUES_AT  10 /* seconds */
+
+static const struct
+{
+    unsigned start, stop; /* ms */
+    const char *text;
+} head[] = {
+    {  1000,  2000, "one" },
+    {  3000, 30000, "two\nlong" },
+    {  5000,  6000, "three" },
+    {  7000,  8000, "four" },
+};
+
+static void WriteTime(FILE *f, unsigned ms)
+{
+    fprintf(f, "%02u:%02u:%02u,%03u", ms / 3600000, (ms / 60000) % 60,
+            (ms / 1000) % 60, ms % 1000);
+}
+
+static void WriteCue(FILE *f, unsigned n, unsigned start, unsigned stop,
+                     const char *text)
+{
+    fprintf(f, "%u\r\n", n);
+    WriteTime(f, start);
+    fputs(" --> ", f);
+    WriteTime(f, stop);
+    fputs("\r\n", f);
+    for (const char *p = text; *p; p++)
+    {
+        if (*p == '\n')
+            fputc('\r', f);
+        fputc(*p, f);
+    }
+}
+
+/* SRT with CRLF line ends, and without any after the last cue */
+static void WriteFile(const char *path)
+{
+    static const unsigned order[] = { 0, 2, 1, 3 };
+    FILE *f = fopen(path, "wb");
+    char text[32];
+
+    assert(f != NULL);
+    for (unsigned i = 0; i < ARRAY_SIZE(order); i++)
+    {
+        const unsigned j = order[i];
+
+        WriteCue(f, i + 1, head[j].start, head[j].stop, head[j].text);
+        fputs("\r\n\r\n", f);
+    }
+    for (unsigned i = 0; i < CUES; i++)
+    {
+        snprintf(text, sizeof (text), "cue %u", i);
+        WriteCue(f, ARRAY_SIZE(head) + i + 1, (CUES_AT + i) * 1000,
+                 (CUES_AT + i + 1) * 1000, text);
+        if (i < CUES - 1)
+            fputs("\r\n\r\n", f);
+    }
+    assert(fclose(f) == 0);
+}
+
+/* Expected cues, in start order */
+static unsigned CueStart(unsigned i)
+{
+    if (i < ARRAY_SIZE(head))
+        return head[i].start;
+    return (CUES_AT + i - ARRAY_SIZE(head)) * 1000;
+}
+
+static unsigned CueStop(unsigned i)
+{
+    if (i < ARRAY_SIZE(head))
+        return head[i].stop;
+    return CueStart(i) + 1000;
+}
+
+/* The demuxer ends every line of text with a line feed */
+static void CueText(unsigned i, char *buf, size_t len)
+{
+    if (i < ARRAY_SIZE(head))
+        snprintf(buf, len, "%s\n", head[i].text);
+    else
+        snprintf(buf, len, "cue %u\n", i - (unsigned)ARRAY_SIZE(head));
+}
+
+/* Checks that the cues come in order, from an expected one */
+struct checker
+{
+    es_out_t out;
+    unsigned next;
+    unsigned count;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    assert(fmt->i_cat == SPU_ES);
+    return (es_out_id_t *)out;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct checker *c = (struct checker *)out;
+    char text[32];
+
+    assert(id == (es_out_id_t *)out);
+    assert(c->next < ARRAY_SIZE(head) + CUES);
+
+    CueText(c->next, text, sizeof (text));
+    assert(block->i_buffer == strlen(text) + 1);
+    assert(!strcmp((const char *)block->p_buffer, text));
+    assert(block->i_pts == VLC_TS_0 + CueStart(c->next) * INT64_C(1000));
+    assert(block->i_length ==
+           (CueStop(c->next) - CueStart(c->next)) * INT64_C(1000));
+
+    c->next++;
+    c->count++;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out; (void) query; (void) args;
+    return VLC_SUCCESS;
+}
+
+/* Seeks, then checks the first cues sent from there */
+static void SeekTo(demux_t *demux, struct checker *c, unsigned ms,
+                   unsigned first)
+{
+    assert(demux_Control(demux, DEMUX_SET_TIME,
+                         (int64_t)ms * 1000, false) == VLC_SUCCESS);
+    c->next = first;
+    c->count = 0;
+    while (c->count < 3)
+        assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+}
+
+static void test_subtitle(libvlc_int_t *obj, const char *path)
+{
+    struct checker c = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+        },
+    };
+    char *url = vlc_path2uri(path, NULL);
+    assert(url != NULL);
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+    demux_t *demux = demux_New(VLC_OBJECT(obj), "subtitle", path, s, &c.out);
+    assert(demux != NULL);
+    free(url);
+
+    /* the latest end, not the end of the last cue */
+    int64_t length;
+    assert(demux_Control(demux, DEMUX_GET_LENGTH, &length) == VLC_SUCCESS);
+    assert(length == (CUES_AT + CUES) * INT64_C(1000000));
+
+    /* every cue, sorted by start time */
+    int ret;
+    while ((ret = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+    assert(ret == VLC_DEMUXER_EOF);
+    assert(c.count == ARRAY_SIZE(head) + CUES);
+
+    /* the long cue is still displayed: it is sent again first */
+    SeekTo(demux, &c, 5500, 1);
+    SeekTo(demux, &c, (CUES_AT + 5) * 1000, 1);
+    /* between cues: an ended one is not sent again */
+    SeekTo(demux, &c, 2500, 1);
+    /* before any cue */
+    SeekTo(demux, &c, 0, 0);
+    /* within and at the start of the ordered cues, once the long one ended */
+    SeekTo(demux, &c, 30000, ARRAY_SIZE(head) + 20);
+    SeekTo(demux, &c, (CUES_AT + 1234) * 1000 + 500, ARRAY_SIZE(head) + 1234);
+    SeekTo(demux, &c, (CUES_AT + 100) * 1000, ARRAY_SIZE(head) + 100);
+
+    /* past the end */
+    assert(demux_Control(demux, DEMUX_SET_TIME,
+                         length + 1000000, false) == VLC_SUCCESS);
+    assert(demux_Demux(demux) == VLC_DEMUXER_EOF);
+
+    demux_Delete(demux);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/vlc-test-subtitle-XXXXXX";
+    int fd = mkstemp(path);
+
+    test_init();
+
+    assert(fd != -1);
+    close(fd);
+    WriteFile(path);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    log("Testing the subtitle demuxer\n");
+    test_subtitle(vlc->p_libvlc_int, path);
+
+    libvlc_release(vlc);
+    unlink(path);
+    return 0;
+}
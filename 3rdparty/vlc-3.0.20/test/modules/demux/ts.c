@@ -0,0 +1,298 @@
+/*****************************************************************************
+ * ts.c: MPEG-TS demuxer throughput test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+/* 16384 PES of 8 packets on the selected PID, as many on an unselected one,
+ * with a PCR packet and null packets in between: 58 MiB */
+#define GROUPS      16384
+#define PES_PACKETS 8
+#define PES_PAYLOAD (PES_PACKETS * 184 - 14)
+#define PID_PMT     0x100
+#define PID_AUDIO   0x101 /* selected, carries the PCR */
+#define PID_OTHER   0x102 /* not selected */
+#define PID_NULL    0x1FFF
+
+static uint8_t PayloadByte(uint32_t pes, size_t i)
+{
+    return pes * 7 + i;
+}
+
+static uint32_t Crc32(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len-- > 0)
+    {
+        crc ^= (uint32_t)*(p++) << 24;
+        for (unsigned i = 0; i < 8; i++)
+            crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04C11DB7 : 0);
+    }
+    return crc;
+}
+
+struct writer
+{
+    FILE *f;
+    uint8_t cc[0x2000];
+};
+
+static void WritePacket(struct writer *w, uint16_t pid, bool start,
+                        const uint8_t *payload, size_t len)
+{
+    uint8_t pkt[188];
+
+    assert(len <= 184);
+    pkt[0] = 0x47;
+    pkt[1] = (start ? 0x40 : 0x00) | (pid >> 8);
+    pkt[2] = pid;
+    pkt[3] = 0x10 | (w->cc[pid]++ & 0xF);
+    memcpy(&pkt[4], payload, len);
+    memset(&pkt[4 + len], 0xFF, 184 - len);
+    assert(fwrite(pkt, sizeof (pkt), 1, w->f) == 1);
+}
+
+/* Adaptation field only packet, without continuity counter increment */
+static void WritePCR(struct writer *w, uint16_t pid, uint64_t pcr)
+{
+    uint8_t pkt[188];
+
+    memset(pkt, 0xFF, sizeof (pkt));
+    pkt[0] = 0x47;
+    pkt[1] = pid >> 8;
+    pkt[2] = pid;
+    pkt[3] = 0x20 | ((w->cc[pid] - 1) & 0xF);
+    pkt[4] = 183;
+    pkt[5] = 0x10;
+    pkt[6] = pcr >> 25;
+    pkt[7] = pcr >> 17;
+    pkt[8] = pcr >> 9;
+    pkt[9] = pcr >> 1;
+    pkt[10] = ((pcr & 1) << 7) | 0x7E;
+    pkt[11] = 0;
+    assert(fwrite(pkt, sizeof (pkt), 1, w->f) == 1);
+}
+
+static void WriteSection(struct writer *w, uint16_t pid, uint8_t *section,
+                         size_t len)
+{
+    uint8_t payload[184];
+
+    /* section length, CRC included */
+    section[1] = 0xB0 | ((len + 4 - 3) >> 8);
+    section[2] = len + 4 - 3;
+    SetDWBE(&section[len], Crc32(section, len));
+    payload[0] = 0; /* pointer field */
+    memcpy(&payload[1], section, len + 4);
+    WritePacket(w, pid, true, payload, len + 5);
+}
+
+static void WritePSI(struct writer *w)
+{
+    uint8_t pat[16] = {
+        0x00, 0, 0, 0x00, 0x01, 0xC1, 0, 0,
+        0x00, 0x01, 0xE0 | (PID_PMT >> 8), PID_PMT & 0xFF,
+    };
+    WriteSection(w, 0, pat, 12);
+
+    uint8_t pmt[26] = {
+        0x02, 0, 0, 0x00, 0x01, 0xC1, 0, 0,
+        0xE0 | (PID_AUDIO >> 8), PID_AUDIO & 0xFF, 0xF0, 0x00,
+        0x03, 0xE0 | (PID_AUDIO >> 8), PID_AUDIO & 0xFF, 0xF0, 0x00,
+        0x03, 0xE0 | (PID_OTHER >> 8), PID_OTHER & 0xFF, 0xF0, 0x00,
+    };
+    WriteSection(w, PID_PMT, pmt, 22);
+}
+
+static void WritePES(struct writer *w, uint16_t pid, uint32_t pes,
+                     uint64_t pts)
+{
+    uint8_t buf[PES_PACKETS * 184];
+    const size_t len = 8 + PES_PAYLOAD;
+
+    buf[0] = 0x00; buf[1] = 0x00; buf[2] = 0x01; buf[3] = 0xC0;
+    buf[4] = len >> 8; buf[5] = len;
+    buf[6] = 0x80; buf[7] = 0x80; buf[8] = 5;
+    buf[9] = 0x21 | ((pts >> 29) & 0x0E);
+    buf[10] = pts >> 22;
+    buf[11] = ((pts >> 14) & 0xFE) | 1;
+    buf[12] = pts >> 7;
+    buf[13] = ((pts << 1) & 0xFE) | 1;
+    for (size_t i = 0; i < PES_PAYLOAD; i++)
+        buf[14 + i] = PayloadByte(pes, i);
+
+    for (unsigned i = 0; i < PES_PACKETS; i++)
+        WritePacket(w, pid, i == 0, &buf[i * 184], 184);
+}
+
+static void WriteFile(const char *path)
+{
+    static const uint8_t nul[184];
+    struct writer w = { .f = fopen(path, "wb") };
+    assert(w.f != NULL);
+
+    for (uint32_t i = 0; i < GROUPS; i++)
+    {
+        const uint64_t pts = 90000 + (uint64_t)i * 3600;
+
+        if (i % 64 == 0)
+            WritePSI(&w);
+        if (i > 0)
+            WritePCR(&w, PID_AUDIO, pts - 9000);
+        else
+            WritePacket(&w, PID_NULL, false, nul, sizeof (nul));
+        WritePES(&w, PID_AUDIO, i, pts);
+        WritePacket(&w, PID_NULL, false, nul, sizeof (nul));
+        WritePES(&w, PID_OTHER, i, pts);
+        WritePacket(&w, PID_NULL, false, nul, sizeof (nul));
+    }
+    assert(fclose(w.f) == 0);
+}
+
+/* Checks that the payload of the selected PID comes whole and in order */
+struct checker
+{
+    es_out_t out;
+    uint32_t pes;
+    size_t offset;
+    uint64_t bytes;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    (void) out;
+    assert(fmt->i_id == PID_AUDIO || fmt->i_id == PID_OTHER);
+    return (es_out_id_t *)(uintptr_t)fmt->i_id;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct checker *c = (struct checker *)out;
+
+    assert(id == (es_out_id_t *)(uintptr_t)PID_AUDIO);
+    for (size_t i = 0; i < block->i_buffer; i++)
+    {
+        assert(block->p_buffer[i] == PayloadByte(c->pes, c->offset));
+        if (++c->offset == PES_PAYLOAD)
+        {
+            c->pes++;
+            c->offset = 0;
+        }
+    }
+    c->bytes += block->i_buffer;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    (void) out;
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *id = va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = id == (es_out_id_t *)(uintptr_t)PID_AUDIO;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        default:
+            return VLC_SUCCESS;
+    }
+}
+
+static void test_ts(libvlc_int_t *obj, const char *path)
+{
+    struct checker c = {
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+        },
+    };
+    char *url = vlc_path2uri(path, NULL);
+    assert(url != NULL);
+
+    stream_t *s = vlc_stream_NewURL(VLC_OBJECT(obj), url);
+    assert(s != NULL);
+    free(url);
+
+    const uint64_t size = stream_Size(s);
+    mtime_t start = mdate();
+    demux_t *demux = demux_New(VLC_OBJECT(obj), "ts", path, s, &c.out);
+    assert(demux != NULL);
+
+    int val;
+    while ((val = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+    assert(val == VLC_DEMUXER_EOF);
+    mtime_t elapsed = mdate() - start;
+
+    /* the last PES may only be flushed on close */
+    demux_Delete(demux);
+    assert(c.pes == GROUPS && c.offset == 0);
+    assert(c.bytes == (uint64_t)GROUPS * PES_PAYLOAD);
+
+    log("  %"PRIu64" MiB in %"PRId64" ms, %"PRIu64" MiB/s\n",
+        size >> 20, elapsed / 1000,
+        elapsed > 0 ? (size * CLOCK_FREQ / elapsed) >> 20 : 0);
+}
+
+int main(void)
+{
+    char path[] = "/tmp/vlc-test-ts-XXXXXX";
+    int fd = mkstemp(path);
+
+    test_init();
+    assert(fd != -1);
+    close(fd);
+
+    log("Generating a %u PES TS file\n", GROUPS);
+    WriteFile(path);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    log("Testing the TS demuxer throughput\n");
+    test_ts(vlc->p_libvlc_int, path);
+
+    libvlc_release(vlc);
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * ts_classify.c: TS packet headers batch extraction test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "../../libvlc/test.h"
+#include "../../../modules/demux/mpeg/ts_classify.h"
+
+/* 12 MiB of 188 bytes packets, or 192 bytes with a 4 bytes M2TS header */
+#define PACKETS (1 << 16)
+#define ROUNDS  16
+
+typedef size_t (*classify_t)(const uint8_t *, size_t, size_t, uint32_t *);
+
+static const struct
+{
+    const char *name;
+    classify_t classify;
+} impls[] = {
+    { "C", ts_packets_Classify_C },
+#ifdef TS_CLASSIFY_X86
+    { "SSE2", ts_packets_Classify_SSE2 },
+    { "AVX2", ts_packets_Classify_AVX2 },
+#endif
+};
+
+static bool Supported(const char *name)
+{
+#ifdef TS_CLASSIFY_X86
+    if (!strcmp(name, "SSE2"))
+        return vlc_CPU_SSE2();
+    if (!strcmp(name, "AVX2"))
+        return vlc_CPU_AVX2();
+#endif
+    (void) name;
+    return true;
+}
+
+static void Fill(uint8_t *buf, size_t stride, size_t header)
+{
+    for (size_t i = 0; i < PACKETS; i++)
+    {
+        uint8_t *p = &buf[i * stride];
+
+        memset(p, 0xFF, stride);
+        p[header] = 0x47;
+        p[header + 1] = (i * 7) & 0x5F; /* TEI, PUSI and PID */
+        p[header + 2] = i * 13;
+        p[header + 3] = 0x10 | (i & 0x2F); /* AF, payload and CC */
+    }
+}
+
+static void Check(classify_t classify, const uint8_t *buf, size_t stride,
+                  size_t header, uint32_t *hdr)
+{
+    const uint8_t *p = &buf[header];
+
+    /* every packet count, so that all the tails are covered */
+    for (size_t count = 0; count <= 17; count++)
+    {
+        memset(hdr, 0, PACKETS * sizeof (*hdr));
+        assert(classify(p, stride, count, hdr) == count);
+        for (size_t i = 0; i < count; i++)
+            assert(hdr[i] == GetDWBE(&p[i * stride]));
+    }
+
+    assert(classify(p, stride, PACKETS, hdr) == PACKETS);
+    for (size_t i = 0; i < PACKETS; i++)
+    {
+        assert(hdr[i] == GetDWBE(&p[i * stride]));
+        assert(TS_HDR_SYNC(hdr[i]) == 0x47);
+        assert(TS_HDR_PID(hdr[i]) == (GetWBE(&p[i * stride + 1]) & 0x1FFF));
+        assert(TS_HDR_CC(hdr[i]) == (p[i * stride + 3] & 0xF));
+    }
+}
+
+/* Returns the first packet with a lost sync at every position in and
+ * around the vector widths */
+static void CheckSync(classify_t classify, uint8_t *buf, size_t stride,
+                      size_t header, uint32_t *hdr)
+{
+    static const size_t lost[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17,
+                                   PACKETS - 1 };
+    uint8_t *p = &buf[header];
+
+    for (size_t i = 0; i < ARRAY_SIZE(lost); i++)
+    {
+        p[lost[i] * stride] = 0x48;
+        assert(classify(p, stride, PACKETS, hdr) == lost[i]);
+        /* the ones before are extracted */
+        for (size_t j = 0; j < lost[i]; j++)
+            assert(hdr[j] == GetDWBE(&p[j * stride]));
+        p[lost[i] * stride] = 0x47;
+    }
+}
+
+static void Bench(const char *name, classify_t classify, const uint8_t *p,
+                  size_t stride, uint32_t *hdr)
+{
+    mtime_t start = mdate();
+    for (unsigned i = 0; i < ROUNDS; i++)
+        assert(classify(p, stride, PACKETS, hdr) == PACKETS);
+    mtime_t elapsed = mdate() - start;
+
+    log("  %-4s %3zu bytes packets: %"PRId64" Mpackets/s\n", name, stride,
+        elapsed > 0 ? (int64_t)PACKETS * ROUNDS / elapsed : 0);
+}
+
+int main(void)
+{
+    test_init();
+
+    uint8_t *buf = malloc(PACKETS * 192);
+    uint32_t *hdr = malloc(PACKETS * sizeof (*hdr));
+    assert(buf != NULL && hdr != NULL);
+
+    static const size_t strides[] = { 188, 192 };
+    for (size_t s = 0; s < ARRAY_SIZE(strides); s++)
+    {
+        const size_t stride = strides[s];
+        const size_t header = stride - 188;
+
+        Fill(buf, stride, header);
+        log("Testing %zu bytes packets\n", stride);
+        for (size_t i = 0; i < ARRAY_SIZE(impls); i++)
+        {
+            if (!Supported(impls[i].name))
+            {
+                log("  %s not supported\n", impls[i].name);
+                continue;
+            }
+            Check(impls[i].classify, buf, stride, header, hdr);
+            CheckSync(impls[i].classify, buf, stride, header, hdr);
+            Bench(impls[i].name, impls[i].classify, &buf[header], stride, hdr);
+        }
+    }
+
+    free(hdr);
+    free(buf);
+    return 0;
+}
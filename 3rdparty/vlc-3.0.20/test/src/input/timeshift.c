@@ -0,0 +1,283 @@
+/*****************************************************************************
+ * timeshift.c: pause/resume latency of live input timeshifting
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+
+#include <string.h>
+
+#include <vlc_common.h>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+
+/* Live raw video over UDP: 320x240 RV32 at 25 fps, about 61 Mbit/s, so that
+ * the timeshift storage gets a few MiB per second of pause */
+#define WIDTH      320
+#define HEIGHT     240
+#define FPS        25
+#define FRAME_SIZE (WIDTH * HEIGHT * 4)
+#define DGRAM_SIZE 1316
+#define PAUSE      CLOCK_FREQ
+
+struct live
+{
+    vlc_thread_t thread;
+    int fd;
+    unsigned port;
+};
+
+static void *Send(void *data)
+{
+    struct live *live = data;
+    static uint8_t frame[FRAME_SIZE];
+    mtime_t deadline = mdate();
+
+    memset(frame, 0x80, sizeof (frame));
+
+    for (;;)
+    {
+        for (size_t off = 0; off < FRAME_SIZE; off += DGRAM_SIZE)
+        {
+            size_t len = FRAME_SIZE - off;
+
+            if (len > DGRAM_SIZE)
+                len = DGRAM_SIZE;
+            send(live->fd, frame + off, len, 0);
+        }
+        deadline += CLOCK_FREQ / FPS;
+        mwait(deadline);
+    }
+    vlc_assert_unreachable();
+}
+
+struct player
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned displayed;
+    mtime_t last_display;
+    bool paused;
+    bool playing;
+    mtime_t paused_date;
+    mtime_t playing_date;
+    uint32_t pixels[WIDTH * HEIGHT];
+};
+
+static void *Lock(void *data, void **planes)
+{
+    struct player *p = data;
+
+    planes[0] = p->pixels;
+    return NULL;
+}
+
+static void Display(void *data, void *id)
+{
+    struct player *p = data;
+
+    (void) id;
+    vlc_mutex_lock(&p->lock);
+    p->displayed++;
+    p->last_display = mdate();
+    vlc_cond_signal(&p->wait);
+    vlc_mutex_unlock(&p->lock);
+}
+
+static void OnEvent(const libvlc_event_t *ev, void *data)
+{
+    struct player *p = data;
+
+    vlc_mutex_lock(&p->lock);
+    if (ev->type == libvlc_MediaPlayerPaused)
+    {
+        p->paused = true;
+        p->paused_date = mdate();
+    }
+    else
+    {
+        p->playing = true;
+        p->playing_date = mdate();
+    }
+    vlc_cond_signal(&p->wait);
+    vlc_mutex_unlock(&p->lock);
+}
+
+/* Bytes written by the process with write() and the like, if known */
+static uint64_t WrittenBytes(void)
+{
+    FILE *stream = fopen("/proc/self/io", "r");
+    unsigned long long val = 0;
+    char line[64];
+
+    if (stream == NULL)
+        return 0;
+    while (fgets(line, sizeof (line), stream) != NULL)
+        if (sscanf(line, "wchar: %llu", &val) == 1)
+            break;
+    fclose(stream);
+    return val;
+}
+
+/* Waits for a picture to be displayed after the given count */
+static void WaitDisplay(struct player *p, unsigned count)
+{
+    vlc_mutex_lock(&p->lock);
+    while (p->displayed <= count)
+        vlc_cond_wait(&p->wait, &p->lock);
+    vlc_mutex_unlock(&p->lock);
+}
+
+static void test_pause_resume(struct live *live, const char *memory)
+{
+    const char *argv[] = {
+        "-v", "--no-audio", "--network-caching=100", "--udp-rcvbuf=8388608",
+        memory,
+    };
+    char mrl[32];
+
+    log("Timeshifting in %s\n", memory);
+
+    libvlc_instance_t *vlc = libvlc_new(sizeof (argv) / sizeof (argv[0]),
+                                        argv);
+    assert(vlc != NULL);
+
+    snprintf(mrl, sizeof (mrl), "udp://@127.0.0.1:%u", live->port);
+    libvlc_media_t *md = libvlc_media_new_location(vlc, mrl);
+    assert(md != NULL);
+    libvlc_media_add_option(md, ":demux=rawvid");
+    libvlc_media_add_option(md, ":rawvid-chroma=RV32");
+    libvlc_media_add_option(md, ":rawvid-width=320");
+    libvlc_media_add_option(md, ":rawvid-height=240");
+    libvlc_media_add_option(md, ":rawvid-fps=25");
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(md);
+    assert(mp != NULL);
+    libvlc_media_release(md);
+
+    struct player *p = malloc(sizeof (*p));
+    assert(p != NULL);
+    vlc_mutex_init(&p->lock);
+    vlc_cond_init(&p->wait);
+    p->displayed = 0;
+    p->paused = p->playing = false;
+
+    libvlc_video_set_callbacks(mp, Lock, NULL, Display, p);
+    libvlc_video_set_format(mp, "RV32", WIDTH, HEIGHT, WIDTH * 4);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    libvlc_event_attach(em, libvlc_MediaPlayerPaused, OnEvent, p);
+    libvlc_event_attach(em, libvlc_MediaPlayerPlaying, OnEvent, p);
+
+    assert(libvlc_media_player_play(mp) == 0);
+    WaitDisplay(p, FPS / 4); /* steady state */
+
+    /* Pause: the live source is now stored */
+    vlc_mutex_lock(&p->lock);
+    p->playing = false;
+    vlc_mutex_unlock(&p->lock);
+
+    mtime_t start = mdate();
+    uint64_t written = WrittenBytes();
+
+    libvlc_media_player_set_pause(mp, 1);
+    vlc_mutex_lock(&p->lock);
+    while (!p->paused)
+        vlc_cond_wait(&p->wait, &p->lock);
+    mtime_t pause_latency = p->paused_date - start;
+    vlc_mutex_unlock(&p->lock);
+
+    msleep(PAUSE);
+    written = WrittenBytes() - written;
+
+    /* Resume: playback goes on from the storage */
+    vlc_mutex_lock(&p->lock);
+    unsigned count = p->displayed;
+    vlc_mutex_unlock(&p->lock);
+
+    start = mdate();
+    libvlc_media_player_set_pause(mp, 0);
+    WaitDisplay(p, count);
+
+    vlc_mutex_lock(&p->lock);
+    mtime_t resume_latency = p->last_display - start;
+    count = p->displayed;
+    vlc_mutex_unlock(&p->lock);
+
+    /* The stored pictures keep flowing at the source rate */
+    msleep(CLOCK_FREQ / 2);
+    vlc_mutex_lock(&p->lock);
+    count = p->displayed - count;
+    vlc_mutex_unlock(&p->lock);
+
+    log("  pause %"PRId64" us, resume to first picture %"PRId64" us, "
+        "%u pictures in the next 0.5 s\n", pause_latency, resume_latency,
+        count);
+    log("  %"PRIu64" bytes passed to write() while paused\n", written);
+
+    libvlc_media_player_stop(mp);
+    libvlc_media_player_release(mp);
+    libvlc_release(vlc);
+
+    vlc_cond_destroy(&p->wait);
+    vlc_mutex_destroy(&p->lock);
+    free(p);
+}
+
+int main(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    socklen_t addrlen = sizeof (addr);
+    struct live live;
+
+    test_init();
+
+    /* find a free port */
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    assert(bind(fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&addr, &addrlen) == 0);
+    close(fd);
+    live.port = ntohs(addr.sin_port);
+
+    live.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(live.fd != -1);
+    assert(connect(live.fd, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    assert(vlc_clone(&live.thread, Send, &live,
+                     VLC_THREAD_PRIORITY_LOW) == 0);
+
+    test_pause_resume(&live, "--input-timeshift-memory=64");
+    test_pause_resume(&live, "--input-timeshift-memory=0");
+
+    vlc_cancel(live.thread);
+    vlc_join(live.thread, NULL);
+    close(live.fd);
+    return 0;
+}
+#else
+int main(void)
+{
+    return 77;
+}
+#endif
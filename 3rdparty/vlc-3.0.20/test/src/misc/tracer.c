@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * tracer.c: pipeline trace points and Chrome trace exporter test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* The tracer is built and tested whether the trace points are enabled */
+#ifndef ENABLE_TRACING
+# define ENABLE_TRACING 1
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+
+/* before test.h, which enables the assertions again */
+#include "../../../src/misc/tracer.c"
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#define WORKERS 4
+#define EVENTS  1000 /* begin and end pairs, per thread and session */
+
+const char vlc_module_name[] = "test_tracer";
+
+static char path[] = "/tmp/vlc-test-tracer-XXXXXX";
+
+static void *Worker(void *data)
+{
+    (void) data;
+    for (unsigned i = 0; i < EVENTS; i++)
+    {
+        vlc_trace_begin("work", i);
+        vlc_trace_end("work", VLC_TICK_INVALID);
+    }
+    return NULL;
+}
+
+/* Keeps tracing across the sessions */
+struct runner
+{
+    vlc_thread_t thread;
+    unsigned long tid;
+    atomic_bool stop;
+    atomic_uint events;
+};
+
+static void *Runner(void *data)
+{
+    struct runner *r = data;
+
+    r->tid = vlc_thread_id();
+    while (!atomic_load(&r->stop))
+    {
+        vlc_trace_instant("run", VLC_TICK_INVALID);
+        atomic_fetch_add(&r->events, 1);
+        mwait(mdate() + CLOCK_FREQ / 1000);
+    }
+    return NULL;
+}
+
+static unsigned CountBuffers(void)
+{
+    unsigned n = 0;
+
+    vlc_mutex_lock(&tracer.lock);
+    for (const struct vlc_trace_buffer *buf = tracer.buffers; buf != NULL;
+         buf = buf->next)
+        n++;
+    vlc_mutex_unlock(&tracer.lock);
+    return n;
+}
+
+struct trace_thread
+{
+    unsigned long tid;
+    unsigned events;
+    unsigned depth;
+    int64_t last;
+};
+
+/* Checks the trace file: events in order and balanced on every thread, and
+ * none from before the session. Returns the threads. */
+static size_t CheckTrace(struct trace_thread *threads, size_t max,
+                         mtime_t start)
+{
+    FILE *f = fopen(path, "rt");
+    char line[512];
+    size_t n = 0;
+
+    assert(f != NULL);
+    assert(fgets(line, sizeof (line), f) != NULL);
+    assert(!strcmp(line, "{\"traceEvents\":[\n"));
+
+    while (fgets(line, sizeof (line), f) != NULL)
+    {
+        const char *ev = line + (line[0] == ',');
+        if (!strcmp(ev, "],\"displayTimeUnit\":\"ms\"}\n"))
+            break;
+
+        char phase;
+        int64_t ts;
+        unsigned long tid;
+        const char *p = strstr(ev, "\"ph\":\"");
+
+        assert(!strncmp(ev, "{\"name\":\"", 9) && p != NULL);
+        assert(sscanf(p, "\"ph\":\"%c\",\"ts\":%"SCNd64",\"pid\":%*d,"
+                      "\"tid\":%lu", &phase, &ts, &tid) == 3);
+        assert(ts >= start);
+
+        size_t i = 0;
+        while (i < n && threads[i].tid != tid)
+            i++;
+        if (i == n)
+        {
+            assert(n < max);
+            threads[n++] = (struct trace_thread){ .tid = tid, .last = ts };
+        }
+
+        struct trace_thread *t = &threads[i];
+        assert(ts >= t->last);
+        t->last = ts;
+        t->events++;
+        if (phase == 'B')
+            t->depth++;
+        else if (phase == 'E')
+        {
+            assert(t->depth > 0);
+            t->depth--;
+        }
+        else
+            assert(phase == 'i');
+    }
+    assert(!feof(f));
+    fclose(f);
+
+    for (size_t i = 0; i < n; i++)
+        assert(threads[i].depth == 0);
+    return n;
+}
+
+static unsigned EventsOf(const struct trace_thread *threads, size_t n,
+                         unsigned long tid)
+{
+    for (size_t i = 0; i < n; i++)
+        if (threads[i].tid == tid)
+            return threads[i].events;
+    return 0;
+}
+
+static void test_tracer(libvlc_int_t *obj)
+{
+    struct trace_thread threads[WORKERS + 2];
+    vlc_thread_t workers[WORKERS];
+    struct runner runner;
+    const unsigned long tid = vlc_thread_id();
+
+    var_Create(obj, "trace-file", VLC_VAR_STRING);
+    var_SetString(obj, "trace-file", path);
+
+    /* Not recorded, nor allocated, without a session */
+    vlc_trace_instant("untraced", VLC_TICK_INVALID);
+    assert(CountBuffers() == 0);
+
+    mtime_t start = mdate();
+    vlc_trace_Init(obj);
+    Worker(NULL);
+
+    atomic_init(&runner.stop, false);
+    atomic_init(&runner.events, 0);
+    if (vlc_clone(&runner.thread, Runner, &runner, VLC_THREAD_PRIORITY_LOW))
+        assert(!"Thread error");
+    for (unsigned i = 0; i < WORKERS; i++)
+        if (vlc_clone(&workers[i], Worker, NULL, VLC_THREAD_PRIORITY_LOW))
+            assert(!"Thread error");
+    for (unsigned i = 0; i < WORKERS; i++)
+        vlc_join(workers[i], NULL);
+    while (atomic_load(&runner.events) == 0)
+        mwait(mdate() + CLOCK_FREQ / 1000);
+
+    /* the buffers of the exited workers are kept until written */
+    assert(CountBuffers() == WORKERS + 2);
+    vlc_trace_Deinit(obj);
+    assert(CountBuffers() == 2);
+
+    size_t n = CheckTrace(threads, ARRAY_SIZE(threads), start);
+    assert(n == WORKERS + 2);
+    assert(EventsOf(threads, n, tid) == 2 * EVENTS);
+    for (size_t i = 0; i < n; i++)
+        if (threads[i].tid != runner.tid)
+            assert(threads[i].events == 2 * EVENTS);
+    log("  %u events from the running thread\n",
+        EventsOf(threads, n, runner.tid));
+
+    /* Second session: the running thread resets its own buffer */
+    start = mdate();
+    vlc_trace_Init(obj);
+    for (unsigned i = 0; i < EVENTS / 2; i++)
+    {
+        vlc_trace_begin("work", i);
+        vlc_trace_end("work", VLC_TICK_INVALID);
+    }
+    if (vlc_clone(&workers[0], Worker, NULL, VLC_THREAD_PRIORITY_LOW))
+        assert(!"Thread error");
+    vlc_join(workers[0], NULL);
+    unsigned events = atomic_load(&runner.events);
+    while (atomic_load(&runner.events) == events)
+        mwait(mdate() + CLOCK_FREQ / 1000);
+    vlc_trace_Deinit(obj);
+
+    n = CheckTrace(threads, ARRAY_SIZE(threads), start);
+    assert(n == 3);
+    assert(EventsOf(threads, n, tid) == EVENTS);
+    assert(EventsOf(threads, n, runner.tid) > 0);
+
+    /* Outside of a session, exiting threads free their buffer */
+    atomic_store(&runner.stop, true);
+    vlc_join(runner.thread, NULL);
+    assert(CountBuffers() == 1);
+}
+
+int main(void)
+{
+    test_init();
+
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+
+    log("Testing the trace buffers and the trace file\n");
+    test_tracer(vlc->p_libvlc_int);
+
+    libvlc_release(vlc);
+    unlink(path);
+    return 0;
+}
@@ -443,6 +443,104 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOVAR );
 }
 
+static void test_table( libvlc_int_t *p_libvlc )
+{
+    char name[16];
+
+    /* Enough variables to grow the hash table several times */
+    for( int i = 0; i < 1000; i++ )
+    {
+        snprintf( name, sizeof (name), "table-%d", i );
+        assert( var_Create( p_libvlc, name, VLC_VAR_INTEGER ) == VLC_SUCCESS );
+        var_SetInteger( p_libvlc, name, i );
+    }
+
+    /* Punch holes in the probe sequences */
+    for( int i = 0; i < 1000; i += 3 )
+    {
+        snprintf( name, sizeof (name), "table-%d", i );
+        var_Destroy( p_libvlc, name );
+    }
+
+    for( int i = 0; i < 1000; i++ )
+    {
+        snprintf( name, sizeof (name), "table-%d", i );
+        if( i % 3 == 0 )
+            assert( var_Type( p_libvlc, name ) == 0 );
+        else
+            assert( var_GetInteger( p_libvlc, name ) == i );
+    }
+
+    for( int i = 0; i < 1000; i++ )
+    {
+        snprintf( name, sizeof (name), "table-%d", i );
+        if( i % 3 != 0 )
+            var_Destroy( p_libvlc, name );
+        assert( var_Type( p_libvlc, name ) == 0 );
+    }
+}
+
+#define CONTENTION_LOOPS 20000
+
+struct contention
+{
+    libvlc_int_t *obj;
+    unsigned index;
+};
+
+static void *contention_thread( void *data )
+{
+    struct contention *c = data;
+    char name[16];
+
+    snprintf( name, sizeof (name), "contended-%u", c->index % 4 );
+    for( int i = 0; i < CONTENTION_LOOPS; i++ )
+    {
+        var_SetInteger( c->obj, name, i );
+        assert( var_GetInteger( c->obj, name ) >= 0 );
+    }
+    return NULL;
+}
+
+static void test_contention( libvlc_int_t *p_libvlc )
+{
+    char name[16];
+
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        snprintf( name, sizeof (name), "contended-%u", i );
+        var_Create( p_libvlc, name, VLC_VAR_INTEGER );
+    }
+
+    for( unsigned threads = 1; threads <= 16; threads *= 2 )
+    {
+        struct contention ctx[16];
+        vlc_thread_t th[16];
+        mtime_t start = mdate();
+
+        for( unsigned i = 0; i < threads; i++ )
+        {
+            ctx[i].obj = p_libvlc;
+            ctx[i].index = i;
+            assert( vlc_clone( &th[i], contention_thread, &ctx[i],
+                               VLC_THREAD_PRIORITY_LOW ) == 0 );
+        }
+        for( unsigned i = 0; i < threads; i++ )
+            vlc_join( th[i], NULL );
+
+        mtime_t elapsed = mdate() - start;
+        log( " %2u thread(s): %"PRId64" get/set pairs per second\n", threads,
+             elapsed > 0 ? (int64_t)threads * CONTENTION_LOOPS * CLOCK_FREQ
+                           / elapsed : 0 );
+    }
+
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        snprintf( name, sizeof (name), "contended-%u", i );
+        var_Destroy( p_libvlc, name );
+    }
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -480,6 +578,12 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    log( "Testing the variables table\n" );
+    test_table( p_libvlc );
+
+    log( "Testing contended accesses\n" );
+    test_contention( p_libvlc );
 }
 
 
@@ -0,0 +1,272 @@
+/*****************************************************************************
+ * httpd.c: HTTP server streaming load test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <vlc_common.h>
+#include <vlc_httpd.h>
+#include <vlc_block.h>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <poll.h>
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+
+#define CLIENTS      64
+#define BLOCK_SIZE   65536
+#define DURATION     (2 * CLOCK_FREQ)
+
+struct feeder
+{
+    httpd_stream_t *stream;
+    uint64_t        sent;
+};
+
+static void FeedCleanup(void *data)
+{
+    block_Release(data);
+}
+
+/* Feeds the stream at about 6.5 MB/s, roughly what a local high bitrate
+ * transcode pushes to access_output/http. Every 64-bits word of the stream
+ * contains its own offset. */
+static void *Feed(void *data)
+{
+    struct feeder *feeder = data;
+    block_t *block = block_Alloc(BLOCK_SIZE);
+
+    assert(block != NULL);
+
+    mtime_t deadline = mdate();
+
+    vlc_cleanup_push(FeedCleanup, block);
+    for (;;)
+    {
+        int canc = vlc_savecancel();
+        for (size_t i = 0; i < BLOCK_SIZE; i += 8)
+        {
+            uint64_t offset = feeder->sent + i;
+            memcpy(&block->p_buffer[i], &offset, 8);
+        }
+        httpd_StreamSend(feeder->stream, block);
+        feeder->sent += block->i_buffer;
+        vlc_restorecancel(canc);
+        deadline += 10000;
+        mwait(deadline);
+    }
+    vlc_cleanup_pop();
+    vlc_assert_unreachable();
+}
+
+/* Checks the data of a client: after the response header, the stream from
+ * the start of a block, in order and without gaps */
+struct client
+{
+    unsigned header; /* matched bytes of the end of the header */
+    bool started;
+    uint64_t next; /* stream offset of the next word */
+    size_t partial;
+    uint8_t word[8];
+    uint64_t received;
+};
+
+static void Receive(struct client *c, const uint8_t *p, size_t len)
+{
+    static const char eoh[] = "\r\n\r\n";
+
+    while (c->header < 4 && len > 0)
+    {
+        if (*p == eoh[c->header])
+            c->header++;
+        else
+            c->header = (*p == '\r');
+        p++;
+        len--;
+    }
+
+    c->received += len;
+    while (len > 0)
+    {
+        size_t copy = __MIN(len, 8 - c->partial);
+
+        memcpy(&c->word[c->partial], p, copy);
+        c->partial += copy;
+        p += copy;
+        len -= copy;
+        if (c->partial < 8)
+            break;
+
+        uint64_t offset;
+        memcpy(&offset, c->word, 8);
+        c->partial = 0;
+        if (!c->started)
+        {   /* joins the live stream at a block */
+            assert(offset % BLOCK_SIZE == 0);
+            c->next = offset;
+            c->started = true;
+        }
+        assert(offset == c->next);
+        c->next += 8;
+    }
+}
+
+/* Reads what is available for every client, for up to a poll timeout */
+static void ReceiveAll(struct pollfd *ufd, struct client *clients)
+{
+    char buf[65536];
+
+    if (poll(ufd, CLIENTS, 100) < 0)
+        assert(errno == EINTR);
+
+    for (unsigned i = 0; i < CLIENTS; i++)
+    {
+        if (ufd[i].revents == 0)
+            continue;
+
+        ssize_t val = read(ufd[i].fd, buf, sizeof (buf));
+        if (val > 0)
+            Receive(&clients[i], (const uint8_t *)buf, val);
+        else
+            assert(val < 0 && errno == EAGAIN);
+    }
+}
+
+static int Connect(unsigned port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    static const char req[] = "GET /stream HTTP/1.0\r\n\r\n";
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd != -1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof (addr)))
+    {
+        perror("connect");
+        abort();
+    }
+    assert(write(fd, req, sizeof (req) - 1) == sizeof (req) - 1);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+static void test_streaming(libvlc_int_t *obj)
+{
+    httpd_host_t *host = NULL;
+    unsigned port;
+
+    var_Create(obj, "http-host", VLC_VAR_STRING);
+    var_SetString(obj, "http-host", "127.0.0.1");
+    var_Create(obj, "http-port", VLC_VAR_INTEGER);
+
+    /* find a free port */
+    for (port = 20000 + (getpid() % 10000); host == NULL; port++)
+    {
+        var_SetInteger(obj, "http-port", port);
+        host = vlc_http_HostNew(VLC_OBJECT(obj));
+    }
+    port--;
+
+    struct feeder feeder = { .sent = 0 };
+    feeder.stream = httpd_StreamNew(host, "/stream",
+                                    "application/octet-stream", NULL, NULL);
+    assert(feeder.stream != NULL);
+
+    vlc_thread_t th;
+    if (vlc_clone(&th, Feed, &feeder, VLC_THREAD_PRIORITY_LOW))
+        assert(!"Thread error");
+
+    struct pollfd ufd[CLIENTS];
+    struct client clients[CLIENTS];
+
+    for (unsigned i = 0; i < CLIENTS; i++)
+    {
+        ufd[i].fd = Connect(port);
+        ufd[i].events = POLLIN;
+        clients[i] = (struct client){ .started = false };
+    }
+
+    mtime_t start = mdate(), deadline = start + DURATION;
+
+    while (mdate() < deadline)
+        ReceiveAll(ufd, clients);
+
+    mtime_t elapsed = mdate() - start;
+    uint64_t total = 0, least = UINT64_MAX;
+
+    for (unsigned i = 0; i < CLIENTS; i++)
+    {
+        total += clients[i].received;
+        if (clients[i].received < least)
+            least = clients[i].received;
+    }
+
+    vlc_cancel(th);
+    vlc_join(th, NULL);
+
+    log("  %u concurrent clients, fed %"PRIu64" bytes\n", CLIENTS,
+        feeder.sent);
+    log("  aggregate %.1f MB/s, slowest client %.1f MB/s\n",
+        total / (double)elapsed * (CLOCK_FREQ / 1e6),
+        least / (double)elapsed * (CLOCK_FREQ / 1e6));
+
+    /* every client gets the rest of the stream, up to its end */
+    for (unsigned i = 0; i < CLIENTS; i++)
+        while (!clients[i].started || clients[i].next < feeder.sent)
+            ReceiveAll(ufd, clients);
+    for (unsigned i = 0; i < CLIENTS; i++)
+    {
+        assert(clients[i].next == feeder.sent && clients[i].partial == 0);
+        close(ufd[i].fd);
+    }
+
+    httpd_StreamDelete(feeder.stream);
+    httpd_HostDelete(host);
+}
+
+int main(void)
+{
+    libvlc_instance_t *vlc;
+
+    test_init();
+
+    log("Testing the HTTP server under streaming load\n");
+    vlc = libvlc_new(test_defaults_nargs, test_defaults_args);
+    assert(vlc != NULL);
+
+    test_streaming(vlc->p_libvlc_int);
+
+    libvlc_release(vlc);
+    return 0;
+}
+#else
+int main(void)
+{
+    return 77;
+}
+#endif